@@ -0,0 +1,337 @@
+#include <stdlib.h>
+#include "dberror.h"
+#include "expr.h"
+#include "record_mgr.h"
+#include "tables.h"
+#include "bench_helper.h"
+
+// benchmark methods
+static void benchCompiledExpr (int numRecords);
+static void benchRangeOperators (int numRecords);
+static void benchShortCircuit (int numRecords);
+
+// helper methods
+Schema *benchSchema (void);
+Record *benchRecords (Schema *schema, int numRecords);
+void freeBenchRecords (Record *records, int numRecords);
+Expr *benchCondition (int numRecords);
+int benchPredicate (char *label, Schema *schema, Record *records, int numRecords, Expr *cond);
+
+// benchmark name
+char *benchName;
+
+// main method, the optional argument is the number of records to filter
+int
+main (int argc, char **argv)
+{
+  int numRecords = (argc > 1) ? atoi(argv[1]) : 1000000;
+  benchName = "";
+
+  benchCompiledExpr(numRecords);
+  benchRangeOperators(numRecords);
+  benchShortCircuit(numRecords);
+
+  return 0;
+}
+
+// ************************************************************
+void
+benchCompiledExpr (int numRecords)
+{
+  Schema *schema;
+  Record *records;
+  Expr *cond;
+  ExprProgram *prog;
+  Value *result;
+  bool match;
+  int i, numInterpreted = 0, numCompiled = 0;
+  double start, end;
+  benchName = "compiled predicate evaluation";
+  schema = benchSchema();
+  records = benchRecords(schema, numRecords);
+  cond = benchCondition(numRecords);
+
+  BENCH_NOW(start);
+  for(i = 0; i < numRecords; i++)
+    {
+      BENCH_CHECK(evalExpr(&records[i], schema, cond, &result));
+      numInterpreted += result->v.boolV;
+      freeVal(result);
+    }
+  BENCH_NOW(end);
+  BENCH_REPORT("evalExpr rows", numRecords, end - start);
+
+  BENCH_NOW(start);
+  BENCH_CHECK(compileExpr(cond, schema, &prog));
+  for(i = 0; i < numRecords; i++)
+    {
+      evalProgram(prog, records[i].data, &match);
+      numCompiled += match;
+    }
+  BENCH_CHECK(freeProgram(prog));
+  BENCH_NOW(end);
+  BENCH_REPORT("evalProgram rows", numRecords, end - start);
+
+  if (numInterpreted != numCompiled)
+    {
+      printf("[%s] FAILED: evalExpr matched %i rows, evalProgram %i\n", benchName, numInterpreted, numCompiled);
+      exit(1);
+    }
+
+  freeExpr(cond);
+  freeBenchRecords(records, numRecords);
+  freeSchema(schema);
+}
+
+// ************************************************************
+void
+benchRangeOperators (int numRecords)
+{
+  Schema *schema;
+  Record *records;
+  Expr *l, *r, *u, *e1, *e2, *cond;
+  Expr *values[100];
+  char str[16];
+  int i, numEmulated, numNative;
+  benchName = "range and list operators";
+  schema = benchSchema();
+  records = benchRecords(schema, numRecords);
+
+  // NOT c < 20 AND NOT 80 < c
+  MAKE_ATTRREF(l, 2);
+  MAKE_CONS(r, stringToValue("i20"));
+  MAKE_BINOP_EXPR(e1, l, r, OP_COMP_SMALLER);
+  MAKE_UNOP_EXPR(u, e1, OP_BOOL_NOT);
+  MAKE_CONS(l, stringToValue("i80"));
+  MAKE_ATTRREF(r, 2);
+  MAKE_BINOP_EXPR(e1, l, r, OP_COMP_SMALLER);
+  MAKE_UNOP_EXPR(e2, e1, OP_BOOL_NOT);
+  MAKE_BINOP_EXPR(cond, u, e2, OP_BOOL_AND);
+  numEmulated = benchPredicate("NOT/AND range", schema, records, numRecords, cond);
+  freeExpr(cond);
+
+  // c BETWEEN 20 AND 80
+  MAKE_ATTRREF(l, 2);
+  MAKE_CONS(r, stringToValue("i20"));
+  MAKE_CONS(u, stringToValue("i80"));
+  MAKE_BETWEEN_EXPR(cond, l, r, u);
+  numNative = benchPredicate("BETWEEN", schema, records, numRecords, cond);
+  freeExpr(cond);
+
+  if (numEmulated != numNative)
+    {
+      printf("[%s] FAILED: range matched %i rows, BETWEEN %i\n", benchName, numEmulated, numNative);
+      exit(1);
+    }
+
+  // a = 0 OR a = 7 OR ... OR a = 693
+  MAKE_ATTRREF(l, 0);
+  MAKE_CONS(r, stringToValue("i0"));
+  MAKE_BINOP_EXPR(cond, l, r, OP_COMP_EQUAL);
+  for(i = 1; i < 100; i++)
+    {
+      sprintf(str, "i%i", i * 7);
+      MAKE_ATTRREF(l, 0);
+      MAKE_CONS(r, stringToValue(str));
+      MAKE_BINOP_EXPR(e1, l, r, OP_COMP_EQUAL);
+      MAKE_BINOP_EXPR(e2, cond, e1, OP_BOOL_OR);
+      cond = e2;
+    }
+  numEmulated = benchPredicate("OR of 100 equalities", schema, records, numRecords, cond);
+  freeExpr(cond);
+
+  // a IN (0, 7, ..., 693)
+  for(i = 0; i < 100; i++)
+    {
+      sprintf(str, "i%i", i * 7);
+      MAKE_CONS(values[i], stringToValue(str));
+    }
+  MAKE_ATTRREF(l, 0);
+  MAKE_IN_EXPR(cond, l, values, 100);
+  numNative = benchPredicate("IN list of 100", schema, records, numRecords, cond);
+  freeExpr(cond);
+
+  if (numEmulated != numNative)
+    {
+      printf("[%s] FAILED: OR chain matched %i rows, IN %i\n", benchName, numEmulated, numNative);
+      exit(1);
+    }
+
+  freeBenchRecords(records, numRecords);
+  freeSchema(schema);
+}
+
+// ************************************************************
+void
+benchShortCircuit (int numRecords)
+{
+  Schema *schema;
+  Record *records;
+  Expr *l, *r, *wide, *narrow, *cond;
+  Value *limit;
+  int numFirst, numLast;
+  benchName = "short circuit and term reordering";
+  schema = benchSchema();
+  records = benchRecords(schema, numRecords);
+
+  // b > '0000000000000010' almost never decides, c = 3 almost always
+  MAKE_ATTRREF(l, 1);
+  MAKE_CONS(r, stringToValue("s0000000000000010"));
+  MAKE_BINOP_EXPR(wide, l, r, OP_COMP_GREATER);
+  MAKE_ATTRREF(l, 2);
+  MAKE_CONS(r, stringToValue("i3"));
+  MAKE_BINOP_EXPR(narrow, l, r, OP_COMP_EQUAL);
+  MAKE_BINOP_EXPR(cond, wide, narrow, OP_BOOL_AND);
+  numFirst = benchPredicate("string term first", schema, records, numRecords, cond);
+  free(cond->expr.op->args);
+  free(cond->expr.op);
+  free(cond);
+
+  MAKE_BINOP_EXPR(cond, narrow, wide, OP_BOOL_AND);
+  numLast = benchPredicate("string term last", schema, records, numRecords, cond);
+  freeExpr(cond);
+
+  if (numFirst != numLast)
+    {
+      printf("[%s] FAILED: string first matched %i rows, last %i\n", benchName, numFirst, numLast);
+      exit(1);
+    }
+
+  // c <> 3 AND a < numRecords / 100 have the same cost, only selectivity differs
+  MAKE_ATTRREF(l, 2);
+  MAKE_CONS(r, stringToValue("i3"));
+  MAKE_BINOP_EXPR(wide, l, r, OP_COMP_NOT_EQUAL);
+  MAKE_VALUE(limit, DT_INT, numRecords / 100);
+  MAKE_ATTRREF(l, 0);
+  MAKE_CONS(r, limit);
+  MAKE_BINOP_EXPR(narrow, l, r, OP_COMP_SMALLER);
+  MAKE_BINOP_EXPR(cond, wide, narrow, OP_BOOL_AND);
+  benchPredicate("unselective term first", schema, records, numRecords, cond);
+  freeExpr(cond);
+
+  freeBenchRecords(records, numRecords);
+  freeSchema(schema);
+}
+
+// ************************************************************
+Schema *
+benchSchema (void)
+{
+  char *names[] = { "a", "b", "c" };
+  DataType dt[] = { DT_INT, DT_STRING, DT_INT };
+  int sizes[] = { 0, 16, 0 };
+  int keys[] = {0};
+
+  return createSchema(3, names, dt, sizes, 1, keys);
+}
+
+Record *
+benchRecords (Schema *schema, int numRecords)
+{
+  Record *records = (Record *) malloc(sizeof(Record) * numRecords);
+  Value *value;
+  char buf[17];
+  int i;
+
+  for(i = 0; i < numRecords; i++)
+    {
+      records[i].data = (char *) malloc(getRecordSize(schema));
+      records[i].id.page = records[i].id.slot = -1;
+
+      MAKE_VALUE(value, DT_INT, i);
+      setAttr(&records[i], schema, 0, value);
+      freeVal(value);
+
+      sprintf(buf, "%016i", i % 1000);
+      MAKE_STRING_VALUE(value, buf);
+      setAttr(&records[i], schema, 1, value);
+      freeVal(value);
+
+      MAKE_VALUE(value, DT_INT, i % 100);
+      setAttr(&records[i], schema, 2, value);
+      freeVal(value);
+    }
+
+  return records;
+}
+
+void
+freeBenchRecords (Record *records, int numRecords)
+{
+  int i;
+
+  for(i = 0; i < numRecords; i++)
+    free(records[i].data);
+  free(records);
+}
+
+// a < numRecords / 2 AND (b = '0000000000000042' OR NOT c < 90)
+Expr *
+benchCondition (int numRecords)
+{
+  Expr *l, *r, *lt, *eq, *smaller, *ge, *or;
+  Value *half;
+  Expr *cond;
+
+  MAKE_VALUE(half, DT_INT, numRecords / 2);
+  MAKE_ATTRREF(l, 0);
+  MAKE_CONS(r, half);
+  MAKE_BINOP_EXPR(lt, l, r, OP_COMP_SMALLER);
+
+  MAKE_ATTRREF(l, 1);
+  MAKE_CONS(r, stringToValue("s0000000000000042"));
+  MAKE_BINOP_EXPR(eq, l, r, OP_COMP_EQUAL);
+
+  MAKE_ATTRREF(l, 2);
+  MAKE_CONS(r, stringToValue("i90"));
+  MAKE_BINOP_EXPR(smaller, l, r, OP_COMP_SMALLER);
+  MAKE_UNOP_EXPR(ge, smaller, OP_BOOL_NOT);
+
+  MAKE_BINOP_EXPR(or, eq, ge, OP_BOOL_OR);
+  MAKE_BINOP_EXPR(cond, lt, or, OP_BOOL_AND);
+
+  return cond;
+}
+
+// evaluate cond over all records with evalExpr and evalProgram, returns the number of matches
+int
+benchPredicate (char *label, Schema *schema, Record *records, int numRecords, Expr *cond)
+{
+  ExprProgram *prog;
+  Value *result;
+  bool match;
+  char report[64];
+  int i, numInterpreted = 0, numCompiled = 0;
+  double start, end;
+
+  BENCH_NOW(start);
+  for(i = 0; i < numRecords; i++)
+    {
+      BENCH_CHECK(evalExpr(&records[i], schema, cond, &result));
+      numInterpreted += result->v.boolV;
+      freeVal(result);
+    }
+  BENCH_NOW(end);
+  sprintf(report, "evalExpr %s", label);
+  BENCH_REPORT(report, numRecords, end - start);
+
+  BENCH_NOW(start);
+  BENCH_CHECK(compileExpr(cond, schema, &prog));
+  for(i = 0; i < numRecords; i++)
+    {
+      evalProgram(prog, records[i].data, &match);
+      numCompiled += match;
+    }
+  BENCH_CHECK(freeProgram(prog));
+  BENCH_NOW(end);
+  sprintf(report, "evalProgram %s", label);
+  BENCH_REPORT(report, numRecords, end - start);
+
+  if (numInterpreted != numCompiled)
+    {
+      printf("[%s] FAILED: evalExpr matched %i rows, evalProgram %i\n", benchName, numInterpreted, numCompiled);
+      exit(1);
+    }
+
+  return numCompiled;
+}
@@ -0,0 +1,41 @@
+#ifndef BENCH_HELPER_H
+#define BENCH_HELPER_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// var to store the current benchmark's name
+extern char *benchName;
+
+// wall clock time in seconds
+#define BENCH_NOW(_result)						\
+  do {									\
+    struct timespec _ts;						\
+    clock_gettime(CLOCK_MONOTONIC, &_ts);				\
+    (_result) = _ts.tv_sec + (_ts.tv_nsec / 1e9);			\
+  } while(0)
+
+// print the throughput of one measured operation
+#define BENCH_REPORT(label, ops, secs)					\
+  do {									\
+    double _secs = (secs);						\
+    printf("[%s] %-32s %10i ops %10.4f s %14.0f ops/s\n", benchName,	\
+	   label, (int) (ops), _secs, (_secs > 0) ? (ops) / _secs : 0.0); \
+  } while(0)
+
+// check the return code and exit if it's an error
+#define BENCH_CHECK(code)						\
+  do {									\
+    int rc_internal = (code);						\
+    if (rc_internal != RC_OK)						\
+      {									\
+	char *message = errorMessage(rc_internal);			\
+	printf("[%s-%s-L%i] FAILED: Operation returned error: %s\n", __FILE__, benchName, __LINE__, message); \
+	free(message);							\
+	exit(1);							\
+      }									\
+  } while(0)
+
+#endif // BENCH_HELPER_H
@@ -0,0 +1,639 @@
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "dberror.h"
+#include "expr.h"
+#include "record_mgr.h"
+#include "query.h"
+#include "tables.h"
+#include "bench_helper.h"
+
+// number of groups of the GROUP BY benchmarks
+#define BENCH_GROUPS 1000
+
+// int attributes of the table comparing the page layouts
+#define BENCH_WIDE_ATTRS 20
+
+// benchmark methods
+static void benchAggregate (int numRecords);
+static void benchJoins (int numRecords);
+static void benchSort (int numRecords);
+static void benchTopN (int numRecords);
+static void benchPageLayout (int numRecords);
+
+// helper methods
+Schema *benchSchema (void);
+void loadBenchTable (RM_TableData *table, Schema *schema, int numRecords, int numGroups);
+
+// benchmark name
+char *benchName;
+
+// main method, the optional argument is the number of records per table
+int
+main (int argc, char **argv)
+{
+  int numRecords = (argc > 1) ? atoi(argv[1]) : 1000000;
+  benchName = "";
+
+  benchAggregate(numRecords);
+  benchJoins(numRecords);
+  benchSort(numRecords);
+  benchTopN(numRecords);
+  benchPageLayout(numRecords);
+
+  return 0;
+}
+
+// ************************************************************
+void
+benchAggregate (int numRecords)
+{
+  RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+  RM_ScanHandle *sc = (RM_ScanHandle *) malloc(sizeof(RM_ScanHandle));
+  AggrSpec sum[] = { { AGGR_SUM, 0 } };
+  AggrSpec perGroup[] = { { AGGR_COUNT, -1 }, { AGGR_SUM, 0 } };
+  int groupBy[] = { 1 };
+  int workers[] = { 1, 4 };
+  int64_t clientSum, clientSums[BENCH_GROUPS], clientCounts[BENCH_GROUPS];
+  AggrResult *res;
+  Record *r;
+  Value *value;
+  Schema *schema;
+  double start, end;
+  char label[64];
+  int i, w, g;
+  benchName = "aggregation";
+  schema = benchSchema();
+
+  BENCH_CHECK(initRecordManager(NULL));
+  BENCH_CHECK(createTable("bench_table_a", schema));
+  BENCH_CHECK(openTable(table, "bench_table_a"));
+  loadBenchTable(table, schema, numRecords, BENCH_GROUPS);
+  BENCH_CHECK(createRecord(&r, schema));
+
+  // SELECT SUM(a): client side with next and getAttr
+  clientSum = 0;
+  BENCH_NOW(start);
+  BENCH_CHECK(startScan(table, sc, NULL));
+  while(next(sc, r) == RC_OK)
+    {
+      BENCH_CHECK(getAttr(r, schema, 0, &value));
+      clientSum += value->v.intV;
+      freeVal(value);
+    }
+  BENCH_CHECK(closeScan(sc));
+  BENCH_NOW(end);
+  BENCH_REPORT("SUM client loop rows", numRecords, end - start);
+
+  for(w = 0; w < 2; w++)
+    {
+      BENCH_NOW(start);
+      BENCH_CHECK(aggregate(table, NULL, 0, NULL, 1, sum, 0, workers[w], &res));
+      BENCH_NOW(end);
+      sprintf(label, "SUM aggregate rows (%i workers)", workers[w]);
+      BENCH_REPORT(label, numRecords, end - start);
+      if (AGGR_VALUE(res, 0, 0).intV != clientSum)
+	{
+	  printf("[%s] FAILED: SUM is %lli, client loop %lli\n", benchName,
+		 (long long) AGGR_VALUE(res, 0, 0).intV, (long long) clientSum);
+	  exit(1);
+	}
+      BENCH_CHECK(freeAggrResult(res));
+    }
+
+  // SELECT g, COUNT(*), SUM(a) GROUP BY g: client side into an array indexed by g
+  memset(clientSums, 0, sizeof(clientSums));
+  memset(clientCounts, 0, sizeof(clientCounts));
+  BENCH_NOW(start);
+  BENCH_CHECK(startScan(table, sc, NULL));
+  while(next(sc, r) == RC_OK)
+    {
+      BENCH_CHECK(getAttr(r, schema, 1, &value));
+      g = value->v.intV;
+      freeVal(value);
+      BENCH_CHECK(getAttr(r, schema, 0, &value));
+      clientSums[g] += value->v.intV;
+      clientCounts[g]++;
+      freeVal(value);
+    }
+  BENCH_CHECK(closeScan(sc));
+  BENCH_NOW(end);
+  BENCH_REPORT("GROUP BY client loop rows", numRecords, end - start);
+
+  for(w = 0; w < 2; w++)
+    {
+      BENCH_NOW(start);
+      BENCH_CHECK(aggregate(table, NULL, 1, groupBy, 2, perGroup, BENCH_GROUPS, workers[w], &res));
+      BENCH_NOW(end);
+      sprintf(label, "GROUP BY aggregate rows (%i workers)", workers[w]);
+      BENCH_REPORT(label, numRecords, end - start);
+      for(i = 0; i < res->numGroups; i++)
+	{
+	  BENCH_CHECK(getGroupAttr(res, i, 0, &value));
+	  g = value->v.intV;
+	  freeVal(value);
+	  if (AGGR_VALUE(res, i, 0).intV != clientCounts[g] || AGGR_VALUE(res, i, 1).intV != clientSums[g])
+	    {
+	      printf("[%s] FAILED: group %i differs from the client loop\n", benchName, g);
+	      exit(1);
+	    }
+	}
+      BENCH_CHECK(freeAggrResult(res));
+    }
+
+  BENCH_CHECK(freeRecord(r));
+  BENCH_CHECK(closeTable(table));
+  BENCH_CHECK(deleteTable("bench_table_a"));
+  BENCH_CHECK(shutdownRecordManager());
+
+  freeSchema(schema);
+  free(sc);
+  free(table);
+}
+
+// ************************************************************
+static RC
+countJoinPair (void *context, Record *left, Record *right)
+{
+  (void) left;
+  (void) right;
+  (*(long *) context)++;
+  return RC_OK;
+}
+
+void
+benchJoins (int numRecords)
+{
+  RM_TableData *left = (RM_TableData *) malloc(sizeof(RM_TableData));
+  RM_TableData *right = (RM_TableData *) malloc(sizeof(RM_TableData));
+  RM_ScanHandle *outer = (RM_ScanHandle *) malloc(sizeof(RM_ScanHandle));
+  RM_ScanHandle *inner = (RM_ScanHandle *) malloc(sizeof(RM_ScanHandle));
+  int numLeft = numRecords / 10, numOuter = 20, i;
+  int onA[] = { 0 };
+  int onG[] = { 1 };
+  long numPairs, numHash;
+  Record *l, *r;
+  Value *value;
+  Expr *cond, *attr, *cons;
+  Schema *schema;
+  double start, end;
+  char label[64];
+  benchName = "joins";
+  schema = benchSchema();
+
+  // g of right joins a of left, every left tuple matches ten right ones
+  BENCH_CHECK(initRecordManager(NULL));
+  BENCH_CHECK(createTable("bench_table_jl", schema));
+  BENCH_CHECK(openTable(left, "bench_table_jl"));
+  BENCH_CHECK(createTable("bench_table_jr", schema));
+  BENCH_CHECK(openTable(right, "bench_table_jr"));
+  loadBenchTable(left, schema, numLeft, BENCH_GROUPS);
+  loadBenchTable(right, schema, numRecords, numLeft);
+  BENCH_CHECK(createRecord(&l, schema));
+  BENCH_CHECK(createRecord(&r, schema));
+
+  // nested scans, as clients join today, for the first numOuter tuples of left
+  numPairs = 0;
+  BENCH_NOW(start);
+  BENCH_CHECK(startScan(left, outer, NULL));
+  for(i = 0; i < numOuter && next(outer, l) == RC_OK; i++)
+    {
+      BENCH_CHECK(getAttr(l, schema, 0, &value));
+      MAKE_ATTRREF(attr, 1);
+      MAKE_CONS(cons, value);
+      MAKE_BINOP_EXPR(cond, attr, cons, OP_COMP_EQUAL);
+      BENCH_CHECK(startScan(right, inner, cond));
+      while(next(inner, r) == RC_OK)
+	numPairs++;
+      BENCH_CHECK(closeScan(inner));
+      freeExpr(cond);
+    }
+  BENCH_CHECK(closeScan(outer));
+  BENCH_NOW(end);
+  sprintf(label, "nested scans, %i outer tuples", numOuter);
+  BENCH_REPORT(label, numOuter, end - start);
+
+  numHash = 0;
+  BENCH_NOW(start);
+  BENCH_CHECK(hashJoin(left, right, 1, onA, onG, 0, countJoinPair, &numHash));
+  BENCH_NOW(end);
+  sprintf(label, "hash join, %i x %i rows", numLeft, numRecords);
+  BENCH_REPORT(label, numLeft + numRecords, end - start);
+  if (numHash != numRecords)
+    {
+      printf("[%s] FAILED: hash join returned %li pairs, expected %i\n", benchName, numHash, numRecords);
+      exit(1);
+    }
+
+  numPairs = 0;
+  BENCH_NOW(start);
+  BENCH_CHECK(hashJoin(left, right, 1, onA, onG, (long) numLeft * 8, countJoinPair, &numPairs));
+  BENCH_NOW(end);
+  BENCH_REPORT("hash join, spilling partitions", numLeft + numRecords, end - start);
+  if (numPairs != numHash)
+    {
+      printf("[%s] FAILED: partitioned hash join returned %li pairs, expected %li\n", benchName, numPairs, numHash);
+      exit(1);
+    }
+
+  numPairs = 0;
+  BENCH_NOW(start);
+  BENCH_CHECK(sortMergeJoin(left, right, 1, onA, onG, countJoinPair, &numPairs));
+  BENCH_NOW(end);
+  BENCH_REPORT("sort-merge join", numLeft + numRecords, end - start);
+  if (numPairs != numHash)
+    {
+      printf("[%s] FAILED: sort-merge join returned %li pairs, expected %li\n", benchName, numPairs, numHash);
+      exit(1);
+    }
+
+  BENCH_CHECK(freeRecord(l));
+  BENCH_CHECK(freeRecord(r));
+  BENCH_CHECK(closeTable(left));
+  BENCH_CHECK(closeTable(right));
+  BENCH_CHECK(deleteTable("bench_table_jl"));
+  BENCH_CHECK(deleteTable("bench_table_jr"));
+  BENCH_CHECK(shutdownRecordManager());
+
+  freeSchema(schema);
+  free(outer);
+  free(inner);
+  free(left);
+  free(right);
+}
+
+// ************************************************************
+// client side comparison of two records by g
+static Schema *sortSchema;
+
+static int
+compareOnG (const void *left, const void *right)
+{
+  Record l, r;
+  Value *lv, *rv;
+  int cmp;
+
+  l.data = *(char **) left;
+  r.data = *(char **) right;
+  getAttr(&l, sortSchema, 1, &lv);
+  getAttr(&r, sortSchema, 1, &rv);
+  cmp = (lv->v.intV > rv->v.intV) - (lv->v.intV < rv->v.intV);
+  freeVal(lv);
+  freeVal(rv);
+  return cmp;
+}
+
+void
+benchSort (int numRecords)
+{
+  RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+  RM_ScanHandle *sc = (RM_ScanHandle *) malloc(sizeof(RM_ScanHandle));
+  RM_SortHandle sort;
+  RM_SortStats stats;
+  long budgets[] = { 0, 16L * 1024 * 1024, 1024 * 1024 };
+  char **rows = (char **) malloc(sizeof(char *) * numRecords);
+  int onG[] = { 1 };
+  int i, n, g, prev;
+  Record *r;
+  Schema *schema;
+  double start, end;
+  char label[64];
+  benchName = "sort";
+  schema = benchSchema();
+  sortSchema = schema;
+
+  BENCH_CHECK(initRecordManager(NULL));
+  BENCH_CHECK(createTable("bench_table_s", schema));
+  BENCH_CHECK(openTable(table, "bench_table_s"));
+  loadBenchTable(table, schema, numRecords, BENCH_GROUPS);
+  BENCH_CHECK(createRecord(&r, schema));
+
+  // ORDER BY g: client side, copying the records and sorting them with qsort
+  BENCH_NOW(start);
+  BENCH_CHECK(startScan(table, sc, NULL));
+  for(n = 0; n < numRecords && next(sc, r) == RC_OK; n++)
+    {
+      rows[n] = (char *) malloc(getRecordSize(schema));
+      memcpy(rows[n], r->data, getRecordSize(schema));
+    }
+  BENCH_CHECK(closeScan(sc));
+  qsort(rows, n, sizeof(char *), compareOnG);
+  BENCH_NOW(end);
+  BENCH_REPORT("client qsort rows", n, end - start);
+  for(i = 0; i < n; i++)
+    free(rows[i]);
+
+  for(i = 0; i < 3; i++)
+    {
+      BENCH_NOW(start);
+      BENCH_CHECK(startScan(table, sc, NULL));
+      BENCH_CHECK(startSort(sc, 1, onG, budgets[i], &sort));
+      BENCH_CHECK(closeScan(sc));
+      for(n = 0, prev = 0; nextSorted(&sort, r) == RC_OK; n++)
+	{
+	  getIntAttr(r, schema, 1, &g);
+	  if (g < prev)
+	    {
+	      printf("[%s] FAILED: tuple %i out of order\n", benchName, n);
+	      exit(1);
+	    }
+	  prev = g;
+	}
+      BENCH_NOW(end);
+      BENCH_CHECK(getSortStats(&sort, &stats));
+      BENCH_CHECK(closeSort(&sort));
+      if (budgets[i] == 0)
+	sprintf(label, "sort rows, in memory");
+      else
+	sprintf(label, "sort rows, %li KB budget", budgets[i] / 1024);
+      BENCH_REPORT(label, n, end - start);
+      printf("[%s] %i runs, %i merge passes, %.1f MB written, %.1f MB read\n", benchName,
+	     stats.numRuns, stats.numMergePasses, stats.bytesWritten / 1048576.0, stats.bytesRead / 1048576.0);
+    }
+
+  BENCH_CHECK(freeRecord(r));
+  BENCH_CHECK(closeTable(table));
+  BENCH_CHECK(deleteTable("bench_table_s"));
+  BENCH_CHECK(shutdownRecordManager());
+
+  freeSchema(schema);
+  free(rows);
+  free(sc);
+  free(table);
+}
+
+// ************************************************************
+// client side comparison of two records by g, then a
+static int
+compareOnGA (const void *left, const void *right)
+{
+  int cmp = compareOnG(left, right), l, r;
+  Record lr, rr;
+
+  if (cmp != 0)
+    return cmp;
+  lr.data = *(char **) left;
+  rr.data = *(char **) right;
+  getIntAttr(&lr, sortSchema, 0, &l);
+  getIntAttr(&rr, sortSchema, 0, &r);
+  return (l > r) - (l < r);
+}
+
+// latency of WHERE g >= 500 ORDER BY g, a LIMIT 100, every query counts as one op
+void
+benchTopN (int numRecords)
+{
+  RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+  RM_ScanHandle *sc = (RM_ScanHandle *) malloc(sizeof(RM_ScanHandle));
+  RM_RecordBatch *batch;
+  RM_SortHandle sort;
+  char **rows = (char **) malloc(sizeof(char *) * numRecords);
+  int onGA[] = { 1, 0 };
+  int limit = 100, i, n, a, first[100];
+  Record *r;
+  Value *value;
+  Expr *cond, *attr, *cons;
+  Schema *schema;
+  double start, end;
+  benchName = "top-n";
+  schema = benchSchema();
+  sortSchema = schema;
+
+  BENCH_CHECK(initRecordManager(NULL));
+  BENCH_CHECK(createTable("bench_table_t", schema));
+  BENCH_CHECK(openTable(table, "bench_table_t"));
+  loadBenchTable(table, schema, numRecords, BENCH_GROUPS);
+  BENCH_CHECK(createRecord(&r, schema));
+  MAKE_VALUE(value, DT_INT, BENCH_GROUPS / 2);
+  MAKE_ATTRREF(attr, 1);
+  MAKE_CONS(cons, value);
+  MAKE_BINOP_EXPR(cond, attr, cons, OP_COMP_GREATER_EQUAL);
+
+  // client side: every matching record copied and sorted
+  BENCH_NOW(start);
+  BENCH_CHECK(startScan(table, sc, cond));
+  for(n = 0; n < numRecords && next(sc, r) == RC_OK; n++)
+    {
+      rows[n] = (char *) malloc(getRecordSize(schema));
+      memcpy(rows[n], r->data, getRecordSize(schema));
+    }
+  BENCH_CHECK(closeScan(sc));
+  qsort(rows, n, sizeof(char *), compareOnGA);
+  for(i = 0; i < limit && i < n; i++)
+    {
+      Record row;
+      row.data = rows[i];
+      getIntAttr(&row, schema, 0, &first[i]);
+    }
+  BENCH_NOW(end);
+  BENCH_REPORT("client qsort, LIMIT 100", 1, end - start);
+  for(i = 0; i < n; i++)
+    free(rows[i]);
+
+  // full sort, first 100 tuples
+  BENCH_NOW(start);
+  BENCH_CHECK(startScan(table, sc, cond));
+  BENCH_CHECK(startSort(sc, 2, onGA, 0, &sort));
+  BENCH_CHECK(closeScan(sc));
+  for(i = 0; i < limit && nextSorted(&sort, r) == RC_OK; i++)
+    ;
+  BENCH_CHECK(closeSort(&sort));
+  BENCH_NOW(end);
+  BENCH_REPORT("startSort, LIMIT 100", 1, end - start);
+
+  BENCH_NOW(start);
+  BENCH_CHECK(startScan(table, sc, cond));
+  BENCH_CHECK(startTopN(sc, 2, onGA, limit, &sort));
+  BENCH_CHECK(closeScan(sc));
+  for(i = 0; nextSorted(&sort, r) == RC_OK; i++)
+    {
+      getIntAttr(r, schema, 0, &a);
+      if (i >= limit || a != first[i])
+	{
+	  printf("[%s] FAILED: tuple %i differs from the client sort\n", benchName, i);
+	  exit(1);
+	}
+    }
+  BENCH_CHECK(closeSort(&sort));
+  BENCH_NOW(end);
+  BENCH_REPORT("startTopN, LIMIT 100", 1, end - start);
+
+  // WHERE g >= 500 LIMIT 100 read by a consumer draining the scan in batches
+  BENCH_CHECK(createRecordBatch(&batch, schema, 1024));
+  BENCH_NOW(start);
+  BENCH_CHECK(startScan(table, sc, cond));
+  for(n = 0; nextBatch(sc, batch) == RC_OK; n += batch->numSelected)
+    ;
+  BENCH_CHECK(closeScan(sc));
+  BENCH_NOW(end);
+  BENCH_REPORT("batches without LIMIT", 1, end - start);
+
+  BENCH_NOW(start);
+  BENCH_CHECK(startScan(table, sc, cond));
+  BENCH_CHECK(setScanLimit(sc, limit));
+  for(n = 0; nextBatch(sc, batch) == RC_OK; n += batch->numSelected)
+    ;
+  BENCH_CHECK(closeScan(sc));
+  BENCH_NOW(end);
+  BENCH_REPORT("batches, LIMIT 100 pushed down", 1, end - start);
+  if (n != limit)
+    {
+      printf("[%s] FAILED: %i tuples returned with LIMIT %i\n", benchName, n, limit);
+      exit(1);
+    }
+  BENCH_CHECK(freeRecordBatch(batch));
+
+  BENCH_CHECK(freeRecord(r));
+  BENCH_CHECK(closeTable(table));
+  BENCH_CHECK(deleteTable("bench_table_t"));
+  BENCH_CHECK(shutdownRecordManager());
+
+  freeExpr(cond);
+  freeSchema(schema);
+  free(rows);
+  free(sc);
+  free(table);
+}
+
+// ************************************************************
+void
+benchPageLayout (int numRecords)
+{
+  RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+  char *names[BENCH_WIDE_ATTRS];
+  DataType dt[BENCH_WIDE_ATTRS];
+  int sizes[BENCH_WIDE_ATTRS];
+  int keys[] = {0};
+  RM_PageLayout layouts[] = { RM_LAYOUT_ROW, RM_LAYOUT_PAX };
+  char *layoutNames[] = { "row", "PAX" };
+  AggrSpec perGroup[] = { { AGGR_COUNT, -1 }, { AGGR_SUM, 0 } };
+  int groupBy[] = { 1 };
+  int64_t count, prevCount = -1;
+  Record *records;
+  AggrResult *res;
+  Schema *schema;
+  Expr *sel, *left, *right;
+  double start, end;
+  char label[64];
+  int i, j, n, l, a, g;
+  benchName = "page layout";
+
+  // c0 = 0..numRecords-1, c1 = c0 % BENCH_GROUPS, c2 = c0 % 100, the others padding
+  for(a = 0; a < BENCH_WIDE_ATTRS; a++)
+    {
+      names[a] = (char *) malloc(4);
+      sprintf(names[a], "c%i", a);
+      dt[a] = DT_INT;
+      sizes[a] = 0;
+    }
+  schema = createSchema(BENCH_WIDE_ATTRS, names, dt, sizes, 1, keys);
+  records = (Record *) malloc(sizeof(Record) * 4096);
+  for(j = 0; j < 4096; j++)
+    records[j].data = (char *) malloc(getRecordSize(schema));
+
+  // SELECT c1, COUNT(*), SUM(c0) WHERE c2 < 10 GROUP BY c1: 3 of 20 attributes
+  MAKE_ATTRREF(left, 2);
+  MAKE_CONS(right, stringToValue("i10"));
+  MAKE_BINOP_EXPR(sel, left, right, OP_COMP_SMALLER);
+
+  BENCH_CHECK(initRecordManager(NULL));
+  for(l = 0; l < 2; l++)
+    {
+      BENCH_CHECK(createTableWithLayout("bench_table_l", schema, layouts[l]));
+      BENCH_CHECK(openTable(table, "bench_table_l"));
+
+      BENCH_NOW(start);
+      for(i = 0; i < numRecords; i += n)
+	{
+	  n = (numRecords - i < 4096) ? numRecords - i : 4096;
+	  for(j = 0; j < n; j++)
+	    for(a = 0; a < BENCH_WIDE_ATTRS; a++)
+	      {
+		int v = (a == 1) ? (i + j) % BENCH_GROUPS : (a == 2) ? (i + j) % 100 : i + j;
+		memcpy(records[j].data + (a * sizeof(int)), &v, sizeof(int));
+	      }
+	  BENCH_CHECK(insertRecords(table, records, n));
+	}
+      BENCH_NOW(end);
+      sprintf(label, "insert rows (%s)", layoutNames[l]);
+      BENCH_REPORT(label, numRecords, end - start);
+
+      BENCH_NOW(start);
+      BENCH_CHECK(aggregate(table, sel, 1, groupBy, 2, perGroup, BENCH_GROUPS, 1, &res));
+      BENCH_NOW(end);
+      sprintf(label, "3 of 20 attributes rows (%s)", layoutNames[l]);
+      BENCH_REPORT(label, numRecords, end - start);
+      count = 0;
+      for(g = 0; g < res->numGroups; g++)
+	count += AGGR_VALUE(res, g, 0).intV;
+      if (prevCount >= 0 && count != prevCount)
+	{
+	  printf("[%s] FAILED: the layouts aggregate %lli and %lli tuples\n", benchName,
+		 (long long) prevCount, (long long) count);
+	  exit(1);
+	}
+      prevCount = count;
+      BENCH_CHECK(freeAggrResult(res));
+
+      // bytes of a page the query reads per tuple: the whole slot, or the
+      // TOMBSTONE and the 3 attributes from their minipages
+      printf("[%s] %-32s %10i bytes\n", benchName, (l == 0) ? "page bytes read per tuple (row)" : "page bytes read per tuple (PAX)",
+	     (l == 0) ? getRecordSize(schema) + 1 : 1 + (3 * (int) sizeof(int)));
+
+      BENCH_CHECK(closeTable(table));
+      BENCH_CHECK(deleteTable("bench_table_l"));
+    }
+  BENCH_CHECK(shutdownRecordManager());
+
+  for(j = 0; j < 4096; j++)
+    free(records[j].data);
+  free(records);
+  freeExpr(sel);
+  freeSchema(schema);
+  free(table);
+}
+
+// ************************************************************
+Schema *
+benchSchema (void)
+{
+  char *names[] = { "a", "g", "v" };
+  DataType dt[] = { DT_INT, DT_INT, DT_FLOAT };
+  int sizes[] = { 0, 0, 0 };
+  int keys[] = {0};
+
+  return createSchema(3, names, dt, sizes, 1, keys);
+}
+
+// records a = 0..numRecords-1, g = a % numGroups, v = a / 2
+void
+loadBenchTable (RM_TableData *table, Schema *schema, int numRecords, int numGroups)
+{
+  Record *records = (Record *) malloc(sizeof(Record) * 4096);
+  Value *value;
+  int i, j, n;
+
+  for(j = 0; j < 4096; j++)
+    records[j].data = (char *) malloc(getRecordSize(schema));
+
+  for(i = 0; i < numRecords; i += n)
+    {
+      n = (numRecords - i < 4096) ? numRecords - i : 4096;
+      for(j = 0; j < n; j++)
+	{
+	  MAKE_VALUE(value, DT_INT, i + j);
+	  setAttr(&records[j], schema, 0, value);
+	  value->v.intV = (i + j) % numGroups;
+	  setAttr(&records[j], schema, 1, value);
+	  freeVal(value);
+	  MAKE_VALUE(value, DT_FLOAT, (i + j) / 2.0);
+	  setAttr(&records[j], schema, 2, value);
+	  freeVal(value);
+	}
+      BENCH_CHECK(insertRecords(table, records, n));
+    }
+
+  for(j = 0; j < 4096; j++)
+    free(records[j].data);
+  free(records);
+}
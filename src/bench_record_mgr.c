@@ -0,0 +1,1555 @@
+#include <stdlib.h>
+#include <pthread.h>
+#include <unistd.h>
+#include "dberror.h"
+#include "expr.h"
+#include "record_mgr.h"
+#include "tables.h"
+#include "storage_mgr.h"
+#include "buffer_mgr_stat.h"
+#include "bench_helper.h"
+
+// benchmark methods
+static void benchBatchRecords (int numRecords);
+static void benchBatchScans (int numRecords);
+static void benchAttrAccess (int numRecords);
+static void benchRecordOverhead (int numRecords);
+static void benchScanViews (int numRecords);
+static void benchParallelScan (int numRecords);
+static void benchCompression (int numRecords);
+static void benchZoneMaps (int numRecords);
+static void benchBloomFilters (int numRecords);
+static void benchCompaction (int numRecords);
+static void benchSparseScans (int numRecords);
+static void benchSharedPool (int numRecords);
+static void benchTableOptions (int numRecords);
+static void benchOnlineResize (int numRecords);
+static void benchPoolStats (int numRecords);
+
+// helper methods
+Schema *benchSchema (void);
+Record *benchRecords (Schema *schema, int numRecords);
+void freeBenchRecords (Record *records, int numRecords);
+void shuffleRids (RID *rids, int numRids);
+void loadBenchTable (RM_TableData *table, Schema *schema, int numRecords);
+Expr *benchCondition (int numRecords);
+
+// benchmark name
+char *benchName;
+
+// main method, the optional argument is the number of records per table
+int
+main (int argc, char **argv)
+{
+  int numRecords = (argc > 1) ? atoi(argv[1]) : 16384;
+  benchName = "";
+
+  benchBatchRecords(numRecords);
+  benchBatchScans(numRecords);
+  benchAttrAccess(numRecords);
+  benchRecordOverhead(numRecords);
+  benchScanViews(numRecords);
+  benchParallelScan(numRecords);
+  benchCompression(numRecords);
+  benchZoneMaps(numRecords);
+  benchBloomFilters(numRecords);
+  benchCompaction(numRecords);
+  benchSparseScans(numRecords);
+  benchSharedPool(numRecords);
+  benchTableOptions(numRecords);
+  benchOnlineResize(numRecords);
+  benchPoolStats(numRecords);
+
+  return 0;
+}
+
+// ************************************************************
+void
+benchBatchRecords (int numRecords)
+{
+  RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+  int batchSizes[] = { 0, 1, 16, 256, 4096 };
+  int numBatchSizes = 5, b, i, n;
+  Record *records, *reads;
+  RID *rids;
+  Schema *schema;
+  double start, end;
+  char label[64];
+  benchName = "batched record handling";
+  schema = benchSchema();
+  records = benchRecords(schema, numRecords);
+  reads = benchRecords(schema, numRecords);
+  rids = (RID *) malloc(sizeof(RID) * numRecords);
+
+  BENCH_CHECK(initRecordManager(NULL));
+
+  // batch size 0 is the single record interface
+  for(b = 0; b < numBatchSizes; b++)
+    {
+      int batch = batchSizes[b];
+
+      BENCH_CHECK(createTable("bench_table_b", schema));
+      BENCH_CHECK(openTable(table, "bench_table_b"));
+
+      BENCH_NOW(start);
+      for(i = 0; i < numRecords; i += n)
+	{
+	  n = (batch == 0) ? 1 : ((numRecords - i < batch) ? numRecords - i : batch);
+	  if (batch == 0)
+	    BENCH_CHECK(insertRecord(table, &records[i]));
+	  else
+	    BENCH_CHECK(insertRecords(table, &records[i], n));
+	}
+      BENCH_NOW(end);
+      sprintf(label, (batch == 0) ? "insertRecord" : "insertRecords (batch %i)", batch);
+      BENCH_REPORT(label, numRecords, end - start);
+
+      for(i = 0; i < numRecords; i++)
+	rids[i] = records[i].id;
+      shuffleRids(rids, numRecords);
+
+      BENCH_NOW(start);
+      for(i = 0; i < numRecords; i += n)
+	{
+	  n = (batch == 0) ? 1 : ((numRecords - i < batch) ? numRecords - i : batch);
+	  if (batch == 0)
+	    BENCH_CHECK(getRecord(table, rids[i], &reads[i]));
+	  else
+	    BENCH_CHECK(getRecords(table, &rids[i], n, &reads[i]));
+	}
+      BENCH_NOW(end);
+      sprintf(label, (batch == 0) ? "getRecord" : "getRecords (batch %i)", batch);
+      BENCH_REPORT(label, numRecords, end - start);
+
+      BENCH_NOW(start);
+      for(i = 0; i < numRecords; i += n)
+	{
+	  n = (batch == 0) ? 1 : ((numRecords - i < batch) ? numRecords - i : batch);
+	  if (batch == 0)
+	    BENCH_CHECK(deleteRecord(table, rids[i]));
+	  else
+	    BENCH_CHECK(deleteRecords(table, &rids[i], n));
+	}
+      BENCH_NOW(end);
+      sprintf(label, (batch == 0) ? "deleteRecord" : "deleteRecords (batch %i)", batch);
+      BENCH_REPORT(label, numRecords, end - start);
+
+      BENCH_CHECK(closeTable(table));
+      BENCH_CHECK(deleteTable("bench_table_b"));
+    }
+
+  BENCH_CHECK(shutdownRecordManager());
+
+  freeBenchRecords(records, numRecords);
+  freeBenchRecords(reads, numRecords);
+  free(rids);
+  free(table);
+  freeSchema(schema);
+}
+
+// ************************************************************
+void
+benchBatchScans (int numRecords)
+{
+  RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+  RM_ScanHandle *sc = (RM_ScanHandle *) malloc(sizeof(RM_ScanHandle));
+  RM_RecordBatch *batch;
+  Record *r;
+  Schema *schema;
+  Expr *cond;
+  int numNext = 0, numBatch = 0;
+  double start, end;
+  benchName = "batched scans";
+  schema = benchSchema();
+  cond = benchCondition(numRecords);
+
+  BENCH_CHECK(initRecordManager(NULL));
+  BENCH_CHECK(createTable("bench_table_s", schema));
+  BENCH_CHECK(openTable(table, "bench_table_s"));
+  loadBenchTable(table, schema, numRecords);
+
+  BENCH_CHECK(createRecord(&r, schema));
+  BENCH_NOW(start);
+  BENCH_CHECK(startScan(table, sc, cond));
+  while(next(sc, r) == RC_OK)
+    numNext++;
+  BENCH_CHECK(closeScan(sc));
+  BENCH_NOW(end);
+  BENCH_REPORT("next rows", numRecords, end - start);
+
+  BENCH_CHECK(createRecordBatch(&batch, schema, 1024));
+  BENCH_NOW(start);
+  BENCH_CHECK(startScan(table, sc, cond));
+  while(nextBatch(sc, batch) == RC_OK)
+    numBatch += batch->numSelected;
+  BENCH_CHECK(closeScan(sc));
+  BENCH_NOW(end);
+  BENCH_REPORT("nextBatch rows (batch 1024)", numRecords, end - start);
+
+  if (numNext != numBatch)
+    {
+      printf("[%s] FAILED: next matched %i rows, nextBatch %i\n", benchName, numNext, numBatch);
+      exit(1);
+    }
+
+  BENCH_CHECK(freeRecordBatch(batch));
+  BENCH_CHECK(freeRecord(r));
+  BENCH_CHECK(closeTable(table));
+  BENCH_CHECK(deleteTable("bench_table_s"));
+  BENCH_CHECK(shutdownRecordManager());
+
+  freeExpr(cond);
+  freeSchema(schema);
+  free(sc);
+  free(table);
+}
+
+// ************************************************************
+void
+benchAttrAccess (int numRecords)
+{
+  Schema *schema;
+  Record *records;
+  Value *value;
+  RM_StringView view;
+  long sumGetAttr = 0, sumView = 0;
+  int i, a, c;
+  double start, end;
+  benchName = "attribute access";
+  schema = benchSchema();
+  records = benchRecords(schema, numRecords);
+
+  // read all three attributes of every record
+  BENCH_NOW(start);
+  for(i = 0; i < numRecords; i++)
+    {
+      BENCH_CHECK(getAttr(&records[i], schema, 0, &value));
+      sumGetAttr += value->v.intV;
+      freeVal(value);
+      BENCH_CHECK(getAttr(&records[i], schema, 1, &value));
+      sumGetAttr += value->v.stringV[15] + strlen(value->v.stringV);
+      freeVal(value);
+      BENCH_CHECK(getAttr(&records[i], schema, 2, &value));
+      sumGetAttr += value->v.intV;
+      freeVal(value);
+    }
+  BENCH_NOW(end);
+  BENCH_REPORT("getAttr reads", 3 * numRecords, end - start);
+
+  BENCH_NOW(start);
+  for(i = 0; i < numRecords; i++)
+    {
+      BENCH_CHECK(getIntAttr(&records[i], schema, 0, &a));
+      BENCH_CHECK(getStringAttr(&records[i], schema, 1, &view));
+      BENCH_CHECK(getIntAttr(&records[i], schema, 2, &c));
+      sumView += a + view.data[15] + view.length + c;
+    }
+  BENCH_NOW(end);
+  BENCH_REPORT("typed accessor reads", 3 * numRecords, end - start);
+
+  if (sumGetAttr != sumView)
+    {
+      printf("[%s] FAILED: getAttr read %li, typed accessors %li\n", benchName, sumGetAttr, sumView);
+      exit(1);
+    }
+
+  freeBenchRecords(records, numRecords);
+  freeSchema(schema);
+}
+
+// ************************************************************
+void
+benchRecordOverhead (int numRecords)
+{
+  RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+  char *names[48];
+  DataType dt[48];
+  int sizes[48];
+  int keys[] = {0};
+  Schema *schema;
+  Record *r;
+  Value *value;
+  RID *rids;
+  long sum = 0;
+  int i, a, numAttr = 48;
+  double start, end;
+  benchName = "per record overhead (48 attributes)";
+
+  for(i = 0; i < numAttr; i++)
+    {
+      names[i] = "x";
+      dt[i] = DT_INT;
+      sizes[i] = 0;
+    }
+  schema = createSchema(numAttr, names, dt, sizes, 1, keys);
+  rids = (RID *) malloc(sizeof(RID) * numRecords);
+  BENCH_CHECK(createRecord(&r, schema));
+
+  BENCH_CHECK(initRecordManager(NULL));
+  BENCH_CHECK(createTable("bench_table_o", schema));
+  BENCH_CHECK(openTable(table, "bench_table_o"));
+
+  // attribute access, the last attribute is furthest from the record start
+  MAKE_VALUE(value, DT_INT, 0);
+  BENCH_NOW(start);
+  for(i = 0; i < numRecords; i++)
+    {
+      value->v.intV = i;
+      BENCH_CHECK(setAttr(r, schema, numAttr - 1, value));
+    }
+  BENCH_NOW(end);
+  BENCH_REPORT("setAttr", numRecords, end - start);
+  freeVal(value);
+
+  BENCH_NOW(start);
+  for(i = 0; i < numRecords; i++)
+    {
+      BENCH_CHECK(getAttr(r, schema, numAttr - 1, &value));
+      sum += value->v.intV - (numRecords - 1);
+      freeVal(value);
+    }
+  BENCH_NOW(end);
+  BENCH_REPORT("getAttr", numRecords, end - start);
+
+  for(i = 0; i < numRecords; i++)
+    {
+      MAKE_VALUE(value, DT_INT, i);
+      BENCH_CHECK(setAttr(r, schema, numAttr - 1, value));
+      freeVal(value);
+      BENCH_CHECK(insertRecord(table, r));
+      rids[i] = r->id;
+    }
+
+  // record access through the buffer pool, all pages are cached
+  BENCH_NOW(start);
+  for(i = 0; i < numRecords; i++)
+    {
+      BENCH_CHECK(getRecord(table, rids[i], r));
+      BENCH_CHECK(getIntAttr(r, schema, numAttr - 1, &a));
+      sum += a;
+    }
+  BENCH_NOW(end);
+  BENCH_REPORT("getRecord", numRecords, end - start);
+
+  if (sum != ((long) numRecords * (numRecords - 1)) / 2)
+    {
+      printf("[%s] FAILED: read back %li\n", benchName, sum);
+      exit(1);
+    }
+
+  BENCH_CHECK(freeRecord(r));
+  BENCH_CHECK(closeTable(table));
+  BENCH_CHECK(deleteTable("bench_table_o"));
+  BENCH_CHECK(shutdownRecordManager());
+
+  freeSchema(schema);
+  free(rids);
+  free(table);
+}
+
+// ************************************************************
+void
+benchScanViews (int numRecords)
+{
+  RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+  RM_ScanHandle *sc = (RM_ScanHandle *) malloc(sizeof(RM_ScanHandle));
+  char *names[] = { "a", "b", "c" };
+  DataType dt[] = { DT_INT, DT_STRING, DT_INT };
+  int sizes[] = { 0, 1000, 0 };
+  int keys[] = {0};
+  Schema *schema;
+  Record *records, *r, view;
+  Expr *cond, *l, *rr;
+  Value *value;
+  int i, j, k, n, numCopied, numViews;
+  double start, end;
+  benchName = "scan views (1008 byte records)";
+
+  schema = createSchema(3, names, dt, sizes, 1, keys);
+  BENCH_CHECK(initRecordManager(NULL));
+  BENCH_CHECK(createTable("bench_table_v", schema));
+  BENCH_CHECK(openTable(table, "bench_table_v"));
+
+  records = (Record *) malloc(sizeof(Record) * 256);
+  for(j = 0; j < 256; j++)
+    {
+      records[j].data = (char *) calloc(1, getRecordSize(schema));
+      memset(records[j].data + 4, 'x', 1000);
+    }
+  for(i = 0; i < numRecords; i += n)
+    {
+      n = (numRecords - i < 256) ? numRecords - i : 256;
+      for(j = 0; j < n; j++)
+	{
+	  MAKE_VALUE(value, DT_INT, i + j);
+	  setAttr(&records[j], schema, 0, value);
+	  value->v.intV = (i + j) % 100;
+	  setAttr(&records[j], schema, 2, value);
+	  freeVal(value);
+	}
+      BENCH_CHECK(insertRecords(table, records, n));
+    }
+  freeBenchRecords(records, 256);
+
+  // c = 3
+  MAKE_ATTRREF(l, 2);
+  MAKE_CONS(rr, stringToValue("i3"));
+  MAKE_BINOP_EXPR(cond, l, rr, OP_COMP_EQUAL);
+
+  BENCH_CHECK(createRecord(&r, schema));
+  for(k = 0; k < 2; k++)
+    {
+      Expr *c = k ? NULL : cond;
+
+      numCopied = 0;
+      BENCH_NOW(start);
+      BENCH_CHECK(startScan(table, sc, c));
+      while(next(sc, r) == RC_OK)
+	numCopied++;
+      BENCH_CHECK(closeScan(sc));
+      BENCH_NOW(end);
+      BENCH_REPORT(k ? "next rows (full scan)" : "next rows (c = 3)", numRecords, end - start);
+
+      numViews = 0;
+      BENCH_NOW(start);
+      BENCH_CHECK(startScan(table, sc, c));
+      while(nextView(sc, &view) == RC_OK)
+	numViews++;
+      BENCH_CHECK(closeScan(sc));
+      BENCH_NOW(end);
+      BENCH_REPORT(k ? "nextView rows (full scan)" : "nextView rows (c = 3)", numRecords, end - start);
+
+      if (numCopied != numViews)
+	{
+	  printf("[%s] FAILED: next returned %i rows, nextView %i\n", benchName, numCopied, numViews);
+	  exit(1);
+	}
+    }
+
+  BENCH_CHECK(freeRecord(r));
+  BENCH_CHECK(closeTable(table));
+  BENCH_CHECK(deleteTable("bench_table_v"));
+  BENCH_CHECK(shutdownRecordManager());
+
+  freeExpr(cond);
+  freeSchema(schema);
+  free(sc);
+  free(table);
+}
+
+// ************************************************************
+// matching tuples per worker, a cache line apart
+static RC
+countParallel (void *context, int worker, Record *record)
+{
+  (void) record;
+  ((long *) context)[worker * 8]++;
+  return RC_OK;
+}
+
+void
+benchParallelScan (int numRecords)
+{
+  RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+  RM_ScanHandle *sc = (RM_ScanHandle *) malloc(sizeof(RM_ScanHandle));
+  int workers[] = { 1, 2, 4, 8 };
+  long counts[8 * 8];
+  long numParallel;
+  int numNext = 0, w, i;
+  Record *r;
+  Schema *schema;
+  Expr *cond;
+  double start, end;
+  char label[64];
+  benchName = "parallel scans";
+  schema = benchSchema();
+  cond = benchCondition(numRecords);
+
+  BENCH_CHECK(initRecordManager(NULL));
+  BENCH_CHECK(createTable("bench_table_p", schema));
+  BENCH_CHECK(openTable(table, "bench_table_p"));
+  loadBenchTable(table, schema, numRecords);
+
+  // the serial scan also brings the table into the buffer pool
+  BENCH_CHECK(createRecord(&r, schema));
+  BENCH_NOW(start);
+  BENCH_CHECK(startScan(table, sc, cond));
+  while(next(sc, r) == RC_OK)
+    numNext++;
+  BENCH_CHECK(closeScan(sc));
+  BENCH_NOW(end);
+  BENCH_REPORT("next rows", numRecords, end - start);
+
+  for(w = 0; w < 4; w++)
+    {
+      memset(counts, 0, sizeof(counts));
+      BENCH_NOW(start);
+      BENCH_CHECK(parallelScan(table, cond, workers[w], countParallel, counts));
+      BENCH_NOW(end);
+      sprintf(label, "parallelScan rows (%i workers)", workers[w]);
+      BENCH_REPORT(label, numRecords, end - start);
+
+      numParallel = 0;
+      for(i = 0; i < 8; i++)
+	numParallel += counts[i * 8];
+      if (numParallel != numNext)
+	{
+	  printf("[%s] FAILED: next matched %i rows, parallelScan %li\n", benchName, numNext, numParallel);
+	  exit(1);
+	}
+    }
+
+  BENCH_CHECK(freeRecord(r));
+  BENCH_CHECK(closeTable(table));
+  BENCH_CHECK(deleteTable("bench_table_p"));
+  BENCH_CHECK(shutdownRecordManager());
+
+  freeExpr(cond);
+  freeSchema(schema);
+  free(sc);
+  free(table);
+}
+
+// ************************************************************
+// scans of a cold table before and after compressTable; every scan reopens
+// the table, so with more pages than the 1000 frames of its buffer pool it
+// reads every page from the file
+void
+benchCompression (int numRecords)
+{
+  RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+  RM_ScanHandle *sc = (RM_ScanHandle *) malloc(sizeof(RM_ScanHandle));
+  char *names[] = { "ts", "category", "region", "flag", "price" };
+  DataType dt[] = { DT_INT, DT_INT, DT_STRING, DT_BOOL, DT_FLOAT };
+  int sizes[] = { 0, 0, 16, 0, 0 };
+  int keys[] = {0};
+  char *regions[] = { "north", "south", "east", "west", "north-east", "north-west", "south-east", "south-west" };
+  RM_CompressionStats stats;
+  long counts[8 * 8];
+  int numMatches[2][2];
+  Record *records, *r;
+  Schema *schema;
+  Expr *cond, *left, *right;
+  Value *value;
+  double start, end;
+  char label[64];
+  char region[16];
+  int i, j, n, c;
+  benchName = "compression";
+
+  // ts ascending, 16 categories, 8 regions padded to 16 characters, flag in runs of 100
+  schema = createSchema(5, names, dt, sizes, 1, keys);
+  records = (Record *) malloc(sizeof(Record) * 4096);
+  for(j = 0; j < 4096; j++)
+    records[j].data = (char *) malloc(getRecordSize(schema));
+
+  // category = 3
+  MAKE_ATTRREF(left, 1);
+  MAKE_CONS(right, stringToValue("i3"));
+  MAKE_BINOP_EXPR(cond, left, right, OP_COMP_EQUAL);
+
+  BENCH_CHECK(initRecordManager(NULL));
+  BENCH_CHECK(createTable("bench_table_z", schema));
+  BENCH_CHECK(openTable(table, "bench_table_z"));
+  for(i = 0; i < numRecords; i += n)
+    {
+      n = (numRecords - i < 4096) ? numRecords - i : 4096;
+      for(j = 0; j < n; j++)
+	{
+	  MAKE_VALUE(value, DT_INT, i + j);
+	  setAttr(&records[j], schema, 0, value);
+	  value->v.intV = (i + j) % 16;
+	  setAttr(&records[j], schema, 1, value);
+	  freeVal(value);
+	  memset(region, 0, sizeof(region));
+	  strcpy(region, regions[((i + j) / 7) % 8]);
+	  MAKE_STRING_VALUE(value, region);
+	  setAttr(&records[j], schema, 2, value);
+	  freeVal(value);
+	  MAKE_VALUE(value, DT_BOOL, ((i + j) / 100) % 2);
+	  setAttr(&records[j], schema, 3, value);
+	  freeVal(value);
+	  MAKE_VALUE(value, DT_FLOAT, ((i + j) % 1000) * 0.25f);
+	  setAttr(&records[j], schema, 4, value);
+	  freeVal(value);
+	}
+      BENCH_CHECK(insertRecords(table, records, n));
+    }
+  BENCH_CHECK(createRecord(&r, schema));
+
+  for(c = 0; c < 2; c++)
+    {
+      if (c == 1)
+	{
+	  BENCH_NOW(start);
+	  BENCH_CHECK(compressTable(table, &stats));
+	  BENCH_NOW(end);
+	  BENCH_REPORT("compressTable rows", numRecords, end - start);
+	  printf("[%s] %-32s %10i pages %10i pages %10.2f x\n", benchName, "data pages before, after",
+		 stats.pagesBefore, stats.pagesAfter, (double) stats.pagesBefore / stats.pagesAfter);
+	  printf("[%s] %-32s %6i PLAIN %6i FOR %6i DICT %6i RLE\n", benchName, "column chunks",
+		 stats.numChunks[RM_ENC_PLAIN], stats.numChunks[RM_ENC_FOR],
+		 stats.numChunks[RM_ENC_DICT], stats.numChunks[RM_ENC_RLE]);
+	}
+
+      BENCH_CHECK(closeTable(table));
+      BENCH_CHECK(openTable(table, "bench_table_z"));
+      numMatches[c][0] = 0;
+      BENCH_NOW(start);
+      BENCH_CHECK(startScan(table, sc, cond));
+      while(next(sc, r) == RC_OK)
+	numMatches[c][0]++;
+      BENCH_CHECK(closeScan(sc));
+      BENCH_NOW(end);
+      sprintf(label, "cold next rows (%s)", (c == 0) ? "plain" : "compressed");
+      BENCH_REPORT(label, numRecords, end - start);
+
+      BENCH_CHECK(closeTable(table));
+      BENCH_CHECK(openTable(table, "bench_table_z"));
+      memset(counts, 0, sizeof(counts));
+      BENCH_NOW(start);
+      BENCH_CHECK(parallelScan(table, cond, 1, countParallel, counts));
+      BENCH_NOW(end);
+      numMatches[c][1] = (int) counts[0];
+      sprintf(label, "cold parallelScan rows (%s)", (c == 0) ? "plain" : "compressed");
+      BENCH_REPORT(label, numRecords, end - start);
+    }
+  if (numMatches[0][0] != numMatches[1][0] || numMatches[0][1] != numMatches[1][1])
+    {
+      printf("[%s] FAILED: the compressed table returns different tuples\n", benchName);
+      exit(1);
+    }
+
+  BENCH_CHECK(freeRecord(r));
+  BENCH_CHECK(closeTable(table));
+  BENCH_CHECK(deleteTable("bench_table_z"));
+  BENCH_CHECK(shutdownRecordManager());
+
+  for(j = 0; j < 4096; j++)
+    free(records[j].data);
+  free(records);
+  freeExpr(cond);
+  freeSchema(schema);
+  free(sc);
+  free(table);
+}
+
+void
+benchZoneMaps (int numRecords)
+{
+  RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+  RM_ScanHandle *sc = (RM_ScanHandle *) malloc(sizeof(RM_ScanHandle));
+  RM_ScanStats stats;
+  Schema *schema;
+  Record view;
+  Expr *conds[2], *attr, *lower, *upper, *l, *r;
+  Value *value;
+  double start, end;
+  int numMatches[2];
+  int c;
+  benchName = "zone maps";
+
+  // time range: a, ascending like a timestamp, in the 1% of the table from 40%
+  MAKE_ATTRREF(attr, 0);
+  MAKE_VALUE(value, DT_INT, (int) (numRecords * 0.4));
+  MAKE_CONS(lower, value);
+  MAKE_VALUE(value, DT_INT, (int) (numRecords * 0.41) - 1);
+  MAKE_CONS(upper, value);
+  MAKE_BETWEEN_EXPR(conds[0], attr, lower, upper);
+
+  // the same range as NOT (a < lower OR a > upper), which the zone maps do not see through
+  MAKE_ATTRREF(l, 0);
+  MAKE_VALUE(value, DT_INT, (int) (numRecords * 0.4));
+  MAKE_CONS(r, value);
+  MAKE_BINOP_EXPR(lower, l, r, OP_COMP_SMALLER);
+  MAKE_ATTRREF(l, 0);
+  MAKE_VALUE(value, DT_INT, (int) (numRecords * 0.41) - 1);
+  MAKE_CONS(r, value);
+  MAKE_BINOP_EXPR(upper, l, r, OP_COMP_GREATER);
+  MAKE_BINOP_EXPR(r, lower, upper, OP_BOOL_OR);
+  MAKE_UNOP_EXPR(conds[1], r, OP_BOOL_NOT);
+
+  schema = benchSchema();
+  BENCH_CHECK(initRecordManager(NULL));
+  BENCH_CHECK(createTable("bench_table_m", schema));
+  BENCH_CHECK(openTable(table, "bench_table_m"));
+  loadBenchTable(table, schema, numRecords);
+
+  for(c = 0; c < 2; c++)
+    {
+      BENCH_CHECK(closeTable(table));
+      BENCH_CHECK(openTable(table, "bench_table_m"));
+      numMatches[c] = 0;
+      BENCH_NOW(start);
+      BENCH_CHECK(startScan(table, sc, conds[c]));
+      while(nextView(sc, &view) == RC_OK)
+	numMatches[c]++;
+      BENCH_CHECK(getScanStats(sc, &stats));
+      BENCH_CHECK(closeScan(sc));
+      BENCH_NOW(end);
+      BENCH_REPORT((c == 0) ? "cold range scan rows (zone maps)" : "cold range scan rows (all pages)", numRecords, end - start);
+      printf("[%s] %-32s %10i pinned %10i skipped %10i matches\n", benchName,
+	     (c == 0) ? "pages (zone maps)" : "pages (all pages)", stats.pagesPinned, stats.pagesSkipped, numMatches[c]);
+    }
+  if (numMatches[0] != numMatches[1])
+    {
+      printf("[%s] FAILED: skipping pages changes the result\n", benchName);
+      exit(1);
+    }
+
+  BENCH_CHECK(closeTable(table));
+  BENCH_CHECK(deleteTable("bench_table_m"));
+  BENCH_CHECK(shutdownRecordManager());
+
+  freeExpr(conds[0]);
+  freeExpr(conds[1]);
+  freeSchema(schema);
+  free(sc);
+  free(table);
+}
+
+void
+benchBloomFilters (int numRecords)
+{
+  RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+  RM_ScanHandle *sc = (RM_ScanHandle *) malloc(sizeof(RM_ScanHandle));
+  RM_ScanStats stats;
+  Schema *schema;
+  Record *records;
+  Record view;
+  Expr *cond, *attr, *cons;
+  Value *value;
+  double start, end;
+  char buf[17];
+  long pinned, skipped, matchingPages, numPages;
+  int numLookups = 100, numMatches;
+  int i, j, n, f, lastPage;
+  benchName = "bloom filters";
+
+  // b unique, its first 8 characters all '0' so the zone maps cannot tell pages apart
+  schema = benchSchema();
+  records = benchRecords(schema, 4096);
+  BENCH_CHECK(initRecordManager(NULL));
+  BENCH_CHECK(createTable("bench_table_b", schema));
+  BENCH_CHECK(openTable(table, "bench_table_b"));
+  for(i = 0; i < numRecords; i += n)
+    {
+      n = (numRecords - i < 4096) ? numRecords - i : 4096;
+      for(j = 0; j < n; j++)
+	{
+	  sprintf(buf, "%016i", i + j);
+	  MAKE_STRING_VALUE(value, buf);
+	  setAttr(&records[j], schema, 1, value);
+	  freeVal(value);
+	}
+      BENCH_CHECK(insertRecords(table, records, n));
+    }
+
+  for(f = 0; f < 2; f++)
+    {
+      if (f == 1)
+	{
+	  BENCH_NOW(start);
+	  BENCH_CHECK(createBloomFilter(table, 1));
+	  BENCH_NOW(end);
+	  BENCH_REPORT("createBloomFilter rows", numRecords, end - start);
+	}
+
+      // b = some key: half of the keys exist, half do not
+      srand(42);
+      pinned = skipped = matchingPages = 0;
+      numMatches = 0;
+      BENCH_NOW(start);
+      for(i = 0; i < numLookups; i++)
+	{
+	  sprintf(buf, "%016i", rand() % (2 * numRecords));
+	  MAKE_ATTRREF(attr, 1);
+	  MAKE_STRING_VALUE(value, buf);
+	  MAKE_CONS(cons, value);
+	  MAKE_BINOP_EXPR(cond, attr, cons, OP_COMP_EQUAL);
+	  BENCH_CHECK(startScan(table, sc, cond));
+	  lastPage = -1;
+	  while(nextView(sc, &view) == RC_OK)
+	    {
+	      numMatches++;
+	      if (view.id.page != lastPage)
+		matchingPages++;
+	      lastPage = view.id.page;
+	    }
+	  BENCH_CHECK(getScanStats(sc, &stats));
+	  BENCH_CHECK(closeScan(sc));
+	  freeExpr(cond);
+	  pinned += stats.pagesPinned;
+	  skipped += stats.pagesSkipped;
+	}
+      BENCH_NOW(end);
+      BENCH_REPORT((f == 0) ? "equality lookups (no filter)" : "equality lookups (bloom filter)", numLookups, end - start);
+      numPages = (pinned + skipped) / numLookups;
+      printf("[%s] %-32s %10.1f pinned %10.1f skipped %10i matches\n", benchName, "pages per lookup",
+	     (double) pinned / numLookups, (double) skipped / numLookups, numMatches);
+      if (f == 1)
+	printf("[%s] %-32s %10.4f %%\n", benchName, "false positive pages",
+	       100.0 * (pinned - matchingPages) / ((numPages * numLookups) - matchingPages));
+    }
+
+  BENCH_CHECK(closeTable(table));
+  BENCH_CHECK(deleteTable("bench_table_b"));
+  BENCH_CHECK(shutdownRecordManager());
+
+  freeBenchRecords(records, 4096);
+  freeSchema(schema);
+  free(sc);
+  free(table);
+}
+
+void
+benchCompaction (int numRecords)
+{
+  RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+  RM_ScanHandle *sc = (RM_ScanHandle *) malloc(sizeof(RM_ScanHandle));
+  RM_RecordBatch *batch;
+  RM_CompactionStats stats;
+  Schema *schema;
+  Record *records;
+  Expr *cond;
+  RID *rids;
+  long counts[8 * 8];
+  long numMatches[2];
+  double start, end, step, maxStep = 0;
+  int numPages[2];
+  int numRids = 0, numSteps = 0, tuplesMoved = 0, c, i;
+  char label[64];
+  benchName = "compaction";
+  schema = benchSchema();
+  cond = benchCondition(numRecords);
+
+  BENCH_CHECK(initRecordManager(NULL));
+  BENCH_CHECK(createTable("bench_table_c", schema));
+  BENCH_CHECK(openTable(table, "bench_table_c"));
+  loadBenchTable(table, schema, numRecords);
+
+  // delete a random half of the tuples
+  rids = (RID *) malloc(sizeof(RID) * numRecords);
+  BENCH_CHECK(createRecordBatch(&batch, schema, 4096));
+  BENCH_CHECK(startScan(table, sc, NULL));
+  while(nextBatch(sc, batch) == RC_OK)
+    for(i = 0; i < batch->numRecords; i++)
+      rids[numRids++] = batch->ids[i];
+  BENCH_CHECK(closeScan(sc));
+  BENCH_CHECK(freeRecordBatch(batch));
+  shuffleRids(rids, numRids);
+  BENCH_CHECK(deleteRecords(table, rids, numRids / 2));
+
+  for(c = 0; c < 2; c++)
+    {
+      if (c == 1)
+	{
+	  // in steps of 64 pages, the longest step is the longest wait of other operations
+	  BENCH_NOW(start);
+	  do
+	    {
+	      BENCH_NOW(step);
+	      BENCH_CHECK(compactTable(table, 64, &stats));
+	      BENCH_NOW(end);
+	      if (numSteps == 0)
+		numPages[0] = stats.pagesBefore;
+	      numPages[1] = stats.pagesAfter;
+	      if (end - step > maxStep)
+		maxStep = end - step;
+	      tuplesMoved += stats.tuplesMoved;
+	      numSteps++;
+	    } while(stats.pagesMoved > 0);
+	  BENCH_NOW(end);
+	  BENCH_REPORT("compactTable tuples moved", tuplesMoved, end - start);
+	  printf("[%s] %-32s %10i steps %10.4f s longest\n", benchName, "compaction steps", numSteps, maxStep);
+	  printf("[%s] %-32s %10i pages %10i pages %10.2f MB saved\n", benchName, "file before, after", numPages[0],
+		 numPages[1], (double) (numPages[0] - numPages[1]) * PAGE_SIZE / (1024 * 1024));
+	}
+
+      BENCH_CHECK(closeTable(table));
+      BENCH_CHECK(openTable(table, "bench_table_c"));
+      memset(counts, 0, sizeof(counts));
+      BENCH_NOW(start);
+      BENCH_CHECK(parallelScan(table, cond, 1, countParallel, counts));
+      BENCH_NOW(end);
+      numMatches[c] = counts[0];
+      sprintf(label, "cold scan rows (%s)", (c == 0) ? "50% deleted" : "compacted");
+      BENCH_REPORT(label, numRecords / 2, end - start);
+    }
+  if (numMatches[0] != numMatches[1])
+    {
+      printf("[%s] FAILED: the compacted table returns different tuples\n", benchName);
+      exit(1);
+    }
+
+  // lookups through the old RIDs of the remaining tuples
+  records = benchRecords(schema, 4096);
+  BENCH_NOW(start);
+  for(i = numRids / 2; i + 4096 <= numRids; i += 4096)
+    BENCH_CHECK(getRecords(table, rids + i, 4096, records));
+  BENCH_NOW(end);
+  BENCH_REPORT("getRecords by old RIDs", i - numRids / 2, end - start);
+
+  BENCH_CHECK(closeTable(table));
+  BENCH_CHECK(deleteTable("bench_table_c"));
+  BENCH_CHECK(shutdownRecordManager());
+
+  freeBenchRecords(records, 4096);
+  free(rids);
+  freeExpr(cond);
+  freeSchema(schema);
+  free(sc);
+  free(table);
+}
+
+void
+benchSparseScans (int numRecords)
+{
+  RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+  RM_ScanHandle *sc = (RM_ScanHandle *) malloc(sizeof(RM_ScanHandle));
+  RM_RecordBatch *batch;
+  RM_ScanStats stats;
+  Schema *schema;
+  Record *record;
+  RID *rids;
+  double start, end;
+  int percents[3] = { 10, 50, 90 };
+  int numRids, numDeleted, numFound, c, p, i;
+  char label[64];
+  benchName = "scans after deletes";
+  schema = benchSchema();
+  rids = (RID *) malloc(sizeof(RID) * numRecords);
+  BENCH_CHECK(initRecordManager(NULL));
+  BENCH_CHECK(createRecord(&record, schema));
+
+  // random deletes leave tombstones on every page, deleting the oldest tuples empties whole pages
+  for(p = 0; p < 3; p++)
+    for(c = 0; c < 2; c++)
+      {
+	BENCH_CHECK(createTable("bench_table_d", schema));
+	BENCH_CHECK(openTable(table, "bench_table_d"));
+	loadBenchTable(table, schema, numRecords);
+
+	numRids = 0;
+	BENCH_CHECK(createRecordBatch(&batch, schema, 4096));
+	BENCH_CHECK(startScan(table, sc, NULL));
+	while(nextBatch(sc, batch) == RC_OK)
+	  for(i = 0; i < batch->numRecords; i++)
+	    rids[numRids++] = batch->ids[i];
+	BENCH_CHECK(closeScan(sc));
+	BENCH_CHECK(freeRecordBatch(batch));
+	if (c == 0)
+	  shuffleRids(rids, numRids);
+	numDeleted = (int) ((long) numRids * percents[p] / 100);
+	BENCH_CHECK(deleteRecords(table, rids, numDeleted));
+
+	BENCH_CHECK(closeTable(table));
+	BENCH_CHECK(openTable(table, "bench_table_d"));
+	numFound = 0;
+	BENCH_NOW(start);
+	BENCH_CHECK(startScan(table, sc, NULL));
+	while(next(sc, record) == RC_OK)
+	  numFound++;
+	BENCH_CHECK(getScanStats(sc, &stats));
+	BENCH_CHECK(closeScan(sc));
+	BENCH_NOW(end);
+	if (numFound != numRids - numDeleted)
+	  {
+	    printf("[%s] FAILED: scan returned %i of %i live tuples\n", benchName, numFound, numRids - numDeleted);
+	    exit(1);
+	  }
+	sprintf(label, "cold scan rows (%i%% %s)", percents[p], (c == 0) ? "random" : "oldest");
+	BENCH_REPORT(label, numFound, end - start);
+	sprintf(label, "pages (%i%% %s)", percents[p], (c == 0) ? "random" : "oldest");
+	printf("[%s] %-32s %10i pinned %10i skipped\n", benchName, label, stats.pagesPinned, stats.pagesSkipped);
+
+	BENCH_CHECK(closeTable(table));
+	BENCH_CHECK(deleteTable("bench_table_d"));
+      }
+
+  BENCH_CHECK(shutdownRecordManager());
+  freeRecord(record);
+  freeSchema(schema);
+  free(rids);
+  free(sc);
+  free(table);
+}
+
+void
+benchSharedPool (int numRecords)
+{
+  int numTables = 200;
+  int tableRecords = numRecords / numTables;
+  int numLookups = numRecords;
+  int poolFrames[4] = { 1000, 4000, 16000, 200 * 1000 };
+  RM_TableData *tables = (RM_TableData *) malloc(sizeof(RM_TableData) * numTables);
+  RM_ScanHandle *sc = (RM_ScanHandle *) malloc(sizeof(RM_ScanHandle));
+  RM_RecordBatch *batch;
+  RM_CatalogStats stats;
+  RM_Config config;
+  Schema *schema;
+  Record *record;
+  RID *rids;
+  double start, end, u;
+  int numRids, c, t, i;
+  char name[32], label[64];
+  benchName = "shared buffer pool";
+  schema = benchSchema();
+  rids = (RID *) malloc(sizeof(RID) * numTables * tableRecords);
+
+  BENCH_CHECK(initRecordManager(NULL));
+  for(t = 0; t < numTables; t++)
+    {
+      sprintf(name, "bench_table_p%i", t);
+      BENCH_CHECK(createTable(name, schema));
+      BENCH_CHECK(openTable(&tables[t], name));
+      loadBenchTable(&tables[t], schema, tableRecords);
+      numRids = 0;
+      BENCH_CHECK(createRecordBatch(&batch, schema, 4096));
+      BENCH_CHECK(startScan(&tables[t], sc, NULL));
+      while(nextBatch(sc, batch) == RC_OK)
+	for(i = 0; i < batch->numRecords; i++)
+	  rids[(t * tableRecords) + numRids++] = batch->ids[i];
+      BENCH_CHECK(closeScan(sc));
+      BENCH_CHECK(freeRecordBatch(batch));
+      BENCH_CHECK(closeTable(&tables[t]));
+    }
+  BENCH_CHECK(shutdownRecordManager());
+
+  // lookups skewed towards the first tables; the last pool is as large as a pool of 1000 frames per table
+  for(c = 0; c < 4; c++)
+    {
+      config.poolFrames = poolFrames[c];
+      config.strategy = RS_LRU;
+      config.tableQuota = 0;
+      BENCH_CHECK(initRecordManager(&config));
+      BENCH_CHECK(createRecord(&record, schema));
+      for(t = 0; t < numTables; t++)
+	{
+	  sprintf(name, "bench_table_p%i", t);
+	  BENCH_CHECK(openTable(&tables[t], name));
+	}
+
+      srand(42);
+      BENCH_NOW(start);
+      for(i = 0; i < numLookups; i++)
+	{
+	  u = (double) rand() / RAND_MAX;
+	  t = (int) (u * u * u * numTables) % numTables;
+	  BENCH_CHECK(getRecord(&tables[t], rids[(t * tableRecords) + (rand() % tableRecords)], record));
+	}
+      BENCH_NOW(end);
+      BENCH_CHECK(getCatalogStats(&stats));
+      sprintf(label, "getRecord (%i frames)", poolFrames[c]);
+      BENCH_REPORT(label, numLookups, end - start);
+      printf("[%s] %-32s %10i tables %10.1f MB %10.2f %% hits\n", benchName, "pool", stats.numTables,
+	     stats.poolBytes / (1024.0 * 1024), 100.0 * stats.numHits / (stats.numHits + stats.numReadIO));
+
+      for(t = 0; t < numTables; t++)
+	BENCH_CHECK(closeTable(&tables[t]));
+      freeRecord(record);
+      BENCH_CHECK(shutdownRecordManager());
+    }
+
+  for(t = 0; t < numTables; t++)
+    {
+      sprintf(name, "bench_table_p%i", t);
+      BENCH_CHECK(deleteTable(name));
+    }
+  freeSchema(schema);
+  free(rids);
+  free(sc);
+  free(tables);
+}
+
+// random lookups of a thread while the pool is resized
+typedef struct LookupLoad
+{
+  RM_TableData *table;
+  Schema *schema;
+  RID *rids;
+  int numRids;
+  volatile int stop;
+  long numLookups;
+  unsigned int seed;
+} LookupLoad;
+
+static void *
+lookupLoad (void *arg)
+{
+  LookupLoad *load = (LookupLoad *) arg;
+  Record *record;
+
+  BENCH_CHECK(createRecord(&record, load->schema));
+  while(!load->stop)
+    {
+      BENCH_CHECK(getRecord(load->table, load->rids[rand_r(&load->seed) % load->numRids], record));
+      load->numLookups++;
+    }
+  freeRecord(record);
+  return NULL;
+}
+
+void
+benchTableOptions (int numRecords)
+{
+  RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+  RM_ScanHandle *sc = (RM_ScanHandle *) malloc(sizeof(RM_ScanHandle));
+  RM_RecordBatch *batch;
+  RM_TableOptions options;
+  RM_CatalogStats stats;
+  LookupLoad loads[2];
+  pthread_t threads[2];
+  Schema *schema;
+  Record *records;
+  RID *rids;
+  double start, end, step, maxStep;
+  long numLookups;
+  int numRids = 0, numResizes, numFound, c, i;
+  benchName = "table options";
+  schema = benchSchema();
+  options.poolFrames = 0;
+  options.strategy = RS_FIFO;
+  options.readAhead = 0;
+  options.writePolicy = BM_WRITE_THROUGH;
+  BENCH_CHECK(initRecordManager(NULL));
+
+  // inserts writing every page when it is unpinned, or once when it is replaced
+  records = benchRecords(schema, 4096);
+  for(c = 0; c < 2; c++)
+    {
+      options.writePolicy = (c == 0) ? BM_WRITE_THROUGH : BM_WRITE_BACK;
+      BENCH_CHECK(createTable("bench_table_o", schema));
+      BENCH_CHECK(openTableWithOptions(table, "bench_table_o", &options));
+      BENCH_NOW(start);
+      for(i = 0; i < numRecords; i++)
+	BENCH_CHECK(insertRecord(table, &records[i % 4096]));
+      BENCH_CHECK(closeTable(table));
+      BENCH_NOW(end);
+      BENCH_CHECK(openTable(table, "bench_table_o"));
+      BENCH_CHECK(getCatalogStats(&stats));
+      BENCH_CHECK(closeTable(table));
+      BENCH_REPORT((c == 0) ? "insertRecord (write through)" : "insertRecord (write back)", numRecords, end - start);
+      if (c == 0)
+	BENCH_CHECK(deleteTable("bench_table_o"));
+    }
+  freeBenchRecords(records, 4096);
+  options.writePolicy = BM_WRITE_THROUGH;
+
+  // cold scans reading a page per call, or 32 at a time
+  for(c = 0; c < 2; c++)
+    {
+      options.readAhead = (c == 0) ? 0 : 32;
+      BENCH_CHECK(openTableWithOptions(table, "bench_table_o", &options));
+      numFound = 0;
+      BENCH_CHECK(createRecordBatch(&batch, schema, 4096));
+      BENCH_NOW(start);
+      BENCH_CHECK(startScan(table, sc, NULL));
+      while(nextBatch(sc, batch) == RC_OK)
+	for(i = 0; i < batch->numRecords; i++)
+	  numFound++;
+      BENCH_CHECK(closeScan(sc));
+      BENCH_NOW(end);
+      BENCH_CHECK(freeRecordBatch(batch));
+      BENCH_CHECK(closeTable(table));
+      BENCH_REPORT((c == 0) ? "cold scan rows (no read ahead)" : "cold scan rows (read ahead 32)", numFound, end - start);
+    }
+  options.readAhead = 0;
+
+  // lookups of two threads on a pool of its own, resized between 256 and 4096 frames every 10 ms
+  options.poolFrames = 4096;
+  options.strategy = RS_LRU;
+  BENCH_CHECK(openTableWithOptions(table, "bench_table_o", &options));
+  rids = (RID *) malloc(sizeof(RID) * numRecords);
+  BENCH_CHECK(createRecordBatch(&batch, schema, 4096));
+  BENCH_CHECK(startScan(table, sc, NULL));
+  while(nextBatch(sc, batch) == RC_OK)
+    for(i = 0; i < batch->numRecords; i++)
+      rids[numRids++] = batch->ids[i];
+  BENCH_CHECK(closeScan(sc));
+  BENCH_CHECK(freeRecordBatch(batch));
+
+  for(c = 0; c < 2; c++)
+    {
+      for(i = 0; i < 2; i++)
+	{
+	  loads[i].table = table;
+	  loads[i].schema = schema;
+	  loads[i].rids = rids;
+	  loads[i].numRids = numRids;
+	  loads[i].stop = 0;
+	  loads[i].numLookups = 0;
+	  loads[i].seed = i + 1;
+	  pthread_create(&threads[i], NULL, lookupLoad, &loads[i]);
+	}
+      numResizes = 0;
+      maxStep = 0;
+      BENCH_NOW(start);
+      do
+	{
+	  usleep(10000);
+	  if (c == 1)
+	    {
+	      BENCH_NOW(step);
+	      BENCH_CHECK(resizeTablePool(table, (numResizes % 2 == 0) ? 256 : 4096));
+	      BENCH_NOW(end);
+	      if (end - step > maxStep)
+		maxStep = end - step;
+	      numResizes++;
+	    }
+	  BENCH_NOW(end);
+	} while(end - start < 2.0);
+      numLookups = 0;
+      for(i = 0; i < 2; i++)
+	{
+	  loads[i].stop = 1;
+	  pthread_join(threads[i], NULL);
+	  numLookups += loads[i].numLookups;
+	}
+      BENCH_NOW(end);
+      BENCH_REPORT((c == 0) ? "getRecord (4096 frames)" : "getRecord (resizing)", numLookups, end - start);
+      if (c == 1)
+	printf("[%s] %-32s %10i resizes %10.4f s longest\n", benchName, "resizeTablePool", numResizes, maxStep);
+    }
+
+  BENCH_CHECK(closeTable(table));
+  BENCH_CHECK(deleteTable("bench_table_o"));
+  BENCH_CHECK(shutdownRecordManager());
+  freeSchema(schema);
+  free(rids);
+  free(sc);
+  free(table);
+}
+
+// lookups of two tenants on the shared pool while it is resized and the
+// quotas are moved between them, and the hit ratio after shrinking the pool
+// online compared to restarting the record manager with fewer frames
+void
+benchOnlineResize (int numRecords)
+{
+  RM_TableData *tables = (RM_TableData *) malloc(sizeof(RM_TableData) * 2);
+  RM_ScanHandle *sc = (RM_ScanHandle *) malloc(sizeof(RM_ScanHandle));
+  RM_RecordBatch *batch;
+  RM_Config config;
+  RM_CatalogStats before, after;
+  LookupLoad loads[2];
+  pthread_t threads[2];
+  Schema *schema;
+  Record *record;
+  RID *rids;
+  double start, end, step, maxStep;
+  long numLookups;
+  int bigPool = (numRecords / 64 > 16) ? numRecords / 64 : 16; // about all pages of both tables
+  int smallPool = bigPool / 4;
+  int numRids = 0, numResizes, c, t, i;
+  unsigned int seed;
+  char name[32], label[64];
+  benchName = "online pool resize";
+  schema = benchSchema();
+  rids = (RID *) malloc(sizeof(RID) * numRecords);
+  config.poolFrames = bigPool;
+  config.strategy = RS_CLOCK;
+  config.tableQuota = 0;
+
+  BENCH_CHECK(initRecordManager(&config));
+  for(t = 0; t < 2; t++)
+    {
+      sprintf(name, "bench_table_r%i", t);
+      BENCH_CHECK(createTable(name, schema));
+      BENCH_CHECK(openTable(&tables[t], name));
+      loadBenchTable(&tables[t], schema, numRecords);
+    }
+  // both tables hold the same tuples at the same RIDs
+  BENCH_CHECK(createRecordBatch(&batch, schema, 4096));
+  BENCH_CHECK(startScan(&tables[0], sc, NULL));
+  while(nextBatch(sc, batch) == RC_OK)
+    for(i = 0; i < batch->numRecords; i++)
+      rids[numRids++] = batch->ids[i];
+  BENCH_CHECK(closeScan(sc));
+  BENCH_CHECK(freeRecordBatch(batch));
+
+  // a thread per tenant; the pool keeps bigPool or smallPool frames, or is
+  // resized between them every 10 ms with most of it going to one tenant at a time
+  for(c = 0; c < 3; c++)
+    {
+      BENCH_CHECK(resizeCatalogPool((c == 1) ? smallPool : bigPool));
+      for(i = 0; i < 2; i++)
+	{
+	  loads[i].table = &tables[i];
+	  loads[i].schema = schema;
+	  loads[i].rids = rids;
+	  loads[i].numRids = numRids;
+	  loads[i].stop = 0;
+	  loads[i].numLookups = 0;
+	  loads[i].seed = i + 1;
+	  pthread_create(&threads[i], NULL, lookupLoad, &loads[i]);
+	}
+      numResizes = 0;
+      maxStep = 0;
+      BENCH_NOW(start);
+      do
+	{
+	  usleep(10000);
+	  if (c == 2)
+	    {
+	      t = numResizes % 2;
+	      BENCH_NOW(step);
+	      BENCH_CHECK(resizeCatalogPool(((numResizes / 2) % 2 == 0) ? smallPool : bigPool));
+	      BENCH_CHECK(setTableQuota(&tables[t], 0));
+	      BENCH_CHECK(setTableQuota(&tables[1 - t], smallPool / 4));
+	      BENCH_NOW(end);
+	      if (end - step > maxStep)
+		maxStep = end - step;
+	      numResizes++;
+	    }
+	  BENCH_NOW(end);
+	} while(end - start < 2.0);
+      numLookups = 0;
+      for(i = 0; i < 2; i++)
+	{
+	  loads[i].stop = 1;
+	  pthread_join(threads[i], NULL);
+	  numLookups += loads[i].numLookups;
+	}
+      BENCH_NOW(end);
+      if (c < 2)
+	sprintf(label, "getRecord (%i frames)", (c == 0) ? bigPool : smallPool);
+      else
+	sprintf(label, "getRecord (resizing)");
+      BENCH_REPORT(label, numLookups, end - start);
+      if (c == 2)
+	printf("[%s] %-32s %10i resizes %10.4f s longest\n", benchName, "resizeCatalogPool", numResizes, maxStep);
+    }
+  for(t = 0; t < 2; t++)
+    BENCH_CHECK(setTableQuota(&tables[t], 0));
+
+  // shrinking to smallPool frames keeps the pages the strategy does not
+  // replace, restarting the record manager starts with an empty pool
+  BENCH_CHECK(createRecord(&record, schema));
+  for(c = 0; c < 2; c++)
+    {
+      BENCH_CHECK(resizeCatalogPool(bigPool));
+      seed = 1;
+      for(i = 0; i < numRids; i++)
+	BENCH_CHECK(getRecord(&tables[i % 2], rids[rand_r(&seed) % numRids], record));
+      BENCH_NOW(start);
+      if (c == 0)
+	BENCH_CHECK(resizeCatalogPool(smallPool));
+      else
+	{
+	  for(t = 0; t < 2; t++)
+	    BENCH_CHECK(closeTable(&tables[t]));
+	  BENCH_CHECK(shutdownRecordManager());
+	  config.poolFrames = smallPool;
+	  BENCH_CHECK(initRecordManager(&config));
+	  for(t = 0; t < 2; t++)
+	    {
+	      sprintf(name, "bench_table_r%i", t);
+	      BENCH_CHECK(openTable(&tables[t], name));
+	    }
+	}
+      BENCH_NOW(end);
+      BENCH_CHECK(getCatalogStats(&before));
+      for(i = 0; i < 2 * smallPool; i++)
+	BENCH_CHECK(getRecord(&tables[i % 2], rids[rand_r(&seed) % numRids], record));
+      BENCH_CHECK(getCatalogStats(&after));
+      printf("[%s] %-32s %10.4f s %10.2f %% hits in the next %i lookups\n", benchName,
+	     (c == 0) ? "shrink online" : "shrink by restart", end - start,
+	     100.0 * (after.numHits - before.numHits) / (2 * smallPool), 2 * smallPool);
+    }
+  freeRecord(record);
+
+  for(t = 0; t < 2; t++)
+    {
+      sprintf(name, "bench_table_r%i", t);
+      BENCH_CHECK(closeTable(&tables[t]));
+      BENCH_CHECK(deleteTable(name));
+    }
+  BENCH_CHECK(shutdownRecordManager());
+  freeSchema(schema);
+  free(rids);
+  free(sc);
+  free(tables);
+}
+
+// reading the statistics of a pool of numRecords frames holding a page each:
+// the arrays of the statistics interface, a snapshot, the counters alone
+// and the metrics text
+void
+benchPoolStats (int numRecords)
+{
+  ReplacementStrategy strategies[2] = { RS_LRU, RS_CLOCK };
+  BM_BufferPool bm;
+  BM_PageHandle h;
+  SM_FileHandle fh;
+  BM_PoolCounters counters;
+  BM_PoolSnapshot snap;
+  double start, end;
+  int reps = 100, s, i;
+  char label[64];
+  benchName = "pool statistics";
+
+  BENCH_CHECK(createPageFile("bench_table_s"));
+  BENCH_CHECK(openPageFile("bench_table_s", &fh));
+  BENCH_CHECK(ensureCapacity(numRecords, &fh));
+  BENCH_CHECK(closePageFile(&fh));
+  for(s = 0; s < 2; s++)
+    {
+      BENCH_CHECK(initBufferPool(&bm, "bench_table_s", numRecords, strategies[s], NULL));
+      for(i = 0; i < numRecords; i++)
+	{
+	  BENCH_CHECK(pinPage(&bm, &h, i));
+	  BENCH_CHECK(unpinPage(&bm, &h));
+	}
+
+      BENCH_NOW(start);
+      for(i = 0; i < reps; i++)
+	{
+	  getFrameContents(&bm);
+	  getDirtyFlags(&bm);
+	  getFixCounts(&bm);
+	}
+      BENCH_NOW(end);
+      sprintf(label, "%s stat arrays (%i frames)", (s == 0) ? "LRU" : "CLOCK", numRecords);
+      BENCH_REPORT(label, reps, end - start);
+
+      BENCH_NOW(start);
+      for(i = 0; i < reps; i++)
+	{
+	  BENCH_CHECK(getPoolSnapshot(&bm, &snap));
+	  BENCH_CHECK(freePoolSnapshot(&snap));
+	}
+      BENCH_NOW(end);
+      sprintf(label, "%s getPoolSnapshot", (s == 0) ? "LRU" : "CLOCK");
+      BENCH_REPORT(label, reps, end - start);
+
+      BENCH_NOW(start);
+      for(i = 0; i < reps; i++)
+	free(sprintPoolMetrics(&bm));
+      BENCH_NOW(end);
+      sprintf(label, "%s sprintPoolMetrics", (s == 0) ? "LRU" : "CLOCK");
+      BENCH_REPORT(label, reps, end - start);
+
+      BENCH_NOW(start);
+      for(i = 0; i < reps * 10000; i++)
+	BENCH_CHECK(getPoolCounters(&bm, &counters));
+      BENCH_NOW(end);
+      sprintf(label, "%s getPoolCounters", (s == 0) ? "LRU" : "CLOCK");
+      BENCH_REPORT(label, reps * 10000, end - start);
+      BENCH_CHECK(shutdownBufferPool(&bm));
+    }
+  BENCH_CHECK(destroyPageFile("bench_table_s"));
+}
+
+// ************************************************************
+Schema *
+benchSchema (void)
+{
+  char *names[] = { "a", "b", "c" };
+  DataType dt[] = { DT_INT, DT_STRING, DT_INT };
+  int sizes[] = { 0, 16, 0 };
+  int keys[] = {0};
+
+  return createSchema(3, names, dt, sizes, 1, keys);
+}
+
+Record *
+benchRecords (Schema *schema, int numRecords)
+{
+  Record *records = (Record *) malloc(sizeof(Record) * numRecords);
+  Value *value;
+  char buf[17];
+  int i;
+
+  for(i = 0; i < numRecords; i++)
+    {
+      records[i].data = (char *) malloc(getRecordSize(schema));
+      records[i].id.page = records[i].id.slot = -1;
+
+      MAKE_VALUE(value, DT_INT, i);
+      setAttr(&records[i], schema, 0, value);
+      freeVal(value);
+
+      sprintf(buf, "%016i", i);
+      MAKE_STRING_VALUE(value, buf);
+      setAttr(&records[i], schema, 1, value);
+      freeVal(value);
+
+      MAKE_VALUE(value, DT_INT, i % 100);
+      setAttr(&records[i], schema, 2, value);
+      freeVal(value);
+    }
+
+  return records;
+}
+
+void
+freeBenchRecords (Record *records, int numRecords)
+{
+  int i;
+
+  for(i = 0; i < numRecords; i++)
+    free(records[i].data);
+  free(records);
+}
+
+void
+shuffleRids (RID *rids, int numRids)
+{
+  int i;
+
+  srand(42);
+  for(i = numRids - 1; i > 0; i--)
+    {
+      int j = rand() % (i + 1);
+      RID tmp = rids[i];
+      rids[i] = rids[j];
+      rids[j] = tmp;
+    }
+}
+
+// insert numRecords bench records in batches of 4096
+void
+loadBenchTable (RM_TableData *table, Schema *schema, int numRecords)
+{
+  Record *records = benchRecords(schema, 4096);
+  int i, j, n;
+
+  for(i = 0; i < numRecords; i += n)
+    {
+      Value *value;
+
+      n = (numRecords - i < 4096) ? numRecords - i : 4096;
+      for(j = 0; j < n; j++)
+	{
+	  MAKE_VALUE(value, DT_INT, i + j);
+	  setAttr(&records[j], schema, 0, value);
+	  freeVal(value);
+	}
+      BENCH_CHECK(insertRecords(table, records, n));
+    }
+
+  freeBenchRecords(records, 4096);
+}
+
+// a < numRecords / 2 AND c = 3
+Expr *
+benchCondition (int numRecords)
+{
+  Expr *l, *r, *lt, *eq;
+  Value *half;
+  Expr *cond;
+
+  MAKE_VALUE(half, DT_INT, numRecords / 2);
+  MAKE_ATTRREF(l, 0);
+  MAKE_CONS(r, half);
+  MAKE_BINOP_EXPR(lt, l, r, OP_COMP_SMALLER);
+
+  MAKE_ATTRREF(l, 2);
+  MAKE_CONS(r, stringToValue("i3"));
+  MAKE_BINOP_EXPR(eq, l, r, OP_COMP_EQUAL);
+
+  MAKE_BINOP_EXPR(cond, lt, eq, OP_BOOL_AND);
+
+  return cond;
+}
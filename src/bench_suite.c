@@ -0,0 +1,742 @@
+#include <stdlib.h>
+#include <pthread.h>
+#include <unistd.h>
+#include "dberror.h"
+#include "expr.h"
+#include "record_mgr.h"
+#include "tables.h"
+#include "storage_mgr.h"
+#include "buffer_mgr.h"
+#include "latency.h"
+#include "bench_helper.h"
+
+// the suite writes one JSON document to stdout; every measurement is
+// repeated and reported with the seconds of all repetitions, their median
+// and the operations per second of the median and of the best run
+
+#define MAX_REPEATS 16
+#define MAX_THREADS 64
+#define MAX_THREAD_COUNTS 8
+
+// sizes of the run, set from the command line
+typedef struct BenchConfig
+{
+  int numRecords; // tuples per table, also evaluations and pins measured
+  int numThreads; // highest number of threads
+  int numPages; // pages of the page file of the storage and pin benchmarks
+  int numRepeats;
+  unsigned int seed;
+} BenchConfig;
+
+// benchmark methods
+static void benchStorage (void);
+static void benchPins (void);
+static void benchRecordOps (void);
+static void benchSelectivity (void);
+static void benchEvalExpr (void);
+
+// helper methods
+Schema *benchSchema (void);
+Record *benchRecords (Schema *schema, int numRecords);
+void freeBenchRecords (Record *records, int numRecords);
+void loadBenchTable (RM_TableData *table, Schema *schema, int numRecords);
+int threadCounts (int *counts);
+void shuffleInts (int *values, int numValues, unsigned int seed);
+void jsonResult (char *group, char *name, char *variant, int threads, long ops, double *secs, char *extra);
+void jsonLatency (void);
+
+// benchmark name
+char *benchName;
+
+static BenchConfig config;
+static int numResults = 0;
+
+// main method, the optional arguments are the number of records, the
+// highest number of threads, the number of pages, the number of
+// repetitions and the seed of the random page and record orders
+int
+main (int argc, char **argv)
+{
+  char *revision = getenv("BENCH_REVISION");
+
+  config.numRecords = (argc > 1) ? atoi(argv[1]) : 65536;
+  config.numThreads = (argc > 2) ? atoi(argv[2]) : 4;
+  config.numPages = (argc > 3) ? atoi(argv[3]) : 4096;
+  config.numRepeats = (argc > 4) ? atoi(argv[4]) : 3;
+  config.seed = (argc > 5) ? (unsigned int) atoi(argv[5]) : 42;
+  if (config.numRecords < 100 || config.numPages < 64 || config.numThreads < 1 || config.numThreads > MAX_THREADS
+      || config.numRepeats < 1 || config.numRepeats > MAX_REPEATS)
+    {
+      fprintf(stderr, "usage: %s [records >= 100] [threads 1-%i] [pages >= 64] [repeats 1-%i] [seed]\n",
+	      argv[0], MAX_THREADS, MAX_REPEATS);
+      return 1;
+    }
+  benchName = "";
+
+  printf("{\n  \"suite\": \"bench_suite\",\n");
+  printf("  \"revision\": \"%s\",\n", (revision != NULL) ? revision : "unknown");
+  printf("  \"config\": {\"records\": %i, \"threads\": %i, \"pages\": %i, \"repeats\": %i, \"seed\": %u, "
+	 "\"page_size\": %i, \"cpus\": %li, \"latency_stats\": %s},\n",
+	 config.numRecords, config.numThreads, config.numPages, config.numRepeats, config.seed,
+	 PAGE_SIZE, sysconf(_SC_NPROCESSORS_ONLN),
+#ifdef LATENCY_STATS
+	 "true"
+#else
+	 "false"
+#endif
+	 );
+  printf("  \"results\": [");
+  resetLatencyStats();
+
+  benchStorage();
+  benchPins();
+  benchRecordOps();
+  benchSelectivity();
+  benchEvalExpr();
+
+  printf("\n  ],\n");
+  jsonLatency();
+  printf("}\n");
+
+  return 0;
+}
+
+// ************************************************************
+void
+benchStorage (void)
+{
+  SM_FileHandle fh;
+  SM_PageHandle page = (SM_PageHandle) calloc(PAGE_SIZE, 1);
+  SM_PageHandle chunk[16];
+  int *order = (int *) malloc(sizeof(int) * config.numPages);
+  double secs[5][MAX_REPEATS];
+  double start, end;
+  int numPages = config.numPages, i, j, r;
+  benchName = "storage";
+
+  for(i = 0; i < 16; i++)
+    chunk[i] = (SM_PageHandle) malloc(PAGE_SIZE);
+  for(i = 0; i < numPages; i++)
+    order[i] = i;
+  shuffleInts(order, numPages, config.seed);
+
+  // the page file fits into the OS page cache, so this measures the
+  // system calls and copies of the storage manager, not the device
+  for(r = 0; r < config.numRepeats; r++)
+    {
+      BENCH_CHECK(createPageFile("bench_suite_pages.bin"));
+      BENCH_CHECK(openPageFile("bench_suite_pages.bin", &fh));
+      BENCH_CHECK(ensureCapacity(numPages, &fh));
+
+      BENCH_NOW(start);
+      for(i = 0; i < numPages; i++)
+	{
+	  page[0] = (char) i;
+	  BENCH_CHECK(writeBlock(i, &fh, page));
+	}
+      BENCH_NOW(end);
+      secs[0][r] = end - start;
+
+      BENCH_NOW(start);
+      for(i = 0; i < numPages; i++)
+	BENCH_CHECK(readBlock(i, &fh, page));
+      BENCH_NOW(end);
+      secs[1][r] = end - start;
+
+      BENCH_NOW(start);
+      for(i = 0; i < numPages; i += 16)
+	BENCH_CHECK(readBlocks(i, (numPages - i < 16) ? numPages - i : 16, &fh, chunk));
+      BENCH_NOW(end);
+      secs[2][r] = end - start;
+
+      BENCH_NOW(start);
+      for(i = 0; i < numPages; i++)
+	BENCH_CHECK(readBlock(order[i], &fh, page));
+      BENCH_NOW(end);
+      secs[3][r] = end - start;
+
+      BENCH_NOW(start);
+      for(i = 0; i < numPages; i++)
+	{
+	  page[0] = (char) order[i];
+	  BENCH_CHECK(writeBlock(order[i], &fh, page));
+	}
+      BENCH_NOW(end);
+      secs[4][r] = end - start;
+
+      // the last write of every page is the one of the random pass
+      for(j = 0; j < numPages; j += numPages / 8)
+	{
+	  BENCH_CHECK(readBlock(j, &fh, page));
+	  if (page[0] != (char) j)
+	    {
+	      printf("[%s] FAILED: page %i holds the wrong content\n", benchName, j);
+	      exit(1);
+	    }
+	}
+
+      BENCH_CHECK(closePageFile(&fh));
+      BENCH_CHECK(destroyPageFile("bench_suite_pages.bin"));
+    }
+
+  jsonResult("storage", "writeBlock", "sequential", 1, numPages, secs[0], NULL);
+  jsonResult("storage", "readBlock", "sequential", 1, numPages, secs[1], NULL);
+  jsonResult("storage", "readBlocks", "sequential, 16 pages per call", 1, numPages, secs[2], NULL);
+  jsonResult("storage", "readBlock", "random", 1, numPages, secs[3], NULL);
+  jsonResult("storage", "writeBlock", "random", 1, numPages, secs[4], NULL);
+
+  for(i = 0; i < 16; i++)
+    free(chunk[i]);
+  free(order);
+  free(page);
+}
+
+// ************************************************************
+typedef struct PinLoad
+{
+  BM_BufferPool *bm;
+  int numPages;
+  int numPins;
+  unsigned int seed;
+} PinLoad;
+
+static void *
+pinLoad (void *arg)
+{
+  PinLoad *load = (PinLoad *) arg;
+  BM_PageHandle h;
+  int i;
+
+  for(i = 0; i < load->numPins; i++)
+    {
+      BENCH_CHECK(pinPage(load->bm, &h, rand_r(&load->seed) % load->numPages));
+      BENCH_CHECK(unpinPage(load->bm, &h));
+    }
+  return NULL;
+}
+
+void
+benchPins (void)
+{
+  // the buffer manager implements no victim choice for RS_LFU and RS_LRU_K
+  ReplacementStrategy strategies[] = { RS_FIFO, RS_LRU, RS_CLOCK };
+  char *strategyNames[] = { "FIFO", "LRU", "CLOCK" };
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PoolCounters before, after;
+  PinLoad loads[MAX_THREADS];
+  pthread_t threads[MAX_THREADS];
+  SM_FileHandle fh;
+  SM_PageHandle page = (SM_PageHandle) calloc(PAGE_SIZE, 1);
+  double secs[MAX_REPEATS];
+  double start, end, hitRatio;
+  int counts[MAX_THREAD_COUNTS];
+  int numCounts = threadCounts(counts);
+  int numPages = config.numPages, numPins = config.numRecords;
+  int s, miss, c, t, r, i;
+  char extra[64];
+  benchName = "buffer pins";
+
+  BENCH_CHECK(createPageFile("bench_suite_pins.bin"));
+  BENCH_CHECK(openPageFile("bench_suite_pins.bin", &fh));
+  BENCH_CHECK(ensureCapacity(numPages, &fh));
+  for(i = 0; i < numPages; i++)
+    BENCH_CHECK(writeBlock(i, &fh, page));
+  BENCH_CHECK(closePageFile(&fh));
+
+  // hits pin pages of a pool holding the whole file, misses pin pages of a
+  // pool of 1/8 of the file, so 7 of 8 pins replace a page
+  for(s = 0; s < 3; s++)
+    for(miss = 0; miss < 2; miss++)
+      for(c = 0; c < numCounts; c++)
+	{
+	  int numThreads = counts[c];
+
+	  hitRatio = 0;
+	  for(r = 0; r < config.numRepeats; r++)
+	    {
+	      BENCH_CHECK(initBufferPool(bm, "bench_suite_pins.bin", miss ? numPages / 8 : numPages,
+					 strategies[s], NULL));
+	      if (!miss)
+		{
+		  BM_PageHandle h;
+
+		  for(i = 0; i < numPages; i++)
+		    {
+		      BENCH_CHECK(pinPage(bm, &h, i));
+		      BENCH_CHECK(unpinPage(bm, &h));
+		    }
+		}
+	      for(t = 0; t < numThreads; t++)
+		{
+		  loads[t].bm = bm;
+		  loads[t].numPages = numPages;
+		  loads[t].numPins = numPins / numThreads;
+		  loads[t].seed = config.seed + t;
+		}
+
+	      BENCH_CHECK(getPoolCounters(bm, &before));
+	      BENCH_NOW(start);
+	      for(t = 0; t < numThreads; t++)
+		pthread_create(&threads[t], NULL, pinLoad, &loads[t]);
+	      for(t = 0; t < numThreads; t++)
+		pthread_join(threads[t], NULL);
+	      BENCH_NOW(end);
+	      BENCH_CHECK(getPoolCounters(bm, &after));
+	      secs[r] = end - start;
+	      hitRatio += (double) (after.numHits - before.numHits)
+		/ (after.numHits - before.numHits + after.numMisses - before.numMisses);
+
+	      BENCH_CHECK(shutdownBufferPool(bm));
+	    }
+
+	  sprintf(extra, "\"strategy\": \"%s\", \"hit_ratio\": %.4f", strategyNames[s], hitRatio / config.numRepeats);
+	  jsonResult("buffer", "pinPage", miss ? "miss" : "hit", numThreads, (long) numPins / numThreads * numThreads, secs, extra);
+	}
+
+  BENCH_CHECK(destroyPageFile("bench_suite_pins.bin"));
+  free(page);
+  free(bm);
+}
+
+// ************************************************************
+typedef struct GetLoad
+{
+  RM_TableData *table;
+  Schema *schema;
+  RID *rids;
+  int *order;
+  int first;
+  int numGets;
+} GetLoad;
+
+static void *
+getLoad (void *arg)
+{
+  GetLoad *load = (GetLoad *) arg;
+  Record *record;
+  int i;
+
+  BENCH_CHECK(createRecord(&record, load->schema));
+  for(i = load->first; i < load->first + load->numGets; i++)
+    BENCH_CHECK(getRecord(load->table, load->rids[load->order[i]], record));
+  freeRecord(record);
+  return NULL;
+}
+
+void
+benchRecordOps (void)
+{
+  RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+  GetLoad loads[MAX_THREADS];
+  pthread_t threads[MAX_THREADS];
+  Schema *schema;
+  Record *records;
+  RID *rids;
+  int *order;
+  double secs[3 + MAX_THREAD_COUNTS][MAX_REPEATS];
+  double start, end;
+  int counts[MAX_THREAD_COUNTS];
+  int numCounts = threadCounts(counts);
+  int numRecords = config.numRecords, c, t, r, i;
+  benchName = "record operations";
+  schema = benchSchema();
+  records = benchRecords(schema, numRecords);
+  rids = (RID *) malloc(sizeof(RID) * numRecords);
+  order = (int *) malloc(sizeof(int) * numRecords);
+  for(i = 0; i < numRecords; i++)
+    order[i] = i;
+  shuffleInts(order, numRecords, config.seed);
+
+  BENCH_CHECK(initRecordManager(NULL));
+  for(r = 0; r < config.numRepeats; r++)
+    {
+      BENCH_CHECK(createTable("bench_suite_r", schema));
+      BENCH_CHECK(openTable(table, "bench_suite_r"));
+
+      BENCH_NOW(start);
+      for(i = 0; i < numRecords; i++)
+	{
+	  BENCH_CHECK(insertRecord(table, &records[i]));
+	  rids[i] = records[i].id;
+	}
+      BENCH_NOW(end);
+      secs[0][r] = end - start;
+
+      // random lookups, split between the threads
+      for(c = 0; c < numCounts; c++)
+	{
+	  for(t = 0; t < counts[c]; t++)
+	    {
+	      loads[t].table = table;
+	      loads[t].schema = schema;
+	      loads[t].rids = rids;
+	      loads[t].order = order;
+	      loads[t].numGets = numRecords / counts[c];
+	      loads[t].first = t * loads[t].numGets;
+	    }
+	  BENCH_NOW(start);
+	  for(t = 0; t < counts[c]; t++)
+	    pthread_create(&threads[t], NULL, getLoad, &loads[t]);
+	  for(t = 0; t < counts[c]; t++)
+	    pthread_join(threads[t], NULL);
+	  BENCH_NOW(end);
+	  secs[3 + c][r] = end - start;
+	}
+
+      BENCH_NOW(start);
+      for(i = 0; i < numRecords; i++)
+	BENCH_CHECK(updateRecord(table, &records[order[i]]));
+      BENCH_NOW(end);
+      secs[1][r] = end - start;
+
+      BENCH_NOW(start);
+      for(i = 0; i < numRecords; i++)
+	BENCH_CHECK(deleteRecord(table, rids[order[i]]));
+      BENCH_NOW(end);
+      secs[2][r] = end - start;
+
+      if (getNumTuples(table) != 0)
+	{
+	  printf("[%s] FAILED: %i tuples left after deleting all\n", benchName, getNumTuples(table));
+	  exit(1);
+	}
+      BENCH_CHECK(closeTable(table));
+      BENCH_CHECK(deleteTable("bench_suite_r"));
+    }
+  BENCH_CHECK(shutdownRecordManager());
+
+  jsonResult("record", "insertRecord", "", 1, numRecords, secs[0], NULL);
+  for(c = 0; c < numCounts; c++)
+    jsonResult("record", "getRecord", "random", counts[c], (long) numRecords / counts[c] * counts[c], secs[3 + c], NULL);
+  jsonResult("record", "updateRecord", "random", 1, numRecords, secs[1], NULL);
+  jsonResult("record", "deleteRecord", "random", 1, numRecords, secs[2], NULL);
+
+  freeBenchRecords(records, numRecords);
+  freeSchema(schema);
+  free(order);
+  free(rids);
+  free(table);
+}
+
+// ************************************************************
+static RC
+countMatch (void *context, int worker, Record *record)
+{
+  (void) record;
+  // one counter per cache line
+  ((long *) context)[worker * 8]++;
+  return RC_OK;
+}
+
+void
+benchSelectivity (void)
+{
+  RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+  RM_ScanHandle *sc = (RM_ScanHandle *) malloc(sizeof(RM_ScanHandle));
+  int bounds[] = { 0, 1, 10, 50, 100 };
+  long matches[MAX_THREADS * 8];
+  double secs[MAX_REPEATS];
+  double start, end;
+  int counts[MAX_THREAD_COUNTS];
+  int numCounts = threadCounts(counts);
+  int numRecords = config.numRecords, numMatched = 0, b, c, r, i;
+  Record *record;
+  Schema *schema;
+  Expr *cond, *left, *right;
+  Value *bound;
+  char extra[64];
+  benchName = "filtered scans";
+  schema = benchSchema();
+
+  BENCH_CHECK(initRecordManager(NULL));
+  BENCH_CHECK(createTable("bench_suite_s", schema));
+  BENCH_CHECK(openTable(table, "bench_suite_s"));
+  loadBenchTable(table, schema, numRecords);
+  BENCH_CHECK(createRecord(&record, schema));
+
+  // c = i % 100, so c < bound selects bound percent of the tuples of every page
+  for(b = 0; b < 5; b++)
+    {
+      MAKE_VALUE(bound, DT_INT, bounds[b]);
+      MAKE_ATTRREF(left, 2);
+      MAKE_CONS(right, bound);
+      MAKE_BINOP_EXPR(cond, left, right, OP_COMP_SMALLER);
+
+      for(c = 0; c < numCounts; c++)
+	{
+	  for(r = 0; r < config.numRepeats; r++)
+	    {
+	      numMatched = 0;
+	      BENCH_NOW(start);
+	      if (counts[c] == 1)
+		{
+		  BENCH_CHECK(startScan(table, sc, cond));
+		  while(next(sc, record) == RC_OK)
+		    numMatched++;
+		  BENCH_CHECK(closeScan(sc));
+		}
+	      else
+		{
+		  memset(matches, 0, sizeof(matches));
+		  BENCH_CHECK(parallelScan(table, cond, counts[c], countMatch, matches));
+		  for(i = 0; i < counts[c]; i++)
+		    numMatched += matches[i * 8];
+		}
+	      BENCH_NOW(end);
+	      secs[r] = end - start;
+
+	      if (numMatched != (long) numRecords / 100 * bounds[b] + ((numRecords % 100 < bounds[b]) ? numRecords % 100 : bounds[b]))
+		{
+		  printf("[%s] FAILED: c < %i matched %i tuples\n", benchName, bounds[b], numMatched);
+		  exit(1);
+		}
+	    }
+
+	  sprintf(extra, "\"selectivity\": %.2f, \"matched\": %i", bounds[b] / 100.0, numMatched);
+	  jsonResult("scan", "scan c < bound", (counts[c] == 1) ? "next" : "parallelScan", counts[c], numRecords, secs, extra);
+	}
+      freeExpr(cond);
+    }
+
+  BENCH_CHECK(freeRecord(record));
+  BENCH_CHECK(closeTable(table));
+  BENCH_CHECK(deleteTable("bench_suite_s"));
+  BENCH_CHECK(shutdownRecordManager());
+
+  freeSchema(schema);
+  free(sc);
+  free(table);
+}
+
+// ************************************************************
+void
+benchEvalExpr (void)
+{
+  char *names[] = { "a = constant", "a < constant AND c = 3", "(a < constant AND c = 3) OR (c > 90 AND NOT a = constant)" };
+  Expr *conds[3], *left, *right, *lt, *eq, *gt, *ne, *and1, *and2;
+  Value *result, *half;
+  Schema *schema;
+  Record *records;
+  double secs[MAX_REPEATS];
+  double start, end;
+  int numRecords = config.numRecords, numTrue = 0, e, r, i;
+  char extra[64];
+  benchName = "expression evaluation";
+  schema = benchSchema();
+  records = benchRecords(schema, numRecords);
+
+  MAKE_ATTRREF(left, 0);
+  MAKE_VALUE(half, DT_INT, numRecords / 2);
+  MAKE_CONS(right, half);
+  MAKE_BINOP_EXPR(conds[0], left, right, OP_COMP_EQUAL);
+
+  MAKE_ATTRREF(left, 0);
+  MAKE_VALUE(half, DT_INT, numRecords / 2);
+  MAKE_CONS(right, half);
+  MAKE_BINOP_EXPR(lt, left, right, OP_COMP_SMALLER);
+  MAKE_ATTRREF(left, 2);
+  MAKE_CONS(right, stringToValue("i3"));
+  MAKE_BINOP_EXPR(eq, left, right, OP_COMP_EQUAL);
+  MAKE_BINOP_EXPR(conds[1], lt, eq, OP_BOOL_AND);
+
+  MAKE_ATTRREF(left, 0);
+  MAKE_VALUE(half, DT_INT, numRecords / 2);
+  MAKE_CONS(right, half);
+  MAKE_BINOP_EXPR(lt, left, right, OP_COMP_SMALLER);
+  MAKE_ATTRREF(left, 2);
+  MAKE_CONS(right, stringToValue("i3"));
+  MAKE_BINOP_EXPR(eq, left, right, OP_COMP_EQUAL);
+  MAKE_BINOP_EXPR(and1, lt, eq, OP_BOOL_AND);
+  MAKE_ATTRREF(left, 2);
+  MAKE_CONS(right, stringToValue("i90"));
+  MAKE_BINOP_EXPR(gt, left, right, OP_COMP_GREATER);
+  MAKE_ATTRREF(left, 0);
+  MAKE_VALUE(half, DT_INT, numRecords / 2);
+  MAKE_CONS(right, half);
+  MAKE_BINOP_EXPR(eq, left, right, OP_COMP_EQUAL);
+  MAKE_UNOP_EXPR(ne, eq, OP_BOOL_NOT);
+  MAKE_BINOP_EXPR(and2, gt, ne, OP_BOOL_AND);
+  MAKE_BINOP_EXPR(conds[2], and1, and2, OP_BOOL_OR);
+
+  for(e = 0; e < 3; e++)
+    {
+      for(r = 0; r < config.numRepeats; r++)
+	{
+	  numTrue = 0;
+	  BENCH_NOW(start);
+	  for(i = 0; i < numRecords; i++)
+	    {
+	      BENCH_CHECK(evalExpr(&records[i], schema, conds[e], &result));
+	      numTrue += result->v.boolV;
+	      freeVal(result);
+	    }
+	  BENCH_NOW(end);
+	  secs[r] = end - start;
+	}
+      sprintf(extra, "\"matched\": %i", numTrue);
+      jsonResult("expr", "evalExpr", names[e], 1, numRecords, secs, extra);
+      freeExpr(conds[e]);
+    }
+
+  freeBenchRecords(records, numRecords);
+  freeSchema(schema);
+}
+
+// ************************************************************
+// the thread counts measured: powers of two below the highest, and it
+int
+threadCounts (int *counts)
+{
+  int n = 0, t;
+
+  for(t = 1; t < config.numThreads && n < MAX_THREAD_COUNTS - 1; t *= 2)
+    counts[n++] = t;
+  counts[n++] = config.numThreads;
+  return n;
+}
+
+// Fisher-Yates shuffle with a fixed seed, so runs use the same order
+void
+shuffleInts (int *values, int numValues, unsigned int seed)
+{
+  int i, j, tmp;
+
+  for(i = numValues - 1; i > 0; i--)
+    {
+      j = rand_r(&seed) % (i + 1);
+      tmp = values[i];
+      values[i] = values[j];
+      values[j] = tmp;
+    }
+}
+
+static int
+compareSecs (const void *left, const void *right)
+{
+  double l = *(double *) left, r = *(double *) right;
+
+  return (l > r) - (l < r);
+}
+
+// prints a result object of the results array; extra holds further
+// members of the object, or is NULL
+void
+jsonResult (char *group, char *name, char *variant, int threads, long ops, double *secs, char *extra)
+{
+  double sorted[MAX_REPEATS];
+  double median;
+  int r;
+
+  memcpy(sorted, secs, sizeof(double) * config.numRepeats);
+  qsort(sorted, config.numRepeats, sizeof(double), compareSecs);
+  median = sorted[config.numRepeats / 2];
+
+  printf("%s\n    {\"group\": \"%s\", \"name\": \"%s\", \"variant\": \"%s\", \"threads\": %i, \"ops\": %li, \"seconds\": [",
+	 (numResults++ > 0) ? "," : "", group, name, variant, threads, ops);
+  for(r = 0; r < config.numRepeats; r++)
+    printf("%s%.6f", (r > 0) ? ", " : "", secs[r]);
+  printf("], \"median_seconds\": %.6f, \"ops_per_second\": %.0f, \"best_ops_per_second\": %.0f, \"ns_per_op\": %.1f",
+	 median, (median > 0) ? ops / median : 0.0, (sorted[0] > 0) ? ops / sorted[0] : 0.0,
+	 (ops > 0) ? median * 1e9 / ops : 0.0);
+  printf("%s%s}", (extra != NULL) ? ", " : "", (extra != NULL) ? extra : "");
+}
+
+// the latency histograms of the whole run, when they are compiled in
+void
+jsonLatency (void)
+{
+  LatencyStats stats;
+  int op, n = 0;
+
+  printf("  \"latency\": [");
+  for(op = 0; op < LAT_NUM_OPS; op++)
+    {
+      getLatencyStats(op, &stats);
+      if (stats.count == 0)
+	continue;
+      printf("%s\n    {\"op\": \"%s\", \"count\": %li, \"mean_ns\": %.1f, \"min_ns\": %lu, \"p50_ns\": %lu, \"p90_ns\": %lu, "
+	     "\"p99_ns\": %lu, \"p999_ns\": %lu, \"max_ns\": %lu}",
+	     (n++ > 0) ? "," : "", latencyOpName(op), stats.count, stats.mean, (unsigned long) stats.min,
+	     (unsigned long) stats.p50, (unsigned long) stats.p90, (unsigned long) stats.p99,
+	     (unsigned long) stats.p999, (unsigned long) stats.max);
+    }
+  printf("%s]\n", (n > 0) ? "\n  " : "");
+}
+
+// ************************************************************
+Schema *
+benchSchema (void)
+{
+  char *names[] = { "a", "b", "c" };
+  DataType dt[] = { DT_INT, DT_STRING, DT_INT };
+  int sizes[] = { 0, 16, 0 };
+  int keys[] = {0};
+
+  return createSchema(3, names, dt, sizes, 1, keys);
+}
+
+Record *
+benchRecords (Schema *schema, int numRecords)
+{
+  Record *records = (Record *) malloc(sizeof(Record) * numRecords);
+  Value *value;
+  char buf[17];
+  int i;
+
+  for(i = 0; i < numRecords; i++)
+    {
+      records[i].data = (char *) malloc(getRecordSize(schema));
+      records[i].id.page = records[i].id.slot = -1;
+
+      MAKE_VALUE(value, DT_INT, i);
+      setAttr(&records[i], schema, 0, value);
+      freeVal(value);
+
+      sprintf(buf, "%016i", i);
+      MAKE_STRING_VALUE(value, buf);
+      setAttr(&records[i], schema, 1, value);
+      freeVal(value);
+
+      MAKE_VALUE(value, DT_INT, i % 100);
+      setAttr(&records[i], schema, 2, value);
+      freeVal(value);
+    }
+
+  return records;
+}
+
+void
+freeBenchRecords (Record *records, int numRecords)
+{
+  int i;
+
+  for(i = 0; i < numRecords; i++)
+    free(records[i].data);
+  free(records);
+}
+
+void
+loadBenchTable (RM_TableData *table, Schema *schema, int numRecords)
+{
+  Record *records = benchRecords(schema, 4096);
+  int i, j, n;
+
+  for(i = 0; i < numRecords; i += n)
+    {
+      Value *value;
+
+      n = (numRecords - i < 4096) ? numRecords - i : 4096;
+      for(j = 0; j < n; j++)
+	{
+	  MAKE_VALUE(value, DT_INT, i + j);
+	  setAttr(&records[j], schema, 0, value);
+	  freeVal(value);
+	  MAKE_VALUE(value, DT_INT, (i + j) % 100);
+	  setAttr(&records[j], schema, 2, value);
+	  freeVal(value);
+	}
+      BENCH_CHECK(insertRecords(table, records, n));
+    }
+
+  freeBenchRecords(records, 4096);
+}
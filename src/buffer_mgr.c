@@ -10,11 +10,15 @@
 #include <string.h>
 #include <unistd.h>
 #include <limits.h>
+#include <pthread.h>
 
 #include "storage_mgr.h"
 #include "buffer_mgr.h"
+#include "latency.h"
 
 #define SIZE_byte (sizeof(char)) // Size 1 Byte.
+// Adds to a counter of a Buffer Pool; atomic so that getPoolCounters can read the counters without the lock.
+#define COUNT(_md, _counter, _n) __atomic_fetch_add(&(_md)->counters._counter, (_n), __ATOMIC_RELAXED)
 
 
 /*
@@ -28,6 +32,8 @@
  * page: Page Handler for the page stored in the frame.
  * seq: Sequencer Variable - Used while reading Buffer Pool Management Data (displaying purposes).
  * refBit: Clock Page Replacement Algorithm - Reference Bit.
+ * owner: Buffer Pool of the page file the page belongs to, NULL while the frame is empty.
+ * ioBusy: TRUE while pinPage reads the page into the frame or writes it back without holding the lock.
  */
 typedef struct Frame
 {
@@ -38,23 +44,64 @@ typedef struct Frame
     BM_PageHandle page;
     int seq;
     int refBit;
+    struct BM_MgmtData* owner;
+    bool ioBusy;
 } Frame;
 
 
+/*
+ * Structure: BM_Frames -
+ * The frames of a Buffer Pool, or of a BM_SharedPool whose frames hold the pages of several page files:
+ *
+ * strategy: Replacement Strategy choosing victims among all frames, whichever file their pages belong to.
+ * numFrames: Number of frames.
+ * clkPtr: Tracks the frame to which the clock is pointing at.
+ * head: stores head of the doubly linked list (buffer pool).
+ * tail: stores tail of the doubly linked list (buffer pool).
+ * shared: TRUE for the frames of a BM_SharedPool, which outlive the Buffer Pools using them.
+ * numPools: Number of Buffer Pools using the frames.
+ * numRetiring: Frames still to drop after a resize found too few of them unpinned; unpinPage drops one
+ *              (chosen by the Replacement Strategy) whenever a page is no longer pinned.
+ * lock: Serializes all operations on the frames so that several threads can pin pages concurrently.
+ * ioDone: Signalled when a frame stops being ioBusy, pinners of its page wait for it.
+ */
+typedef struct BM_Frames
+{
+	ReplacementStrategy strategy;
+	int numFrames;
+	Frame* clkPtr;
+	Frame* head;
+	Frame* tail;
+	bool shared;
+	int numPools;
+	int numRetiring;
+	pthread_mutex_t lock;
+	pthread_cond_t ioDone;
+}BM_Frames;
+
+
 /*
  * Structure: BM_MgmtData -
- * Stores additional mgmtInfo data:
+ * Stores additional mgmtInfo data of the Buffer Pool of one page file:
  *
  * frameContents: Array to store pageNum values for all frames in the buffer pool.
  * dirtyFlags: Array to store dirtyBit flags for all frames in the buffer pool.
  * fixCounts: Array to store fixBit values for all frames in the buffer pool.
  * refBits: Array to store refBit values for all frames in the buffer pool.
- * numReadIO: stores total number of reads done on BufferPool.
- * numWriteIO: stores total number of writes done on BufferPool.
- * clkPtr: Tracks the frame to which the clock is pointing at.
- * head: stores head of the doubly linked list (buffer pool).
- * tail: stores tail of the doubly linked list (buffer pool).
+ * counters: Hits, misses, reads, writes, evictions, dirty writes and pin waits of the BufferPool (see COUNT).
+ * frames: Frames holding the pages, private to this Buffer Pool or shared (see initBufferPoolShared).
+ * numBuffered: Number of frames holding pages of this file.
+ * quota: Maximum of numBuffered, 0 for no limit. A Buffer Pool at its quota replaces its own pages,
+ *        unless all of them are pinned.
  * fHandle: File Handler for the file to be read into the buffer.
+ * pageTable: Maps page numbers to the frame holding them (NULL if the page is not buffered).
+ *            Together with the Buffer Pool of the file it finds the frame of a (file, page).
+ * pageTableSize: Number of entries in pageTable, grown on demand.
+ * ioLock: Serializes the reads and writes of fHandle, as pinPage does them without holding the frames' lock.
+ * writePolicy: Whether unpinPage writes dirty pages (BM_WRITE_THROUGH) or replacing and flushing does (BM_WRITE_BACK).
+ * readAhead: Pages read together with a page whose predecessor was read last (sequential access), 0 for none.
+ * lastRead: Page read from disk last, by a miss or read ahead.
+ * statsSize: Entries of frameContents, dirtyFlags, fixCounts and refBits, reallocated when the frames were resized.
  */
 typedef struct BM_MgmtData
 {
@@ -62,29 +109,226 @@ typedef struct BM_MgmtData
 	bool *dirtyFlags;
 	int *fixCounts;
 	int *refBits;
-	int numReadIO;
-	int numWriteIO;
-	Frame* clkPtr;
-	Frame* head;
-	Frame* tail;
+	BM_PoolCounters counters;
+	BM_Frames* frames;
+	int numBuffered;
+	int quota;
 	SM_FileHandle fHandle;
+	Frame** pageTable;
+	int pageTableSize;
+	pthread_mutex_t ioLock;
+	BM_WritePolicy writePolicy;
+	int readAhead;
+	PageNumber lastRead;
+	int statsSize;
 }BM_MgmtData;
 
 
+/*
+ * Function lookupFrame:
+ *
+ * Returns the frame holding page pageNum, or NULL if the page is not in the Buffer Pool.
+ */
+static Frame* lookupFrame(BM_MgmtData* md, PageNumber pageNum)
+{
+	if(pageNum<0 || pageNum>=md->pageTableSize)
+		return NULL;
+	return md->pageTable[pageNum];
+}
+
+/*
+ * Function mapFrame:
+ *
+ * Records in the page table of md that the (empty) frame now holds page pageNum.
+ */
+static void mapFrame(BM_MgmtData* md, Frame* frame, PageNumber pageNum)
+{
+	if(pageNum>=md->pageTableSize)
+	{
+		int size = md->pageTableSize;
+		while(size<=pageNum)
+			size = size*2;
+		md->pageTable = (Frame**)realloc(md->pageTable, sizeof(Frame*)*size);
+		memset(md->pageTable+md->pageTableSize, 0, sizeof(Frame*)*(size-md->pageTableSize));
+		md->pageTableSize = size;
+	}
+	md->pageTable[pageNum] = frame;
+	frame->page.pageNum = pageNum;
+	frame->owner = md;
+	md->numBuffered = md->numBuffered+1;
+}
+
+/*
+ * Function readFramePage:
+ *
+ * Reads page pageNum of the file of md into data.
+ */
+static RC readFramePage(BM_MgmtData* md, PageNumber pageNum, char* data)
+{
+	RC rc;
+	pthread_mutex_lock(&md->ioLock);
+	rc = readBlock(pageNum, &md->fHandle, (SM_PageHandle)data);
+	pthread_mutex_unlock(&md->ioLock);
+	return rc;
+}
+
+/*
+ * Function writeFramePage:
+ *
+ * Writes data to page pageNum of the file of md.
+ */
+static RC writeFramePage(BM_MgmtData* md, PageNumber pageNum, char* data)
+{
+	RC rc;
+	pthread_mutex_lock(&md->ioLock);
+	rc = writeBlock(pageNum, &md->fHandle, (SM_PageHandle)data);
+	pthread_mutex_unlock(&md->ioLock);
+	return rc;
+}
+
+/*
+ * Function readFramePages:
+ *
+ * Reads numPages pages of the file of md from pageNum on into datas[0..numPages-1] with readBlocks.
+ */
+static RC readFramePages(BM_MgmtData* md, PageNumber pageNum, int numPages, SM_PageHandle* datas)
+{
+	RC rc;
+	pthread_mutex_lock(&md->ioLock);
+	rc = readBlocks(pageNum, numPages, &md->fHandle, datas);
+	pthread_mutex_unlock(&md->ioLock);
+	return rc;
+}
+
+/*
+ * Function releaseFrame:
+ *
+ * Empties a frame, writing its page to the file it belongs to first if the page is dirty.
+ */
+static void releaseFrame(Frame* frame)
+{
+	BM_MgmtData* owner = frame->owner;
+
+	if(owner==NULL)
+		return;
+	if(frame->dirtyBit==TRUE)
+	{
+		writeFramePage(owner, frame->page.pageNum, frame->page.data);
+		COUNT(owner, numWriteIO, 1);
+		COUNT(owner, numDirtyWrites, 1);
+		frame->dirtyBit = FALSE;
+	}
+	if(lookupFrame(owner, frame->page.pageNum)==frame)
+		owner->pageTable[frame->page.pageNum] = NULL;
+	owner->numBuffered = owner->numBuffered-1;
+	frame->owner = NULL;
+	frame->page.pageNum = NO_PAGE;
+	frame->refBit = 0;
+}
+
+/*
+ * Function evictFrame:
+ *
+ * Empties a frame to make room for another page (or to drop the frame), counting the eviction of its page.
+ */
+static void evictFrame(Frame* frame)
+{
+	if(frame->owner!=NULL)
+		COUNT(frame->owner, numEvictions, 1);
+	releaseFrame(frame);
+}
+
+/*
+ * Function moveToHead:
+ *
+ * Unlinks a frame from the doubly linked list and places it as the new Head.
+ */
+static void moveToHead(BM_Frames* frames, Frame* frame)
+{
+	if(frame == frames->head)
+		return;
+	if(frame == frames->tail) //Frame at Tail of the Linked List.
+		frames->tail = frame->prev;
+	else //Frame at an intermediate Node of the Linked List.
+		frame->next->prev = frame->prev;
+	frame->prev->next = frame->next;
+
+	frame->prev = NULL;
+	frame->next = frames->head; // Old Head should be pointed as the next of the new Head.
+	frames->head->prev = frame; // Old Head's prev pointer should point to the new Head.
+	frames->head = frame;
+}
+
+/*
+ * Function evictable:
+ *
+ * Tells whether Buffer Pool md may replace the page held by frame: the frame must not be pinned,
+ * and with useQuota a Buffer Pool at its quota may only replace its own pages.
+ */
+static bool evictable(BM_MgmtData* md, Frame* frame, bool useQuota)
+{
+	if(frame->fixBit!=0)
+		return FALSE;
+	return !useQuota || md->quota<=0 || md->numBuffered<md->quota || frame->owner==md;
+}
+
+/*
+ * Function findVictim:
+ *
+ * Chooses the frame to read a page of md into using the Replacement Strategy, NULL if none is evictable.
+ * md may be NULL without useQuota.
+ */
+static Frame* findVictim(BM_Frames* frames, BM_MgmtData* md, bool useQuota)
+{
+	Frame* frame = NULL;
+	int i;
+
+	// FIFO or LRU Page Replacement Implementation:
+	if(frames->strategy == RS_FIFO || frames->strategy == RS_LRU )
+	{
+		//Search for a frame from the tail-end whose fixBit is Zero (0) and read the page into this frame.
+		frame = frames->tail;
+		while(frame!=NULL && !evictable(md, frame, useQuota))
+			frame = frame->prev;
+	}
+
+	// Clock Replacement Algorithm Implementation:
+	else if(frames->strategy == RS_CLOCK)
+	{
+		frame = frames->clkPtr; // Start Searching for a frame beginning from the clkPtr Position.
+		for(i=0;i<2*frames->numFrames;i++) // Twice around, the first round may only reset refBits.
+		{
+			if(evictable(md, frame, useQuota))
+			{
+				if(frame->refBit == 0) // Check for a frame whose fixBit and refBit are both 0.
+					break;
+				frame->refBit=0; // Continue Resetting refBit as the clkPtr progresses.
+			}
+			frame = frame->next;
+		}
+		if(i<2*frames->numFrames)
+			frames->clkPtr=frame->next; //clkPtr should point to the next of the replaced page frame.
+		else
+			frame = NULL;
+	}
+	return frame;
+}
+
+
 /*
  * Function activateFrames:
  *
  * Creates and places 'numPages' number of frames (client specified) into the Buffer Pool.
  *
  * frame: Memory Allocated frame (node) to be inserted into the Buffer Pool (Doubly Linked List).
- * bm: Buffer Manager
+ * frames: Frames of the Buffer Pool
  * i: Sequence Number of the Frame
  */
-RC activateFrames(Frame* frame, BM_BufferPool *const bm, int i)
+RC activateFrames(Frame* frame, BM_Frames* frames, int i)
 {
 	if(frame==NULL)
 		return RC_BM_NULL_FRAME;
-	if(bm==NULL)
+	if(frames==NULL)
 		return RC_BM_NULL_BUFFER;
 
 	//Initialize Frames
@@ -95,28 +339,146 @@ RC activateFrames(Frame* frame, BM_BufferPool *const bm, int i)
 	frame->page.pageNum = -1;
 	frame->seq = i;
 	frame->refBit = 0;
+	frame->owner = NULL;
+	frame->ioBusy = FALSE;
 	frame->page.data = (char*)malloc(SIZE_byte * PAGE_SIZE);
 	memset(frame->page.data, 0, SIZE_byte * PAGE_SIZE);
 
 	//Backing up Head Frame from BufferPool.
-	Frame* head = ((BM_MgmtData*)bm->mgmtData)->head;
+	Frame* head = frames->head;
 
 	//Placing Subsequent Frames in BufferPool.
 	if(head!=NULL && i!=0)
 	{
-		((BM_MgmtData*)bm->mgmtData)->head = frame; // New Head
+		frames->head = frame; // New Head
 		frame->next = head;
 		head->prev = frame;
 	}
 	//Placing First Frame in BufferPool as both Head & Tail.
 	else
 	{
-		((BM_MgmtData*)bm->mgmtData)->head = frame;
-		((BM_MgmtData*)bm->mgmtData)->tail = frame;
+		frames->head = frame;
+		frames->tail = frame;
 	}
 	return RC_OK;
 }
 
+/*
+ * Function createFrames:
+ *
+ * Allocates numFrames empty frames replaced with the given Replacement Strategy.
+ */
+static BM_Frames* createFrames(int numFrames, ReplacementStrategy strategy, bool shared)
+{
+	BM_Frames* frames = (BM_Frames*)malloc(sizeof(BM_Frames));
+	frames->strategy = strategy;
+	frames->numFrames = numFrames;
+	frames->head = NULL;
+	frames->tail = NULL;
+	frames->clkPtr = NULL;
+	frames->shared = shared;
+	frames->numPools = 0;
+	frames->numRetiring = 0;
+
+	//Recursive, as unpinPage and shutdownBufferPool call forcePage and forceFlushPool.
+	pthread_mutexattr_t attr;
+	pthread_mutexattr_init(&attr);
+	pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+	pthread_mutex_init(&frames->lock, &attr);
+	pthread_mutexattr_destroy(&attr);
+	pthread_cond_init(&frames->ioDone, NULL);
+
+	//Create Doubly Linked List with numFrames Nodes.
+	Frame* frame;
+	int i=0;
+	while(i<numFrames)
+	{
+		frame=(Frame*)malloc(sizeof(Frame));
+		activateFrames(frame,frames,i);
+		i++;
+	}
+	//Convert to Circular Linked List if Clock Replacement Algorithm requested.
+	if(strategy == RS_CLOCK)
+	{
+		frames->clkPtr = frames->head;
+		frames->tail->next = frames->head;
+		frames->head->prev = frames->tail;
+	}
+	return frames;
+}
+
+/*
+ * Function destroyFrames:
+ *
+ * Frees the frames and the memory of their pages.
+ */
+static void destroyFrames(BM_Frames* frames)
+{
+	Frame* frame=frames->head;
+	Frame* nextFrame;
+	int i;
+	for(i=0;i<frames->numFrames;i++)
+	{
+		nextFrame = frame->next; // Save link before the frame is released.
+		free(frame->page.data);
+		free(frame);
+		frame = nextFrame;
+	}
+	pthread_mutex_destroy(&frames->lock);
+	pthread_cond_destroy(&frames->ioDone);
+	free(frames);
+}
+
+/*
+ * Function attachPool:
+ *
+ * Initializes the Buffer Pool of a page file keeping its pages in the given frames, failing if the file cannot be opened.
+ */
+static RC attachPool(BM_BufferPool *const bm, const char *const pageFileName, BM_Frames* frames, int quota)
+{
+	SM_FileHandle fHandle;
+	RC rc;
+
+	//Open Client's Page File
+	if((rc=openPageFile((char*)pageFileName,&fHandle))!=RC_OK)
+		return rc;
+
+	//Populate BM_BufferPool structure's contents, using arguments provided by Client.
+	bm->pageFile=(char*)pageFileName;
+	bm->numPages=frames->numFrames;
+	bm->strategy=frames->strategy;
+
+	//Memory Allocation for BM_MgmtData.
+	BM_MgmtData* md =(BM_MgmtData*)malloc(sizeof(BM_MgmtData));
+
+	//Store BM_MgmtData within mgmtData of BM_BufferPool
+	bm->mgmtData=md;
+
+	//Reset/Initialize BM_MgmtData statistics variables.
+	memset(&md->counters, 0, sizeof(BM_PoolCounters));
+	md->frames=frames;
+	md->numBuffered=0;
+	md->quota=quota;
+	md->frameContents=(PageNumber*)malloc(sizeof(PageNumber)*frames->numFrames);
+	md->dirtyFlags=(bool*)malloc(sizeof(bool)*frames->numFrames);
+	md->fixCounts=(int*)malloc(sizeof(int)*frames->numFrames);
+	md->refBits=(int*)malloc(sizeof(int)*frames->numFrames);
+	md->pageTableSize=(frames->numFrames>0) ? frames->numFrames : 1;
+	md->pageTable=(Frame**)calloc(md->pageTableSize, sizeof(Frame*));
+	pthread_mutex_init(&md->ioLock, NULL);
+	md->writePolicy=BM_WRITE_THROUGH;
+	md->readAhead=0;
+	md->lastRead=NO_PAGE;
+	md->statsSize=frames->numFrames;
+
+	md->fHandle=fHandle;
+
+	pthread_mutex_lock(&frames->lock);
+	frames->numPools = frames->numPools+1;
+	pthread_mutex_unlock(&frames->lock);
+	return RC_OK;
+}
+
 /*
  * Function initBufferPool:
  *
@@ -132,47 +494,345 @@ RC initBufferPool(BM_BufferPool *const bm, const char *const pageFileName,
 	if(bm==NULL)
 		return RC_BM_NULL_BUFFER;
 
-	//Populate BM_BufferPool structure's contents, using arguments provided by Client.
-	bm->pageFile=(char*)pageFileName;
-	bm->numPages=numPages;
-	bm->strategy=strategy;
+	BM_Frames* frames = createFrames(numPages, strategy, FALSE);
+	RC rc = attachPool(bm, pageFileName, frames, 0);
+	if(rc!=RC_OK)
+		destroyFrames(frames);
+	return rc;
+}
 
-	//Memory Allocation for BM_MgmtData.
-	BM_MgmtData* md =(BM_MgmtData*)malloc(sizeof(BM_MgmtData));
+/*
+ * Function initSharedPool:
+ *
+ * Creates numPages frames shared by the Buffer Pools of several page files (see initBufferPoolShared).
+ * Pages of all files compete for the frames under one Replacement Strategy.
+ */
 
-	//Store BM_MgmtData within mgmtData of BM_BufferPool
-	bm->mgmtData=md;
+RC initSharedPool(BM_SharedPool *const sp, const int numPages, ReplacementStrategy strategy)
+{
+	if(sp==NULL)
+		return RC_BM_NULL_BUFFER;
 
-	//Reset/Initialize BM_MgmtData statistics variables.
-	md->numReadIO=0;
-	md->numWriteIO=0;
-	md->frameContents=(PageNumber*)malloc(sizeof(PageNumber)*numPages);
-	md->dirtyFlags=(bool*)malloc(sizeof(bool)*numPages);
-	md->fixCounts=(int*)malloc(sizeof(int)*numPages);
-	md->refBits=(int*)malloc(sizeof(int)*numPages);
+	sp->numPages=numPages;
+	sp->strategy=strategy;
+	sp->mgmtData=createFrames(numPages, strategy, TRUE);
+	return RC_OK;
+}
 
-	//Open Client's Page File
-	openPageFile(bm->pageFile,&md->fHandle);
+/*
+ * Function shutdownSharedPool:
+ *
+ * Frees the frames of a Shared Pool. All Buffer Pools using it have to be shut down before.
+ */
+
+RC shutdownSharedPool(BM_SharedPool *const sp)
+{
+	if(sp==NULL || sp->mgmtData==NULL)
+		return RC_BM_NULL_BUFFER;
+
+	BM_Frames* frames = (BM_Frames*)sp->mgmtData;
+	if(frames->numPools>0)
+		return RC_BM_POOL_IN_USE;
+	destroyFrames(frames);
+	sp->mgmtData=NULL;
+	return RC_OK;
+}
 
-	//Create Doubly Linked List with numPages Nodes.
+/*
+ * Function initBufferPoolShared:
+ *
+ * Initializes the Buffer Pool for the client-specified Page File keeping its pages in the frames of a Shared Pool.
+ * quota limits the frames holding pages of this file (0 for no limit).
+ */
+
+RC initBufferPoolShared(BM_BufferPool *const bm, const char *const pageFileName,
+			BM_SharedPool *const sp, const int quota)
+{
+	if(pageFileName==NULL)
+		return RC_BM_NULL_PGFILE;
+	if(bm==NULL || sp==NULL || sp->mgmtData==NULL)
+		return RC_BM_NULL_BUFFER;
+
+	return attachPool(bm, pageFileName, (BM_Frames*)sp->mgmtData, quota);
+}
+
+/*
+ * Function setPoolQuota:
+ *
+ * Limits the frames holding pages of the Buffer Pool's file to numPages (0 for no limit).
+ * A Buffer Pool above its new quota replaces its own pages until it is back within it.
+ */
+
+RC setPoolQuota(BM_BufferPool *const bm, const int numPages)
+{
+	if(bm==NULL)
+		return RC_BM_NULL_BUFFER;
+
+	BM_MgmtData* md = (BM_MgmtData*)bm->mgmtData;
+	pthread_mutex_lock(&md->frames->lock);
+	md->quota = numPages;
+	pthread_mutex_unlock(&md->frames->lock);
+	return RC_OK;
+}
+
+/*
+ * Function setWritePolicy:
+ *
+ * Chooses when dirty pages are written: by unpinPage (BM_WRITE_THROUGH, the default), or once their frame
+ * is replaced, the pool flushed or shut down (BM_WRITE_BACK), so a page modified many times is written once.
+ */
+
+RC setWritePolicy(BM_BufferPool *const bm, BM_WritePolicy policy)
+{
+	if(bm==NULL)
+		return RC_BM_NULL_BUFFER;
+
+	BM_MgmtData* md = (BM_MgmtData*)bm->mgmtData;
+	pthread_mutex_lock(&md->frames->lock);
+	md->writePolicy = policy;
+	pthread_mutex_unlock(&md->frames->lock);
+	return RC_OK;
+}
+
+/*
+ * Function setReadAhead:
+ *
+ * When a page following the page read last is missed, pinPage reads up to numPages pages behind it
+ * into further frames with the same call (readBlocks). 0 turns read ahead off, more than
+ * BM_MAX_READ_AHEAD pages are cut to it.
+ */
+
+RC setReadAhead(BM_BufferPool *const bm, const int numPages)
+{
+	if(bm==NULL)
+		return RC_BM_NULL_BUFFER;
+
+	BM_MgmtData* md = (BM_MgmtData*)bm->mgmtData;
+	pthread_mutex_lock(&md->frames->lock);
+	md->readAhead = (numPages>BM_MAX_READ_AHEAD) ? BM_MAX_READ_AHEAD : ((numPages>0) ? numPages : 0);
+	pthread_mutex_unlock(&md->frames->lock);
+	return RC_OK;
+}
+
+/*
+ * Function unlinkFrame:
+ *
+ * Removes a frame from the (doubly or circular) linked list.
+ */
+static void unlinkFrame(BM_Frames* frames, Frame* frame)
+{
+	if(frames->clkPtr == frame)
+		frames->clkPtr = frame->next;
+	if(frames->head == frame)
+		frames->head = frame->next;
+	if(frames->tail == frame)
+		frames->tail = frame->prev;
+	if(frame->prev!=NULL)
+		frame->prev->next = frame->next;
+	if(frame->next!=NULL)
+		frame->next->prev = frame->prev;
+	frame->next = NULL;
+	frame->prev = NULL;
+}
+
+/*
+ * Function retireFrame:
+ *
+ * Drops one unpinned frame chosen by the Replacement Strategy, writing its page back if it is dirty.
+ * The frame with the highest seq takes over its seq, so the frames stay numbered 0..numFrames-1.
+ * The caller holds the lock.
+ */
+static void retireFrame(BM_Frames* frames)
+{
+	Frame* victim = findVictim(frames, NULL, FALSE);
 	Frame* frame;
-	int i=0;
-	while(i<numPages)
+	int i;
+
+	if(victim==NULL)
+		return;
+	evictFrame(victim);
+	unlinkFrame(frames, victim);
+	frames->numFrames = frames->numFrames-1;
+	frame = frames->head;
+	for(i=0;i<frames->numFrames;i++)
 	{
-		frame=(Frame*)malloc(sizeof(Frame));
-		activateFrames(frame,bm,i);
-		i++;
+		if(frame->seq == frames->numFrames)
+			frame->seq = victim->seq;
+		frame = frame->next;
 	}
-	//Convert to Circular Linked List if Clock Replacement Algorithm requested.
-	if(bm->strategy == RS_CLOCK)
+	free(victim->page.data);
+	free(victim);
+}
+
+/*
+ * Function resizeFrames:
+ *
+ * Grows or shrinks the frames to numFrames, the caller holds the lock.
+ * New frames are empty and placed where the Replacement Strategy takes its next victim;
+ * shrinking replaces as many pages as frames are dropped, choosing them with the Replacement Strategy.
+ * Frames that cannot be dropped because their pages are pinned are retired by unpinPage later on.
+ */
+static RC resizeFrames(BM_Frames* frames, int numFrames)
+{
+	Frame* frame;
+	Frame** bySeq;
+	int numUnpinned = 0;
+	int numDrop;
+	int i, seq;
+
+	if(numFrames<1)
+		return RC_BM_NULL_FRAME;
+
+	frames->numRetiring = 0; // A new size replaces the one still being shrunk to.
+	if(numFrames<frames->numFrames)
 	{
-		((BM_MgmtData*)bm->mgmtData)->clkPtr = md->head;
-		md->tail->next = md->head;
-		md->head->prev = md->tail;
+		frame = frames->head;
+		for(i=0;i<frames->numFrames;i++)
+		{
+			if(frame->fixBit==0)
+				numUnpinned++;
+			frame = frame->next;
+		}
+		numDrop = frames->numFrames-numFrames;
+		if(numUnpinned<numDrop)
+		{
+			frames->numRetiring = numDrop-numUnpinned; // Dropped as pages are unpinned.
+			numDrop = numUnpinned;
+		}
+
+		// Frames by seq, to number the remaining ones 0..numFrames-1 in their order.
+		bySeq = (Frame**)calloc(frames->numFrames, sizeof(Frame*));
+		frame = frames->head;
+		for(i=0;i<frames->numFrames;i++)
+		{
+			bySeq[frame->seq] = frame;
+			frame = frame->next;
+		}
+		for(i=0;i<numDrop;i++)
+		{
+			frame = findVictim(frames, NULL, FALSE);
+			evictFrame(frame); // Write the replaced page back if it is dirty.
+			unlinkFrame(frames, frame);
+			bySeq[frame->seq] = NULL;
+			free(frame->page.data);
+			free(frame);
+		}
+		for(i=0, seq=0;i<frames->numFrames;i++)
+			if(bySeq[i]!=NULL)
+				bySeq[i]->seq = seq++;
+		free(bySeq);
+		frames->numFrames = frames->numFrames-numDrop;
+		return RC_OK;
 	}
+
+	for(i=frames->numFrames;i<numFrames;i++)
+	{
+		frame = (Frame*)malloc(sizeof(Frame));
+		frame->dirtyBit = FALSE;
+		frame->fixBit = 0;
+		frame->page.pageNum = NO_PAGE;
+		frame->seq = i;
+		frame->refBit = 0;
+		frame->owner = NULL;
+		frame->ioBusy = FALSE;
+		frame->page.data = (char*)malloc(SIZE_byte * PAGE_SIZE);
+		memset(frame->page.data, 0, SIZE_byte * PAGE_SIZE);
+
+		if(frames->strategy == RS_CLOCK)
+		{
+			// Just before the clock pointer, which moves to the new frame.
+			frame->next = frames->clkPtr;
+			frame->prev = frames->clkPtr->prev;
+			frame->prev->next = frame;
+			frame->next->prev = frame;
+			frames->clkPtr = frame;
+		}
+		else
+		{
+			// At the Tail, where victims are searched first.
+			frame->next = NULL;
+			frame->prev = frames->tail;
+			frames->tail->next = frame;
+			frames->tail = frame;
+		}
+	}
+	frames->numFrames = numFrames;
 	return RC_OK;
 }
 
+/*
+ * Function syncStats:
+ *
+ * Fits the statistics arrays and numPages of a Buffer Pool to its frames, which may have been resized
+ * since (through another Buffer Pool of a Shared Pool, or by unpinPage retiring frames). The caller holds the lock.
+ */
+static void syncStats(BM_BufferPool *const bm)
+{
+	BM_MgmtData* md = (BM_MgmtData*)bm->mgmtData;
+	int numFrames = md->frames->numFrames;
+
+	if(md->statsSize!=numFrames)
+	{
+		md->frameContents=(PageNumber*)realloc(md->frameContents, sizeof(PageNumber)*numFrames);
+		md->dirtyFlags=(bool*)realloc(md->dirtyFlags, sizeof(bool)*numFrames);
+		md->fixCounts=(int*)realloc(md->fixCounts, sizeof(int)*numFrames);
+		md->refBits=(int*)realloc(md->refBits, sizeof(int)*numFrames);
+		md->statsSize = numFrames;
+	}
+	bm->numPages = numFrames;
+}
+
+/*
+ * Function resizeBufferPool:
+ *
+ * Grows or shrinks a Buffer Pool to numPages frames while it stays open; the pages in the remaining frames stay cached.
+ * Frames holding pinned pages are dropped once unpinned, until then numPages stays above the new size.
+ * The frames of a Shared Pool cannot be resized through one of its Buffer Pools (see resizeSharedPool).
+ */
+
+RC resizeBufferPool(BM_BufferPool *const bm, const int numPages)
+{
+	if(bm==NULL)
+		return RC_BM_NULL_BUFFER;
+
+	BM_MgmtData* md = (BM_MgmtData*)bm->mgmtData;
+	BM_Frames* frames = md->frames;
+	RC rc;
+
+	if(frames->shared)
+		return RC_BM_POOL_IN_USE;
+	pthread_mutex_lock(&frames->lock);
+	rc = resizeFrames(frames, numPages);
+	syncStats(bm);
+	pthread_mutex_unlock(&frames->lock);
+	return rc;
+}
+
+/*
+ * Function resizeSharedPool:
+ *
+ * Grows or shrinks the frames of a Shared Pool to numPages while its Buffer Pools keep pinning pages.
+ * New frames are taken by the next misses of any file; shrinking replaces the pages the Replacement Strategy
+ * picks, and frames whose pages are pinned are dropped as soon as they are unpinned.
+ * sp->numPages is the new size, the numPages of each Buffer Pool follows its frames.
+ */
+
+RC resizeSharedPool(BM_SharedPool *const sp, const int numPages)
+{
+	if(sp==NULL || sp->mgmtData==NULL)
+		return RC_BM_NULL_BUFFER;
+
+	BM_Frames* frames = (BM_Frames*)sp->mgmtData;
+	RC rc;
+
+	pthread_mutex_lock(&frames->lock);
+	rc = resizeFrames(frames, numPages);
+	if(rc==RC_OK)
+		sp->numPages = numPages;
+	pthread_mutex_unlock(&frames->lock);
+	return rc;
+}
+
 /*
  * Function shutdownBufferPool:
  *
@@ -186,33 +846,46 @@ RC shutdownBufferPool(BM_BufferPool *const bm)
 
 	//Read BufferPool's mgmtData into BM_MgmtData.
 	BM_MgmtData* md = (BM_MgmtData*)bm->mgmtData;
-	int pgCnt = bm->numPages;
+	BM_Frames* frames = md->frames;
 
 	//Retrieve Head Node(Frame) of the BufferPool.
-	Frame* frame=(Frame*)md->head;
+	Frame* frame;
 
-	//Check DirtyBit & FixCountBit of all Frames before ShutDown.
+	//Check FixCountBit of the Frames of this file before ShutDown.
 	int i;
-	for(i=0;i<pgCnt;i++)
+	pthread_mutex_lock(&frames->lock);
+	frame=frames->head;
+	for(i=0;i<frames->numFrames;i++)
 	{
-		if(frame->fixBit!=0)
-					return RC_WRITE_FAILED; //Cannot Shutdown Buffer Pool while a client is still accessing a page.
-		else if(frame->dirtyBit==TRUE)
-			forceFlushPool(bm); //Write Frame Contents to Disk if the Page was Dirty.
+		if(frame->owner==md && frame->fixBit!=0)
+		{
+			pthread_mutex_unlock(&frames->lock);
+			return RC_WRITE_FAILED; //Cannot Shutdown Buffer Pool while a client is still accessing a page.
+		}
 		frame = frame->next;
 	}
 
-	//Free BufferPool Memory.
-	frame=(Frame*)md->head;
-	for(i=0;i<pgCnt;i++)
+	//Write Frame Contents to Disk if the Page was Dirty, leaving the frames empty for other files.
+	frame=frames->head;
+	for(i=0;i<frames->numFrames;i++)
 	{
-		free(frame);
+		if(frame->owner==md)
+			releaseFrame(frame);
 		frame = frame->next;
 	}
+	frames->numPools = frames->numPools-1;
+	pthread_mutex_unlock(&frames->lock);
+
+	//Free BufferPool Memory.
+	if(!frames->shared)
+		destroyFrames(frames);
+	closePageFile(&md->fHandle);
     free(md->frameContents);
     free(md->dirtyFlags);
     free(md->fixCounts);
     free(md->refBits);
+    free(md->pageTable);
+    pthread_mutex_destroy(&md->ioLock);
     free(md);
     md=NULL;
     return RC_OK;
@@ -231,54 +904,99 @@ RC forceFlushPool(BM_BufferPool *const bm)
 
 	//Read BufferPool's mgmtData into BM_MgmtData.
 	BM_MgmtData* md = (BM_MgmtData*)bm->mgmtData;
-	int pgCnt = bm->numPages;
+	BM_Frames* frames = md->frames;
 
 	//Retrieve Head Node(Frame) of the BufferPool.
-	Frame* frame=(Frame*)md->head;
+	Frame* frame;
 	int i = 0;
-	while(i<pgCnt)
+	pthread_mutex_lock(&frames->lock);
+	frame=frames->head;
+	while(i<frames->numFrames)
 	{
-		if(frame->dirtyBit && frame->fixBit==0)
+		if(frame->owner==md && frame->dirtyBit && frame->fixBit==0)
 		{
-			writeBlock(frame->page.pageNum, &md->fHandle, (SM_PageHandle)frame->page.data);
+			writeFramePage(md, frame->page.pageNum, frame->page.data);
+			COUNT(md, numWriteIO, 1);
+			COUNT(md, numDirtyWrites, 1);
 			frame->dirtyBit=FALSE;
 		}
 		frame = frame->next;
 		i++;
 	}
+	pthread_mutex_unlock(&frames->lock);
 	return RC_OK;
 }
 
 /*
- * Function markDirty:
+ * Function truncatePool:
  *
- * Marks the Client-specified page within bm BufferPool as Dirty.
+ * Shrinks the page file to its first numPages pages, dropping the frames holding the pages behind them.
+ * None of these pages may be pinned.
  */
 
-RC markDirty (BM_BufferPool *const bm, BM_PageHandle *const page)
+RC truncatePool(BM_BufferPool *const bm, const int numPages)
 {
-	if(page==NULL)
-		return RC_BM_NULL_PAGE;
 	if(bm==NULL)
 		return RC_BM_NULL_BUFFER;
 
 	//Read BufferPool's mgmtData into BM_MgmtData.
 	BM_MgmtData* md = (BM_MgmtData*)bm->mgmtData;
-	int pgCnt = bm->numPages;
+	BM_Frames* frames = md->frames;
+	Frame* frame;
+	RC rc;
+	int i;
 
-	//Retrieve Head Node(Frame) of the BufferPool.
-	Frame* frame=(Frame*)md->head;
+	pthread_mutex_lock(&frames->lock);
+	frame=frames->head;
+	for(i=0;i<frames->numFrames;i++)
+	{
+		if(frame->owner==md && frame->page.pageNum>=numPages && frame->fixBit!=0)
+		{
+			pthread_mutex_unlock(&frames->lock);
+			return RC_WRITE_FAILED; //Cannot drop a page while a client is still accessing it.
+		}
+		frame = frame->next;
+	}
 
-	int i;
-	for(i=0;i<pgCnt;i++)
+	//Empty the frames, their contents are discarded without writing them.
+	frame=frames->head;
+	for(i=0;i<frames->numFrames;i++)
 	{
-		if(frame->page.pageNum==page->pageNum) //Search for the required page in the BufferPool
+		if(frame->owner==md && frame->page.pageNum>=numPages)
 		{
-			frame->dirtyBit=TRUE;
-			break;
+			frame->dirtyBit = FALSE;
+			releaseFrame(frame);
 		}
 		frame = frame->next;
 	}
+	pthread_mutex_lock(&md->ioLock);
+	rc = truncatePageFile(numPages, &md->fHandle);
+	pthread_mutex_unlock(&md->ioLock);
+	pthread_mutex_unlock(&frames->lock);
+	return rc;
+}
+
+/*
+ * Function markDirty:
+ *
+ * Marks the Client-specified page within bm BufferPool as Dirty.
+ */
+
+RC markDirty (BM_BufferPool *const bm, BM_PageHandle *const page)
+{
+	if(page==NULL)
+		return RC_BM_NULL_PAGE;
+	if(bm==NULL)
+		return RC_BM_NULL_BUFFER;
+
+	//Read BufferPool's mgmtData into BM_MgmtData.
+	BM_MgmtData* md = (BM_MgmtData*)bm->mgmtData;
+
+	pthread_mutex_lock(&md->frames->lock);
+	Frame* frame=lookupFrame(md, page->pageNum); //Search for the required page in the BufferPool
+	if(frame!=NULL)
+		frame->dirtyBit=TRUE;
+	pthread_mutex_unlock(&md->frames->lock);
 	return RC_OK;
 }
 
@@ -297,32 +1015,35 @@ RC unpinPage (BM_BufferPool *const bm, BM_PageHandle *const page)
 
 	//Read BufferPool's mgmtData into BM_MgmtData.
 	BM_MgmtData* md = (BM_MgmtData*)bm->mgmtData;
-	int pgCnt = bm->numPages;
+	RC rc = RC_OK;
 
-	//Retrieve Head Node(Frame) of the BufferPool.
-	Frame* frame=(Frame*)md->head;
-
-	int i;
-	for(i=0;i<pgCnt;i++)
+	pthread_mutex_lock(&md->frames->lock);
+	Frame* frame=lookupFrame(md, page->pageNum);
+	if(frame!=NULL)
 	{
-		if(frame->page.pageNum==page->pageNum)
+		frame->fixBit = frame->fixBit-1; //Decrement fixBit by 1
+		if(frame->fixBit<0)
+			rc = RC_WRITE_FAILED; //Cannot UnPin a page which is not pinned in any frame of the Buffer Pool.
+
+		// Write Page to Disk if it is Dirty, unless writing is deferred until the frame is replaced
+		else if(frame->dirtyBit==TRUE && md->writePolicy==BM_WRITE_THROUGH)
 		{
-			frame->fixBit = frame->fixBit-1; //Decrement fixBit by 1
-			if(frame->fixBit<0)
-				return RC_WRITE_FAILED; //Cannot UnPin a page which is not pinned in any frame of the Buffer Pool.
+			// Overwrite with Latest page data given by Client.
+			frame->page.data = page->data;
+			forcePage(bm, page); // Write Dirty Page Data to Disk.
+			COUNT(md, numDirtyWrites, 1);
+			frame->dirtyBit = FALSE; // Page on Disk is now up to date.
+		}
 
-			// Write Page to Disk if it is Dirty
-			if(frame->dirtyBit==TRUE)
-			{
-				// Overwrite with Latest page data given by Client.
-				frame->page.data = page->data;
-				forcePage(bm, page); // Write Dirty Page Data to Disk.
-			}
-			break;
+		// A shrinking pool drops a frame as soon as one is free.
+		if(frame->fixBit==0 && md->frames->numRetiring>0)
+		{
+			retireFrame(md->frames);
+			md->frames->numRetiring = md->frames->numRetiring-1;
 		}
-		frame = frame->next;
 	}
-	return RC_OK;
+	pthread_mutex_unlock(&md->frames->lock);
+	return rc;
 }
 
 /*
@@ -341,8 +1062,10 @@ RC forcePage (BM_BufferPool *const bm, BM_PageHandle *const page)
 	//Read BufferPool's mgmtData into BM_MgmtData.
 	BM_MgmtData* md = (BM_MgmtData*)bm->mgmtData;
 
-	writeBlock(page->pageNum, &md->fHandle, (SM_PageHandle)page->data);
-	md->numWriteIO = md->numWriteIO+1;
+	pthread_mutex_lock(&md->frames->lock);
+	writeFramePage(md, page->pageNum, page->data);
+	COUNT(md, numWriteIO, 1);
+	pthread_mutex_unlock(&md->frames->lock);
 	return RC_OK;
 }
 
@@ -355,6 +1078,9 @@ RC forcePage (BM_BufferPool *const bm, BM_PageHandle *const page)
  * Else, the page is read from Disk and pinned to the buffer frame.
  *
  * Uses the client specified Page Replacement Algorithm while replacing or pinning pages.
+ * The victim may hold a page of another file sharing the frames (see initBufferPoolShared).
+ * The replaced page is written back and the page read without holding the lock: the frame stays pinned
+ * and ioBusy meanwhile, and other pinners of either page wait until the I/O is done.
  */
 
 RC pinPage (BM_BufferPool *const bm, BM_PageHandle *const page,
@@ -368,118 +1094,192 @@ RC pinPage (BM_BufferPool *const bm, BM_PageHandle *const page,
 	//Read BufferPool's mgmtData into BM_MgmtData.
 
 	BM_MgmtData* md = (BM_MgmtData*)bm->mgmtData;
-	int pgCnt = bm->numPages;
-
-	//Retrieve Head Node(Frame) of the BufferPool.
-	Frame* frame=(Frame*)md->head;
-	Frame* oldHead = (Frame*)md->head;
-
-	/*---------------------------------------------------------------------
-	 * Attempting to find Page in Buffer:
-	 */
+	BM_Frames* frames = md->frames;
+	BM_MgmtData* owner;
+	Frame* frame;
+	Frame* ahead[1+BM_MAX_READ_AHEAD];
+	SM_PageHandle datas[1+BM_MAX_READ_AHEAD];
+	int numRead;
+	RC rc;
 	int i;
-	for(i=0;i<pgCnt;i++)
+	LATENCY_START(start);
+
+	if(pthread_mutex_trylock(&frames->lock)!=0)
 	{
-		if(frame->page.pageNum==pageNum)
+		COUNT(md, numPinWaits, 1); // Another thread holds the frames.
+		pthread_mutex_lock(&frames->lock);
+	}
+	while(TRUE)
+	{
+		/*---------------------------------------------------------------------
+		 * Attempting to find Page in Buffer:
+		 */
+		frame=lookupFrame(md, pageNum);
+		if(frame!=NULL && frame->ioBusy)
+		{
+			// Another thread is reading the page or writing it back, look again once it is done.
+			pthread_cond_wait(&frames->ioDone, &frames->lock);
+			continue;
+		}
+		if(frame!=NULL)
 		{
 			frame->fixBit = frame->fixBit + 1;
 			frame->refBit = 1;
 			page->pageNum = frame->page.pageNum;
 			page->data = frame->page.data;
+			COUNT(md, numHits, 1);
 
 			//Following Process for LRU Replacement Strategy:
-			if(bm->strategy == RS_LRU)
-			{
-				oldHead = (Frame*)md->head;
-				if(frame == (Frame*)md->tail)
-				{
-					frame->prev->next = NULL;
-					((BM_MgmtData*)bm->mgmtData)->tail = frame->prev;
-					frame->prev = NULL;
-				}
-				else
-				{
-					frame->prev->next = frame->next;
-					frame->next->prev = frame->prev;
-				}
-				((BM_MgmtData*)bm->mgmtData)->head = frame;
-				frame->next = oldHead;
-				oldHead->prev = frame;
-			}
-			else if(bm->strategy == RS_CLOCK)
+			if(frames->strategy == RS_LRU)
+				moveToHead(frames, frame);
+			else if(frames->strategy == RS_CLOCK)
 			{
-				md->clkPtr=frame->next;
+				frames->clkPtr=frame->next;
 			}
+			pthread_mutex_unlock(&frames->lock);
+			LATENCY_END(LAT_PIN_HIT, start);
 			return RC_OK;
 		}
-		frame = frame->next;
-	}
 
-	/*---------------------------------------------------------------------
-	// Using Page Replacement if Page not already in BufferPool.
-	// Read the page from disk and load into memory.
-	*/
+		/*---------------------------------------------------------------------
+		// Using Page Replacement if Page not already in BufferPool.
+		// Read the page from disk and load into memory.
+		*/
 
-	// FIFO or LRU Page Replacement Implementation:
-	if(bm->strategy == RS_FIFO || bm->strategy == RS_LRU )
-	{
-		//Search for a frame from the tail-end whose fixBit is Zero (0) and read the page into this frame.
-		frame = (Frame*)md->tail;
-		while(frame->prev!=NULL)
+		// The quota is a soft limit: when all frames of this file are pinned, another frame is taken.
+		frame = findVictim(frames, md, TRUE);
+		if(frame==NULL && md->quota>0)
+			frame = findVictim(frames, md, FALSE);
+
+		if(frame==NULL)
 		{
-			if(frame->fixBit == 0)
-				break;
-			frame = frame->prev;
+			pthread_mutex_unlock(&frames->lock);
+			return RC_BM_NO_FREE_FRAME; // All frames this Buffer Pool may replace are pinned.
 		}
-		readBlock(pageNum,&md->fHandle,(SM_PageHandle)frame->page.data);
-
-		frame->fixBit = frame->fixBit + 1; //Increment fixBit
-		md->numReadIO = md->numReadIO + 1; //Increment BufferManager Statistics numReadIO
 
-		//Re-organizing Linked List - Place the newly pinned Page as the Head of the Linked List.
-		oldHead = (Frame*)md->head;
-
-		if(frame == (Frame*)md->tail) //If page was replaced at Tail of the Linked List.
+		// Pinned, the frame cannot be chosen again or dropped while the lock is released.
+		frame->fixBit = frame->fixBit + 1;
+		frame->ioBusy = TRUE;
+		if(frame->dirtyBit==TRUE)
 		{
-			frame->prev->next = NULL;
-			((BM_MgmtData*)bm->mgmtData)->tail = frame->prev;
-			frame->prev = NULL;
+			// Write the replaced page back.
+			owner = frame->owner;
+			pthread_mutex_unlock(&frames->lock);
+			rc = writeFramePage(owner, frame->page.pageNum, frame->page.data);
+			pthread_mutex_lock(&frames->lock);
+			if(rc==RC_OK)
+			{
+				COUNT(owner, numWriteIO, 1);
+				COUNT(owner, numDirtyWrites, 1);
+				frame->dirtyBit = FALSE;
+			}
+			if(rc!=RC_OK || lookupFrame(md, pageNum)!=NULL)
+			{
+				// Failed, or the page was pinned by another thread meanwhile: keep the replaced page.
+				frame->fixBit = frame->fixBit - 1;
+				frame->ioBusy = FALSE;
+				pthread_cond_broadcast(&frames->ioDone);
+				if(rc!=RC_OK)
+				{
+					pthread_mutex_unlock(&frames->lock);
+					return rc;
+				}
+				continue;
+			}
 		}
-		else //If page was replaced at an intermediate Node of the Linked List.
+		evictFrame(frame);
+		mapFrame(md, frame, pageNum);
+		pthread_cond_broadcast(&frames->ioDone); // Pinners of the replaced page may read it again.
+
+		// Sequential access: read the following pages into further frames with the same call.
+		// Read ahead only takes frames whose page need not be written back first.
+		numRead = 1;
+		ahead[0] = frame;
+		datas[0] = frame->page.data;
+		if(md->readAhead>0 && pageNum==md->lastRead+1)
 		{
-			frame->prev->next = frame->next;
-			frame->next->prev = frame->prev;
+			while(numRead<=md->readAhead && pageNum+numRead<md->fHandle.totalNumPages
+					&& lookupFrame(md, pageNum+numRead)==NULL
+					&& (ahead[numRead] = findVictim(frames, md, TRUE))!=NULL
+					&& ahead[numRead]->dirtyBit==FALSE)
+			{
+				evictFrame(ahead[numRead]);
+				ahead[numRead]->fixBit = 1; // Held until the read is done, so it is not chosen again.
+				ahead[numRead]->ioBusy = TRUE;
+				mapFrame(md, ahead[numRead], pageNum+numRead);
+				datas[numRead] = ahead[numRead]->page.data;
+				numRead++;
+			}
 		}
-		((BM_MgmtData*)bm->mgmtData)->head = frame; // Make this newly pinned page the new Head.
-		frame->next = oldHead; // Old Head should be pointed as the next of the new Head.
-		oldHead->prev = frame; // Old Head's prev pointer should point to the new Head.
-	}
 
-	// Clock Replacement Algorithm Implementation:
-	else if(bm->strategy == RS_CLOCK)
-	{
-		frame = (Frame*)md->clkPtr; // Start Searching for a frame beginning from the clkPtr Position.
-		for(i=0;i<pgCnt;i++)
+		pthread_mutex_unlock(&frames->lock);
+		if(numRead>1)
+			rc = readFramePages(md, pageNum, numRead, datas);
+		else
+			rc = readFramePage(md, pageNum, frame->page.data); //Read the page from disk to the designated frame.
+		pthread_mutex_lock(&frames->lock);
+		for(i=0;i<numRead;i++)
+			ahead[i]->ioBusy = FALSE;
+		for(i=1;i<numRead;i++)
+			ahead[i]->fixBit = 0;
+		pthread_cond_broadcast(&frames->ioDone);
+		if(rc!=RC_OK)
 		{
-			if(frame->fixBit == 0 && frame->refBit == 0) // Check for a frame whose fixBit and refBit are both 0.
-				break;
-			frame->refBit=0; // Continue Resetting refBit as the clkPtr progresses.
-			frame = frame->next;
+			// Leave the frames empty rather than pinned with garbage.
+			frame->fixBit = frame->fixBit - 1;
+			for(i=0;i<numRead;i++)
+				releaseFrame(ahead[i]);
+			pthread_mutex_unlock(&frames->lock);
+			return rc;
 		}
-		md->clkPtr=frame->next; //clkPtr should point to the next of the replaced page frame.
-		readBlock(pageNum,&md->fHandle,(SM_PageHandle)frame->page.data); //Read the page from disk to the designated frame.
-		frame->fixBit = frame->fixBit + 1; // Increment the fixBit of the frame which is used to replace the page by 1.
-		frame->refBit = 1; // Set refBit to 1 for the frame which is used to replace a Page.
-		md->numReadIO = md->numReadIO + 1; //Increment the BufferManager statistics numReadIO by 1.
+		for(i=0;i<numRead;i++)
+			ahead[i]->refBit = 1; // Set refBit to 1 for the frames which are used to replace Pages.
+		COUNT(md, numMisses, 1);
+		COUNT(md, numReadIO, numRead); //Increment BufferManager Statistics numReadIO
+		md->lastRead = pageNum + numRead - 1;
+
+		//Re-organizing Linked List - Place the newly read Pages as the Head of the Linked List, the pinned one first.
+		if(frames->strategy == RS_FIFO || frames->strategy == RS_LRU )
+			for(i=numRead-1;i>=0;i--)
+				moveToHead(frames, ahead[i]);
+
+		page->pageNum=pageNum;
+		page->data=frame->page.data;
+
+		pthread_mutex_unlock(&frames->lock);
+		LATENCY_END(LAT_PIN_MISS, start);
+		return RC_OK;
 	}
+}
 
-	frame->page.pageNum = pageNum;
-	page->pageNum=pageNum;
-	page->data=frame->page.data;
 
-	return RC_OK;
-}
+/*
+ * Function fillFrameStats:
+ *
+ * Fills the arrays that are not NULL with the state of every frame in one pass: indexed by seq for FIFO and LRU,
+ * in the order of the clock for CLOCK. Frames holding no page of this Buffer Pool show NO_PAGE, not dirty,
+ * fix count and refBit 0. The caller holds the lock.
+ */
+static void fillFrameStats(BM_MgmtData* md, PageNumber* pageNums, bool* dirty, int* fixCounts, int* refBits)
+{
+	Frame* frame = md->frames->head;
+	bool bySeq = md->frames->strategy==RS_FIFO || md->frames->strategy==RS_LRU;
+	int i, pos;
 
+	for(i=0;i<md->frames->numFrames;i++)
+	{
+		pos = bySeq ? frame->seq : i;
+		if(pageNums!=NULL)
+			pageNums[pos] = (frame->owner==md) ? frame->page.pageNum : NO_PAGE;
+		if(dirty!=NULL)
+			dirty[pos] = (frame->owner==md) && frame->dirtyBit;
+		if(fixCounts!=NULL)
+			fixCounts[pos] = (frame->owner==md) ? frame->fixBit : 0;
+		if(refBits!=NULL)
+			refBits[pos] = (frame->owner==md) ? frame->refBit : 0;
+		frame = frame->next;
+	}
+}
 
 /*
  * Function getFrameContents
@@ -494,36 +1294,11 @@ PageNumber *getFrameContents (BM_BufferPool *const bm)
 
 	//Read BufferPool's mgmtData into BM_MgmtData.
 	BM_MgmtData* md = (BM_MgmtData*)bm->mgmtData;
-	int pgCnt = bm->numPages;
-
-	//Retrieve Head Node(Frame) of the BufferPool.
-	Frame* frame=(Frame*)md->head;
-
-	PageNumber* data = ((BM_MgmtData*)bm->mgmtData)->frameContents;
-	if(data!=NULL && (bm->strategy==RS_FIFO || bm->strategy==RS_LRU))
-	{
-		int i,j;
-		for(i=0;i<pgCnt;i++)
-		{
-			for(j=0;j<pgCnt;j++)
-			{
-				if(frame->seq == i)
-					data[i] = frame->page.pageNum;
-				frame = frame->next;
-			}
-			frame=(Frame*)md->head;
-		}
-	}
-	else if(data!=NULL && bm->strategy==RS_CLOCK)
-	{
-		int i;
-		for(i=0;i<pgCnt;i++)
-		{
-			data[i]=frame->page.pageNum;
-			frame=frame->next;
-		}
-	}
-	return data;
+	pthread_mutex_lock(&md->frames->lock);
+	syncStats(bm); // The frames may have been resized since.
+	fillFrameStats(md, md->frameContents, NULL, NULL, NULL);
+	pthread_mutex_unlock(&md->frames->lock);
+	return md->frameContents;
 }
 
 
@@ -540,36 +1315,11 @@ bool *getDirtyFlags (BM_BufferPool *const bm)
 
 	//Read BufferPool's mgmtData into BM_MgmtData.
 	BM_MgmtData* md = (BM_MgmtData*)bm->mgmtData;
-	int pgCnt = bm->numPages;
-
-	//Retrieve Head Node(Frame) of the BufferPool.
-	Frame* frame=(Frame*)md->head;
-
-	bool* dirtyBits = ((BM_MgmtData*)bm->mgmtData)->dirtyFlags;
-	if(dirtyBits!=NULL && (bm->strategy==RS_FIFO || bm->strategy==RS_LRU))
-	{
-		int i,j;
-		for(i=0;i<pgCnt;i++)
-		{
-			for(j=0;j<pgCnt;j++)
-			{
-				if(frame->seq == i)
-					dirtyBits[i] = frame->dirtyBit;
-				frame = frame->next;
-			}
-			frame=(Frame*)md->head;
-		}
-	}
-	else if(dirtyBits!=NULL && bm->strategy==RS_CLOCK)
-		{
-			int i;
-			for(i=0;i<pgCnt;i++)
-			{
-				dirtyBits[i]=frame->dirtyBit;
-				frame=frame->next;
-			}
-		}
-	return dirtyBits;
+	pthread_mutex_lock(&md->frames->lock);
+	syncStats(bm);
+	fillFrameStats(md, NULL, md->dirtyFlags, NULL, NULL);
+	pthread_mutex_unlock(&md->frames->lock);
+	return md->dirtyFlags;
 }
 
 
@@ -586,36 +1336,11 @@ int *getFixCounts (BM_BufferPool *const bm)
 
 	//Read BufferPool's mgmtData into BM_MgmtData.
 	BM_MgmtData* md = (BM_MgmtData*)bm->mgmtData;
-	int pgCnt = bm->numPages;
-
-	//Retrieve Head Node(Frame) of the BufferPool.
-	Frame* frame=(Frame*)md->head;
-
-	int* fixCnts = ((BM_MgmtData*)bm->mgmtData)->fixCounts;
-	if(fixCnts!=NULL && (bm->strategy==RS_FIFO || bm->strategy==RS_LRU))
-	{
-		int i,j;
-		for(i=0;i<pgCnt;i++)
-		{
-			for(j=0;j<pgCnt;j++)
-			{
-				if(frame->seq == i)
-					fixCnts[i] = frame->fixBit;
-				frame = frame->next;
-			}
-			frame=(Frame*)md->head;
-		}
-	}
-	else if(fixCnts!=NULL && bm->strategy==RS_CLOCK)
-		{
-			int i;
-			for(i=0;i<pgCnt;i++)
-			{
-				fixCnts[i]=frame->fixBit;
-				frame=frame->next;
-			}
-		}
-	return fixCnts;
+	pthread_mutex_lock(&md->frames->lock);
+	syncStats(bm);
+	fillFrameStats(md, NULL, NULL, md->fixCounts, NULL);
+	pthread_mutex_unlock(&md->frames->lock);
+	return md->fixCounts;
 }
 
 
@@ -633,22 +1358,72 @@ int *getRefBits (BM_BufferPool *const bm)
 
 	//Read BufferPool's mgmtData into BM_MgmtData.
 	BM_MgmtData* md = (BM_MgmtData*)bm->mgmtData;
-	int pgCnt = bm->numPages;
+	pthread_mutex_lock(&md->frames->lock);
+	syncStats(bm);
+	fillFrameStats(md, NULL, NULL, NULL, md->refBits);
+	pthread_mutex_unlock(&md->frames->lock);
+	return md->refBits;
+}
 
-	//Retrieve Head Node(Frame) of the BufferPool.
-	Frame* frame=(Frame*)md->head;
+/*
+ * Function getPoolSnapshot:
+ *
+ * Copies the state of all frames and the counters of a Buffer Pool at one point in time, in one pass over
+ * the frames while holding the lock once. The arrays are allocated for the caller, see freePoolSnapshot.
+ */
 
-	int* refBits = ((BM_MgmtData*)bm->mgmtData)->refBits;
-	if(refBits!=NULL)
-		{
-			int i;
-			for(i=0;i<pgCnt;i++)
-			{
-				refBits[i]=frame->refBit;
-				frame=frame->next;
-			}
-		}
-	return refBits;
+RC getPoolSnapshot (BM_BufferPool *const bm, BM_PoolSnapshot *snapshot)
+{
+	if(bm==NULL)
+		return RC_BM_NULL_BUFFER;
+
+	BM_MgmtData* md = (BM_MgmtData*)bm->mgmtData;
+	int i, numFrames;
+
+	pthread_mutex_lock(&md->frames->lock);
+	numFrames = md->frames->numFrames;
+	snapshot->numFrames = numFrames;
+	snapshot->strategy = md->frames->strategy;
+	snapshot->frameContents = (PageNumber*)malloc(sizeof(PageNumber)*numFrames);
+	snapshot->dirtyFlags = (bool*)malloc(sizeof(bool)*numFrames);
+	snapshot->fixCounts = (int*)malloc(sizeof(int)*numFrames);
+	snapshot->refBits = (int*)malloc(sizeof(int)*numFrames);
+	fillFrameStats(md, snapshot->frameContents, snapshot->dirtyFlags, snapshot->fixCounts, snapshot->refBits);
+	getPoolCounters(bm, &snapshot->counters);
+	pthread_mutex_unlock(&md->frames->lock);
+
+	snapshot->numBuffered = 0;
+	snapshot->numPinned = 0;
+	snapshot->numDirty = 0;
+	for(i=0;i<numFrames;i++)
+	{
+		if(snapshot->frameContents[i]!=NO_PAGE)
+			snapshot->numBuffered++;
+		if(snapshot->fixCounts[i]>0)
+			snapshot->numPinned++;
+		if(snapshot->dirtyFlags[i])
+			snapshot->numDirty++;
+	}
+	return RC_OK;
+}
+
+/*
+ * Function freePoolSnapshot:
+ *
+ * Frees the arrays of a snapshot taken by getPoolSnapshot.
+ */
+
+RC freePoolSnapshot (BM_PoolSnapshot *snapshot)
+{
+	free(snapshot->frameContents);
+	free(snapshot->dirtyFlags);
+	free(snapshot->fixCounts);
+	free(snapshot->refBits);
+	snapshot->frameContents = NULL;
+	snapshot->dirtyFlags = NULL;
+	snapshot->fixCounts = NULL;
+	snapshot->refBits = NULL;
+	return RC_OK;
 }
 
 /*
@@ -662,7 +1437,7 @@ int getNumReadIO (BM_BufferPool *const bm)
 	if(bm==NULL)
 		return RC_BM_NULL_BUFFER;
 	else
-		return ((BM_MgmtData*)bm->mgmtData)->numReadIO;
+		return (int)__atomic_load_n(&((BM_MgmtData*)bm->mgmtData)->counters.numReadIO, __ATOMIC_RELAXED);
 }
 
 
@@ -677,5 +1452,43 @@ int getNumWriteIO (BM_BufferPool *const bm)
 	if(bm==NULL)
 		return RC_BM_NULL_BUFFER;
 	else
-		return ((BM_MgmtData*)bm->mgmtData)->numWriteIO;
+		return (int)__atomic_load_n(&((BM_MgmtData*)bm->mgmtData)->counters.numWriteIO, __ATOMIC_RELAXED);
+}
+
+
+/*
+ * Function getNumHits:
+ *
+ * Returns the count of pins the Buffer Manager served from its frames without reading the page from Disk
+ */
+
+int getNumHits (BM_BufferPool *const bm)
+{
+	if(bm==NULL)
+		return RC_BM_NULL_BUFFER;
+	else
+		return (int)__atomic_load_n(&((BM_MgmtData*)bm->mgmtData)->counters.numHits, __ATOMIC_RELAXED);
+}
+
+/*
+ * Function getPoolCounters:
+ *
+ * Copies the counters of a Buffer Pool without taking its lock, so monitoring never stops the pinning threads.
+ * Every counter is read atomically; counters updated meanwhile may be one operation apart from each other.
+ */
+
+RC getPoolCounters (BM_BufferPool *const bm, BM_PoolCounters *counters)
+{
+	if(bm==NULL)
+		return RC_BM_NULL_BUFFER;
+
+	BM_PoolCounters* c = &((BM_MgmtData*)bm->mgmtData)->counters;
+	counters->numHits = __atomic_load_n(&c->numHits, __ATOMIC_RELAXED);
+	counters->numMisses = __atomic_load_n(&c->numMisses, __ATOMIC_RELAXED);
+	counters->numReadIO = __atomic_load_n(&c->numReadIO, __ATOMIC_RELAXED);
+	counters->numWriteIO = __atomic_load_n(&c->numWriteIO, __ATOMIC_RELAXED);
+	counters->numEvictions = __atomic_load_n(&c->numEvictions, __ATOMIC_RELAXED);
+	counters->numDirtyWrites = __atomic_load_n(&c->numDirtyWrites, __ATOMIC_RELAXED);
+	counters->numPinWaits = __atomic_load_n(&c->numPinWaits, __ATOMIC_RELAXED);
+	return RC_OK;
 }
@@ -16,6 +16,12 @@ typedef enum ReplacementStrategy {
   RS_LRU_K = 4
 } ReplacementStrategy;
 
+// When dirty pages are written to the page file, see setWritePolicy
+typedef enum BM_WritePolicy {
+  BM_WRITE_THROUGH = 0, // by unpinPage
+  BM_WRITE_BACK = 1 // when the frame is replaced or the pool flushed or shut down
+} BM_WritePolicy;
+
 // Data Types and Structures
 typedef int PageNumber;
 #define NO_PAGE -1
@@ -28,6 +34,42 @@ typedef struct BM_BufferPool {
                   // manager needs for a buffer pool
 } BM_BufferPool;
 
+// frames shared by the buffer pools of several page files, see
+// initBufferPoolShared: pages of all files compete for the frames under one
+// replacement strategy
+typedef struct BM_SharedPool {
+  int numPages;
+  ReplacementStrategy strategy;
+  void *mgmtData;
+} BM_SharedPool;
+
+// counters of a buffer pool, updated atomically so that getPoolCounters
+// reads them without stopping the pool
+typedef struct BM_PoolCounters {
+  long numHits; // pins served from the frames
+  long numMisses; // pins reading their page
+  long numReadIO; // pages read, by misses and read ahead
+  long numWriteIO;
+  long numEvictions; // pages of the pool replaced by other pages or dropped by a resize
+  long numDirtyWrites; // modified pages written (unpinPage, replacement, flush)
+  long numPinWaits; // pins that waited for another thread to release the frames
+} BM_PoolCounters;
+
+// state of all frames of a buffer pool at one point in time, see
+// getPoolSnapshot; the arrays are ordered like the ones of getFrameContents
+typedef struct BM_PoolSnapshot {
+  int numFrames;
+  ReplacementStrategy strategy;
+  PageNumber *frameContents; // NO_PAGE for frames holding no page of the pool
+  bool *dirtyFlags;
+  int *fixCounts;
+  int *refBits;
+  int numBuffered; // frames holding pages of the pool
+  int numPinned;
+  int numDirty;
+  BM_PoolCounters counters;
+} BM_PoolSnapshot;
+
 typedef struct BM_PageHandle {
   PageNumber pageNum;
   char *data;
@@ -46,6 +88,22 @@ RC initBufferPool(BM_BufferPool *const bm, const char *const pageFileName,
 		  void *stratData);
 RC shutdownBufferPool(BM_BufferPool *const bm);
 RC forceFlushPool(BM_BufferPool *const bm);
+RC truncatePool(BM_BufferPool *const bm, const int numPages);
+RC resizeBufferPool(BM_BufferPool *const bm, const int numPages);
+RC setWritePolicy(BM_BufferPool *const bm, BM_WritePolicy policy);
+RC setReadAhead(BM_BufferPool *const bm, const int numPages);
+
+// Most pages read ahead, so a miss is read with a single readBlocks call
+#define BM_MAX_READ_AHEAD 63
+
+// Buffer Manager Interface Shared Pools
+RC initSharedPool(BM_SharedPool *const sp, const int numPages,
+		  ReplacementStrategy strategy);
+RC shutdownSharedPool(BM_SharedPool *const sp);
+RC initBufferPoolShared(BM_BufferPool *const bm, const char *const pageFileName,
+			BM_SharedPool *const sp, const int quota);
+RC setPoolQuota(BM_BufferPool *const bm, const int numPages);
+RC resizeSharedPool(BM_SharedPool *const sp, const int numPages);
 
 // Buffer Manager Interface Access Pages
 RC markDirty (BM_BufferPool *const bm, BM_PageHandle *const page);
@@ -60,5 +118,9 @@ bool *getDirtyFlags (BM_BufferPool *const bm);
 int *getFixCounts (BM_BufferPool *const bm);
 int getNumReadIO (BM_BufferPool *const bm);
 int getNumWriteIO (BM_BufferPool *const bm);
+int getNumHits (BM_BufferPool *const bm);
+RC getPoolCounters (BM_BufferPool *const bm, BM_PoolCounters *counters);
+RC getPoolSnapshot (BM_BufferPool *const bm, BM_PoolSnapshot *snapshot);
+RC freePoolSnapshot (BM_PoolSnapshot *snapshot);
 
 #endif
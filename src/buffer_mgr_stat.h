@@ -9,4 +9,8 @@ void printPageContent (BM_PageHandle *const page);
 char *sprintPoolContent (BM_BufferPool *const bm);
 char *sprintPageContent (BM_PageHandle *const page);
 
+// counters and frame states of a pool for a metrics scraper (Prometheus text format)
+void printPoolMetrics (BM_BufferPool *const bm);
+char *sprintPoolMetrics (BM_BufferPool *const bm);
+
 #endif
@@ -3,6 +3,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 // local functions
 static void printStrat (BM_BufferPool *const bm);
@@ -54,6 +55,49 @@ sprintPoolContent (BM_BufferPool *const bm)
 }
 
 
+// metrics of a pool in the Prometheus text format, one sample per line
+char *
+sprintPoolMetrics (BM_BufferPool *const bm)
+{
+  BM_PoolSnapshot snap;
+  char *message;
+  char *name = bm->pageFile;
+  int pos = 0;
+
+  getPoolSnapshot(bm, &snap);
+  message = (char *) malloc(2048 + 16 * strlen(name));
+  pos += sprintf(message + pos, "# TYPE bm_pins_total counter\n");
+  pos += sprintf(message + pos, "bm_pins_total{pool=\"%s\",result=\"hit\"} %ld\n", name, snap.counters.numHits);
+  pos += sprintf(message + pos, "bm_pins_total{pool=\"%s\",result=\"miss\"} %ld\n", name, snap.counters.numMisses);
+  pos += sprintf(message + pos, "# TYPE bm_read_io_total counter\n");
+  pos += sprintf(message + pos, "bm_read_io_total{pool=\"%s\"} %ld\n", name, snap.counters.numReadIO);
+  pos += sprintf(message + pos, "# TYPE bm_write_io_total counter\n");
+  pos += sprintf(message + pos, "bm_write_io_total{pool=\"%s\"} %ld\n", name, snap.counters.numWriteIO);
+  pos += sprintf(message + pos, "# TYPE bm_evictions_total counter\n");
+  pos += sprintf(message + pos, "bm_evictions_total{pool=\"%s\"} %ld\n", name, snap.counters.numEvictions);
+  pos += sprintf(message + pos, "# TYPE bm_dirty_writes_total counter\n");
+  pos += sprintf(message + pos, "bm_dirty_writes_total{pool=\"%s\"} %ld\n", name, snap.counters.numDirtyWrites);
+  pos += sprintf(message + pos, "# TYPE bm_pin_waits_total counter\n");
+  pos += sprintf(message + pos, "bm_pin_waits_total{pool=\"%s\"} %ld\n", name, snap.counters.numPinWaits);
+  pos += sprintf(message + pos, "# TYPE bm_frames gauge\n");
+  pos += sprintf(message + pos, "bm_frames{pool=\"%s\",state=\"total\"} %i\n", name, snap.numFrames);
+  pos += sprintf(message + pos, "bm_frames{pool=\"%s\",state=\"buffered\"} %i\n", name, snap.numBuffered);
+  pos += sprintf(message + pos, "bm_frames{pool=\"%s\",state=\"pinned\"} %i\n", name, snap.numPinned);
+  pos += sprintf(message + pos, "bm_frames{pool=\"%s\",state=\"dirty\"} %i\n", name, snap.numDirty);
+  freePoolSnapshot(&snap);
+
+  return message;
+}
+
+void
+printPoolMetrics (BM_BufferPool *const bm)
+{
+  char *message = sprintPoolMetrics(bm);
+
+  printf("%s", message);
+  free(message);
+}
+
 void
 printPageContent (BM_PageHandle *const page)
 {
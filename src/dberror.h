@@ -21,6 +21,7 @@ typedef int RC;
 #define RC_RM_NO_MORE_TUPLES 203
 #define RC_RM_NO_PRINT_FOR_DATATYPE 204
 #define RC_RM_UNKOWN_DATATYPE 205
+#define RC_RM_EXPR_TOO_COMPLEX 206
 
 #define RC_IM_KEY_NOT_FOUND 300
 #define RC_IM_KEY_ALREADY_EXISTS 301
@@ -31,12 +32,17 @@ typedef int RC;
 #define RC_BM_NULL_BUFFER 402
 #define RC_BM_NULL_PGFILE 403
 #define RC_BM_NULL_PAGE 404
+#define RC_BM_NO_FREE_FRAME 405
+#define RC_BM_POOL_IN_USE 406
 
 #define RC_RM_LARGE_SCHEMA 501
 #define RC_RM_LARGE_RECORD 502
 #define RC_RM_INSERT_FAILED 503
 #define RC_RM_DELETE_FAILED 504
 #define RC_RM_UPDATE_FAILED 505
+#define RC_RM_MEMORY_BUDGET 506
+#define RC_RM_READ_ONLY 507
+#define RC_RM_POOL_TOO_SMALL 508
 
 /* holder for error messages */
 extern char *RC_message;
@@ -1,10 +1,71 @@
 #include <string.h>
 #include <stdlib.h>
+#include <math.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 #include "dberror.h"
 #include "record_mgr.h"
 #include "expr.h"
 #include "tables.h"
+#include "latency.h"
+
+// prototypes
+static int countInstr (Expr *expr);
+static int countTerms (Expr *expr, OpType type);
+static Instr *initInstr (ExprProgram *program, InstrType type);
+static RC compileNode (Expr *expr, Schema *schema, ExprProgram *program);
+static RC compileTerms (Expr *expr, OpType type, Schema *schema, ExprProgram *program);
+static int instrCost (Instr *in);
+static void reorderProgram (ExprProgram *program);
+static void reorderGroup (ExprProgram *program, int group);
+static void linkGroup (ExprProgram *program, int group);
+static RC compileOperand (Expr *expr, Schema *schema, Operand *operand);
+static void buildValueSet (ValueSet *set);
+static bool valueSetContains (ValueSet *set, Operand *operand, char *data);
+static unsigned int hashOperand (Operand *operand, char *data);
+static char *operandString (Operand *operand, char *data, int *length);
+static int compareOperands (Operand *left, Operand *right, char *data);
+static bool cmpMatches (OpType op, int cmp);
+static bool evalComp (Instr *in, char *data);
+static int kernelMode (OpType op, bool attrLeft);
+static void runKernel (Operand *attr, Operand *cons, int mode, void *column, int numRecords, uint64_t *result);
+static RC evalBatch (ExprProgram *program, char *data, int stride, char **columns,
+		     int numRecords, uint64_t *selection, void *scratch);
+static char *batchRecord (Instr *in, char *data, int stride, char **columns, int i, char *row);
+static void compareBatch (Instr *in, char *data, int stride, char **columns, int numRecords,
+			  uint64_t *active, uint64_t *result, uint64_t *tmp, void *column, char *row);
+static void intKernel (int *column, int numRecords, int cons, int mode, uint64_t *result);
+static void floatKernel (float *column, int numRecords, float cons, int mode, uint64_t *result);
+
+// comparison of a column against a constant, as evaluated by the kernels
+#define KERNEL_EQ 0
+#define KERNEL_LT 1
+#define KERNEL_GT 2
+#define KERNEL_NE 3
+#define KERNEL_LE 4
+#define KERNEL_GE 5
+
+#define KERNEL_MATCH(_v,_c,_mode)					\
+  ((_mode) == KERNEL_EQ ? (_v) == (_c)					\
+   : (_mode) == KERNEL_NE ? (_v) != (_c)				\
+   : (_mode) == KERNEL_LT ? (_v) < (_c)					\
+   : (_mode) == KERNEL_LE ? (_v) <= (_c)				\
+   : (_mode) == KERNEL_GE ? (_v) >= (_c) : (_v) > (_c))
+
+// result of compareOperands when a float operand is NaN, no comparison
+// with NaN holds, as in valueEquals and valueSmaller
+#define CMP_UNORDERED 2
+
+// read an operand either from the record data or from its constant
+#define LOAD_OPERAND(_result,_operand,_data,_field)			\
+  do {									\
+    if ((_operand)->isAttr)						\
+      memcpy(&(_result), (_data) + (_operand)->offset, sizeof(_result)); \
+    else								\
+      (_result) = (_operand)->cons.v._field;				\
+  } while(0)
 
 // implementations
 RC 
@@ -50,6 +111,7 @@ valueSmaller (Value *left, Value *right, Value *result)
     break;
   case DT_BOOL:
     result->v.boolV = (left->v.boolV < right->v.boolV);
+    break;
   case DT_STRING:
     result->v.boolV = (strcmp(left->v.stringV, right->v.stringV) < 0);
     break;
@@ -58,6 +120,83 @@ valueSmaller (Value *left, Value *right, Value *result)
   return RC_OK;
 }
 
+RC
+valueGreater (Value *left, Value *right, Value *result)
+{
+  return valueSmaller(right, left, result);
+}
+
+// not the negation of valueGreater and valueSmaller, which would be true
+// for a NaN float
+RC
+valueSmallerEquals (Value *left, Value *right, Value *result)
+{
+  Value equal;
+
+  equal.v.boolV = FALSE;
+  if (valueSmaller(left, right, result) != RC_OK || valueEquals(left, right, &equal) != RC_OK)
+    THROW(RC_RM_COMPARE_VALUE_OF_DIFFERENT_DATATYPE, "comparison only supported for values of the same datatype");
+  result->v.boolV = (result->v.boolV || equal.v.boolV);
+  return RC_OK;
+}
+
+RC
+valueGreaterEquals (Value *left, Value *right, Value *result)
+{
+  return valueSmallerEquals(right, left, result);
+}
+
+RC
+valueNotEquals (Value *left, Value *right, Value *result)
+{
+  RC rc = valueEquals(left, right, result);
+  result->v.boolV = !result->v.boolV;
+  return rc;
+}
+
+RC
+valueBetween (Value *input, Value *lower, Value *upper, Value *result)
+{
+  Value upperOk;
+
+  if (valueGreaterEquals(input, lower, result) != RC_OK
+      || valueSmallerEquals(input, upper, &upperOk) != RC_OK)
+    THROW(RC_RM_COMPARE_VALUE_OF_DIFFERENT_DATATYPE, "between only supported for bounds of the same datatype");
+  result->v.boolV = (result->v.boolV && upperOk.v.boolV);
+
+  return RC_OK;
+}
+
+RC
+valueIn (Value *input, Value **values, int numValues, Value *result)
+{
+  Value found;
+  int i;
+
+  result->dt = found.dt = DT_BOOL;
+  result->v.boolV = found.v.boolV = FALSE;
+  for(i = 0; i < numValues && !result->v.boolV; i++)
+    {
+      if (valueEquals(input, values[i], &found) != RC_OK)
+	THROW(RC_RM_COMPARE_VALUE_OF_DIFFERENT_DATATYPE, "in only supported for lists of the same datatype");
+      result->v.boolV = found.v.boolV;
+    }
+
+  return RC_OK;
+}
+
+RC
+valuePrefix (Value *input, Value *prefix, Value *result)
+{
+  if (input->dt != DT_STRING || prefix->dt != DT_STRING)
+    THROW(RC_RM_COMPARE_VALUE_OF_DIFFERENT_DATATYPE, "prefix match only supported for strings");
+
+  result->dt = DT_BOOL;
+  result->v.boolV = (strncmp(input->v.stringV, prefix->v.stringV, strlen(prefix->v.stringV)) == 0);
+
+  return RC_OK;
+}
+
 RC 
 boolNot (Value *input, Value *result)
 {
@@ -74,6 +213,7 @@ boolAnd (Value *left, Value *right, Value *result)
 {
   if (left->dt != DT_BOOL || right->dt != DT_BOOL)
     THROW(RC_RM_BOOLEAN_EXPR_ARG_IS_NOT_BOOLEAN, "boolean AND requires boolean inputs");
+  result->dt = DT_BOOL;
   result->v.boolV = (left->v.boolV && right->v.boolV);
 
   return RC_OK;
@@ -84,16 +224,35 @@ boolOr (Value *left, Value *right, Value *result)
 {
   if (left->dt != DT_BOOL || right->dt != DT_BOOL)
     THROW(RC_RM_BOOLEAN_EXPR_ARG_IS_NOT_BOOLEAN, "boolean OR requires boolean inputs");
+  result->dt = DT_BOOL;
   result->v.boolV = (left->v.boolV || right->v.boolV);
 
   return RC_OK;
 }
 
+// with LATENCY_STATS, evalExpr measures a whole expression and evalTree
+// evaluates it recursively; without, they are the same function
+#ifdef LATENCY_STATS
+static RC evalTree (Record *record, Schema *schema, Expr *expr, Value **result);
+
 RC
 evalExpr (Record *record, Schema *schema, Expr *expr, Value **result)
 {
-  Value *lIn;
-  Value *rIn;
+  LATENCY_START(start);
+  RC rc = evalTree(record, schema, expr, result);
+  LATENCY_END(LAT_EVAL_EXPR, start);
+  return rc;
+}
+
+static RC
+#else
+#define evalTree evalExpr
+RC
+#endif
+evalTree (Record *record, Schema *schema, Expr *expr, Value **result)
+{
+  Value **in;
+  int i, n;
   MAKE_VALUE(*result, DT_INT, -1);
 
   switch(expr->type)
@@ -101,39 +260,72 @@ evalExpr (Record *record, Schema *schema, Expr *expr, Value **result)
     case EXPR_OP:
       {
       Operator *op = expr->expr.op;
-      bool twoArgs = (op->type != OP_BOOL_NOT);
-      //      lIn = (Value *) malloc(sizeof(Value));
-      //    rIn = (Value *) malloc(sizeof(Value));
-      
-      CHECK(evalExpr(record, schema, op->args[0], &lIn));
-      if (twoArgs)
-	CHECK(evalExpr(record, schema, op->args[1], &rIn));
+      in = (Value **) malloc(op->numArgs * sizeof(Value *));
+
+      // the left input of AND (OR) decides the result if it is FALSE (TRUE)
+      for(n = 0; n < op->numArgs; n++)
+	{
+	  CHECK(evalTree(record, schema, op->args[n], &in[n]));
+	  if (n == 0 && in[0]->dt == DT_BOOL
+	      && ((op->type == OP_BOOL_AND && !in[0]->v.boolV)
+		  || (op->type == OP_BOOL_OR && in[0]->v.boolV)))
+	    {
+	      n++;
+	      break;
+	    }
+	}
 
-      switch(op->type) 
+      if (n < op->numArgs)
+	{
+	  (*result)->dt = DT_BOOL;
+	  (*result)->v.boolV = in[0]->v.boolV;
+	}
+      else switch(op->type) 
 	{
 	case OP_BOOL_NOT:
-	  CHECK(boolNot(lIn, *result));
+	  CHECK(boolNot(in[0], *result));
 	  break;
 	case OP_BOOL_AND:
-	  CHECK(boolAnd(lIn, rIn, *result));
+	  CHECK(boolAnd(in[0], in[1], *result));
 	  break;
 	case OP_BOOL_OR:
-	  CHECK(boolOr(lIn, rIn, *result));
+	  CHECK(boolOr(in[0], in[1], *result));
 	  break;
 	case OP_COMP_EQUAL:
-	  CHECK(valueEquals(lIn, rIn, *result));
+	  CHECK(valueEquals(in[0], in[1], *result));
 	  break;
 	case OP_COMP_SMALLER:
-	  CHECK(valueSmaller(lIn, rIn, *result));
+	  CHECK(valueSmaller(in[0], in[1], *result));
+	  break;
+	case OP_COMP_GREATER:
+	  CHECK(valueGreater(in[0], in[1], *result));
+	  break;
+	case OP_COMP_SMALLER_EQUAL:
+	  CHECK(valueSmallerEquals(in[0], in[1], *result));
+	  break;
+	case OP_COMP_GREATER_EQUAL:
+	  CHECK(valueGreaterEquals(in[0], in[1], *result));
+	  break;
+	case OP_COMP_NOT_EQUAL:
+	  CHECK(valueNotEquals(in[0], in[1], *result));
+	  break;
+	case OP_COMP_BETWEEN:
+	  CHECK(valueBetween(in[0], in[1], in[2], *result));
+	  break;
+	case OP_COMP_IN:
+	  CHECK(valueIn(in[0], in + 1, op->numArgs - 1, *result));
+	  break;
+	case OP_COMP_PREFIX:
+	  CHECK(valuePrefix(in[0], in[1], *result));
 	  break;
 	default:
 	  break;
 	}
 
       // cleanup
-      freeVal(lIn);
-      if (twoArgs)
-	freeVal(rIn);
+      for(i = 0; i < n; i++)
+	freeVal(in[i]);
+      free(in);
       }
       break;
     case EXPR_CONST:
@@ -156,17 +348,11 @@ freeExpr (Expr *expr)
     case EXPR_OP:
       {
       Operator *op = expr->expr.op;
-      switch(op->type) 
-	{
-	case OP_BOOL_NOT:
-	  freeExpr(op->args[0]);
-	  break;
-	default:
-	  freeExpr(op->args[0]);
-	  freeExpr(op->args[1]);
-	  break;
-	}
+      int i;
+      for(i = 0; i < op->numArgs; i++)
+	freeExpr(op->args[i]);
       free(op->args);
+      free(op);
       }
       break;
     case EXPR_CONST:
@@ -188,3 +374,1019 @@ freeVal (Value *val)
   free(val);
 }
 
+/*
+ * compile a condition into a flat postfix program. Attribute references are
+ * resolved to offsets within the record data and constants are copied, so
+ * the program can be evaluated for every tuple without touching the Expr
+ * tree or allocating memory. Comparisons have to be between attributes or
+ * constants and IN lists have to consist of constants; conditions using
+ * other shapes return an error and have to be evaluated with evalExpr.
+ */
+RC
+compileExpr (Expr *expr, Schema *schema, ExprProgram **program)
+{
+  ExprProgram *prog;
+  int depth = 0;
+  int i;
+  RC rc;
+
+  prog = (ExprProgram *) malloc(sizeof(ExprProgram));
+  prog->numInstr = 0;
+  prog->numEvals = 0;
+  prog->instr = (Instr *) malloc(sizeof(Instr) * countInstr(expr));
+  prog->spare = NULL;
+
+  if ((rc = compileNode(expr, schema, prog)) != RC_OK)
+    {
+      freeProgram(prog);
+      return rc;
+    }
+
+  // the boolean stack has a fixed size so evaluation never allocates
+  for(i = 0; i < prog->numInstr; i++)
+    {
+      switch(prog->instr[i].type)
+	{
+	case INSTR_COMP:
+	case INSTR_PUSH:
+	case INSTR_GROUP:
+	  depth++;
+	  break;
+	case INSTR_SHORT_CIRCUIT:
+	  depth--;
+	  break;
+	case INSTR_BOOL_NOT:
+	  break;
+	}
+      if (depth > EXPR_STACK_SIZE)
+	{
+	  freeProgram(prog);
+	  THROW(RC_RM_EXPR_TOO_COMPLEX, "expression exceeds the stack of a compiled program");
+	}
+    }
+
+  // without statistics the terms of a group are ordered by their cost
+  prog->spare = (Instr *) malloc(sizeof(Instr) * prog->numInstr);
+  reorderProgram(prog);
+
+  *program = prog;
+  return RC_OK;
+}
+
+RC
+evalProgram (ExprProgram *program, char *data, bool *result)
+{
+  bool stack[EXPR_STACK_SIZE];
+  int top = 0;
+  int i;
+
+  for(i = 0; i < program->numInstr; i++)
+    {
+      Instr *in = &program->instr[i];
+
+      switch(in->type)
+	{
+	case INSTR_COMP:
+	  stack[top++] = evalComp(in, data);
+	  break;
+	case INSTR_PUSH:
+	  {
+	    bool b;
+	    LOAD_OPERAND(b, &in->left, data, boolV);
+	    stack[top++] = (b != 0);
+	  }
+	  break;
+	case INSTR_BOOL_NOT:
+	  stack[top - 1] = !stack[top - 1];
+	  break;
+	case INSTR_GROUP:
+	  stack[top++] = (in->op == OP_BOOL_AND);
+	  break;
+	case INSTR_SHORT_CIRCUIT:
+	  top--;
+	  in->numEvals++;
+	  if (stack[top] != (in->op == OP_BOOL_AND))
+	    {
+	      in->numDecided++;
+	      stack[top - 1] = stack[top];
+	      i += in->jump;
+	    }
+	  break;
+	}
+    }
+
+  if (++program->numEvals >= EXPR_REORDER_INTERVAL)
+    reorderProgram(program);
+
+  *result = stack[0];
+  return RC_OK;
+}
+
+/*
+ * evaluate a compiled program over a batch of numRecords records stored
+ * stride bytes apart and set bit i of selection for every matching record.
+ * Comparisons of an int or float attribute with constants gather the
+ * attribute into a column and compare four values per SIMD instruction;
+ * all other instructions are evaluated per record. Groups combine whole
+ * bitmaps a word at a time and keep a bitmap of the records they have not
+ * decided yet: records decided by an enclosing group are skipped by the
+ * per record comparisons and a group ends as soon as all are decided.
+ */
+RC
+evalProgramBatch (ExprProgram *program, char *data, int stride, int numRecords,
+		  uint64_t *selection, void *scratch)
+{
+  return evalBatch(program, data, stride, NULL, numRecords, selection, scratch);
+}
+
+/*
+ * evaluate a compiled program over a batch of numRecords records stored
+ * column by column: the values of attribute a are contiguous, typeLength
+ * bytes apart, starting at columns[a]. Only the columns of attributes the
+ * program refers to are read; the SIMD kernels compare the columns in
+ * place and the other comparisons read the attributes they need into a
+ * record.
+ */
+RC
+evalProgramColumns (ExprProgram *program, char **columns, int numRecords,
+		    uint64_t *selection, void *scratch)
+{
+  return evalBatch(program, NULL, 0, columns, numRecords, selection, scratch);
+}
+
+// evalProgramBatch and evalProgramColumns, columns is NULL for records stored stride bytes apart
+RC
+evalBatch (ExprProgram *program, char *data, int stride, char **columns,
+	   int numRecords, uint64_t *selection, void *scratch)
+{
+  char row[PAGE_SIZE]; // attributes of a record read from the columns
+  int words = BITMAP_WORDS(numRecords);
+  uint64_t *stack = (uint64_t *) scratch;
+  uint64_t *active = stack + (EXPR_STACK_SIZE * words);
+  uint64_t *tmp = active + ((EXPR_STACK_SIZE + 1) * words);
+  void *column = tmp + words;
+  uint64_t *top = stack;
+  uint64_t any;
+  int i, j, w;
+
+  // all records of the batch are undecided
+  memset(active, 0xFF, words * sizeof(uint64_t));
+  if (numRecords % 64 != 0)
+    active[words - 1] = (((uint64_t) 1) << (numRecords % 64)) - 1;
+
+  for(i = 0; i < program->numInstr; i++)
+    {
+      Instr *in = &program->instr[i];
+
+      switch(in->type)
+	{
+	case INSTR_COMP:
+	  compareBatch(in, data, stride, columns, numRecords, active, top, tmp, column, row);
+	  top += words;
+	  break;
+	case INSTR_PUSH:
+	  memset(top, 0, words * sizeof(uint64_t));
+	  for(j = 0; j < numRecords; j++)
+	    {
+	      bool b;
+	      if (!BITMAP_TEST(active, j))
+		continue;
+	      LOAD_OPERAND(b, &in->left, batchRecord(in, data, stride, columns, j, row), boolV);
+	      if (b)
+		top[j / 64] |= ((uint64_t) 1) << (j % 64);
+	    }
+	  top += words;
+	  break;
+	case INSTR_BOOL_NOT:
+	  for(w = 0; w < words; w++)
+	    top[w - words] = ~top[w - words];
+	  break;
+	case INSTR_GROUP:
+	  memset(top, (in->op == OP_BOOL_AND) ? 0xFF : 0, words * sizeof(uint64_t));
+	  top += words;
+	  memcpy(active + words, active, words * sizeof(uint64_t));
+	  active += words;
+	  break;
+	case INSTR_SHORT_CIRCUIT:
+	  top -= words;
+	  any = 0;
+	  for(w = 0; w < words; w++)
+	    {
+	      // records where the term is FALSE (TRUE) are decided
+	      uint64_t decided = active[w] & ((in->op == OP_BOOL_AND) ? ~top[w] : top[w]);
+	      in->numEvals += __builtin_popcountll(active[w]);
+	      in->numDecided += __builtin_popcountll(decided);
+	      if (in->op == OP_BOOL_AND)
+		top[w - words] &= top[w];
+	      else
+		top[w - words] |= top[w];
+	      active[w] &= ~decided;
+	      any |= active[w];
+	    }
+	  if (any == 0 || in->jump == 0)
+	    {
+	      active -= words;
+	      i += in->jump;
+	    }
+	  break;
+	}
+    }
+
+  program->numEvals += numRecords;
+  if (program->numEvals >= EXPR_REORDER_INTERVAL)
+    reorderProgram(program);
+
+  memcpy(selection, stack, words * sizeof(uint64_t));
+  // clear the bits past the last record
+  if (numRecords % 64 != 0)
+    selection[words - 1] &= (((uint64_t) 1) << (numRecords % 64)) - 1;
+
+  return RC_OK;
+}
+
+RC
+freeProgram (ExprProgram *program)
+{
+  int i, j;
+
+  for(i = 0; i < program->numInstr; i++)
+    {
+      Instr *in = &program->instr[i];
+      if (!in->left.isAttr && in->left.dt == DT_STRING)
+	free(in->left.cons.v.stringV);
+      if (!in->right.isAttr && in->right.dt == DT_STRING)
+	free(in->right.cons.v.stringV);
+      if (!in->upper.isAttr && in->upper.dt == DT_STRING)
+	free(in->upper.cons.v.stringV);
+      if (in->set != NULL)
+	{
+	  for(j = 0; j < in->set->numValues; j++)
+	    if (in->set->values[j].dt == DT_STRING)
+	      free(in->set->values[j].cons.v.stringV);
+	  free(in->set->values);
+	  free(in->set->buckets);
+	  free(in->set);
+	}
+    }
+  free(program->instr);
+  free(program->spare);
+  free(program);
+
+  return RC_OK;
+}
+
+/*
+ * number of instructions compileNode emits for an expression: a group
+ * adds its own instruction and a short circuit after every term, and
+ * nested groups of the same type are flattened into it
+ */
+int
+countInstr (Expr *expr)
+{
+  if (expr->type != EXPR_OP)
+    return 1;
+  switch(expr->expr.op->type)
+    {
+    case OP_BOOL_AND:
+    case OP_BOOL_OR:
+      return 1 + countTerms(expr, expr->expr.op->type);
+    case OP_BOOL_NOT:
+      return countInstr(expr->expr.op->args[0]) + 1;
+    default:
+      return 1;
+    }
+}
+
+int
+countTerms (Expr *expr, OpType type)
+{
+  int count = 0;
+  int i;
+
+  if (expr->type == EXPR_OP && expr->expr.op->type == type)
+    {
+      for(i = 0; i < expr->expr.op->numArgs; i++)
+	count += countTerms(expr->expr.op->args[i], type);
+      return count;
+    }
+  return countInstr(expr) + 1;
+}
+
+/*
+ * take the next instruction of a program. Operands that are not compiled
+ * are marked as attributes so freeProgram never frees them.
+ */
+Instr *
+initInstr (ExprProgram *program, InstrType type)
+{
+  Instr *in = &program->instr[program->numInstr++];
+
+  in->type = type;
+  in->left.isAttr = in->right.isAttr = in->upper.isAttr = TRUE;
+  in->left.attrNum = in->right.attrNum = in->upper.attrNum = -1;
+  in->set = NULL;
+  in->length = 1;
+  in->jump = 0;
+  in->numEvals = in->numDecided = 0;
+  return in;
+}
+
+RC
+compileNode (Expr *expr, Schema *schema, ExprProgram *program)
+{
+  Instr *in;
+  int i;
+  RC rc;
+
+  if (expr->type != EXPR_OP)
+    {
+      // a boolean attribute or constant used as a condition
+      in = initInstr(program, INSTR_PUSH);
+      if ((rc = compileOperand(expr, schema, &in->left)) != RC_OK)
+	return rc;
+      if (in->left.dt != DT_BOOL)
+	THROW(RC_RM_EXPR_RESULT_IS_NOT_BOOLEAN, "condition has to be boolean");
+      return RC_OK;
+    }
+
+  Operator *op = expr->expr.op;
+  switch(op->type)
+    {
+    case OP_BOOL_AND:
+    case OP_BOOL_OR:
+      {
+	int group = program->numInstr;
+	initInstr(program, INSTR_GROUP)->op = op->type;
+	if ((rc = compileTerms(expr, op->type, schema, program)) != RC_OK)
+	  return rc;
+	program->instr[group].length = program->numInstr - group;
+	linkGroup(program, group);
+      }
+      break;
+    case OP_BOOL_NOT:
+      if ((rc = compileNode(op->args[0], schema, program)) != RC_OK)
+	return rc;
+      initInstr(program, INSTR_BOOL_NOT);
+      break;
+    case OP_COMP_EQUAL:
+    case OP_COMP_SMALLER:
+    case OP_COMP_GREATER:
+    case OP_COMP_SMALLER_EQUAL:
+    case OP_COMP_GREATER_EQUAL:
+    case OP_COMP_NOT_EQUAL:
+    case OP_COMP_PREFIX:
+      in = initInstr(program, INSTR_COMP);
+      in->op = op->type;
+      if ((rc = compileOperand(op->args[0], schema, &in->left)) != RC_OK
+	  || (rc = compileOperand(op->args[1], schema, &in->right)) != RC_OK)
+	return rc;
+      if (in->left.dt != in->right.dt)
+	THROW(RC_RM_COMPARE_VALUE_OF_DIFFERENT_DATATYPE, "comparison only supported for values of the same datatype");
+      if (op->type == OP_COMP_PREFIX && in->left.dt != DT_STRING)
+	THROW(RC_RM_COMPARE_VALUE_OF_DIFFERENT_DATATYPE, "prefix match only supported for strings");
+      break;
+    case OP_COMP_BETWEEN:
+      in = initInstr(program, INSTR_COMP);
+      in->op = op->type;
+      if ((rc = compileOperand(op->args[0], schema, &in->left)) != RC_OK
+	  || (rc = compileOperand(op->args[1], schema, &in->right)) != RC_OK
+	  || (rc = compileOperand(op->args[2], schema, &in->upper)) != RC_OK)
+	return rc;
+      if (in->left.dt != in->right.dt || in->left.dt != in->upper.dt)
+	THROW(RC_RM_COMPARE_VALUE_OF_DIFFERENT_DATATYPE, "between only supported for bounds of the same datatype");
+      break;
+    case OP_COMP_IN:
+      in = initInstr(program, INSTR_COMP);
+      in->op = op->type;
+      if ((rc = compileOperand(op->args[0], schema, &in->left)) != RC_OK)
+	return rc;
+      in->set = (ValueSet *) malloc(sizeof(ValueSet));
+      in->set->numValues = 0;
+      in->set->values = (Operand *) malloc((op->numArgs - 1) * sizeof(Operand));
+      in->set->numBuckets = 0;
+      in->set->buckets = NULL;
+      for(i = 1; i < op->numArgs; i++)
+	{
+	  if (op->args[i]->type != EXPR_CONST)
+	    THROW(RC_RM_EXPR_TOO_COMPLEX, "in list has to consist of constants");
+	  compileOperand(op->args[i], schema, &in->set->values[in->set->numValues++]);
+	  if (op->args[i]->expr.cons->dt != in->left.dt)
+	    THROW(RC_RM_COMPARE_VALUE_OF_DIFFERENT_DATATYPE, "in only supported for lists of the same datatype");
+	}
+      buildValueSet(in->set);
+      break;
+    default:
+      THROW(RC_RM_EXPR_TOO_COMPLEX, "operator cannot be compiled");
+    }
+
+  return RC_OK;
+}
+
+/*
+ * compile the terms of a chain of AND (OR), nested operators of the same
+ * type are flattened into the group. Each term ends with a short circuit
+ * that knows the length and estimated cost of the term.
+ */
+RC
+compileTerms (Expr *expr, OpType type, Schema *schema, ExprProgram *program)
+{
+  Instr *in;
+  int start, i;
+  RC rc;
+
+  if (expr->type == EXPR_OP && expr->expr.op->type == type)
+    {
+      for(i = 0; i < expr->expr.op->numArgs; i++)
+	if ((rc = compileTerms(expr->expr.op->args[i], type, schema, program)) != RC_OK)
+	  return rc;
+      return RC_OK;
+    }
+
+  start = program->numInstr;
+  if ((rc = compileNode(expr, schema, program)) != RC_OK)
+    return rc;
+  in = initInstr(program, INSTR_SHORT_CIRCUIT);
+  in->op = type;
+  in->length = program->numInstr - start;
+  in->cost = 0;
+  for(i = start; i < program->numInstr - 1; i++)
+    in->cost += instrCost(&program->instr[i]);
+  return RC_OK;
+}
+
+RC
+compileOperand (Expr *expr, Schema *schema, Operand *operand)
+{
+  // nothing to free unless a string constant was copied
+  operand->isAttr = TRUE;
+
+  switch(expr->type)
+    {
+    case EXPR_ATTRREF:
+      if (schema == NULL || expr->expr.attrRef < 0 || expr->expr.attrRef >= schema->numAttr)
+	THROW(RC_RM_EXPR_TOO_COMPLEX, "attribute reference outside of the schema");
+      operand->dt = schema->dataTypes[expr->expr.attrRef];
+      operand->length = schema->typeLength[expr->expr.attrRef];
+      operand->attrNum = expr->expr.attrRef;
+      operand->offset = schema->attrOffsets[expr->expr.attrRef];
+      break;
+    case EXPR_CONST:
+      operand->isAttr = FALSE;
+      operand->dt = expr->expr.cons->dt;
+      operand->attrNum = -1;
+      operand->offset = 0;
+      operand->cons = *expr->expr.cons;
+      if (operand->dt == DT_STRING)
+	{
+	  operand->length = strlen(expr->expr.cons->v.stringV);
+	  operand->cons.v.stringV = (char *) malloc(operand->length + 1);
+	  strcpy(operand->cons.v.stringV, expr->expr.cons->v.stringV);
+	}
+      else
+	operand->length = 0;
+      break;
+    default:
+      THROW(RC_RM_EXPR_TOO_COMPLEX, "nested operator cannot be compared");
+    }
+
+  return RC_OK;
+}
+
+/*
+ * estimated cost of evaluating an instruction for one record. Strings are
+ * compared a character at a time and dominate the cost of a condition.
+ */
+int
+instrCost (Instr *in)
+{
+  int cost;
+
+  if (in->type != INSTR_COMP)
+    return (in->type == INSTR_PUSH) ? 1 : 0;
+
+  cost = (in->left.dt == DT_STRING) ? 2 + (in->left.length + in->right.length) / 4 : 1;
+  if (in->op == OP_COMP_BETWEEN)
+    cost *= 2;
+  else if (in->op == OP_COMP_IN)
+    cost *= (in->set->numBuckets == 0) ? in->set->numValues : 2;
+  return cost;
+}
+
+/*
+ * reorder the terms of all groups so the terms that decide the group at
+ * the lowest cost are evaluated first. Terms are ranked by their cost over
+ * the observed fraction of evaluations they decided; the statistics are
+ * halved afterwards so the order follows changes in the data.
+ */
+void
+reorderProgram (ExprProgram *program)
+{
+  int i = 0;
+
+  while (i < program->numInstr)
+    {
+      if (program->instr[i].type == INSTR_GROUP)
+	{
+	  reorderGroup(program, i);
+	  i += program->instr[i].length;
+	}
+      else
+	i++;
+    }
+  program->numEvals = 0;
+}
+
+void
+reorderGroup (ExprProgram *program, int group)
+{
+  Instr *instr = program->instr;
+  int end = group + instr[group].length;
+  int starts[EXPR_STACK_SIZE * 2], ends[EXPR_STACK_SIZE * 2];
+  double ranks[EXPR_STACK_SIZE * 2];
+  int numTerms = 0;
+  int pos = group + 1;
+  int i, j, n;
+  bool sorted = TRUE;
+
+  // find the terms, reordering nested groups first
+  while (pos < end && numTerms < EXPR_STACK_SIZE * 2)
+    {
+      starts[numTerms] = pos;
+      while (instr[pos].type != INSTR_SHORT_CIRCUIT)
+	{
+	  if (instr[pos].type == INSTR_GROUP)
+	    {
+	      reorderGroup(program, pos);
+	      pos += instr[pos].length;
+	    }
+	  else
+	    pos++;
+	}
+      ends[numTerms] = pos;
+      ranks[numTerms] = instr[pos].cost * (instr[pos].numEvals + 2.0) / (instr[pos].numDecided + 1.0);
+      instr[pos].numEvals /= 2;
+      instr[pos].numDecided /= 2;
+      if (numTerms > 0 && ranks[numTerms] < ranks[numTerms - 1])
+	sorted = FALSE;
+      numTerms++;
+      pos++;
+    }
+  if (sorted || pos != end)
+    return;
+
+  // stable insertion sort of the terms by rank
+  for(i = 1; i < numTerms; i++)
+    for(j = i; j > 0 && ranks[j] < ranks[j - 1]; j--)
+      {
+	double r = ranks[j]; ranks[j] = ranks[j - 1]; ranks[j - 1] = r;
+	int t = starts[j]; starts[j] = starts[j - 1]; starts[j - 1] = t;
+	t = ends[j]; ends[j] = ends[j - 1]; ends[j - 1] = t;
+      }
+
+  // jumps are relative, so terms and the groups inside them can be moved
+  n = 0;
+  for(i = 0; i < numTerms; i++)
+    {
+      int length = ends[i] - starts[i] + 1;
+      memcpy(program->spare + n, instr + starts[i], length * sizeof(Instr));
+      n += length;
+      program->spare[n - 1].jump = end - (group + 1 + n);
+    }
+  memcpy(instr + group + 1, program->spare, n * sizeof(Instr));
+}
+
+// point the short circuits of a group's terms to the end of the group
+void
+linkGroup (ExprProgram *program, int group)
+{
+  Instr *instr = program->instr;
+  int end = group + instr[group].length;
+  int pos = group + 1;
+
+  while (pos < end)
+    {
+      if (instr[pos].type == INSTR_GROUP)
+	pos += instr[pos].length;
+      else
+	{
+	  if (instr[pos].type == INSTR_SHORT_CIRCUIT)
+	    instr[pos].jump = end - pos - 1;
+	  pos++;
+	}
+    }
+}
+
+/*
+ * hash the constants of a long IN list into an open addressing table with
+ * at least twice as many buckets as values, so a probe is O(1) on average.
+ */
+void
+buildValueSet (ValueSet *set)
+{
+  int i;
+
+  if (set->numValues <= VALUE_SET_LINEAR_MAX)
+    return;
+
+  set->numBuckets = 1;
+  while (set->numBuckets < 2 * set->numValues)
+    set->numBuckets *= 2;
+  set->buckets = (int *) calloc(set->numBuckets, sizeof(int));
+
+  for(i = 0; i < set->numValues; i++)
+    {
+      unsigned int b = hashOperand(&set->values[i], NULL) & (set->numBuckets - 1);
+      while (set->buckets[b] != 0)
+	b = (b + 1) & (set->numBuckets - 1);
+      set->buckets[b] = i + 1;
+    }
+}
+
+bool
+valueSetContains (ValueSet *set, Operand *operand, char *data)
+{
+  int i;
+
+  if (set->numBuckets == 0)
+    {
+      for(i = 0; i < set->numValues; i++)
+	if (compareOperands(operand, &set->values[i], data) == 0)
+	  return TRUE;
+      return FALSE;
+    }
+
+  unsigned int b = hashOperand(operand, data) & (set->numBuckets - 1);
+  while (set->buckets[b] != 0)
+    {
+      if (compareOperands(operand, &set->values[set->buckets[b] - 1], data) == 0)
+	return TRUE;
+      b = (b + 1) & (set->numBuckets - 1);
+    }
+  return FALSE;
+}
+
+/*
+ * hash an operand consistently with compareOperands: equal values hash
+ * equally, in particular 0.0 and -0.0 and strings ending early in a field.
+ */
+unsigned int
+hashOperand (Operand *operand, char *data)
+{
+  unsigned int h = 0;
+
+  switch(operand->dt)
+    {
+    case DT_INT:
+      {
+	int v;
+	LOAD_OPERAND(v, operand, data, intV);
+	h = (unsigned int) v;
+      }
+      break;
+    case DT_FLOAT:
+      {
+	float v;
+	LOAD_OPERAND(v, operand, data, floatV);
+	if (v == 0)
+	  v = 0;
+	memcpy(&h, &v, sizeof(h));
+      }
+      break;
+    case DT_BOOL:
+      {
+	bool v;
+	LOAD_OPERAND(v, operand, data, boolV);
+	h = (unsigned int) v;
+      }
+      break;
+    case DT_STRING:
+      {
+	int len, i;
+	char *s = operandString(operand, data, &len);
+
+	// FNV-1a
+	h = 2166136261u;
+	for(i = 0; i < len && s[i] != '\0'; i++)
+	  h = (h ^ (unsigned char) s[i]) * 16777619u;
+	return h;
+      }
+    }
+
+  h *= 2654435761u;
+  return h ^ (h >> 16);
+}
+
+char *
+operandString (Operand *operand, char *data, int *length)
+{
+  // constants are NUL terminated, attributes may fill their whole field
+  *length = operand->isAttr ? operand->length : operand->length + 1;
+  return operand->isAttr ? data + operand->offset : operand->cons.v.stringV;
+}
+
+/*
+ * three way comparison of two operands of the same datatype, or
+ * CMP_UNORDERED if a float operand is NaN. Strings of attributes are
+ * bounded by their type length and otherwise NUL terminated, which
+ * matches strcmp on the values returned by getAttr.
+ */
+int
+compareOperands (Operand *left, Operand *right, char *data)
+{
+  switch(left->dt)
+    {
+    case DT_INT:
+      {
+	int l, r;
+	LOAD_OPERAND(l, left, data, intV);
+	LOAD_OPERAND(r, right, data, intV);
+	return (l > r) - (l < r);
+      }
+    case DT_FLOAT:
+      {
+	float l, r;
+	LOAD_OPERAND(l, left, data, floatV);
+	LOAD_OPERAND(r, right, data, floatV);
+	if (isnan(l) || isnan(r))
+	  return CMP_UNORDERED;
+	return (l > r) - (l < r);
+      }
+    case DT_BOOL:
+      {
+	bool l, r;
+	LOAD_OPERAND(l, left, data, boolV);
+	LOAD_OPERAND(r, right, data, boolV);
+	return (l > r) - (l < r);
+      }
+    case DT_STRING:
+      {
+	int lLen, rLen;
+	char *l = operandString(left, data, &lLen);
+	char *r = operandString(right, data, &rLen);
+	int i = 0;
+	unsigned char lc, rc;
+
+	while (i < lLen && i < rLen && l[i] != '\0' && l[i] == r[i])
+	  i++;
+	lc = (i < lLen) ? l[i] : '\0';
+	rc = (i < rLen) ? r[i] : '\0';
+	return (lc > rc) - (lc < rc);
+      }
+    }
+
+  return 0;
+}
+
+// outcome of a binary comparison operator given a three way comparison,
+// only <> holds for an unordered comparison
+bool
+cmpMatches (OpType op, int cmp)
+{
+  if (cmp == CMP_UNORDERED)
+    return (op == OP_COMP_NOT_EQUAL);
+
+  switch(op)
+    {
+    case OP_COMP_EQUAL:
+      return cmp == 0;
+    case OP_COMP_SMALLER:
+      return cmp < 0;
+    case OP_COMP_GREATER:
+      return cmp > 0;
+    case OP_COMP_SMALLER_EQUAL:
+      return cmp <= 0;
+    case OP_COMP_GREATER_EQUAL:
+      return cmp >= 0;
+    case OP_COMP_NOT_EQUAL:
+      return cmp != 0;
+    default:
+      return FALSE;
+    }
+}
+
+bool
+evalComp (Instr *in, char *data)
+{
+  switch(in->op)
+    {
+    case OP_COMP_BETWEEN:
+      return cmpMatches(OP_COMP_GREATER_EQUAL, compareOperands(&in->left, &in->right, data))
+	&& cmpMatches(OP_COMP_SMALLER_EQUAL, compareOperands(&in->left, &in->upper, data));
+    case OP_COMP_IN:
+      return valueSetContains(in->set, &in->left, data);
+    case OP_COMP_PREFIX:
+      {
+	int sLen, pLen, i;
+	char *s = operandString(&in->left, data, &sLen);
+	char *p = operandString(&in->right, data, &pLen);
+
+	for(i = 0; i < pLen && p[i] != '\0'; i++)
+	  if (i >= sLen || s[i] != p[i])
+	    return FALSE;
+	return TRUE;
+      }
+    default:
+      return cmpMatches(in->op, compareOperands(&in->left, &in->right, data));
+    }
+}
+
+/*
+ * kernel comparing an attribute with a constant; the comparison is mirrored
+ * if the constant is on the left side, so c < a becomes a > c. Returns -1
+ * for operators without a kernel.
+ */
+int
+kernelMode (OpType op, bool attrLeft)
+{
+  switch(op)
+    {
+    case OP_COMP_EQUAL:
+      return KERNEL_EQ;
+    case OP_COMP_NOT_EQUAL:
+      return KERNEL_NE;
+    case OP_COMP_SMALLER:
+      return attrLeft ? KERNEL_LT : KERNEL_GT;
+    case OP_COMP_GREATER:
+      return attrLeft ? KERNEL_GT : KERNEL_LT;
+    case OP_COMP_SMALLER_EQUAL:
+      return attrLeft ? KERNEL_LE : KERNEL_GE;
+    case OP_COMP_GREATER_EQUAL:
+      return attrLeft ? KERNEL_GE : KERNEL_LE;
+    default:
+      return -1;
+    }
+}
+
+void
+runKernel (Operand *attr, Operand *cons, int mode, void *column, int numRecords, uint64_t *result)
+{
+  if (attr->dt == DT_INT)
+    intKernel((int *) column, numRecords, cons->cons.v.intV, mode, result);
+  else
+    floatKernel((float *) column, numRecords, cons->cons.v.floatV, mode, result);
+}
+
+// record i of a batch; from columns only the attributes of the instruction are read into row
+char *
+batchRecord (Instr *in, char *data, int stride, char **columns, int i, char *row)
+{
+  Operand *operands[3];
+  int j;
+
+  if (columns == NULL)
+    return data + (i * stride);
+  operands[0] = &in->left;
+  operands[1] = &in->right;
+  operands[2] = &in->upper;
+  for(j = 0; j < 3; j++)
+    if (operands[j]->isAttr && operands[j]->attrNum >= 0)
+      memcpy(row + operands[j]->offset, columns[operands[j]->attrNum] + (i * operands[j]->length),
+	     operands[j]->length);
+  return row;
+}
+
+void
+compareBatch (Instr *in, char *data, int stride, char **columns, int numRecords,
+	      uint64_t *active, uint64_t *result, uint64_t *tmp, void *column, char *row)
+{
+  int words = BITMAP_WORDS(numRecords);
+  Operand *attr = in->left.isAttr ? &in->left : &in->right;
+  Operand *cons = in->left.isAttr ? &in->right : &in->left;
+  int mode = kernelMode(in->op, in->left.isAttr);
+  bool vectorize;
+  int i, w;
+
+  // kernels need an int or float attribute compared with constants only
+  if (in->left.dt != DT_INT && in->left.dt != DT_FLOAT)
+    vectorize = FALSE;
+  else if (in->op == OP_COMP_BETWEEN)
+    vectorize = (in->left.isAttr && !in->right.isAttr && !in->upper.isAttr);
+  else if (in->op == OP_COMP_IN)
+    vectorize = (in->left.isAttr && in->set->numBuckets == 0);
+  else
+    vectorize = (mode != -1 && in->left.isAttr != in->right.isAttr);
+
+  if (vectorize)
+    {
+      // gather the attribute into a contiguous column, unless it is one already
+      if (columns != NULL)
+	column = columns[attr->attrNum];
+      else
+	for(i = 0; i < numRecords; i++)
+	  memcpy((char *) column + (i * sizeof(int)), data + (i * stride) + attr->offset, sizeof(int));
+
+      switch(in->op)
+	{
+	case OP_COMP_BETWEEN:
+	  runKernel(attr, &in->right, KERNEL_GE, column, numRecords, result);
+	  runKernel(attr, &in->upper, KERNEL_LE, column, numRecords, tmp);
+	  for(w = 0; w < words; w++)
+	    result[w] &= tmp[w];
+	  break;
+	case OP_COMP_IN:
+	  // short lists are an OR of equality kernels
+	  memset(result, 0, words * sizeof(uint64_t));
+	  for(i = 0; i < in->set->numValues; i++)
+	    {
+	      runKernel(attr, &in->set->values[i], KERNEL_EQ, column, numRecords, tmp);
+	      for(w = 0; w < words; w++)
+		result[w] |= tmp[w];
+	    }
+	  break;
+	default:
+	  runKernel(attr, cons, mode, column, numRecords, result);
+	  break;
+	}
+      return;
+    }
+
+  // only records that are not decided yet
+  memset(result, 0, words * sizeof(uint64_t));
+  for(w = 0; w < words; w++)
+    {
+      uint64_t todo = active[w];
+      while (todo != 0)
+	{
+	  i = (w * 64) + __builtin_ctzll(todo);
+	  todo &= todo - 1;
+	  if (evalComp(in, batchRecord(in, data, stride, columns, i, row)))
+	    result[w] |= ((uint64_t) 1) << (i % 64);
+	}
+    }
+}
+
+void
+intKernel (int *column, int numRecords, int cons, int mode, uint64_t *result)
+{
+  int i = 0;
+
+  memset(result, 0, BITMAP_WORDS(numRecords) * sizeof(uint64_t));
+#ifdef __SSE2__
+  __m128i c = _mm_set1_epi32(cons);
+  // NE, LE and GE are the complements of EQ, GT and LT
+  int invert = (mode == KERNEL_NE || mode == KERNEL_LE || mode == KERNEL_GE) ? 0xF : 0;
+  for(; i + 4 <= numRecords; i += 4)
+    {
+      __m128i v = _mm_loadu_si128((__m128i *) (column + i));
+      __m128i m;
+      switch(mode)
+	{
+	case KERNEL_EQ:
+	case KERNEL_NE:
+	  m = _mm_cmpeq_epi32(v, c);
+	  break;
+	case KERNEL_LT:
+	case KERNEL_GE:
+	  m = _mm_cmplt_epi32(v, c);
+	  break;
+	default:
+	  m = _mm_cmpgt_epi32(v, c);
+	  break;
+	}
+      // four lanes never straddle a bitmap word
+      result[i / 64] |= ((uint64_t) (_mm_movemask_ps(_mm_castsi128_ps(m)) ^ invert)) << (i % 64);
+    }
+#endif
+  for(; i < numRecords; i++)
+    result[i / 64] |= ((uint64_t) KERNEL_MATCH(column[i], cons, mode)) << (i % 64);
+}
+
+void
+floatKernel (float *column, int numRecords, float cons, int mode, uint64_t *result)
+{
+  int i = 0;
+
+  memset(result, 0, BITMAP_WORDS(numRecords) * sizeof(uint64_t));
+#ifdef __SSE2__
+  __m128 c = _mm_set1_ps(cons);
+  for(; i + 4 <= numRecords; i += 4)
+    {
+      __m128 v = _mm_loadu_ps(column + i);
+      __m128 m;
+      switch(mode)
+	{
+	case KERNEL_EQ:
+	  m = _mm_cmpeq_ps(v, c);
+	  break;
+	case KERNEL_NE:
+	  m = _mm_cmpneq_ps(v, c);
+	  break;
+	case KERNEL_LT:
+	  m = _mm_cmplt_ps(v, c);
+	  break;
+	case KERNEL_LE:
+	  m = _mm_cmple_ps(v, c);
+	  break;
+	case KERNEL_GE:
+	  m = _mm_cmpge_ps(v, c);
+	  break;
+	default:
+	  m = _mm_cmpgt_ps(v, c);
+	  break;
+	}
+      result[i / 64] |= ((uint64_t) _mm_movemask_ps(m)) << (i % 64);
+    }
+#endif
+  for(; i < numRecords; i++)
+    result[i / 64] |= ((uint64_t) KERNEL_MATCH(column[i], cons, mode)) << (i % 64);
+}
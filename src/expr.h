@@ -1,6 +1,8 @@
 #ifndef EXPR_H
 #define EXPR_H
 
+#include <stdint.h>
+
 #include "dberror.h"
 #include "tables.h"
 
@@ -26,17 +28,99 @@ typedef enum OpType {
   OP_BOOL_OR,
   OP_BOOL_NOT,
   OP_COMP_EQUAL,
-  OP_COMP_SMALLER
+  OP_COMP_SMALLER,
+  OP_COMP_GREATER,
+  OP_COMP_SMALLER_EQUAL,
+  OP_COMP_GREATER_EQUAL,
+  OP_COMP_NOT_EQUAL,
+  OP_COMP_BETWEEN, // args: input, lower bound, upper bound (inclusive)
+  OP_COMP_IN, // args: input, followed by the constants of the list
+  OP_COMP_PREFIX // args: string input, string prefix
 } OpType;
 
 typedef struct Operator {
   OpType type;
+  int numArgs;
   Expr **args;
 } Operator;
 
+// compiled conditions: a flat postfix program over a boolean stack that
+// reads attributes at precomputed offsets and never allocates
+#define EXPR_STACK_SIZE 64
+
+// evaluations between two reorderings of the terms of AND/OR groups
+#define EXPR_REORDER_INTERVAL 4096
+
+// chains of AND (OR) are compiled into a group: INSTR_GROUP pushes TRUE
+// (FALSE) and every term is followed by an INSTR_SHORT_CIRCUIT, which pops
+// the term and, if it is FALSE (TRUE), replaces the group result and skips
+// the remaining terms
+typedef enum InstrType {
+  INSTR_COMP,
+  INSTR_PUSH,
+  INSTR_BOOL_NOT,
+  INSTR_GROUP,
+  INSTR_SHORT_CIRCUIT
+} InstrType;
+
+typedef struct Operand {
+  bool isAttr;
+  DataType dt;
+  int attrNum; // attribute of the schema, -1 for constants
+  int offset;
+  int length;
+  Value cons;
+} Operand;
+
+// constants of an IN list; lists longer than VALUE_SET_LINEAR_MAX are hashed
+#define VALUE_SET_LINEAR_MAX 8
+
+typedef struct ValueSet {
+  int numValues;
+  Operand *values;
+  int numBuckets; // 0 if values are searched linearly
+  int *buckets; // open addressing, index + 1 into values, 0 if empty
+} ValueSet;
+
+typedef struct Instr {
+  InstrType type;
+  OpType op; // comparison, or OP_BOOL_AND/OR of a group and its terms
+  Operand left;
+  Operand right;
+  Operand upper; // upper bound of OP_COMP_BETWEEN
+  ValueSet *set; // list of OP_COMP_IN
+  int length; // instructions of a group, or of a term up to its short circuit
+  int jump; // instructions a short circuit skips to the end of its group
+  int cost; // estimated cost of the term ending with a short circuit
+  unsigned int numEvals; // evaluations of the term since the last reordering
+  unsigned int numDecided; // evaluations that decided the group
+} Instr;
+
+typedef struct ExprProgram {
+  int numInstr;
+  Instr *instr;
+  Instr *spare; // room to permute the terms of a group
+  int numEvals; // evaluations since the last reordering
+} ExprProgram;
+
+// selection bitmaps of a batch: bit i of word i / 64 is set for tuple i
+#define BITMAP_WORDS(_n) (((_n) + 63) / 64)
+#define BITMAP_TEST(_bitmap,_i) (((_bitmap)[(_i) / 64] >> ((_i) % 64)) & 1)
+
+// scratch memory evalProgramBatch needs for batches of up to _n tuples
+#define EXPR_BATCH_SCRATCH_SIZE(_n)					\
+  (((2 * EXPR_STACK_SIZE + 2) * BITMAP_WORDS(_n) * sizeof(uint64_t)) + ((_n) * sizeof(int)))
+
 // expression evaluation methods
 extern RC valueEquals (Value *left, Value *right, Value *result);
 extern RC valueSmaller (Value *left, Value *right, Value *result);
+extern RC valueGreater (Value *left, Value *right, Value *result);
+extern RC valueSmallerEquals (Value *left, Value *right, Value *result);
+extern RC valueGreaterEquals (Value *left, Value *right, Value *result);
+extern RC valueNotEquals (Value *left, Value *right, Value *result);
+extern RC valueBetween (Value *input, Value *lower, Value *upper, Value *result);
+extern RC valueIn (Value *input, Value **values, int numValues, Value *result);
+extern RC valuePrefix (Value *input, Value *prefix, Value *result);
 extern RC boolNot (Value *input, Value *result);
 extern RC boolAnd (Value *left, Value *right, Value *result);
 extern RC boolOr (Value *left, Value *right, Value *result);
@@ -44,6 +128,15 @@ extern RC evalExpr (Record *record, Schema *schema, Expr *expr, Value **result);
 extern RC freeExpr (Expr *expr);
 extern void freeVal(Value *val);
 
+// compiled expression methods
+extern RC compileExpr (Expr *expr, Schema *schema, ExprProgram **program);
+extern RC evalProgram (ExprProgram *program, char *data, bool *result);
+extern RC evalProgramBatch (ExprProgram *program, char *data, int stride, int numRecords,
+			    uint64_t *selection, void *scratch);
+extern RC evalProgramColumns (ExprProgram *program, char **columns, int numRecords,
+			      uint64_t *selection, void *scratch);
+extern RC freeProgram (ExprProgram *program);
+
 
 #define CPVAL(_result,_input)						\
   do {									\
@@ -54,7 +147,7 @@ extern void freeVal(Value *val);
       (_result)->v.intV = _input->v.intV;					\
       break;								\
     case DT_STRING:							\
-      (_result)->v.stringV = (char *) malloc(strlen(_input->v.stringV));	\
+      (_result)->v.stringV = (char *) malloc(strlen(_input->v.stringV) + 1);	\
       strcpy((_result)->v.stringV, _input->v.stringV);			\
       break;								\
     case DT_FLOAT:							\
@@ -73,6 +166,7 @@ extern void freeVal(Value *val);
       _result->type = EXPR_OP;						\
       _result->expr.op = _op;						\
       _op->type = _optype;						\
+      _op->numArgs = 2;							\
       _op->args = (Expr **) malloc(2 * sizeof(Expr*));			\
       _op->args[0] = _left;						\
       _op->args[1] = _right;						\
@@ -85,10 +179,41 @@ extern void freeVal(Value *val);
     _result->type = EXPR_OP;						\
     _result->expr.op = _op;						\
     _op->type = _optype;						\
+    _op->numArgs = 1;							\
     _op->args = (Expr **) malloc(sizeof(Expr*));			\
     _op->args[0] = _input;						\
   } while (0)
 
+#define MAKE_BETWEEN_EXPR(_result,_input,_lower,_upper)			\
+  do {									\
+    Operator *_op = (Operator *) malloc(sizeof(Operator));		\
+    _result = (Expr *) malloc(sizeof(Expr));				\
+    _result->type = EXPR_OP;						\
+    _result->expr.op = _op;						\
+    _op->type = OP_COMP_BETWEEN;					\
+    _op->numArgs = 3;							\
+    _op->args = (Expr **) malloc(3 * sizeof(Expr*));			\
+    _op->args[0] = _input;						\
+    _op->args[1] = _lower;						\
+    _op->args[2] = _upper;						\
+  } while (0)
+
+// _values is an array of _numValues constant expressions, owned by the result
+#define MAKE_IN_EXPR(_result,_input,_values,_numValues)			\
+  do {									\
+    int _i;								\
+    Operator *_op = (Operator *) malloc(sizeof(Operator));		\
+    _result = (Expr *) malloc(sizeof(Expr));				\
+    _result->type = EXPR_OP;						\
+    _result->expr.op = _op;						\
+    _op->type = OP_COMP_IN;						\
+    _op->numArgs = (_numValues) + 1;					\
+    _op->args = (Expr **) malloc(_op->numArgs * sizeof(Expr*));	\
+    _op->args[0] = _input;						\
+    for(_i = 0; _i < (_numValues); _i++)				\
+      _op->args[_i + 1] = (_values)[_i];				\
+  } while (0)
+
 #define MAKE_ATTRREF(_result,_attr)					\
   do {									\
     _result = (Expr *) malloc(sizeof(Expr));				\
@@ -0,0 +1,149 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "dberror.h"
+#include "latency.h"
+
+// a histogram keeps 16 sub buckets for every power of two, so a bucket is
+// at most 1/16 of its values wide; values below 16 ns get a bucket each
+#define LATENCY_SUB_BITS 4
+#define LATENCY_SUB (1 << LATENCY_SUB_BITS)
+#define LATENCY_BUCKETS ((64 - LATENCY_SUB_BITS + 1) * LATENCY_SUB)
+
+// histogram of one operation, updated with atomic adds by all threads
+typedef struct Histogram {
+  uint64_t count;
+  uint64_t sum;
+  uint64_t min; // + 1, 0 while empty
+  uint64_t max;
+  uint64_t buckets[LATENCY_BUCKETS];
+} Histogram;
+
+static Histogram histograms[LAT_NUM_OPS];
+
+static const char *opNames[LAT_NUM_OPS] = {
+  "pinPage hit", "pinPage miss", "readBlock", "readBlocks", "writeBlock",
+  "insertRecord", "next", "evalExpr"
+};
+
+static int
+bucketOf (uint64_t ns)
+{
+  int magnitude;
+
+  if (ns < LATENCY_SUB)
+    return (int) ns;
+  magnitude = 63 - __builtin_clzll(ns); // >= LATENCY_SUB_BITS
+  return (magnitude - LATENCY_SUB_BITS + 1) * LATENCY_SUB
+    + (int) ((ns >> (magnitude - LATENCY_SUB_BITS)) & (LATENCY_SUB - 1));
+}
+
+// highest value falling into a bucket
+static uint64_t
+bucketTop (int bucket)
+{
+  int magnitude;
+  uint64_t sub;
+
+  if (bucket < LATENCY_SUB)
+    return bucket;
+  magnitude = bucket / LATENCY_SUB + LATENCY_SUB_BITS - 1;
+  sub = bucket % LATENCY_SUB;
+  return ((LATENCY_SUB + sub + 1) << (magnitude - LATENCY_SUB_BITS)) - 1;
+}
+
+void
+latencyRecord (LatencyOp op, uint64_t ns)
+{
+  Histogram *h = &histograms[op];
+  uint64_t old;
+
+  __atomic_fetch_add(&h->buckets[bucketOf(ns)], 1, __ATOMIC_RELAXED);
+  __atomic_fetch_add(&h->count, 1, __ATOMIC_RELAXED);
+  __atomic_fetch_add(&h->sum, ns, __ATOMIC_RELAXED);
+  old = __atomic_load_n(&h->max, __ATOMIC_RELAXED);
+  while (ns > old && !__atomic_compare_exchange_n(&h->max, &old, ns, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+    ;
+  old = __atomic_load_n(&h->min, __ATOMIC_RELAXED);
+  while ((old == 0 || ns + 1 < old)
+	 && !__atomic_compare_exchange_n(&h->min, &old, ns + 1, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+    ;
+}
+
+RC
+getLatencyStats (LatencyOp op, LatencyStats *stats)
+{
+  Histogram *h = &histograms[op];
+  double quantiles[4] = { 0.5, 0.9, 0.99, 0.999 };
+  uint64_t *results[4] = { &stats->p50, &stats->p90, &stats->p99, &stats->p999 };
+  uint64_t seen = 0, total = 0;
+  int b, q = 0;
+
+  memset(stats, 0, sizeof(LatencyStats));
+  // the buckets may be updated meanwhile, their sum is the count used
+  for (b = 0; b < LATENCY_BUCKETS; b++)
+    total += __atomic_load_n(&h->buckets[b], __ATOMIC_RELAXED);
+  if (total == 0)
+    return RC_OK;
+
+  stats->count = total;
+  stats->mean = (double) __atomic_load_n(&h->sum, __ATOMIC_RELAXED) / __atomic_load_n(&h->count, __ATOMIC_RELAXED);
+  stats->min = __atomic_load_n(&h->min, __ATOMIC_RELAXED) - 1;
+  stats->max = __atomic_load_n(&h->max, __ATOMIC_RELAXED);
+  for (b = 0; b < LATENCY_BUCKETS && q < 4; b++)
+    {
+      seen += __atomic_load_n(&h->buckets[b], __ATOMIC_RELAXED);
+      while (q < 4 && seen >= quantiles[q] * total)
+	{
+	  *results[q] = (bucketTop(b) < stats->max) ? bucketTop(b) : stats->max;
+	  q++;
+	}
+    }
+  return RC_OK;
+}
+
+void
+resetLatencyStats (void)
+{
+  memset(histograms, 0, sizeof(histograms));
+}
+
+const char *
+latencyOpName (LatencyOp op)
+{
+  return (op >= 0 && op < LAT_NUM_OPS) ? opNames[op] : "unknown";
+}
+
+char *
+sprintLatencyStats (void)
+{
+  LatencyStats stats;
+  char *message = (char *) malloc(256 * (LAT_NUM_OPS + 1));
+  int pos = 0;
+  int op;
+
+#ifndef LATENCY_STATS
+  pos += sprintf(message + pos, "latency histograms not compiled in (make LATENCY=1)\n");
+#endif
+  for (op = 0; op < LAT_NUM_OPS; op++)
+    {
+      getLatencyStats(op, &stats);
+      if (stats.count == 0)
+	continue;
+      pos += sprintf(message + pos, "[latency] %-14s %10ld ops mean %10.0f ns p50 %8lu p90 %8lu p99 %8lu p99.9 %8lu max %10lu\n",
+		     opNames[op], stats.count, stats.mean, (unsigned long) stats.p50, (unsigned long) stats.p90,
+		     (unsigned long) stats.p99, (unsigned long) stats.p999, (unsigned long) stats.max);
+    }
+  message[pos] = '\0';
+  return message;
+}
+
+void
+printLatencyStats (void)
+{
+  char *message = sprintLatencyStats();
+
+  printf("%s", message);
+  free(message);
+}
@@ -0,0 +1,82 @@
+#ifndef LATENCY_H
+#define LATENCY_H
+
+#include <stdint.h>
+#include <time.h>
+
+#include "dberror.h"
+
+// latency histograms of the hot paths of the storage, buffer and record
+// managers. They are compiled in with -DLATENCY_STATS (make LATENCY=1);
+// -DLATENCY_USDT (make LATENCY=usdt) also fires the USDT probe
+// dbms:latency(op, ns) for perf and bpftrace. Without the flags
+// LATENCY_START and LATENCY_END expand to nothing.
+
+// operations measured
+typedef enum LatencyOp {
+  LAT_PIN_HIT, // pinPage finding the page in the pool
+  LAT_PIN_MISS, // pinPage reading the page
+  LAT_READ_BLOCK,
+  LAT_READ_BLOCKS, // one call, reading several pages
+  LAT_WRITE_BLOCK,
+  LAT_INSERT_RECORD,
+  LAT_SCAN_NEXT, // next
+  LAT_EVAL_EXPR,
+  LAT_NUM_OPS
+} LatencyOp;
+
+// summary of the histogram of an operation, in nanoseconds; the
+// percentiles are exact to 1/16 of their value (HDR style buckets)
+typedef struct LatencyStats {
+  long count;
+  double mean;
+  uint64_t min;
+  uint64_t p50;
+  uint64_t p90;
+  uint64_t p99;
+  uint64_t p999;
+  uint64_t max;
+} LatencyStats;
+
+#ifdef LATENCY_USDT
+#ifndef LATENCY_STATS
+#define LATENCY_STATS
+#endif
+#include <sys/sdt.h>
+#define LATENCY_PROBE(_op,_ns) DTRACE_PROBE2(dbms, latency, (int) (_op), (_ns))
+#else
+#define LATENCY_PROBE(_op,_ns) do { } while(0)
+#endif
+
+#ifdef LATENCY_STATS
+static inline uint64_t
+latencyNow (void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+// LATENCY_START declares the variable _t holding the start time
+#define LATENCY_START(_t) uint64_t _t = latencyNow()
+#define LATENCY_END(_op,_t)						\
+  do {									\
+    uint64_t _ns = latencyNow() - (_t);					\
+    latencyRecord((_op), _ns);						\
+    LATENCY_PROBE((_op), _ns);						\
+  } while(0)
+#else
+#define LATENCY_START(_t)
+#define LATENCY_END(_op,_t) do { } while(0)
+#endif
+
+extern void latencyRecord (LatencyOp op, uint64_t ns);
+extern RC getLatencyStats (LatencyOp op, LatencyStats *stats);
+extern void resetLatencyStats (void);
+extern const char *latencyOpName (LatencyOp op);
+
+// dump of the operations measured so far, one line each
+extern char *sprintLatencyStats (void);
+extern void printLatencyStats (void);
+
+#endif // LATENCY_H
@@ -0,0 +1,1787 @@
+#define _GNU_SOURCE // qsort_r
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <math.h>
+#include <unistd.h>
+
+#include "dberror.h"
+#include "record_mgr.h"
+#include "storage_mgr.h"
+#include "expr.h"
+#include "query.h"
+#include "tables.h"
+
+// layout of a key made of some attributes of a schema, see buildKey
+typedef struct KeyLayout {
+  Schema *schema;
+  int numAttrs;
+  int *attrs;
+  int *offsets; // offset of every attribute within the key
+  int size;
+} KeyLayout;
+
+// hash table of groups with open addressing: the slots hold indexes into
+// dense arrays of groups, so growing the slots does not move the groups
+typedef struct AggrTable {
+  int numSlots; // power of two
+  int *slots; // group index + 1, 0 if free
+  int numGroups;
+  int maxGroups;
+  uint32_t *hashes;
+  char *keys;
+  AggrValue *values;
+  int64_t *counts; // tuples of every group, for AVG
+} AggrTable;
+
+// state of an aggregation, shared by the workers of the scan
+typedef struct AggrState {
+  Schema *schema;
+  KeyLayout key; // group attributes
+  int numAggrs;
+  AggrSpec *aggrs;
+  DataType *aggrTypes; // type of the aggregated attributes
+  int intKey; // offset of a single int or float group attribute, -1 otherwise
+  AggrTable **tables; // partial aggregates of every worker
+  char **scratch; // key being looked up by every worker
+  char **rows; // tuple of every worker gathered from the columns of a PAX page
+  int numUsed;
+  int *usedAttrs; // group and aggregated attributes, the ones gathered
+} AggrState;
+
+// tuples of a join input copied into memory, rowSize bytes each: the key,
+// the RID and the record data
+typedef struct JoinRows {
+  KeyLayout key;
+  int recordSize;
+  int rowSize;
+  int numRows;
+  int maxRows;
+  char *data;
+  bool sorted; // keys were appended in nondecreasing order
+} JoinRows;
+
+#define ROW(_rows,_i) ((_rows)->data + ((size_t) (_i) * (_rows)->rowSize))
+#define ROW_RID(_rows,_row) ((RID *) ((_row) + (_rows)->key.size))
+#define ROW_DATA(_rows,_row) ((_row) + (_rows)->key.size + sizeof(RID))
+
+// hash table over the rows of the left input, chained through next
+typedef struct JoinTable {
+  int numSlots; // power of two
+  int *slots; // first row + 1, 0 if empty
+  int *next; // next row + 1 with the same slot
+  uint32_t *hashes;
+} JoinTable;
+
+// rows of a join input being written to the partitions of a partitioned hash join
+typedef struct JoinSpill {
+  JoinRows *rows; // layout of the rows, holds no data
+  int bits; // log2 of the number of partitions
+  FILE **files;
+  char *row;
+} JoinSpill;
+
+// probing the hash table with the tuples of the right input
+typedef struct JoinProbe {
+  JoinRows *build;
+  JoinTable *table;
+  KeyLayout *key;
+  char *scratch;
+  RM_JoinCallback callback;
+  void *context;
+} JoinProbe;
+
+// pages written at once by a sort, and pages read ahead per run when merging
+#define SORT_WRITE_PAGES 8
+#define SORT_READ_PAGES 16
+
+// tuple of the in-memory sort: the first eight bytes of its normalized key
+// as a big-endian number, and its row
+typedef struct SortEntry {
+  uint64_t prefix;
+  int row;
+} SortEntry;
+
+// sorted run in the temporary page file, rows follow each other across pages
+typedef struct SortRun {
+  int firstPage;
+  long numRows;
+} SortRun;
+
+// reads a run several pages at a time; the rows between pos and end are
+// contiguous, a row split across two reads is moved to the buffer start
+typedef struct RunReader {
+  int nextPage;
+  long rowsLeft; // rows not yet consumed, the current one at pos included
+  int numPages;
+  char *buffer;
+  char *pos;
+  char *end;
+} RunReader;
+
+// state of a sort, rows are laid out like JoinRows with a normalized key
+typedef struct SortState {
+  KeyLayout key;
+  int recordSize;
+  int rowSize;
+  long budget; // bytes, 0 for no limit
+  char *data; // rows of the current run
+  SortEntry *entries;
+  SortEntry *tmp; // second buffer of the radix sort
+  int numRows;
+  int maxRows;
+  int budgetRows; // maximum rows within the budget
+  int nextRow; // next row returned when the tuples fit into memory
+  char fileName[64]; // temporary page file of the runs
+  SM_FileHandle file;
+  bool fileOpen;
+  int numPages;
+  SortRun *runs;
+  int numRuns;
+  int maxRuns;
+  char *out; // pages of the run being written
+  int outPages;
+  int outUsed; // bytes
+  RunReader *readers; // runs being merged
+  int numReaders;
+  int *losers; // loser tree over the readers, the winner in losers[0]
+  RM_SortStats stats;
+} SortState;
+
+// prototypes
+static RC aggregateBatch (void *context, int worker, RM_ColumnBatch *batch);
+static void aggregateRow (AggrState *st, int worker, char *data);
+static AggrTable *createAggrTable (AggrState *st, int expectedGroups);
+static void freeAggrTable (AggrTable *table);
+static int findGroup (AggrState *st, AggrTable *table, char *key, uint32_t hash);
+static int findIntGroup (AggrState *st, AggrTable *table, uint32_t key);
+static void growSlots (AggrTable *table);
+static void initValues (AggrState *st, AggrValue *acc);
+static void accumulate (AggrState *st, AggrValue *acc, char *data);
+static void combine (AggrState *st, AggrValue *acc, AggrValue *partial);
+static void finalize (AggrState *st, AggrValue *acc, int64_t count);
+static void initKeyLayout (KeyLayout *layout, Schema *schema, int numAttrs, int *attrs);
+static void buildKey (KeyLayout *layout, char *data, char *key);
+static uint32_t hashKey (char *key, int size);
+static int compareKeys (KeyLayout *layout, char *left, char *right);
+static RC checkJoinAttrs (RM_TableData *left, RM_TableData *right, int numAttrs, int *leftAttrs, int *rightAttrs);
+static void initJoinRows (JoinRows *rows, Schema *schema, int numAttrs, int *attrs);
+static void freeJoinRows (JoinRows *rows);
+static int allocJoinRow (JoinRows *rows);
+static RC appendJoinRow (void *context, int worker, Record *record);
+static RC spillJoinTuple (void *context, int worker, Record *record);
+static void buildJoinTable (JoinRows *rows, JoinTable *table);
+static void freeJoinTable (JoinTable *table);
+static RC probeJoinTuple (void *context, int worker, Record *record);
+static RC probeJoinKey (JoinProbe *probe, char *key, uint32_t hash, Record *record);
+static int compareJoinRows (const void *left, const void *right, void *layout);
+static RC checkSortAttrs (Schema *schema, int numAttrs, int *attrs);
+static SortState *createSortState (Schema *schema, int numAttrs, int *attrs);
+static void siftDown (SortState *st, int *heap, int numRows, int i);
+static void buildSortKey (KeyLayout *layout, char *data, char *key);
+static uint64_t keyPrefix (char *key, int size);
+static RC addSortRow (SortState *st, Record *record);
+static void sortRows (SortState *st);
+static int compareSortEntries (const void *left, const void *right, void *state);
+static RC spillRun (SortState *st);
+static void beginRun (SortState *st);
+static RC writeSortRow (SortState *st, char *row);
+static RC flushSortPages (SortState *st);
+static RC mergeRuns (SortState *st, int fanIn);
+static RC openReaders (SortState *st, int first, int numRuns, long bytes);
+static void closeReaders (SortState *st);
+static RC fillReader (SortState *st, RunReader *reader);
+static bool readerWins (SortState *st, int a, int b);
+static int playLosers (SortState *st, int node);
+static RC advanceMerge (SortState *st);
+
+/*
+ * Computes the aggregates for the tuples of a table matching cond (all
+ * tuples if cond is NULL), grouped by the given attributes. Without group
+ * attributes the result has exactly one group, whose aggregates are 0 if
+ * no tuple matched. The scan runs on numWorkers threads a page at a time
+ * (see parallelScanColumns); every worker aggregates into its own hash table, sized
+ * for expectedGroups groups (0 if unknown), and the partial aggregates are
+ * merged at the end. Aggregates other than COUNT take int or float
+ * attributes, which are read in place without creating Values.
+ */
+RC
+aggregate (RM_TableData *rel, Expr *cond, int numGroupAttrs, int *groupAttrs,
+	   int numAggrs, AggrSpec *aggrs, int expectedGroups, int numWorkers,
+	   AggrResult **result)
+{
+  Schema *schema = rel->schema;
+  AggrState st;
+  AggrTable *merged, *t;
+  AggrResult *res;
+  int total, i, w, g, m;
+  RC rc;
+
+  for(i = 0; i < numGroupAttrs; i++)
+    if (groupAttrs[i] < 0 || groupAttrs[i] >= schema->numAttr)
+      THROW(RC_RM_UNKOWN_DATATYPE, "group attribute does not exist");
+  for(i = 0; i < numAggrs; i++)
+    {
+      if (aggrs[i].type == AGGR_COUNT)
+	continue;
+      if (aggrs[i].attrNum < 0 || aggrs[i].attrNum >= schema->numAttr)
+	THROW(RC_RM_UNKOWN_DATATYPE, "aggregated attribute does not exist");
+      if (schema->dataTypes[aggrs[i].attrNum] != DT_INT
+	  && schema->dataTypes[aggrs[i].attrNum] != DT_FLOAT)
+	THROW(RC_RM_UNKOWN_DATATYPE, "only int and float attributes can be aggregated");
+    }
+
+  if (numWorkers <= 0)
+    numWorkers = (int) sysconf(_SC_NPROCESSORS_ONLN);
+  if (numWorkers < 1)
+    numWorkers = 1;
+
+  st.schema = schema;
+  initKeyLayout(&st.key, schema, numGroupAttrs, groupAttrs);
+  st.numAggrs = numAggrs;
+  st.aggrs = aggrs;
+  st.aggrTypes = (DataType *) malloc(sizeof(DataType) * numAggrs);
+  for(i = 0; i < numAggrs; i++)
+    st.aggrTypes[i] = (aggrs[i].type == AGGR_COUNT) ? DT_INT : schema->dataTypes[aggrs[i].attrNum];
+  st.intKey = -1;
+  if (numGroupAttrs == 1 && schema->dataTypes[groupAttrs[0]] != DT_STRING
+      && schema->typeLength[groupAttrs[0]] == sizeof(int))
+    st.intKey = schema->attrOffsets[groupAttrs[0]];
+  if (numGroupAttrs == 0)
+    expectedGroups = 1;
+
+  st.numUsed = 0;
+  st.usedAttrs = (int *) malloc(sizeof(int) * (numGroupAttrs + numAggrs));
+  for(i = 0; i < numGroupAttrs; i++)
+    st.usedAttrs[st.numUsed++] = groupAttrs[i];
+  for(i = 0; i < numAggrs; i++)
+    if (aggrs[i].type != AGGR_COUNT)
+      st.usedAttrs[st.numUsed++] = aggrs[i].attrNum;
+
+  st.tables = (AggrTable **) malloc(sizeof(AggrTable *) * numWorkers);
+  st.scratch = (char **) malloc(sizeof(char *) * numWorkers);
+  st.rows = (char **) malloc(sizeof(char *) * numWorkers);
+  for(w = 0; w < numWorkers; w++)
+    {
+      st.tables[w] = createAggrTable(&st, expectedGroups);
+      st.scratch[w] = (char *) malloc(st.key.size + 1);
+      st.rows[w] = (char *) malloc(schema->recordSize);
+    }
+
+  rc = parallelScanColumns(rel, cond, numWorkers, aggregateBatch, &st);
+
+  // merge the partial aggregates into a table sized for all of them
+  total = 0;
+  for(w = 0; w < numWorkers; w++)
+    total += st.tables[w]->numGroups;
+  merged = createAggrTable(&st, (numGroupAttrs == 0) ? 1 : total);
+  for(w = 0; rc == RC_OK && w < numWorkers; w++)
+    {
+      t = st.tables[w];
+      for(g = 0; g < t->numGroups; g++)
+	{
+	  m = findGroup(&st, merged, t->keys + (g * st.key.size), t->hashes[g]);
+	  combine(&st, merged->values + (m * numAggrs), t->values + (g * numAggrs));
+	  merged->counts[m] += t->counts[g];
+	}
+    }
+  if (rc == RC_OK && numGroupAttrs == 0 && merged->numGroups == 0)
+    findGroup(&st, merged, st.scratch[0], hashKey(st.scratch[0], 0));
+  for(g = 0; g < merged->numGroups; g++)
+    finalize(&st, merged->values + (g * numAggrs), merged->counts[g]);
+
+  for(w = 0; w < numWorkers; w++)
+    {
+      freeAggrTable(st.tables[w]);
+      free(st.scratch[w]);
+      free(st.rows[w]);
+    }
+  free(st.tables);
+  free(st.scratch);
+  free(st.rows);
+  free(st.usedAttrs);
+
+  if (rc != RC_OK)
+    {
+      freeAggrTable(merged);
+      free(st.aggrTypes);
+      free(st.key.offsets);
+      return rc;
+    }
+
+  // hand the arrays of the merged table over to the result
+  res = (AggrResult *) malloc(sizeof(AggrResult));
+  res->numGroups = merged->numGroups;
+  res->numAggrs = numAggrs;
+  res->types = st.aggrTypes;
+  for(i = 0; i < numAggrs; i++)
+    if (aggrs[i].type == AGGR_AVG)
+      res->types[i] = DT_FLOAT;
+  res->values = merged->values;
+  res->numGroupAttrs = numGroupAttrs;
+  res->keyTypes = (DataType *) malloc(sizeof(DataType) * numGroupAttrs);
+  res->keyLengths = (int *) malloc(sizeof(int) * numGroupAttrs);
+  for(i = 0; i < numGroupAttrs; i++)
+    {
+      res->keyTypes[i] = schema->dataTypes[groupAttrs[i]];
+      res->keyLengths[i] = schema->typeLength[groupAttrs[i]];
+    }
+  res->keyOffsets = st.key.offsets;
+  res->keySize = st.key.size;
+  res->keys = merged->keys;
+
+  free(merged->slots);
+  free(merged->hashes);
+  free(merged->counts);
+  free(merged);
+  *result = res;
+  return RC_OK;
+}
+
+/*
+ * Returns a group attribute of a group of an aggregation result as a
+ * newly allocated Value, like getAttr.
+ */
+RC
+getGroupAttr (AggrResult *result, int group, int groupAttr, Value **value)
+{
+  char *attr;
+  Value *val;
+  int length;
+
+  if (group < 0 || group >= result->numGroups || groupAttr < 0 || groupAttr >= result->numGroupAttrs)
+    THROW(RC_RM_UNKOWN_DATATYPE, "group or group attribute does not exist");
+
+  attr = result->keys + (group * result->keySize) + result->keyOffsets[groupAttr];
+  val = (Value *) malloc(sizeof(Value));
+  val->dt = result->keyTypes[groupAttr];
+  switch(val->dt)
+    {
+    case DT_INT:
+      memcpy(&val->v.intV, attr, sizeof(int));
+      break;
+    case DT_FLOAT:
+      memcpy(&val->v.floatV, attr, sizeof(float));
+      break;
+    case DT_BOOL:
+      memcpy(&val->v.boolV, attr, sizeof(bool));
+      break;
+    case DT_STRING:
+      length = strnlen(attr, result->keyLengths[groupAttr]);
+      val->v.stringV = (char *) malloc(length + 1);
+      memcpy(val->v.stringV, attr, length);
+      val->v.stringV[length] = '\0';
+      break;
+    }
+  *value = val;
+  return RC_OK;
+}
+
+RC
+freeAggrResult (AggrResult *result)
+{
+  free(result->types);
+  free(result->values);
+  free(result->keyTypes);
+  free(result->keyLengths);
+  free(result->keyOffsets);
+  free(result->keys);
+  free(result);
+  return RC_OK;
+}
+
+/*
+ * Hash join: builds a hash table on the join attributes of the left table
+ * and probes it with the tuples of the right one, so left should be the
+ * smaller input. If the left table is expected to need more than
+ * memoryBudget bytes (0 for no limit), both tables are first partitioned by
+ * the hash of their join attributes into temporary files and the
+ * partitions are joined one pair at a time.
+ */
+RC
+hashJoin (RM_TableData *left, RM_TableData *right, int numAttrs, int *leftAttrs,
+	  int *rightAttrs, long memoryBudget, RM_JoinCallback callback, void *context)
+{
+  JoinRows build, probeRows;
+  JoinTable table;
+  JoinProbe probe;
+  JoinSpill spill;
+  FILE **files;
+  long needed;
+  int numParts, p;
+  RC rc;
+
+  if ((rc = checkJoinAttrs(left, right, numAttrs, leftAttrs, rightAttrs)) != RC_OK)
+    return rc;
+
+  initJoinRows(&build, left->schema, numAttrs, leftAttrs);
+  initJoinRows(&probeRows, right->schema, numAttrs, rightAttrs);
+  probe.build = &build;
+  probe.table = &table;
+  probe.key = &probeRows.key;
+  probe.scratch = (char *) malloc(probeRows.rowSize);
+  probe.callback = callback;
+  probe.context = context;
+
+  // bytes of the rows, chains and slots of the left input
+  needed = (long) getNumTuples(left) * (build.rowSize + 4 * sizeof(int));
+  if (memoryBudget <= 0 || needed <= memoryBudget)
+    {
+      rc = parallelScan(left, NULL, 1, appendJoinRow, &build);
+      if (rc == RC_OK)
+	{
+	  buildJoinTable(&build, &table);
+	  rc = parallelScan(right, NULL, 1, probeJoinTuple, &probe);
+	  freeJoinTable(&table);
+	}
+      freeJoinRows(&build);
+      freeJoinRows(&probeRows);
+      free(probe.scratch);
+      return rc;
+    }
+
+  // partitions expected to fill half of the budget, leaving room for skew
+  spill.bits = 1;
+  while ((1L << spill.bits) * memoryBudget < 2 * needed && spill.bits < 8)
+    spill.bits++;
+  numParts = 1 << spill.bits;
+  files = (FILE **) calloc(2 * numParts, sizeof(FILE *));
+  for(p = 0; p < 2 * numParts; p++)
+    if ((files[p] = tmpfile()) == NULL)
+      rc = RC_WRITE_FAILED;
+
+  spill.row = (char *) malloc(build.rowSize > probeRows.rowSize ? build.rowSize : probeRows.rowSize);
+  if (rc == RC_OK)
+    {
+      spill.rows = &build;
+      spill.files = files;
+      rc = parallelScan(left, NULL, 1, spillJoinTuple, &spill);
+    }
+  if (rc == RC_OK)
+    {
+      spill.rows = &probeRows;
+      spill.files = files + numParts;
+      rc = parallelScan(right, NULL, 1, spillJoinTuple, &spill);
+    }
+
+  // join the pairs of partitions in memory
+  for(p = 0; rc == RC_OK && p < numParts; p++)
+    {
+      Record record;
+      char *row = spill.row;
+
+      rewind(files[p]);
+      build.numRows = 0;
+      while (rc == RC_OK && fread(row, build.rowSize, 1, files[p]) == 1)
+	{
+	  int i = allocJoinRow(&build);
+	  memcpy(ROW(&build, i), row, build.rowSize);
+	}
+      buildJoinTable(&build, &table);
+
+      rewind(files[numParts + p]);
+      while (rc == RC_OK && fread(row, probeRows.rowSize, 1, files[numParts + p]) == 1)
+	{
+	  record.id = *ROW_RID(&probeRows, row);
+	  record.data = ROW_DATA(&probeRows, row);
+	  rc = probeJoinKey(&probe, row, hashKey(row, probeRows.key.size), &record);
+	}
+      freeJoinTable(&table);
+    }
+
+  for(p = 0; p < 2 * numParts; p++)
+    if (files[p] != NULL)
+      fclose(files[p]);
+  free(files);
+  free(spill.row);
+  freeJoinRows(&build);
+  freeJoinRows(&probeRows);
+  free(probe.scratch);
+  return rc;
+}
+
+/*
+ * Sort-merge join: reads both tables into memory, sorts them on their join
+ * attributes and merges them, joining every tuple of a run of equal keys on
+ * the left with every tuple of the matching run on the right. Inputs which
+ * are already in key order, such as tables loaded in that order, are not
+ * sorted again.
+ */
+RC
+sortMergeJoin (RM_TableData *left, RM_TableData *right, int numAttrs, int *leftAttrs,
+	       int *rightAttrs, RM_JoinCallback callback, void *context)
+{
+  JoinRows l, r;
+  Record leftRecord, rightRecord;
+  int i, j, iEnd, jEnd, a, b, cmp;
+  RC rc;
+
+  if ((rc = checkJoinAttrs(left, right, numAttrs, leftAttrs, rightAttrs)) != RC_OK)
+    return rc;
+
+  initJoinRows(&l, left->schema, numAttrs, leftAttrs);
+  initJoinRows(&r, right->schema, numAttrs, rightAttrs);
+  rc = parallelScan(left, NULL, 1, appendJoinRow, &l);
+  if (rc == RC_OK)
+    rc = parallelScan(right, NULL, 1, appendJoinRow, &r);
+  if (rc == RC_OK && !l.sorted)
+    qsort_r(l.data, l.numRows, l.rowSize, compareJoinRows, &l.key);
+  if (rc == RC_OK && !r.sorted)
+    qsort_r(r.data, r.numRows, r.rowSize, compareJoinRows, &r.key);
+
+  i = 0;
+  j = 0;
+  while (rc == RC_OK && i < l.numRows && j < r.numRows)
+    {
+      cmp = compareKeys(&l.key, ROW(&l, i), ROW(&r, j));
+      if (cmp < 0)
+	i++;
+      else if (cmp > 0)
+	j++;
+      else
+	{
+	  // runs of equal keys on both sides
+	  for(iEnd = i + 1; iEnd < l.numRows && compareKeys(&l.key, ROW(&l, i), ROW(&l, iEnd)) == 0; iEnd++)
+	    ;
+	  for(jEnd = j + 1; jEnd < r.numRows && compareKeys(&r.key, ROW(&r, j), ROW(&r, jEnd)) == 0; jEnd++)
+	    ;
+	  for(a = i; rc == RC_OK && a < iEnd; a++)
+	    for(b = j; rc == RC_OK && b < jEnd; b++)
+	      {
+		leftRecord.id = *ROW_RID(&l, ROW(&l, a));
+		leftRecord.data = ROW_DATA(&l, ROW(&l, a));
+		rightRecord.id = *ROW_RID(&r, ROW(&r, b));
+		rightRecord.data = ROW_DATA(&r, ROW(&r, b));
+		rc = callback(context, &leftRecord, &rightRecord);
+	      }
+	  i = iEnd;
+	  j = jEnd;
+	}
+    }
+
+  freeJoinRows(&l);
+  freeJoinRows(&r);
+  return rc;
+}
+
+/*
+ * External merge sort of the remaining tuples of a scan on the given
+ * attributes, ascending. startSort consumes the scan (which the caller
+ * still closes) and nextSorted returns the tuples in order. The rows are
+ * sorted in memory on a normalized key compared with memcmp, by radix sort
+ * if the key has at most eight bytes. Whatever does not fit into
+ * memoryBudget bytes (0 for no limit) is written as sorted runs to a
+ * temporary page file and merged with a loser tree, reading ahead several
+ * pages per run; if there are more runs than buffers in the budget, groups
+ * of runs are first merged into longer runs. Sorts and merges never use
+ * more than memoryBudget bytes for rows and buffers.
+ */
+RC
+startSort (RM_ScanHandle *scan, int numAttrs, int *attrs, long memoryBudget, RM_SortHandle *sort)
+{
+  Schema *schema = scan->rel->schema;
+  SortState *st;
+  Record view;
+  long rowsBudget, finalFanIn;
+  RC rc;
+
+  if ((rc = checkSortAttrs(schema, numAttrs, attrs)) != RC_OK)
+    return rc;
+
+  st = createSortState(schema, numAttrs, attrs);
+  st->budget = memoryBudget;
+
+  // the write buffer, at least one row and two runs being merged have to fit
+  if (memoryBudget > 0 && memoryBudget < PAGE_SIZE + 2 * ((long) st->rowSize + PAGE_SIZE))
+    {
+      free(st->key.offsets);
+      free(st);
+      THROW(RC_RM_MEMORY_BUDGET, "memory budget too small for the sort");
+    }
+  st->outPages = SORT_WRITE_PAGES;
+  if (memoryBudget > 0)
+    {
+      while (st->outPages > 1 && (long) st->outPages * PAGE_SIZE * 8 > memoryBudget)
+	st->outPages /= 2;
+      rowsBudget = (memoryBudget - (long) st->outPages * PAGE_SIZE) / (st->rowSize + 2 * sizeof(SortEntry));
+      st->budgetRows = (rowsBudget < INT_MAX) ? rowsBudget : INT_MAX;
+    }
+  else
+    st->budgetRows = INT_MAX;
+  st->maxRows = getNumTuples(scan->rel) + 1;
+  if (st->maxRows > st->budgetRows)
+    st->maxRows = st->budgetRows;
+  st->data = (char *) malloc((size_t) st->maxRows * st->rowSize);
+  st->entries = (SortEntry *) malloc(sizeof(SortEntry) * st->maxRows);
+  st->tmp = (SortEntry *) malloc(sizeof(SortEntry) * st->maxRows);
+  sort->rel = scan->rel;
+  sort->mgmtData = st;
+
+  // run generation
+  while ((rc = nextView(scan, &view)) == RC_OK)
+    if ((rc = addSortRow(st, &view)) != RC_OK)
+      break;
+  if (rc != RC_RM_NO_MORE_TUPLES)
+    {
+      closeSort(sort);
+      return rc;
+    }
+  rc = RC_OK;
+  if (st->numRuns == 0)
+    {
+      sortRows(st);
+      return RC_OK;
+    }
+  if (st->numRows > 0)
+    rc = spillRun(st);
+
+  // the rows are on disk, their memory goes to the buffers of the merges
+  free(st->data);
+  free(st->entries);
+  free(st->tmp);
+  st->data = NULL;
+  st->entries = NULL;
+  st->tmp = NULL;
+  finalFanIn = memoryBudget / (st->rowSize + PAGE_SIZE);
+  while (rc == RC_OK && st->numRuns > finalFanIn)
+    rc = mergeRuns(st, (memoryBudget - (long) st->outPages * PAGE_SIZE) / (st->rowSize + PAGE_SIZE));
+  free(st->out);
+  st->out = NULL;
+  if (rc == RC_OK)
+    rc = openReaders(st, 0, st->numRuns, memoryBudget);
+  if (rc != RC_OK)
+    {
+      closeSort(sort);
+      return rc;
+    }
+  st->stats.numMergePasses++;
+  return RC_OK;
+}
+
+/*
+ * Top-N: the first limit tuples of a scan in the order of the given
+ * attributes (ORDER BY ... LIMIT), returned by nextSorted and freed by
+ * closeSort like a sort. Only the limit smallest rows seen so far are
+ * kept, in a max-heap on their normalized keys, so a tuple is copied only
+ * if it sorts before the largest of them; memory is bounded by limit rows
+ * whatever the size of the table.
+ */
+RC
+startTopN (RM_ScanHandle *scan, int numAttrs, int *attrs, int limit, RM_SortHandle *sort)
+{
+  Schema *schema = scan->rel->schema;
+  SortState *st;
+  Record view;
+  int *heap, i;
+  char *row, *key;
+  RC rc;
+
+  if ((rc = checkSortAttrs(schema, numAttrs, attrs)) != RC_OK)
+    return rc;
+
+  st = createSortState(schema, numAttrs, attrs);
+  if (limit < 0)
+    limit = 0;
+  st->maxRows = limit;
+  st->data = (char *) malloc((size_t) (limit + 1) * st->rowSize);
+  st->entries = (SortEntry *) malloc(sizeof(SortEntry) * (limit + 1));
+  st->tmp = (SortEntry *) malloc(sizeof(SortEntry) * (limit + 1));
+  heap = (int *) malloc(sizeof(int) * (limit + 1));
+  key = ROW(st, limit); // key of the tuple being read
+  sort->rel = scan->rel;
+  sort->mgmtData = st;
+
+  while (limit > 0 && (rc = nextView(scan, &view)) == RC_OK)
+    {
+      st->stats.numTuples++;
+      if (st->numRows < limit)
+	{
+	  // sift the new row up
+	  row = ROW(st, st->numRows);
+	  buildSortKey(&st->key, view.data, row);
+	  for(i = st->numRows++; i > 0 && memcmp(ROW(st, heap[(i - 1) / 2]), row, st->key.size) < 0; i = (i - 1) / 2)
+	    heap[i] = heap[(i - 1) / 2];
+	  heap[i] = st->numRows - 1;
+	}
+      else
+	{
+	  buildSortKey(&st->key, view.data, key);
+	  row = ROW(st, heap[0]);
+	  if (memcmp(key, row, st->key.size) >= 0)
+	    continue;
+	  memcpy(row, key, st->key.size);
+	  siftDown(st, heap, st->numRows, 0);
+	}
+      *ROW_RID(st, row) = view.id;
+      memcpy(ROW_DATA(st, row), view.data, st->recordSize);
+    }
+  free(heap);
+  if (limit > 0 && rc != RC_RM_NO_MORE_TUPLES)
+    {
+      closeSort(sort);
+      return rc;
+    }
+  sortRows(st);
+  return RC_OK;
+}
+
+/*
+ * Copies the next tuple in sort order into record, RC_RM_NO_MORE_TUPLES
+ * after the last one.
+ */
+RC
+nextSorted (RM_SortHandle *sort, Record *record)
+{
+  SortState *st = (SortState *) sort->mgmtData;
+  char *row;
+
+  if (st->readers == NULL)
+    {
+      if (st->nextRow == st->numRows)
+	return RC_RM_NO_MORE_TUPLES;
+      row = ROW(st, st->entries[st->nextRow++].row);
+      record->id = *ROW_RID(st, row);
+      memcpy(record->data, ROW_DATA(st, row), st->recordSize);
+      return RC_OK;
+    }
+
+  if (st->readers[st->losers[0]].rowsLeft == 0)
+    return RC_RM_NO_MORE_TUPLES;
+  row = st->readers[st->losers[0]].pos;
+  record->id = *ROW_RID(st, row);
+  memcpy(record->data, ROW_DATA(st, row), st->recordSize);
+  return advanceMerge(st);
+}
+
+RC
+getSortStats (RM_SortHandle *sort, RM_SortStats *stats)
+{
+  *stats = ((SortState *) sort->mgmtData)->stats;
+  return RC_OK;
+}
+
+// frees the memory of a sort and removes its temporary file
+RC
+closeSort (RM_SortHandle *sort)
+{
+  SortState *st = (SortState *) sort->mgmtData;
+  RC rc = RC_OK;
+
+  closeReaders(st);
+  if (st->fileOpen)
+    {
+      closePageFile(&st->file);
+      rc = destroyPageFile(st->fileName);
+    }
+  free(st->key.offsets);
+  free(st->data);
+  free(st->entries);
+  free(st->tmp);
+  free(st->runs);
+  free(st->out);
+  free(st);
+  sort->mgmtData = NULL;
+  return rc;
+}
+
+// adds the matching tuples of a page to the partial aggregates of the
+// worker; with the PAX layout only the attributes used are gathered
+static RC
+aggregateBatch (void *context, int worker, RM_ColumnBatch *batch)
+{
+  AggrState *st = (AggrState *) context;
+  Schema *schema = st->schema;
+  char *row = st->rows[worker];
+  uint64_t todo;
+  int w, i, j, a;
+
+  for(w = 0; w < BITMAP_WORDS(batch->numSlots); w++)
+    for(todo = batch->selection[w]; todo != 0; todo &= todo - 1)
+      {
+	i = (w * 64) + __builtin_ctzll(todo);
+	if (batch->rows != NULL)
+	  {
+	    aggregateRow(st, worker, batch->rows + (i * batch->rowStride));
+	    continue;
+	  }
+	for(j = 0; j < st->numUsed; j++)
+	  {
+	    a = st->usedAttrs[j];
+	    memcpy(row + schema->attrOffsets[a], batch->columns[a] + (i * batch->strides[a]),
+		   schema->typeLength[a]);
+	  }
+	aggregateRow(st, worker, row);
+      }
+  return RC_OK;
+}
+
+// adds a matching tuple to the partial aggregates of the worker
+static void
+aggregateRow (AggrState *st, int worker, char *data)
+{
+  AggrTable *table = st->tables[worker];
+  char *key = st->scratch[worker];
+  int group = 0;
+
+  if (st->intKey >= 0)
+    {
+      // fast path for a single int or float group attribute
+      uint32_t word;
+      memcpy(&word, data + st->intKey, sizeof(uint32_t));
+      group = findIntGroup(st, table, word);
+    }
+  else if (st->key.size > 0)
+    {
+      buildKey(&st->key, data, key);
+      group = findGroup(st, table, key, hashKey(key, st->key.size));
+    }
+  else if (table->numGroups == 0)
+    findGroup(st, table, key, hashKey(key, 0));
+
+  accumulate(st, table->values + (group * st->numAggrs), data);
+  table->counts[group]++;
+}
+
+// a table with room for expectedGroups groups before it has to grow
+static AggrTable *
+createAggrTable (AggrState *st, int expectedGroups)
+{
+  AggrTable *table = (AggrTable *) malloc(sizeof(AggrTable));
+
+  table->maxGroups = (expectedGroups < 16) ? 16 : expectedGroups;
+  table->numSlots = 32;
+  while (table->numSlots < 2 * table->maxGroups)
+    table->numSlots *= 2;
+  table->slots = (int *) calloc(table->numSlots, sizeof(int));
+  table->numGroups = 0;
+  table->hashes = (uint32_t *) malloc(sizeof(uint32_t) * table->maxGroups);
+  table->keys = (char *) malloc(st->key.size * table->maxGroups + 1);
+  table->values = (AggrValue *) malloc(sizeof(AggrValue) * st->numAggrs * table->maxGroups + 1);
+  table->counts = (int64_t *) malloc(sizeof(int64_t) * table->maxGroups);
+  return table;
+}
+
+static void
+freeAggrTable (AggrTable *table)
+{
+  free(table->slots);
+  free(table->hashes);
+  free(table->keys);
+  free(table->values);
+  free(table->counts);
+  free(table);
+}
+
+/*
+ * Returns the group with the given key, adding it if the table does not
+ * contain it yet. Slots are probed linearly and the table keeps at most
+ * half of its slots in use.
+ */
+static int
+findGroup (AggrState *st, AggrTable *table, char *key, uint32_t hash)
+{
+  int mask = table->numSlots - 1;
+  int slot = hash & mask;
+  int group;
+
+  while (table->slots[slot] != 0)
+    {
+      group = table->slots[slot] - 1;
+      if (table->hashes[group] == hash
+	  && memcmp(table->keys + (group * st->key.size), key, st->key.size) == 0)
+	return group;
+      slot = (slot + 1) & mask;
+    }
+
+  // add the group
+  if (table->numGroups == table->maxGroups)
+    {
+      table->maxGroups *= 2;
+      table->hashes = (uint32_t *) realloc(table->hashes, sizeof(uint32_t) * table->maxGroups);
+      table->keys = (char *) realloc(table->keys, st->key.size * table->maxGroups + 1);
+      table->values = (AggrValue *) realloc(table->values, sizeof(AggrValue) * st->numAggrs * table->maxGroups + 1);
+      table->counts = (int64_t *) realloc(table->counts, sizeof(int64_t) * table->maxGroups);
+    }
+  group = table->numGroups++;
+  table->hashes[group] = hash;
+  memcpy(table->keys + (group * st->key.size), key, st->key.size);
+  initValues(st, table->values + (group * st->numAggrs));
+  table->counts[group] = 0;
+  table->slots[slot] = group + 1;
+
+  if (2 * table->numGroups > table->numSlots)
+    growSlots(table);
+  return group;
+}
+
+// findGroup for keys of a single int or float, compared as words
+static int
+findIntGroup (AggrState *st, AggrTable *table, uint32_t key)
+{
+  uint32_t hash = hashKey((char *) &key, sizeof(uint32_t));
+  int mask = table->numSlots - 1;
+  int slot = hash & mask;
+  uint32_t *keys = (uint32_t *) table->keys;
+  int group;
+
+  while (table->slots[slot] != 0)
+    {
+      group = table->slots[slot] - 1;
+      if (keys[group] == key)
+	return group;
+      slot = (slot + 1) & mask;
+    }
+  return findGroup(st, table, (char *) &key, hash);
+}
+
+// doubles the slots, the groups stay where they are
+static void
+growSlots (AggrTable *table)
+{
+  int mask, slot, g;
+
+  table->numSlots *= 2;
+  mask = table->numSlots - 1;
+  free(table->slots);
+  table->slots = (int *) calloc(table->numSlots, sizeof(int));
+  for(g = 0; g < table->numGroups; g++)
+    {
+      slot = table->hashes[g] & mask;
+      while (table->slots[slot] != 0)
+	slot = (slot + 1) & mask;
+      table->slots[slot] = g + 1;
+    }
+}
+
+static void
+initValues (AggrState *st, AggrValue *acc)
+{
+  int i;
+
+  for(i = 0; i < st->numAggrs; i++)
+    {
+      bool isInt = (st->aggrTypes[i] == DT_INT);
+      switch(st->aggrs[i].type)
+	{
+	case AGGR_MIN:
+	  if (isInt)
+	    acc[i].intV = INT64_MAX;
+	  else
+	    acc[i].floatV = HUGE_VAL;
+	  break;
+	case AGGR_MAX:
+	  if (isInt)
+	    acc[i].intV = INT64_MIN;
+	  else
+	    acc[i].floatV = -HUGE_VAL;
+	  break;
+	default:
+	  if (isInt)
+	    acc[i].intV = 0;
+	  else
+	    acc[i].floatV = 0;
+	  break;
+	}
+    }
+}
+
+// typed update of the aggregates with the attributes of a tuple
+static void
+accumulate (AggrState *st, AggrValue *acc, char *data)
+{
+  int i, intV;
+  float floatV;
+
+  for(i = 0; i < st->numAggrs; i++)
+    {
+      AggrSpec *spec = &st->aggrs[i];
+      char *attr;
+
+      if (spec->type == AGGR_COUNT)
+	{
+	  acc[i].intV++;
+	  continue;
+	}
+
+      attr = data + st->schema->attrOffsets[spec->attrNum];
+      if (st->aggrTypes[i] == DT_INT)
+	{
+	  memcpy(&intV, attr, sizeof(int));
+	  switch(spec->type)
+	    {
+	    case AGGR_MIN:
+	      if (intV < acc[i].intV)
+		acc[i].intV = intV;
+	      break;
+	    case AGGR_MAX:
+	      if (intV > acc[i].intV)
+		acc[i].intV = intV;
+	      break;
+	    default:
+	      acc[i].intV += intV;
+	      break;
+	    }
+	}
+      else
+	{
+	  memcpy(&floatV, attr, sizeof(float));
+	  switch(spec->type)
+	    {
+	    case AGGR_MIN:
+	      if (floatV < acc[i].floatV)
+		acc[i].floatV = floatV;
+	      break;
+	    case AGGR_MAX:
+	      if (floatV > acc[i].floatV)
+		acc[i].floatV = floatV;
+	      break;
+	    default:
+	      acc[i].floatV += floatV;
+	      break;
+	    }
+	}
+    }
+}
+
+// merges the partial aggregates of a worker
+static void
+combine (AggrState *st, AggrValue *acc, AggrValue *partial)
+{
+  int i;
+
+  for(i = 0; i < st->numAggrs; i++)
+    {
+      bool isInt = (st->aggrTypes[i] == DT_INT);
+      switch(st->aggrs[i].type)
+	{
+	case AGGR_MIN:
+	  if (isInt ? partial[i].intV < acc[i].intV : partial[i].floatV < acc[i].floatV)
+	    acc[i] = partial[i];
+	  break;
+	case AGGR_MAX:
+	  if (isInt ? partial[i].intV > acc[i].intV : partial[i].floatV > acc[i].floatV)
+	    acc[i] = partial[i];
+	  break;
+	default:
+	  if (isInt)
+	    acc[i].intV += partial[i].intV;
+	  else
+	    acc[i].floatV += partial[i].floatV;
+	  break;
+	}
+    }
+}
+
+// turns sums into averages, aggregates of no tuples are 0
+static void
+finalize (AggrState *st, AggrValue *acc, int64_t count)
+{
+  int i;
+
+  for(i = 0; i < st->numAggrs; i++)
+    {
+      bool isInt = (st->aggrTypes[i] == DT_INT);
+      switch(st->aggrs[i].type)
+	{
+	case AGGR_AVG:
+	  if (count == 0)
+	    acc[i].floatV = 0;
+	  else
+	    acc[i].floatV = (isInt ? (double) acc[i].intV : acc[i].floatV) / count;
+	  break;
+	case AGGR_MIN:
+	case AGGR_MAX:
+	  if (count == 0 && isInt)
+	    acc[i].intV = 0;
+	  else if (count == 0)
+	    acc[i].floatV = 0;
+	  break;
+	default:
+	  break;
+	}
+    }
+}
+
+// offsets of the attributes of a key, which are stored one after the other
+static void
+initKeyLayout (KeyLayout *layout, Schema *schema, int numAttrs, int *attrs)
+{
+  int i;
+
+  layout->schema = schema;
+  layout->numAttrs = numAttrs;
+  layout->attrs = attrs;
+  layout->offsets = (int *) malloc(sizeof(int) * numAttrs + 1);
+  layout->size = 0;
+  for(i = 0; i < numAttrs; i++)
+    {
+      layout->offsets[i] = layout->size;
+      layout->size += schema->typeLength[attrs[i]];
+    }
+}
+
+// copies the key attributes of a tuple into a key, strings are padded with NULs
+static void
+buildKey (KeyLayout *layout, char *data, char *key)
+{
+  Schema *schema = layout->schema;
+  int i, attrNum, length, used;
+
+  for(i = 0; i < layout->numAttrs; i++)
+    {
+      attrNum = layout->attrs[i];
+      length = schema->typeLength[attrNum];
+      if (schema->dataTypes[attrNum] == DT_STRING)
+	{
+	  used = strnlen(data + schema->attrOffsets[attrNum], length);
+	  memcpy(key + layout->offsets[i], data + schema->attrOffsets[attrNum], used);
+	  memset(key + layout->offsets[i] + used, 0, length - used);
+	}
+      else
+	memcpy(key + layout->offsets[i], data + schema->attrOffsets[attrNum], length);
+    }
+}
+
+// multiplicative hash of a key, four bytes at a time
+static uint32_t
+hashKey (char *key, int size)
+{
+  uint64_t h = 0x9E3779B97F4A7C15ULL ^ (uint64_t) size;
+  uint32_t word;
+  int i;
+
+  for(i = 0; i + 4 <= size; i += 4)
+    {
+      memcpy(&word, key + i, sizeof(uint32_t));
+      h = (h ^ word) * 0xFF51AFD7ED558CCDULL;
+      h ^= h >> 32;
+    }
+  for(; i < size; i++)
+    h = (h ^ (unsigned char) key[i]) * 0xFF51AFD7ED558CCDULL;
+  h ^= h >> 29;
+  return (uint32_t) h;
+}
+
+// join attributes have to exist and be of the same type and length on both sides
+static RC
+checkJoinAttrs (RM_TableData *left, RM_TableData *right, int numAttrs, int *leftAttrs, int *rightAttrs)
+{
+  int i;
+
+  for(i = 0; i < numAttrs; i++)
+    {
+      if (leftAttrs[i] < 0 || leftAttrs[i] >= left->schema->numAttr
+	  || rightAttrs[i] < 0 || rightAttrs[i] >= right->schema->numAttr)
+	THROW(RC_RM_UNKOWN_DATATYPE, "join attribute does not exist");
+      if (left->schema->dataTypes[leftAttrs[i]] != right->schema->dataTypes[rightAttrs[i]]
+	  || left->schema->typeLength[leftAttrs[i]] != right->schema->typeLength[rightAttrs[i]])
+	THROW(RC_RM_COMPARE_VALUE_OF_DIFFERENT_DATATYPE, "join attributes differ in type or length");
+    }
+  return RC_OK;
+}
+
+static void
+initJoinRows (JoinRows *rows, Schema *schema, int numAttrs, int *attrs)
+{
+  initKeyLayout(&rows->key, schema, numAttrs, attrs);
+  rows->recordSize = schema->recordSize;
+  rows->rowSize = rows->key.size + sizeof(RID) + rows->recordSize;
+  rows->numRows = 0;
+  rows->maxRows = 0;
+  rows->data = NULL;
+  rows->sorted = TRUE;
+}
+
+static void
+freeJoinRows (JoinRows *rows)
+{
+  free(rows->key.offsets);
+  free(rows->data);
+}
+
+// index of a new row at the end, growing the rows by doubling
+static int
+allocJoinRow (JoinRows *rows)
+{
+  if (rows->numRows == rows->maxRows)
+    {
+      rows->maxRows = (rows->maxRows == 0) ? 1024 : 2 * rows->maxRows;
+      rows->data = (char *) realloc(rows->data, (size_t) rows->maxRows * rows->rowSize);
+    }
+  return rows->numRows++;
+}
+
+// scan callback copying a tuple into the rows
+static RC
+appendJoinRow (void *context, int worker, Record *record)
+{
+  JoinRows *rows = (JoinRows *) context;
+  int i = allocJoinRow(rows); // may move the rows
+  char *row = ROW(rows, i);
+
+  (void) worker; // the joins scan with a single worker
+  buildKey(&rows->key, record->data, row);
+  *ROW_RID(rows, row) = record->id;
+  memcpy(ROW_DATA(rows, row), record->data, rows->recordSize);
+  if (rows->sorted && rows->numRows > 1
+      && compareKeys(&rows->key, row - rows->rowSize, row) > 0)
+    rows->sorted = FALSE;
+  return RC_OK;
+}
+
+// scan callback writing a tuple to the partition of its hash
+static RC
+spillJoinTuple (void *context, int worker, Record *record)
+{
+  JoinSpill *spill = (JoinSpill *) context;
+  JoinRows *rows = spill->rows;
+  uint32_t hash;
+
+  (void) worker;
+  buildKey(&rows->key, record->data, spill->row);
+  *ROW_RID(rows, spill->row) = record->id;
+  memcpy(ROW_DATA(rows, spill->row), record->data, rows->recordSize);
+  hash = hashKey(spill->row, rows->key.size);
+  if (fwrite(spill->row, rows->rowSize, 1, spill->files[hash >> (32 - spill->bits)]) != 1)
+    return RC_WRITE_FAILED;
+  return RC_OK;
+}
+
+static void
+buildJoinTable (JoinRows *rows, JoinTable *table)
+{
+  int i, slot;
+
+  table->numSlots = 64;
+  while (table->numSlots < 2 * rows->numRows)
+    table->numSlots *= 2;
+  table->slots = (int *) calloc(table->numSlots, sizeof(int));
+  table->next = (int *) malloc(sizeof(int) * rows->numRows + 1);
+  table->hashes = (uint32_t *) malloc(sizeof(uint32_t) * rows->numRows + 1);
+  for(i = 0; i < rows->numRows; i++)
+    {
+      table->hashes[i] = hashKey(ROW(rows, i), rows->key.size);
+      slot = table->hashes[i] & (table->numSlots - 1);
+      table->next[i] = table->slots[slot];
+      table->slots[slot] = i + 1;
+    }
+}
+
+static void
+freeJoinTable (JoinTable *table)
+{
+  free(table->slots);
+  free(table->next);
+  free(table->hashes);
+}
+
+// scan callback probing the hash table with a tuple of the right input
+static RC
+probeJoinTuple (void *context, int worker, Record *record)
+{
+  JoinProbe *probe = (JoinProbe *) context;
+
+  (void) worker;
+  buildKey(probe->key, record->data, probe->scratch);
+  return probeJoinKey(probe, probe->scratch, hashKey(probe->scratch, probe->key->size), record);
+}
+
+// calls the join callback for every row of the hash table with the key
+static RC
+probeJoinKey (JoinProbe *probe, char *key, uint32_t hash, Record *record)
+{
+  JoinRows *build = probe->build;
+  JoinTable *table = probe->table;
+  Record match;
+  char *row;
+  int i;
+  RC rc;
+
+  for(i = table->slots[hash & (table->numSlots - 1)]; i != 0; i = table->next[i - 1])
+    {
+      row = ROW(build, i - 1);
+      if (table->hashes[i - 1] != hash || memcmp(row, key, build->key.size) != 0)
+	continue;
+      match.id = *ROW_RID(build, row);
+      match.data = ROW_DATA(build, row);
+      if ((rc = probe->callback(probe->context, &match, record)) != RC_OK)
+	return rc;
+    }
+  return RC_OK;
+}
+
+// qsort_r comparison of rows by their keys
+static int
+compareJoinRows (const void *left, const void *right, void *layout)
+{
+  return compareKeys((KeyLayout *) layout, (char *) left, (char *) right);
+}
+
+// orders keys attribute by attribute, by the values of their types
+static int
+compareKeys (KeyLayout *layout, char *left, char *right)
+{
+  Schema *schema = layout->schema;
+  int i, cmp, li, ri;
+  float lf, rf;
+  bool lb, rb;
+
+  for(i = 0; i < layout->numAttrs; i++)
+    {
+      char *l = left + layout->offsets[i];
+      char *r = right + layout->offsets[i];
+
+      switch(schema->dataTypes[layout->attrs[i]])
+	{
+	case DT_INT:
+	  memcpy(&li, l, sizeof(int));
+	  memcpy(&ri, r, sizeof(int));
+	  cmp = (li > ri) - (li < ri);
+	  break;
+	case DT_FLOAT:
+	  memcpy(&lf, l, sizeof(float));
+	  memcpy(&rf, r, sizeof(float));
+	  cmp = (lf > rf) - (lf < rf);
+	  break;
+	case DT_BOOL:
+	  memcpy(&lb, l, sizeof(bool));
+	  memcpy(&rb, r, sizeof(bool));
+	  cmp = (lb > rb) - (lb < rb);
+	  break;
+	default:
+	  cmp = strncmp(l, r, schema->typeLength[layout->attrs[i]]);
+	  break;
+	}
+      if (cmp != 0)
+	return cmp;
+    }
+  return 0;
+}
+
+// sort attributes have to exist
+static RC
+checkSortAttrs (Schema *schema, int numAttrs, int *attrs)
+{
+  int i;
+
+  for(i = 0; i < numAttrs; i++)
+    if (attrs[i] < 0 || attrs[i] >= schema->numAttr)
+      THROW(RC_RM_UNKOWN_DATATYPE, "sort attribute does not exist");
+  return RC_OK;
+}
+
+static SortState *
+createSortState (Schema *schema, int numAttrs, int *attrs)
+{
+  SortState *st = (SortState *) calloc(1, sizeof(SortState));
+
+  initKeyLayout(&st->key, schema, numAttrs, attrs);
+  st->recordSize = schema->recordSize;
+  st->rowSize = st->key.size + sizeof(RID) + st->recordSize;
+  return st;
+}
+
+// restores the max-heap of rows below entry i after its key became smaller
+static void
+siftDown (SortState *st, int *heap, int numRows, int i)
+{
+  int top = heap[i], child;
+
+  while ((child = 2 * i + 1) < numRows)
+    {
+      if (child + 1 < numRows && memcmp(ROW(st, heap[child + 1]), ROW(st, heap[child]), st->key.size) > 0)
+	child++;
+      if (memcmp(ROW(st, heap[child]), ROW(st, top), st->key.size) <= 0)
+	break;
+      heap[i] = heap[child];
+      i = child;
+    }
+  heap[i] = top;
+}
+
+// key whose bytes order like compareKeys orders the values: ints and
+// floats big-endian with the sign flipped (all bits for negative floats),
+// bools as 0 or 1 in the last byte and strings padded with NULs
+static void
+buildSortKey (KeyLayout *layout, char *data, char *key)
+{
+  Schema *schema = layout->schema;
+  unsigned char *k;
+  uint32_t u;
+  bool b;
+  int i, length;
+
+  buildKey(layout, data, key);
+  for(i = 0; i < layout->numAttrs; i++)
+    {
+      k = (unsigned char *) key + layout->offsets[i];
+      length = schema->typeLength[layout->attrs[i]];
+      switch(schema->dataTypes[layout->attrs[i]])
+	{
+	case DT_INT:
+	case DT_FLOAT:
+	  memcpy(&u, k, sizeof(uint32_t));
+	  if (schema->dataTypes[layout->attrs[i]] == DT_INT || !(u & 0x80000000u))
+	    u ^= 0x80000000u;
+	  else
+	    u = ~u;
+	  k[0] = u >> 24;
+	  k[1] = u >> 16;
+	  k[2] = u >> 8;
+	  k[3] = u;
+	  break;
+	case DT_BOOL:
+	  memcpy(&b, k, sizeof(bool));
+	  memset(k, 0, length);
+	  k[length - 1] = (b != 0);
+	  break;
+	default:
+	  break;
+	}
+    }
+}
+
+// first eight bytes of a normalized key as a number ordering like memcmp
+static uint64_t
+keyPrefix (char *key, int size)
+{
+  uint64_t prefix = 0;
+  int i;
+
+  for(i = 0; i < 8; i++)
+    prefix = (prefix << 8) | ((i < size) ? (unsigned char) key[i] : 0);
+  return prefix;
+}
+
+// copies a tuple into the rows of the run, writing the run out when the budget is full
+static RC
+addSortRow (SortState *st, Record *record)
+{
+  char *row;
+  RC rc;
+
+  if (st->numRows == st->maxRows)
+    {
+      if (st->maxRows == st->budgetRows)
+	{
+	  if ((rc = spillRun(st)) != RC_OK)
+	    return rc;
+	}
+      else
+	{
+	  st->maxRows = (st->maxRows > st->budgetRows / 2) ? st->budgetRows : 2 * st->maxRows;
+	  st->data = (char *) realloc(st->data, (size_t) st->maxRows * st->rowSize);
+	  st->entries = (SortEntry *) realloc(st->entries, sizeof(SortEntry) * st->maxRows);
+	  st->tmp = (SortEntry *) realloc(st->tmp, sizeof(SortEntry) * st->maxRows);
+	}
+    }
+  row = ROW(st, st->numRows++);
+  buildSortKey(&st->key, record->data, row);
+  *ROW_RID(st, row) = record->id;
+  memcpy(ROW_DATA(st, row), record->data, st->recordSize);
+  st->stats.numTuples++;
+  return RC_OK;
+}
+
+// orders the entries of the rows: LSD radix sort on the prefix if it holds
+// the whole key, skipping bytes equal in all keys, comparisons otherwise
+static void
+sortRows (SortState *st)
+{
+  SortEntry *swap;
+  int count[256];
+  int i, j, shift, pos, n = st->numRows;
+
+  for(i = 0; i < n; i++)
+    {
+      st->entries[i].prefix = keyPrefix(ROW(st, i), st->key.size);
+      st->entries[i].row = i;
+    }
+  if (st->key.size > 8)
+    {
+      qsort_r(st->entries, n, sizeof(SortEntry), compareSortEntries, st);
+      return;
+    }
+
+  for(j = st->key.size - 1; j >= 0; j--)
+    {
+      shift = 56 - 8 * j;
+      memset(count, 0, sizeof(count));
+      for(i = 0; i < n; i++)
+	count[(st->entries[i].prefix >> shift) & 0xFF]++;
+      if (n == 0 || count[(st->entries[0].prefix >> shift) & 0xFF] == n)
+	continue;
+      for(i = 0, pos = 0; i < 256; i++)
+	{
+	  int c = count[i];
+	  count[i] = pos;
+	  pos += c;
+	}
+      for(i = 0; i < n; i++)
+	st->tmp[count[(st->entries[i].prefix >> shift) & 0xFF]++] = st->entries[i];
+      swap = st->entries;
+      st->entries = st->tmp;
+      st->tmp = swap;
+    }
+}
+
+// qsort_r comparison of entries by their prefixes, then the rest of the keys
+static int
+compareSortEntries (const void *left, const void *right, void *state)
+{
+  SortState *st = (SortState *) state;
+  const SortEntry *l = (const SortEntry *) left;
+  const SortEntry *r = (const SortEntry *) right;
+
+  if (l->prefix != r->prefix)
+    return (l->prefix > r->prefix) ? 1 : -1;
+  return memcmp(ROW(st, l->row) + 8, ROW(st, r->row) + 8, st->key.size - 8);
+}
+
+// sorts the rows in memory and writes them as a new run
+static RC
+spillRun (SortState *st)
+{
+  int i;
+  RC rc = RC_OK;
+
+  sortRows(st);
+  beginRun(st);
+  if (!st->fileOpen)
+    {
+      static int numFiles = 0;
+
+      snprintf(st->fileName, sizeof(st->fileName), "sort_%i_%i.tmp", (int) getpid(),
+	       __atomic_fetch_add(&numFiles, 1, __ATOMIC_RELAXED));
+      if ((rc = createPageFile(st->fileName)) != RC_OK
+	  || (rc = openPageFile(st->fileName, &st->file)) != RC_OK)
+	return rc;
+      st->fileOpen = TRUE;
+      st->out = (char *) malloc((size_t) st->outPages * PAGE_SIZE);
+    }
+  for(i = 0; rc == RC_OK && i < st->numRows; i++)
+    rc = writeSortRow(st, ROW(st, st->entries[i].row));
+  if (rc == RC_OK)
+    rc = flushSortPages(st);
+  st->numRows = 0;
+  st->stats.numRuns++;
+  return rc;
+}
+
+// appends an empty run starting at the next page of the file
+static void
+beginRun (SortState *st)
+{
+  if (st->numRuns == st->maxRuns)
+    {
+      st->maxRuns = (st->maxRuns == 0) ? 16 : 2 * st->maxRuns;
+      st->runs = (SortRun *) realloc(st->runs, sizeof(SortRun) * st->maxRuns);
+    }
+  st->runs[st->numRuns].firstPage = st->numPages;
+  st->runs[st->numRuns].numRows = 0;
+  st->numRuns++;
+}
+
+// appends a row to the last run, rows may span pages
+static RC
+writeSortRow (SortState *st, char *row)
+{
+  int left = st->rowSize, capacity = st->outPages * PAGE_SIZE, chunk;
+  RC rc;
+
+  while (left > 0)
+    {
+      chunk = (left < capacity - st->outUsed) ? left : capacity - st->outUsed;
+      memcpy(st->out + st->outUsed, row, chunk);
+      st->outUsed += chunk;
+      row += chunk;
+      left -= chunk;
+      if (st->outUsed == capacity && (rc = flushSortPages(st)) != RC_OK)
+	return rc;
+    }
+  st->runs[st->numRuns - 1].numRows++;
+  return RC_OK;
+}
+
+// writes the pages begun in the output buffer to the end of the file
+static RC
+flushSortPages (SortState *st)
+{
+  int i, numPages = (st->outUsed + PAGE_SIZE - 1) / PAGE_SIZE;
+  RC rc;
+
+  memset(st->out + st->outUsed, 0, (size_t) numPages * PAGE_SIZE - st->outUsed);
+  for(i = 0; i < numPages; i++)
+    if ((rc = writeBlock(st->numPages++, &st->file, st->out + (size_t) i * PAGE_SIZE)) != RC_OK)
+      return rc;
+  st->stats.bytesWritten += (long) numPages * PAGE_SIZE;
+  st->outUsed = 0;
+  return RC_OK;
+}
+
+// one merge pass: merges groups of fanIn runs into longer runs
+static RC
+mergeRuns (SortState *st, int fanIn)
+{
+  int end = st->numRuns, first, n;
+  long bytes = st->budget - (long) st->outPages * PAGE_SIZE;
+  RC rc = RC_OK;
+
+  for(first = 0; rc == RC_OK && first < end; first += n)
+    {
+      n = (end - first < fanIn) ? end - first : fanIn;
+      if (n == 1)
+	{
+	  beginRun(st);
+	  st->runs[st->numRuns - 1] = st->runs[first];
+	  continue;
+	}
+      if ((rc = openReaders(st, first, n, bytes)) != RC_OK)
+	break;
+      beginRun(st);
+      while (rc == RC_OK && st->readers[st->losers[0]].rowsLeft > 0)
+	{
+	  rc = writeSortRow(st, st->readers[st->losers[0]].pos);
+	  if (rc == RC_OK)
+	    rc = advanceMerge(st);
+	}
+      if (rc == RC_OK)
+	rc = flushSortPages(st);
+      closeReaders(st);
+    }
+  memmove(st->runs, st->runs + end, sizeof(SortRun) * (st->numRuns - end));
+  st->numRuns -= end;
+  st->stats.numMergePasses++;
+  return rc;
+}
+
+// starts merging numRuns runs, sharing bytes between their read buffers
+static RC
+openReaders (SortState *st, int first, int numRuns, long bytes)
+{
+  RunReader *reader;
+  int i, numPages;
+  RC rc = RC_OK;
+
+  numPages = (bytes / numRuns - st->rowSize) / PAGE_SIZE;
+  if (numPages > SORT_READ_PAGES)
+    numPages = SORT_READ_PAGES;
+  if (numPages < 1)
+    numPages = 1;
+  st->numReaders = numRuns;
+  st->readers = (RunReader *) calloc(numRuns, sizeof(RunReader));
+  st->losers = (int *) malloc(sizeof(int) * numRuns);
+  for(i = 0; i < numRuns; i++)
+    {
+      reader = st->readers + i;
+      reader->nextPage = st->runs[first + i].firstPage;
+      reader->rowsLeft = st->runs[first + i].numRows;
+      reader->numPages = numPages;
+      reader->buffer = (char *) malloc(st->rowSize + (size_t) numPages * PAGE_SIZE);
+      reader->pos = reader->buffer;
+      reader->end = reader->buffer;
+      if (rc == RC_OK)
+	rc = fillReader(st, reader);
+    }
+  st->losers[0] = (numRuns > 1) ? playLosers(st, 1) : 0;
+  return rc;
+}
+
+static void
+closeReaders (SortState *st)
+{
+  int i;
+
+  for(i = 0; i < st->numReaders; i++)
+    free(st->readers[i].buffer);
+  free(st->readers);
+  free(st->losers);
+  st->readers = NULL;
+  st->losers = NULL;
+  st->numReaders = 0;
+}
+
+// makes sure the current row of a reader is in its buffer, reading the
+// next pages of its run after the rest of the buffer if it is not
+static RC
+fillReader (SortState *st, RunReader *reader)
+{
+  long tail = reader->end - reader->pos, needed;
+  int i, numPages;
+  RC rc;
+
+  if (reader->rowsLeft == 0 || tail >= st->rowSize)
+    return RC_OK;
+
+  memmove(reader->buffer, reader->pos, tail);
+  needed = reader->rowsLeft * st->rowSize - tail;
+  numPages = (needed + PAGE_SIZE - 1) / PAGE_SIZE;
+  if (numPages > reader->numPages)
+    numPages = reader->numPages;
+  for(i = 0; i < numPages; i++)
+    if ((rc = readBlock(reader->nextPage++, &st->file, reader->buffer + tail + (size_t) i * PAGE_SIZE)) != RC_OK)
+      return rc;
+  st->stats.bytesRead += (long) numPages * PAGE_SIZE;
+  reader->pos = reader->buffer;
+  reader->end = reader->buffer + tail + (((long) numPages * PAGE_SIZE < needed) ? (long) numPages * PAGE_SIZE : needed);
+  return RC_OK;
+}
+
+// reader a wins over reader b if its row comes first, exhausted readers lose
+static bool
+readerWins (SortState *st, int a, int b)
+{
+  RunReader *ra = st->readers + a, *rb = st->readers + b;
+  int cmp;
+
+  if (rb->rowsLeft == 0)
+    return TRUE;
+  if (ra->rowsLeft == 0)
+    return FALSE;
+  cmp = memcmp(ra->pos, rb->pos, st->key.size);
+  return cmp < 0 || (cmp == 0 && a < b);
+}
+
+// plays the matches of a subtree of the loser tree, the leaves of the
+// readers are nodes numReaders..2*numReaders-1; returns the winner
+static int
+playLosers (SortState *st, int node)
+{
+  int left, right;
+
+  if (node >= st->numReaders)
+    return node - st->numReaders;
+  left = playLosers(st, 2 * node);
+  right = playLosers(st, 2 * node + 1);
+  if (readerWins(st, left, right))
+    {
+      st->losers[node] = right;
+      return left;
+    }
+  st->losers[node] = left;
+  return right;
+}
+
+// consumes the row of the winner and replays its path to the root
+static RC
+advanceMerge (SortState *st)
+{
+  int winner = st->losers[0], node, swap;
+  RunReader *reader = st->readers + winner;
+  RC rc;
+
+  reader->pos += st->rowSize;
+  reader->rowsLeft--;
+  if ((rc = fillReader(st, reader)) != RC_OK)
+    return rc;
+  for(node = (winner + st->numReaders) / 2; node >= 1; node /= 2)
+    if (readerWins(st, st->losers[node], winner))
+      {
+	swap = st->losers[node];
+	st->losers[node] = winner;
+	winner = swap;
+      }
+  st->losers[0] = winner;
+  return RC_OK;
+}
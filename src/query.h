@@ -0,0 +1,97 @@
+#ifndef QUERY_H
+#define QUERY_H
+
+#include <stdint.h>
+
+#include "dberror.h"
+#include "expr.h"
+#include "record_mgr.h"
+#include "tables.h"
+
+// query operators layered on the scans of the record manager: aggregation,
+// joins and sorting
+
+// aggregate functions
+typedef enum AggrType {
+  AGGR_COUNT, // number of tuples, attrNum is ignored
+  AGGR_SUM,
+  AGGR_MIN,
+  AGGR_MAX,
+  AGGR_AVG
+} AggrType;
+
+typedef struct AggrSpec {
+  AggrType type;
+  int attrNum; // int or float attribute to aggregate
+} AggrSpec;
+
+// value of an aggregate: COUNT and the SUM, MIN and MAX of int attributes
+// are 64 bit integers (DT_INT), AVG and the SUM, MIN and MAX of float
+// attributes are doubles (DT_FLOAT)
+typedef union AggrValue {
+  int64_t intV;
+  double floatV;
+} AggrValue;
+
+// groups computed by aggregate, in no particular order
+typedef struct AggrResult {
+  int numGroups;
+  int numAggrs;
+  DataType *types; // result type of every aggregate
+  AggrValue *values; // numAggrs values per group, see AGGR_VALUE
+  int numGroupAttrs;
+  DataType *keyTypes; // type, length and offset within a key of every group attribute
+  int *keyLengths;
+  int *keyOffsets;
+  int keySize;
+  char *keys; // group attributes of every group, keySize bytes each
+} AggrResult;
+
+#define AGGR_VALUE(_result,_group,_aggr)				\
+  ((_result)->values[((_group) * (_result)->numAggrs) + (_aggr)])
+
+// called by the joins for every pair of joining tuples, a tuple of the left
+// and one of the right table; both records are views valid until the
+// callback returns. Any result but RC_OK stops the join.
+typedef RC (*RM_JoinCallback) (void *context, Record *left, Record *right);
+
+// sorted output of a scan, see startSort
+typedef struct RM_SortHandle
+{
+  RM_TableData *rel;
+  void *mgmtData;
+} RM_SortHandle;
+
+// work done by a sort
+typedef struct RM_SortStats
+{
+  long numTuples;
+  int numRuns; // sorted runs written to disk, 0 if the tuples fit into memory
+  int numMergePasses; // merges reading all tuples, including the final one
+  long bytesWritten; // spill volume: pages of runs written
+  long bytesRead;
+} RM_SortStats;
+
+// aggregation, optionally grouped by some attributes (GROUP BY)
+extern RC aggregate (RM_TableData *rel, Expr *cond, int numGroupAttrs, int *groupAttrs,
+		     int numAggrs, AggrSpec *aggrs, int expectedGroups, int numWorkers,
+		     AggrResult **result);
+extern RC getGroupAttr (AggrResult *result, int group, int groupAttr, Value **value);
+extern RC freeAggrResult (AggrResult *result);
+
+// equi joins: attribute leftAttrs[i] of the left table equals rightAttrs[i]
+// of the right table, the attributes have to be of the same type and length
+extern RC hashJoin (RM_TableData *left, RM_TableData *right, int numAttrs, int *leftAttrs,
+		    int *rightAttrs, long memoryBudget, RM_JoinCallback callback, void *context);
+extern RC sortMergeJoin (RM_TableData *left, RM_TableData *right, int numAttrs, int *leftAttrs,
+			 int *rightAttrs, RM_JoinCallback callback, void *context);
+
+// external merge sort of the tuples returned by a scan on some attributes,
+// and the first tuples in that order (top-N)
+extern RC startSort (RM_ScanHandle *scan, int numAttrs, int *attrs, long memoryBudget, RM_SortHandle *sort);
+extern RC startTopN (RM_ScanHandle *scan, int numAttrs, int *attrs, int limit, RM_SortHandle *sort);
+extern RC nextSorted (RM_SortHandle *sort, Record *record);
+extern RC getSortStats (RM_SortHandle *sort, RM_SortStats *stats);
+extern RC closeSort (RM_SortHandle *sort);
+
+#endif // QUERY_H
@@ -10,10 +10,24 @@
 	#include "rm_serializer.c"
 	#include "buffer_mgr.h"
 	#include "storage_mgr.h"
+	#include "latency.h"
 	#include "string.h"
 	#include "assert.h"
+	#include <pthread.h>
+	#include <unistd.h>
 
 	#define REC_SZ (PAGE_SIZE - (sizeof(char) + (2*sizeof(int)) + '\0'))
+	#define RM_MORSEL_PAGES 16 // Pages a parallel scan worker takes at a time.
+	#define PAX_ALIGN(x) (((x)+7) & ~7) // PAX minipages start 8 byte aligned.
+	// TOMBSTONE of a slot, slots points to the slot area of a data page
+	#define TOMBSTONE(td, slots, slot) ((slots) + ((slot)*(td)->tombStride))
+	#define RM_MOVED -2 // TOMBSTONE of a slot reserved for a tuple compactTable moved away, see appendPage.
+	#define SLOT_FREE(tomb) ((tomb) == 0 || (tomb) == -1) // Unused or deleted.
+	#define RM_COMPRESSED_SLOTS 2048 // Tuples a compressed page holds at most.
+	#define RM_DICT_MAX 256 // Distinct values of a page dictionary.
+	#define RM_DICT_BUCKETS 512 // Hash table of a page dictionary while compressing.
+	#define RM_BLOOM_BITS_PER_KEY 10 // Bloom filter bits per slot of a page, about 1% false positives.
+	#define RM_BLOOM_HASHES 4 // Bits set per value.
 
 	typedef struct Frame
 	{
@@ -24,6 +38,7 @@
 		BM_PageHandle page;
 		int seq;
 		int refBit;
+		struct BM_MgmtData* owner;
 	} Frame;
 
 	typedef struct BM_MgmtData
@@ -32,12 +47,17 @@
 		bool *dirtyFlags;
 		int *fixCounts;
 		int *refBits;
-		int numReadIO;
-		int numWriteIO;
-		Frame* clkPtr;
-		Frame* head;
-		Frame* tail;
+		BM_PoolCounters counters;
+		struct BM_Frames* frames;
+		int numBuffered;
+		int quota;
 		SM_FileHandle fHandle;
+		Frame** pageTable;
+		int pageTableSize;
+		BM_WritePolicy writePolicy;
+		int readAhead;
+		PageNumber lastRead;
+		int statsSize;
 	}BM_MgmtData;
 
 	typedef struct RM_ScanTuple
@@ -47,36 +67,386 @@
 		char data; // Data within this tuple
 	}RM_ScanTuple;
 
+	// Values of an attribute on a compressed page, followed by the data of the encoding
+	typedef struct RM_EncodedColumn
+	{
+		int encoding; //RM_Encoding.
+		int bits; //FOR and DICT: bits per value.
+		int base; //FOR: minimum value.
+		int numEntries; //DICT: values in the dictionary, RLE: runs.
+		int offset; //Data within the page.
+	} RM_EncodedColumn;
+
+	// Run of equal bool values
+	typedef struct RM_Run
+	{
+		int length;
+		bool value;
+	} RM_Run;
+
+	// Min and max of an attribute on a page as order preserving keys, see zoneKey
+	typedef struct RM_Zone
+	{
+		uint64_t min; //UINT64_MAX and 0 while no tuple was on the page.
+		uint64_t max;
+	} RM_Zone;
+
+	// Where compactTable moved a tuple, from is first for bsearch on a RID
+	typedef struct RM_RidMap
+	{
+		RID from;
+		RID to;
+	} RM_RidMap;
+
+	// Bloom filters on an attribute, one per data page
+	typedef struct RM_BloomFilter
+	{
+		int attrNum;
+		int words; //64 bit words of the filter of a page.
+		int cap; //Pages the filters have room for.
+		uint64_t *bits; //words per page, indexed by page number.
+		int *stale; //Tuples deleted or overwritten per page since its filter was built.
+		struct RM_BloomFilter *next;
+	} RM_BloomFilter;
+
+	// Decodes compressed pages into PAX pages, caching the last one
+	typedef struct RM_PageDecoder
+	{
+		char *buf; //NULL for uncompressed tables.
+		int page;
+		int numSlots;
+	} RM_PageDecoder;
+
 	// Stores Management Information of a Table
 	typedef struct RM_MgmtData_Table
 	{
 		int recCnt; //Total count of records in the Table.
 		int initFreePg; //Initial (First) Free Page.
+		int slotSize; //Size of a slot: TOMBSTONE and Record.
+		int slotsPerPage; //Total Number of Slots on a page.
+		RM_PageLayout layout; //Row or PAX layout of the data pages.
+		int tombStride; //Bytes between the TOMBSTONES of two slots.
+		int *columnOffsets; //PAX: offset of the minipage of every attribute.
+		int compressed; //Data pages are compressed and decoded into PAX pages, table is read only.
+		int decodedSize; //Size of a decoded page.
+		RM_PageDecoder decoder; //Last page decoded while rebuilding zone maps and bloom filters.
+		RM_Zone *zones; //Zone map: numAttr zones per page, indexed by page number.
+		int *zoneLive; //Live tuples per page.
+		int zoneCap; //Pages the zone map has room for.
+		RM_BloomFilter *blooms; //Bloom filters on chosen attributes, see createBloomFilter.
+		RM_RidMap *remap; //Tuples moved by compactTable, sorted by old RID.
+		int numRemap;
 		BM_BufferPool bm;
+		RM_TableOptions options; //Buffer Pool options the table was opened with.
+		bool ownPool; //Buffer Pool with frames of its own instead of the shared ones, see openTableWithOptions.
 		BM_PageHandle h;
 	} RM_MgmtData_Table;
 
 	typedef struct RM_MgmtData_Scan
 	{
 		RID rid; //Record being Scanned.
-		int recScanCnt; //Count of Records scanned by far.
 		Expr *cond; //Conditional Expression to be evaluated.
+		ExprProgram *prog; //Compiled cond, NULL if cond is interpreted.
+		RID batchRid; //Next slot to be read by nextBatch.
+		int limit; //Maximum number of matching tuples to return, -1 for all.
+		int numReturned; //Matching tuples returned by far.
 		RM_ScanTuple *dataPtr; //Pointer to scan individual tuples.
+		char *viewData; //PAX: tuple returned by nextView, gathered from the minipages.
+		char *slots; //Slots of the page being scanned.
+		int pageSlots; //Slots on that page.
+		RM_PageDecoder decoder;
+		RM_ScanStats stats; //Pages read and skipped by next and nextBatch.
 		BM_PageHandle h;
 	} RM_MgmtData_Scan;
 
-	static int findFreeSlot(RM_ScanTuple *dataPtr, Schema *schema);
+	// Statistics of the values of an attribute on the page being compressed
+	typedef struct RM_ColumnStats
+	{
+		int min, max; //Int attributes.
+		int numDistinct; //String attributes, RM_DICT_MAX+1 once the dictionary overflows.
+		int numRuns; //Bool attributes.
+	} RM_ColumnStats;
+
+	// Fills compressed pages with tuples, see compressTable
+	typedef struct RM_PageBuilder
+	{
+		RM_MgmtData_Table *td;
+		Schema *schema;
+		int numTuples;
+		char *tuples; //Tuples of the page, recordSize bytes each.
+		RM_ColumnStats *stats;
+		RM_ColumnStats *next; //Stats including the tuple being added.
+		char **dicts; //Distinct values of every string attribute.
+		int **buckets; //Index into dicts + 1 of every string attribute, 0 if free.
+		SM_FileHandle *fh;
+		int numPages;
+		RM_CompressionStats *cs;
+		char page[PAGE_SIZE];
+	} RM_PageBuilder;
+
+	// Database wide state, set up by initRecordManager
+	typedef struct RM_Catalog
+	{
+		bool init; //TRUE between initRecordManager and shutdownRecordManager.
+		BM_SharedPool pool; //Frames shared by the Buffer Pools of all open tables.
+		int tableQuota; //Quota of the Buffer Pool of a table opened, 0 for no limit.
+		RM_MgmtData_Table **tables; //Open tables.
+		int numTables;
+		int capTables;
+	} RM_Catalog;
+
+	static RM_Catalog catalog;
+	static pthread_mutex_t catalogLock= PTHREAD_MUTEX_INITIALIZER; //Protects catalog.
+
+	// State shared by the workers of a parallelScan
+	typedef struct RM_ParallelScan
+	{
+		RM_TableData *rel;
+		Expr *cond;
+		RM_ScanCallback callback; //Called per tuple, or
+		RM_ColumnCallback columnCallback; //called per page by parallelScanColumns.
+		void *context;
+		int numPages; //Pages of the table when the scan started.
+		int nextPage; //First page of the next morsel, taken atomically by the workers.
+		int stop; //Set once a callback fails, so the other workers stop taking morsels.
+		RC rc; //First error returned by a callback.
+		pthread_mutex_t lock; //Protects rc.
+	} RM_ParallelScan;
+
+	typedef struct RM_ScanWorker
+	{
+		RM_ParallelScan *ps;
+		int id;
+		pthread_t thread;
+	} RM_ScanWorker;
+
+	static int findFreeSlot(RM_ScanTuple *dataPtr, RM_MgmtData_Table *td);
+	static RC scanNext(RM_ScanHandle *scan, Record *record, bool copy);
+	static void initSchemaLayout(Schema *schema);
+	static void *scanWorker(void *arg);
+	static RC addFreePage(RM_MgmtData_Table *td, RM_ScanTuple *dataPtr, int page);
+	static RC removeFreePage(RM_MgmtData_Table *td, RM_ScanTuple *dataPtr, int page);
+	static int initPaxLayout(RM_MgmtData_Table *td, Schema *schema);
+	static void readSlot(RM_MgmtData_Table *td, Schema *schema, char *slots, int slot, char *data);
+	static void writeSlot(RM_MgmtData_Table *td, Schema *schema, char *slots, int slot, char *data);
+	static RC runParallelScan(RM_ParallelScan *ps, int numWorkers);
+	static void initSlotLayout(RM_MgmtData_Table *td, Schema *schema);
+	static void initDecoder(RM_MgmtData_Table *td, RM_PageDecoder *dec);
+	static char *pageSlots(RM_MgmtData_Table *td, Schema *schema, RM_PageDecoder *dec, RM_ScanTuple *dataPtr, int page, int *numSlots);
+	static int decodePage(RM_MgmtData_Table *td, Schema *schema, char *in, char *out);
+	static void initBuilder(RM_PageBuilder *b, RM_MgmtData_Table *td, Schema *schema, SM_FileHandle *fh, RM_CompressionStats *cs);
+	static void freeBuilder(RM_PageBuilder *b);
+	static RC builderAdd(RM_PageBuilder *b, char *tuple);
+	static RC builderFlush(RM_PageBuilder *b);
+	static int builderSize(RM_PageBuilder *b, RM_ColumnStats *stats, int numTuples);
+	static int columnBytes(Schema *schema, int attr, RM_ColumnStats *stats, int numTuples, int *encoding, int *bits);
+	static int dictFind(RM_PageBuilder *b, int attr, char *value, bool insert);
+	static bool scanToPage(RM_ScanHandle *scan, int page);
+	static uint64_t zoneKey(DataType dt, int len, char *value);
+	static void ensureZones(RM_MgmtData_Table *td, int numAttr, int page);
+	static void zoneAdd(RM_MgmtData_Table *td, Schema *schema, int page, char *data, bool newTuple);
+	static bool pageMayMatch(RM_MgmtData_Table *td, Schema *schema, Expr *cond, int page, bool useBloom);
+	static bool skipPage(RM_MgmtData_Table *td, Schema *schema, Expr *cond, int page, RM_ScanStats *stats);
+	static uint64_t bloomHash(DataType dt, int len, char *value);
+	static void bloomAdd(RM_MgmtData_Table *td, Schema *schema, int page, char *data, bool newTuple);
+	static void bloomDelete(RM_MgmtData_Table *td, int page);
+	static void buildBloomPage(RM_MgmtData_Table *td, Schema *schema, RM_BloomFilter *bf, int page, char *slots, int numSlots);
+	static void refreshBlooms(RM_MgmtData_Table *td, Schema *schema, int page, char *slots, int numSlots);
+	static void buildBlooms(RM_MgmtData_Table *td, Schema *schema, RM_BloomFilter *bf);
+	static uint64_t constHash(Value *v, int len);
+	static bool bloomMayContain(RM_BloomFilter *bf, int page, uint64_t hash);
+	static void rebuildZones(RM_MgmtData_Table *td, Schema *schema);
+	static RC loadZones(RM_MgmtData_Table *td, RM_TableData *rel);
+	static RC saveZones(RM_MgmtData_Table *td, RM_TableData *rel);
+	static char *sideFile(char *name, char *suffix);
+	static RC resolveRid(RM_MgmtData_Table *td, RID *rid);
+	static RC appendPage(RM_MgmtData_Table *td, int *page);
+	static RC loadRemap(RM_MgmtData_Table *td, RM_TableData *rel);
+	static RC saveRemap(RM_MgmtData_Table *td, RM_TableData *rel);
+	static RC openPool(RM_MgmtData_Table *td, char *name, RM_TableOptions *options);
+	static void unregisterTable(RM_MgmtData_Table *td);
 
 	//########## TABLE AND MANAGER ##########
 
+	/*
+	 * function initRecordManager:
+	 *
+	 * Creates the buffer pool shared by all tables opened until the record
+	 * manager is shut down. mgmtData is an RM_Config, NULL for the defaults.
+	 */
 	RC initRecordManager (void *mgmtData)
 	{
+		RM_Config *config= (RM_Config*) mgmtData;
+		RC rc;
+
 		initStorageManager();
-		return RC_OK;
+		if (catalog.init && (rc= shutdownRecordManager()) != RC_OK)
+			return rc;
+
+		pthread_mutex_lock(&catalogLock);
+		catalog.tableQuota= (config != NULL && config->tableQuota > 0) ? config->tableQuota : 0;
+		catalog.tables= NULL;
+		catalog.numTables= 0;
+		catalog.capTables= 0;
+		rc= initSharedPool(&catalog.pool, (config != NULL && config->poolFrames > 0) ? config->poolFrames : RM_DEFAULT_POOL_FRAMES,
+				(config != NULL) ? config->strategy : RS_FIFO);
+		catalog.init= (rc == RC_OK);
+		pthread_mutex_unlock(&catalogLock);
+		return rc;
 	}
 
+	/*
+	 * function shutdownRecordManager:
+	 *
+	 * Frees the shared buffer pool, all tables have to be closed.
+	 */
 	RC shutdownRecordManager ()
 	{
+		RC rc= RC_OK;
+
+		pthread_mutex_lock(&catalogLock);
+		if (catalog.init && catalog.numTables > 0)
+			rc= RC_BM_POOL_IN_USE;
+		else if (catalog.init)
+		{
+			rc= shutdownSharedPool(&catalog.pool);
+			free(catalog.tables);
+			catalog.tables= NULL;
+			catalog.init= FALSE;
+		}
+		pthread_mutex_unlock(&catalogLock);
+		return rc;
+	}
+
+	/*
+	 * function openPool:
+	 *
+	 * Sets up the Buffer Pool of a table in the frames shared by all tables,
+	 * or in frames of its own if the options ask for them or while the
+	 * record manager is not initialized (1000 FIFO frames).
+	 */
+	RC openPool(RM_MgmtData_Table *td, char *name, RM_TableOptions *options)
+	{
+		RC rc;
+
+		pthread_mutex_lock(&catalogLock);
+		td->ownPool= (options != NULL && options->poolFrames > 0) || !catalog.init;
+		if (options != NULL && options->poolFrames > 0)
+			rc= initBufferPool(&td->bm, name, options->poolFrames, options->strategy, NULL);
+		else if (catalog.init)
+			rc= initBufferPoolShared(&td->bm, name, &catalog.pool, catalog.tableQuota);
+		else
+			rc= initBufferPool(&td->bm, name, 1000, RS_FIFO, NULL);
+		pthread_mutex_unlock(&catalogLock);
+
+		if (rc == RC_OK && options != NULL)
+		{
+			setReadAhead(&td->bm, options->readAhead);
+			setWritePolicy(&td->bm, options->writePolicy);
+		}
+		return rc;
+	}
+
+	/*
+	 * function unregisterTable:
+	 *
+	 * Removes a table from the catalog of open tables.
+	 */
+	void unregisterTable(RM_MgmtData_Table *td)
+	{
+		int i;
+
+		pthread_mutex_lock(&catalogLock);
+		for (i=0; i<catalog.numTables; i++)
+			if (catalog.tables[i] == td)
+			{
+				catalog.tables[i]= catalog.tables[--catalog.numTables];
+				break;
+			}
+		pthread_mutex_unlock(&catalogLock);
+	}
+
+	/*
+	 * function resizeTablePool:
+	 *
+	 * Grows or shrinks the buffer pool of a table opened with frames of its
+	 * own while the table stays open, keeping the cached pages that fit.
+	 */
+	RC resizeTablePool (RM_TableData *rel, int numFrames)
+	{
+		RM_MgmtData_Table *td= (RM_MgmtData_Table*) rel->mgmtData;
+
+		if (!td->ownPool)
+			return RC_BM_POOL_IN_USE; // See setTableQuota
+		if (numFrames < RM_MIN_POOL_FRAMES)
+			return RC_RM_POOL_TOO_SMALL;
+		return resizeBufferPool(&td->bm, numFrames);
+	}
+
+	/*
+	 * function resizeCatalogPool:
+	 *
+	 * Grows or shrinks the buffer pool shared by all tables while they stay
+	 * open; frames holding pinned pages are dropped once they are unpinned.
+	 * Together with setTableQuota this moves memory between tables. Like an
+	 * own pool it keeps at least RM_MIN_POOL_FRAMES frames.
+	 */
+	RC resizeCatalogPool (int numFrames)
+	{
+		RC rc;
+
+		if (numFrames < RM_MIN_POOL_FRAMES)
+			return RC_RM_POOL_TOO_SMALL;
+		pthread_mutex_lock(&catalogLock);
+		rc= catalog.init ? resizeSharedPool(&catalog.pool, numFrames) : RC_BM_NULL_BUFFER;
+		pthread_mutex_unlock(&catalogLock);
+		return rc;
+	}
+
+	/*
+	 * function setTableQuota:
+	 *
+	 * Limits the frames of the shared buffer pool holding pages of a table,
+	 * 0 for no limit.
+	 */
+	RC setTableQuota (RM_TableData *rel, int numFrames)
+	{
+		return setPoolQuota(&((RM_MgmtData_Table*) rel->mgmtData)->bm, numFrames);
+	}
+
+	/*
+	 * function getCatalogStats:
+	 *
+	 * Buffer pool memory and page accesses of all open tables.
+	 */
+	RC getCatalogStats (RM_CatalogStats *stats)
+	{
+		BM_PoolCounters counters;
+		int i;
+
+		pthread_mutex_lock(&catalogLock);
+		stats->numTables= catalog.numTables;
+		stats->poolFrames= catalog.init ? catalog.pool.numPages : 0;
+		stats->poolBytes= (long) stats->poolFrames * PAGE_SIZE;
+		stats->numHits= 0;
+		stats->numReadIO= 0;
+		stats->numWriteIO= 0;
+		stats->numEvictions= 0;
+		stats->numDirtyWrites= 0;
+		stats->numPinWaits= 0;
+		for (i=0; i<catalog.numTables; i++)
+		{
+			if (catalog.tables[i]->ownPool)
+				stats->poolBytes += (long) catalog.tables[i]->bm.numPages * PAGE_SIZE;
+			getPoolCounters(&catalog.tables[i]->bm, &counters);
+			stats->numHits += counters.numHits;
+			stats->numReadIO += counters.numReadIO;
+			stats->numWriteIO += counters.numWriteIO;
+			stats->numEvictions += counters.numEvictions;
+			stats->numDirtyWrites += counters.numDirtyWrites;
+			stats->numPinWaits += counters.numPinWaits;
+		}
+		pthread_mutex_unlock(&catalogLock);
 		return RC_OK;
 	}
 
@@ -88,14 +458,7 @@
 	 */
 	int getRecordSize (Schema *schema)
 	{
-		int recSz = 0;
-		int i=0;
-		while(i<schema->numAttr)
-		{
-			recSz = recSz+schema->typeLength[i];
-			i++;
-		}
-		return (recSz);
+		return schema->recordSize;
 	}
 
 
@@ -147,9 +510,31 @@
 			}
 			i++;
 		}
+		initSchemaLayout(sch);
 		return sch;
 	}
 
+	/*
+	 * function initSchemaLayout:
+	 * Precomputes the offset of each attribute within the record data and
+	 * the record size, so records and attributes can be accessed without
+	 * walking the schema.
+	 */
+	void initSchemaLayout(Schema *schema)
+	{
+		int i=0;
+		int ofst=0;
+
+		schema->attrOffsets= (int*) malloc(sizeof(int)*schema->numAttr);
+		while(i<schema->numAttr)
+		{
+			schema->attrOffsets[i]= ofst;
+			ofst = ofst+schema->typeLength[i];
+			i++;
+		}
+		schema->recordSize= ofst;
+	}
+
 	RC freeSchema(Schema *schema)
 	{
 		int i=0;
@@ -162,6 +547,7 @@
 		free(schema->dataTypes);
 		free(schema->typeLength);
 		free(schema->keyAttrs);
+		free(schema->attrOffsets);
 		free(schema);
 		return RC_OK;
 	}
@@ -175,6 +561,19 @@
 	 */
 
 	RC createTable (char *name, Schema *schema)
+	{
+		return createTableWithLayout(name, schema, RM_LAYOUT_ROW);
+	}
+
+	/*
+	 * Function createTableWithLayout:
+	 *
+	 * Creates a Table whose data pages use the given layout, stored after the schema.
+	 * RM_LAYOUT_PAX keeps the values of every attribute in a minipage of its own,
+	 * so scans reading a few attributes touch only their minipages.
+	 */
+
+	RC createTableWithLayout (char *name, Schema *schema, RM_PageLayout layout)
 	{
 		SM_FileHandle fh;
 		char data[PAGE_SIZE];
@@ -182,7 +581,7 @@
 		int recLen,i;
 
 		// Schema Size cannot exceed 1 Page
-		recLen= (4 * sizeof(int)); // recCnt, initFreePg, numAttrs, keySize
+		recLen= (6 * sizeof(int)); // recCnt, initFreePg, numAttrs, keySize, layout, compressed
 		recLen = recLen + (76 * schema->numAttr); // Name(64) + type(4) + len(4) + keyAttr(4)
 		if (recLen > PAGE_SIZE)
 			return RC_RM_LARGE_SCHEMA;
@@ -224,6 +623,9 @@
 			ofst = ofst + 4;
 			i++;
 		}
+		*(int*)ofst= (int) layout;
+		ofst = ofst + sizeof(int);
+		*(int*)ofst= 0; // Not compressed
 
 		// Create a Page File with single page Table data.
 		createPageFile(name);
@@ -240,20 +642,74 @@
 	 */
 
 	RC openTable (RM_TableData *rel, char *name)
+	{
+		return openTableWithOptions(rel, name, NULL);
+	}
+
+	/*
+	 * Function openTableWithOptions:
+	 *
+	 * Opens the Table with the buffer pool set up by options, NULL for the
+	 * defaults of openTable (see RM_TableOptions). A pool of the table's own
+	 * needs RM_MIN_POOL_FRAMES frames. If the pool cannot be set up or the
+	 * first page read, nothing stays allocated or registered.
+	 */
+
+	RC openTableWithOptions (RM_TableData *rel, char *name, RM_TableOptions *options)
 	{
 		char *ofst;
 		RM_MgmtData_Table *td;
 		int numAttrs, keySize, i;
+		RC rc;
+
+		if (options != NULL && options->poolFrames > 0 && options->poolFrames < RM_MIN_POOL_FRAMES)
+			return RC_RM_POOL_TOO_SMALL;
 
 		// Allocate RM_TableData
 		td= (RM_MgmtData_Table*) malloc( sizeof(RM_MgmtData_Table) );
 		rel->mgmtData= td;
 		rel->name= strdup(name);
 
-		// Initialize BufferPool
-		initBufferPool(&td->bm, rel->name, 1000, RS_FIFO, NULL);
+		// Initialize BufferPool and register the table in the catalog
+		if (options != NULL)
+			td->options= *options;
+		else
+		{
+			td->options.poolFrames= 0;
+			td->options.strategy= RS_FIFO;
+			td->options.readAhead= 0;
+			td->options.writePolicy= BM_WRITE_THROUGH;
+		}
+		if ((rc= openPool(td, rel->name, &td->options)) != RC_OK)
+		{
+			free(rel->name);
+			free(td);
+			rel->name= NULL;
+			rel->mgmtData= NULL;
+			return rc;
+		}
+		pthread_mutex_lock(&catalogLock);
+		if (catalog.init)
+		{
+			if (catalog.numTables == catalog.capTables)
+			{
+				catalog.capTables= (catalog.capTables == 0) ? 16 : 2*catalog.capTables;
+				catalog.tables= (RM_MgmtData_Table**) realloc(catalog.tables, sizeof(RM_MgmtData_Table*)*catalog.capTables);
+			}
+			catalog.tables[catalog.numTables++]= td;
+		}
+		pthread_mutex_unlock(&catalogLock);
 		// Read page and prepare schema
-		pinPage(&td->bm, &td->h, (PageNumber)0);
+		if ((rc= pinPage(&td->bm, &td->h, (PageNumber)0)) != RC_OK)
+		{
+			shutdownBufferPool(&td->bm);
+			unregisterTable(td);
+			free(rel->name);
+			free(td);
+			rel->name= NULL;
+			rel->mgmtData= NULL;
+			return rc;
+		}
 
 		ofst= (char*) td->h.data;
 		td->recCnt= *(int*)ofst;
@@ -301,6 +757,26 @@
 			ofst = ofst + 4;
 			i++;
 		}
+		td->layout= (RM_PageLayout) *(int*)ofst;
+		ofst = ofst + sizeof(int);
+		td->compressed= *(int*)ofst;
+		initSchemaLayout(rel->schema);
+
+		// Slot layout of the data pages
+		td->columnOffsets= NULL;
+		initSlotLayout(td, rel->schema);
+		initDecoder(td, &td->decoder);
+
+		// Zone map, rebuilt if the side file is missing or stale
+		td->zones= NULL;
+		td->zoneLive= NULL;
+		td->zoneCap= 0;
+		td->blooms= NULL;
+		td->remap= NULL;
+		td->numRemap= 0;
+		loadRemap(td, rel);
+		if (loadZones(td, rel) != RC_OK)
+			rebuildZones(td, rel->schema);
 
 		unpinPage(&td->bm, &td->h); // UnPin Page
 		return RC_OK;
@@ -327,18 +803,26 @@
 
 		markDirty(&td->bm, &td->h);
 		*(int*)ofst= td->recCnt;
+		ofst = ofst + sizeof(int);
+		*(int*)ofst= td->initFreePg;
 		unpinPage(&td->bm, &td->h);
+		saveZones(td, rel);
+		saveRemap(td, rel);
 
-		// Shutdown Buffer Pool
+		// Shutdown Buffer Pool and remove the table from the catalog
 		shutdownBufferPool(&td->bm);
+		unregisterTable(td);
+		free(td->columnOffsets);
+		free(td->decoder.buf);
+		free(td->zones);
+		free(td->zoneLive);
+		while (td->blooms != NULL)
+			dropBloomFilter(rel, td->blooms->attrNum);
+		free(td->remap);
 
 		// Free Schema Memory
 		free(rel->name);
-		free(rel->schema->attrNames);
-		free(rel->schema->dataTypes);
-		free(rel->schema->typeLength);
-		free(rel->schema->keyAttrs);
-		free(rel->schema);
+		freeSchema(rel->schema);
 		rel->schema= NULL;
 		free(rel->mgmtData);
 		rel->mgmtData= NULL;
@@ -350,7 +834,14 @@
 	 */
 	RC deleteTable (char *name)
 	{
+		char *file= sideFile(name, ".zm");
+
 		destroyPageFile(name);
+		destroyPageFile(file); // Zone map, if any
+		free(file);
+		file= sideFile(name, ".rid");
+		destroyPageFile(file); // Moved tuples, if any
+		free(file);
 		return RC_OK;
 	}
 
@@ -366,6 +857,117 @@
 		return recCnt;
 	}
 
+	/*
+	 * function compressTable():
+	 *
+	 * Rewrites the live tuples of a cold table into compressed pages, packing
+	 * as many tuples as fit (up to RM_COMPRESSED_SLOTS). Every attribute of a
+	 * page gets the smallest of: plain values, frame of reference (ints:
+	 * offsets from the page minimum, bit-packed), a page dictionary (strings:
+	 * up to RM_DICT_MAX distinct values, codes bit-packed) or runs (bools).
+	 * Scans and getRecord decode a page at a time into a PAX page, so the
+	 * batch kernels run on the decoded minipages. The table becomes read
+	 * only: writes return RC_RM_READ_ONLY. Tuples get new RIDs.
+	 */
+
+	RC compressTable (RM_TableData *rel, RM_CompressionStats *stats)
+	{
+		RM_MgmtData_Table *td= rel->mgmtData;
+		BM_MgmtData *bm= td->bm.mgmtData;
+		Schema *schema= rel->schema;
+		RM_PageBuilder b;
+		RM_BloomFilter *bf;
+		SM_FileHandle fh;
+		BM_PageHandle h;
+		char *tmpName, *tuple, *slots, *ofst;
+		int page, slot;
+		RC rc= RC_OK;
+
+		memset(stats, 0, sizeof(RM_CompressionStats));
+		stats->pagesBefore= bm->fHandle.totalNumPages-1;
+		stats->pagesAfter= stats->pagesBefore;
+		if (td->compressed)
+			return RC_OK;
+		// A single tuple has to fit, stored plain
+		if (sizeof(int) + (schema->numAttr*sizeof(RM_EncodedColumn)) + schema->recordSize > REC_SZ)
+			return RC_RM_LARGE_RECORD;
+
+		// Write the compressed table to a new file
+		tmpName= (char*) malloc(strlen(rel->name)+5);
+		sprintf(tmpName, "%s.tmp", rel->name);
+		if (createPageFile(tmpName) != RC_OK || openPageFile(tmpName, &fh) != RC_OK)
+		{
+			free(tmpName);
+			return RC_WRITE_FAILED;
+		}
+		initBuilder(&b, td, schema, &fh, stats);
+		tuple= (char*) malloc(schema->recordSize);
+
+		for (page=1; rc == RC_OK && page<bm->fHandle.totalNumPages; page++)
+		{
+			pinPage(&td->bm, &h, (PageNumber)page);
+			slots= (char*) &((RM_ScanTuple*) h.data)->data;
+			for (slot=0; rc == RC_OK && slot<td->slotsPerPage; slot++)
+			{
+				if (*TOMBSTONE(td, slots, slot) > 0)
+				{
+					readSlot(td, schema, slots, slot, tuple);
+					rc= builderAdd(&b, tuple);
+				}
+			}
+			unpinPage(&td->bm, &h);
+		}
+		if (rc == RC_OK)
+			rc= builderFlush(&b);
+
+		// Header page: no free pages, compressed data pages
+		if (rc == RC_OK)
+		{
+			pinPage(&td->bm, &td->h, (PageNumber)0);
+			memcpy(b.page, td->h.data, PAGE_SIZE);
+			unpinPage(&td->bm, &td->h);
+			ofst= b.page;
+			*(int*)ofst= td->recCnt;
+			ofst = ofst + sizeof(int);
+			*(int*)ofst= 0;
+			ofst = b.page + (5*sizeof(int)) + (76*schema->numAttr); // after the layout
+			*(int*)ofst= 1;
+			rc= writeBlock(0, &fh, b.page);
+		}
+		stats->pagesAfter= b.numPages;
+		closePageFile(&fh);
+		freeBuilder(&b);
+		free(tuple);
+		if (rc != RC_OK)
+		{
+			destroyPageFile(tmpName);
+			free(tmpName);
+			stats->pagesAfter= stats->pagesBefore;
+			return rc;
+		}
+
+		// Replace the file of the table, dropping its cached pages
+		if (td->options.poolFrames > 0)
+			td->options.poolFrames= td->bm.numPages; // Keep the size of a resized pool
+		shutdownBufferPool(&td->bm);
+		rename(tmpName, rel->name);
+		free(tmpName);
+		if ((rc= openPool(td, rel->name, &td->options)) != RC_OK)
+			return rc;
+		td->initFreePg= 0;
+		td->compressed= 1;
+		free(td->decoder.buf);
+		initSlotLayout(td, schema);
+		initDecoder(td, &td->decoder);
+		rebuildZones(td, schema);
+		for (bf= td->blooms; bf != NULL; bf= bf->next)
+			buildBlooms(td, schema, bf);
+		free(td->remap); // Tuples get new RIDs anyway
+		td->remap= NULL;
+		td->numRemap= 0;
+		return RC_OK;
+	}
+
 
 	//########## HANDLING RECORDS IN TABLE ##########
 
@@ -380,144 +982,64 @@
 	RC insertRecord (RM_TableData *rel, Record *record)
 	{
 		RM_MgmtData_Table *td= rel->mgmtData;
-		BM_MgmtData *bm= td->bm.mgmtData;
 		RM_ScanTuple *dataPtr;
-		RM_ScanTuple *remFreePgLL;
-		RM_ScanTuple *remFreePgLL2;
-		RM_ScanTuple *addFreePgLL;
-		BM_PageHandle h;
-		BM_PageHandle h2;
 		RID *rid= &record->id;
-		char *slotNo;
-		int recordSize;
+
+		if (td->compressed)
+			return RC_RM_READ_ONLY;
+		LATENCY_START(start);
 
 		if (td->initFreePg == 0)
 		{
 			// add new page
-			if (appendEmptyBlock(&bm->fHandle) != RC_OK)
+			if (appendPage(td, &rid->page) != RC_OK) //Page Number Allocation
 				return RC_RM_INSERT_FAILED;
 
-			rid->page= bm->fHandle.totalNumPages-1; //Page Number Allocation
-
 			pinPage(&td->bm, &td->h, (PageNumber)rid->page);
 			dataPtr= (RM_ScanTuple*) td->h.data;
 
-			rid->slot= 0; //Slot assignment
+			rid->slot= findFreeSlot(dataPtr, td); //Slot assignment
 		}
 		else // Space available for Record in a pre-existing page
 		{
 			rid->page= td->initFreePg;
 			pinPage(&td->bm, &td->h, (PageNumber)rid->page);
 			dataPtr= (RM_ScanTuple*) td->h.data;
-			rid->slot= findFreeSlot(dataPtr, rel->schema);
+			rid->slot= findFreeSlot(dataPtr, td);
 			if (rid->slot==-1)
 			{
+				// Stale list entry, unlink the full page
+				markDirty(&td->bm, &td->h);
+				removeFreePage(td, dataPtr, rid->page);
 				unpinPage(&td->bm, &td->h);
 
 				// add new page
-				if (appendEmptyBlock(&bm->fHandle) != RC_OK)
+				if (appendPage(td, &rid->page) != RC_OK)
 					return RC_RM_INSERT_FAILED;
-				rid->page= bm->fHandle.totalNumPages-1;
 				pinPage(&td->bm, &td->h, (PageNumber)rid->page);
 				dataPtr= (RM_ScanTuple*) td->h.data;
-				rid->slot= 0;
+				rid->slot= findFreeSlot(dataPtr, td);
 			}
 		}
 
 		// Write record now
 		markDirty(&td->bm, &td->h);
-		slotNo = ((char*) &dataPtr->data) + (rid->slot*(getRecordSize(rel->schema)+1));
-		// Write Record to Slot
-		recordSize= getRecordSize(rel->schema);
-		memcpy(slotNo+1, record->data, recordSize); // +1 for TOMBSTONE
-		*(char*)slotNo=1; //Set TOMBSTONE Address
+		writeSlot(td, rel->schema, (char*) &dataPtr->data, rid->slot, record->data);
+		*TOMBSTONE(td, (char*) &dataPtr->data, rid->slot)=1; //Set TOMBSTONE Address
+		zoneAdd(td, rel->schema, rid->page, record->data, TRUE);
+		bloomAdd(td, rel->schema, rid->page, record->data, TRUE);
 
 		//Updating Free Page Linked List---------------------
 		// Search if there are any TOMBSTONES which are free.
-		if (findFreeSlot(dataPtr, rel->schema) != -1)
-		{
-			// First page to have free space
-			if (td->initFreePg == 0)
-			{
-				dataPtr->next=dataPtr->prev= rid->page;
-				td->initFreePg= rid->page;
-			}
-			else // Add this page to head of list
-			{
-				// Read head block and link this page
-				pinPage(&td->bm, &h, (PageNumber)td->initFreePg);
-				addFreePgLL= (RM_ScanTuple*) h.data;
-
-				markDirty(&td->bm, &h);
-				addFreePgLL->prev= rid->page;
-				unpinPage(&td->bm, &h);
-
-				dataPtr->next= td->initFreePg;
-				td->initFreePg= rid->page;
-				dataPtr->prev= 0;
-			}
-		}
+		if (findFreeSlot(dataPtr, td) != -1)
+			addFreePage(td, dataPtr, rid->page);
 		else // No free space
-		{
-			// Remove from head
-			if (rid->page == td->initFreePg)
-			{
-				// Single node in list
-				if (dataPtr->next == 0)
-				{
-					dataPtr->prev= 0;
-					td->initFreePg= 0;
-				}
-				else
-				{
-					// Read head block and link this page
-					pinPage(&td->bm, &h, (PageNumber)dataPtr->next);
-					remFreePgLL= (RM_ScanTuple*) h.data;
-					markDirty(&td->bm, &h);
-					remFreePgLL->prev= 0;
-					unpinPage(&td->bm, &h);
-
-					td->initFreePg= dataPtr->next;
-					dataPtr->next=dataPtr->prev= 0;
-				}
-			}
-
-			// Remove from tail
-			else if (dataPtr->next == 0)
-			{
-				// Read previous block and remove
-				pinPage(&td->bm, &h, (PageNumber)dataPtr->prev);
-				remFreePgLL= (RM_ScanTuple*) h.data;
-				markDirty(&td->bm, &h);
-				remFreePgLL->next= 0;
-				unpinPage(&td->bm, &h);
-
-				dataPtr->next=dataPtr->prev= 0;
-			}
-			else if (dataPtr->next != 0 && dataPtr->prev != 0)// Read from middle
-			{
-				// Read next block and previous block and reorganize linked list
-				pinPage(&td->bm, &h, (PageNumber)dataPtr->prev);
-				pinPage(&td->bm, &h2, (PageNumber)dataPtr->next);
-				remFreePgLL= (RM_ScanTuple*) h.data;
-				remFreePgLL2= (RM_ScanTuple*) h2.data;
-
-				markDirty(&td->bm, &h);
-				markDirty(&td->bm, &h2);
-
-				remFreePgLL->next= dataPtr->next;
-				remFreePgLL2->prev= dataPtr->prev;
-
-				unpinPage(&td->bm, &h);
-				unpinPage(&td->bm, &h2);
-
-				dataPtr->next=dataPtr->prev= 0;
-			}
-		}
+			removeFreePage(td, dataPtr, rid->page);
 		//---------------------------------------------------
 		unpinPage(&td->bm, &td->h);
 		td->recCnt++;
 
+		LATENCY_END(LAT_INSERT_RECORD, start);
 		return RC_OK;
 	}
 
@@ -532,39 +1054,31 @@
 		char *slotNo;
 		RM_MgmtData_Table *td= rel->mgmtData;
 		RM_ScanTuple *dataPtr;
-		RM_ScanTuple *addFreePgLL;
-		BM_PageHandle h;
 
 		if (id.page == -1 || id.slot == -1)
 			return RC_RM_DELETE_FAILED;
+		if (td->compressed)
+			return RC_RM_READ_ONLY;
+		if (resolveRid(td, &id) != RC_OK)
+			return RC_RM_DELETE_FAILED;
 
 		pinPage(&td->bm, &td->h, (PageNumber)id.page);
 		dataPtr= (RM_ScanTuple*) td->h.data;
-		slotNo = ((char*) &dataPtr->data) + (id.slot*(getRecordSize(rel->schema)+1));
+		slotNo = TOMBSTONE(td, (char*) &dataPtr->data, id.slot);
+		// a free or already deleted slot would throw off the live counts
+		if (*(char*)slotNo <= 0)
+		{
+			unpinPage(&td->bm, &td->h);
+			return RC_RM_DELETE_FAILED;
+		}
 		markDirty(&td->bm, &td->h);
 		*(char*)slotNo = -1; // Remove TOMBSTONE
+		if (id.page < td->zoneCap)
+			td->zoneLive[id.page]--;
+		bloomDelete(td, id.page);
 
 		// Mark free page links
-		// First page to have free space
-		if (td->initFreePg == 0)
-		{
-			dataPtr->next=dataPtr->prev= id.page;
-			td->initFreePg= id.page;
-		}
-		else // Add this page to head of list
-		{
-			// Read head block and link this page
-			pinPage(&td->bm, &h, td->initFreePg);
-			addFreePgLL= (RM_ScanTuple*) h.data;
-
-			markDirty(&td->bm, &h);
-			addFreePgLL->prev= id.page;
-			unpinPage(&td->bm, &h);
-
-			dataPtr->next= td->initFreePg;
-			td->initFreePg= id.page;
-			dataPtr->prev= 0;
-		}
+		addFreePage(td, dataPtr, id.page);
 
 		unpinPage(&td->bm, &td->h);
 
@@ -581,22 +1095,25 @@
 
 	RC updateRecord (RM_TableData *rel, Record *record)
 	{
-		RID *rid= &record->id;
+		RID id= record->id;
+		RID *rid= &id;
 		RM_MgmtData_Table *td= rel->mgmtData;
 		RM_ScanTuple *dataPtr;
-		char *slotNo;
-		int recordSize;
 
 		if (rid->page == -1 || rid->slot == -1)
 			return RC_RM_UPDATE_FAILED;
+		if (td->compressed)
+			return RC_RM_READ_ONLY;
+		if (resolveRid(td, rid) != RC_OK)
+			return RC_RM_UPDATE_FAILED;
 
 		pinPage(&td->bm, &td->h, (PageNumber)rid->page);
 		dataPtr= (RM_ScanTuple*) td->h.data;
-		slotNo = ((char*) &dataPtr->data) + (rid->slot*(getRecordSize(rel->schema)+1));
 		markDirty(&td->bm, &td->h);
 		// Write Record to Slot
-		recordSize= getRecordSize(rel->schema);
-		memcpy(slotNo+1, record->data, recordSize); // +1 for TOMBSTONE
+		writeSlot(td, rel->schema, (char*) &dataPtr->data, rid->slot, record->data);
+		zoneAdd(td, rel->schema, rid->page, record->data, FALSE);
+		bloomAdd(td, rel->schema, rid->page, record->data, FALSE);
 		unpinPage(&td->bm, &td->h);
 
 		return RC_OK;
@@ -606,104 +1123,440 @@
 	{
 		RM_MgmtData_Table *td= rel->mgmtData;
 		RM_ScanTuple *dataPtr;
-		char *slotNo;
-		int recordSize;
+		// Not td->h, so that threads can look up tuples of one table concurrently
+		BM_PageHandle h;
+		RM_PageDecoder decoder;
+		char *slots;
+		int numSlots;
 
 		if (id.page == -1 || id.slot == -1)
 			return RC_RM_UPDATE_FAILED;
+		record->id= id; // The RID of the caller, even if the tuple was moved
+		if (resolveRid(td, &id) != RC_OK)
+			return RC_RM_UPDATE_FAILED;
 
-		pinPage(&td->bm, &td->h, (PageNumber)id.page);
-		dataPtr= (RM_ScanTuple*) td->h.data;
-		slotNo = ((char*) &dataPtr->data) + (id.slot*(getRecordSize(rel->schema)+1));
+		initDecoder(td, &decoder);
+		pinPage(&td->bm, &h, (PageNumber)id.page);
+		dataPtr= (RM_ScanTuple*) h.data;
+		slots= pageSlots(td, rel->schema, &decoder, dataPtr, id.page, &numSlots);
 		//Read Record from Slot
-		recordSize= getRecordSize(rel->schema);
-		memcpy(record->data, slotNo+1, recordSize); // +1 for TOMBSTONE
-		unpinPage(&td->bm, &td->h);
-
-		record->id= id;
+		if (id.slot < numSlots)
+			readSlot(td, rel->schema, slots, id.slot, record->data);
+		unpinPage(&td->bm, &h);
+		free(decoder.buf);
+		if (id.slot >= numSlots)
+			return RC_RM_UPDATE_FAILED;
 
 		return RC_OK;
 	}
 
 
-	//########## SCANS ##########
+	//########## BATCHED RECORD HANDLING ##########
 
 	/*
-	 * function startScan
+	 * Structure RM_BatchEntry:
+	 *
+	 * Position of a RID within the caller's array,
+	 * used to visit a batch in (page, slot) order.
 	 */
-	RC startScan (RM_TableData *rel, RM_ScanHandle *scan, Expr *cond)
+	typedef struct RM_BatchEntry
 	{
-		RM_MgmtData_Scan *sd;
-		sd = (RM_MgmtData_Scan*) malloc(sizeof(RM_MgmtData_Scan));
-		scan->mgmtData = sd;
-		sd->rid.page= -1;
-		sd->rid.slot= -1;
-		sd->recScanCnt= 0;
-		sd->cond= cond;
-		scan->rel= rel;
-		return RC_OK;
+		RID id;
+		int pos;
+	} RM_BatchEntry;
+
+	static int cmpBatchEntry(const void *a, const void *b)
+	{
+		const RM_BatchEntry *l= a;
+		const RM_BatchEntry *r= b;
+
+		if (l->id.page != r->id.page)
+			return (l->id.page < r->id.page) ? -1 : 1;
+		if (l->id.slot != r->id.slot)
+			return (l->id.slot < r->id.slot) ? -1 : 1;
+		return 0;
 	}
 
 	/*
-	 * function next():
+	 * function sortBatch:
+	 *
+	 * Returns the RIDs of a batch, resolved if their tuples were moved,
+	 * sorted by page and slot, or NULL if one of the RIDs is invalid.
 	 */
-	RC next (RM_ScanHandle *scan, Record *record)
-	{
-		RM_MgmtData_Scan *sd= (RM_MgmtData_Scan*) scan->mgmtData;
-		RM_MgmtData_Table *td= (RM_MgmtData_Table*) scan->rel->mgmtData;
-
-		char *slotNo;
-		int recordSize;
-		Value *result = (Value *) malloc(sizeof(Value));
-		result->v.boolV = TRUE;
 
-		if (td->recCnt == 0) //Check if tuples exist
-			return RC_RM_NO_MORE_TUPLES;
+	static RM_BatchEntry *sortBatch(RM_MgmtData_Table *td, RID *ids, int numIds)
+	{
+		RM_BatchEntry *entries;
+		int i;
 
-		do
+		entries= (RM_BatchEntry*) malloc(sizeof(RM_BatchEntry)*numIds);
+		for (i=0; i<numIds; i++)
 		{
-			if (sd->recScanCnt == 0)
-			{
-				sd->rid.page= 1;
-				sd->rid.slot= 0;
-				pinPage(&td->bm, &sd->h, (PageNumber)sd->rid.page);
-				sd->dataPtr= (RM_ScanTuple*) sd->h.data;
-			}
-			else if (sd->recScanCnt == td->recCnt ) // Stop scan
+			entries[i].id= ids[i];
+			entries[i].pos= i;
+			if (ids[i].page == -1 || ids[i].slot == -1 || resolveRid(td, &entries[i].id) != RC_OK)
 			{
-				unpinPage(&td->bm, &sd->h);
-				sd->rid.page= -1;
-				sd->rid.slot= -1;
-				sd->recScanCnt = 0;
-				sd->dataPtr= NULL;
-				return RC_RM_NO_MORE_TUPLES;
+				free(entries);
+				return NULL;
 			}
-			else
-			{
-				int totSlots = REC_SZ/(getRecordSize(scan->rel->schema)+1);
-				sd->rid.slot++;
-				if (sd->rid.slot== totSlots)
-				{
-					sd->rid.page++;
-					sd->rid.slot= 0;
-					pinPage(&td->bm, &sd->h, (PageNumber)sd->rid.page);
-					sd->dataPtr= (RM_ScanTuple*) sd->h.data;
+		}
+		qsort(entries, numIds, sizeof(RM_BatchEntry), cmpBatchEntry);
+		return entries;
+	}
+
+	/*
+	 * function insertRecords():
+	 *
+	 * Inserts numRecords records. Free slots of a page are filled
+	 * in a single pass while the page is pinned once, and the
+	 * Free Page Linked List is updated once per page.
+	 * The RID of every record is updated as in insertRecord.
+	 */
+
+	RC insertRecords (RM_TableData *rel, Record *records, int numRecords)
+	{
+		RM_MgmtData_Table *td= rel->mgmtData;
+		RM_ScanTuple *dataPtr;
+		BM_PageHandle h;
+		char *slotNo;
+		int totSlots= td->slotsPerPage;
+		int page, slot;
+		int i=0;
+
+		if (td->compressed)
+			return RC_RM_READ_ONLY;
+
+		while (i<numRecords)
+		{
+			if (td->initFreePg == 0)
+			{
+				// add new page
+				if (appendPage(td, &page) != RC_OK)
+					return RC_RM_INSERT_FAILED;
+			}
+			else
+				page= td->initFreePg;
+
+			pinPage(&td->bm, &h, (PageNumber)page);
+			dataPtr= (RM_ScanTuple*) h.data;
+			markDirty(&td->bm, &h);
+
+			// Fill every free slot of this page
+			slotNo= (char*) &dataPtr->data;
+			for (slot=0; slot<totSlots && i<numRecords; slot++)
+			{
+				if (SLOT_FREE(*(char*)slotNo))
+				{
+					writeSlot(td, rel->schema, (char*) &dataPtr->data, slot, records[i].data);
+					*(char*)slotNo=1; //Set TOMBSTONE Address
+					zoneAdd(td, rel->schema, page, records[i].data, TRUE);
+					bloomAdd(td, rel->schema, page, records[i].data, TRUE);
+					records[i].id.page= page;
+					records[i].id.slot= slot;
+					td->recCnt++;
+					i++;
+				}
+				slotNo = slotNo + td->tombStride;
+			}
+
+			//Updating Free Page Linked List
+			if (findFreeSlot(dataPtr, td) != -1)
+				addFreePage(td, dataPtr, page);
+			else
+				removeFreePage(td, dataPtr, page);
+			unpinPage(&td->bm, &h);
+		}
+
+		return RC_OK;
+	}
+
+	/*
+	 * function deleteRecords():
+	 *
+	 * Deletes the records whose RIDs are specified.
+	 * RIDs are visited in page order so that each page is pinned once.
+	 * Like deleteRecord, the batch fails if a RID names a free or
+	 * already deleted slot; all RIDs are checked before any is deleted.
+	 */
+
+	RC deleteRecords (RM_TableData *rel, RID *ids, int numIds)
+	{
+		RM_MgmtData_Table *td= rel->mgmtData;
+		RM_BatchEntry *entries;
+		RM_ScanTuple *dataPtr;
+		BM_PageHandle h;
+		char *slotNo;
+		int page;
+		int i=0;
+
+		if (td->compressed)
+			return RC_RM_READ_ONLY;
+		if ((entries= sortBatch(td, ids, numIds)) == NULL)
+			return RC_RM_DELETE_FAILED;
+
+		// Check every RID first, a RID listed twice would be deleted twice
+		while (i<numIds)
+		{
+			page= entries[i].id.page;
+			pinPage(&td->bm, &h, (PageNumber)page);
+			dataPtr= (RM_ScanTuple*) h.data;
+
+			for (; i<numIds && entries[i].id.page == page; i++)
+			{
+				slotNo = TOMBSTONE(td, (char*) &dataPtr->data, entries[i].id.slot);
+				if (entries[i].id.slot >= td->slotsPerPage || *(char*)slotNo <= 0
+					|| (i > 0 && cmpBatchEntry(&entries[i-1], &entries[i]) == 0))
+				{
+					unpinPage(&td->bm, &h);
+					free(entries);
+					return RC_RM_DELETE_FAILED;
+				}
+			}
+
+			unpinPage(&td->bm, &h);
+		}
+
+		i=0;
+		while (i<numIds)
+		{
+			page= entries[i].id.page;
+			pinPage(&td->bm, &h, (PageNumber)page);
+			dataPtr= (RM_ScanTuple*) h.data;
+			markDirty(&td->bm, &h);
+
+			for (; i<numIds && entries[i].id.page == page; i++)
+			{
+				slotNo = TOMBSTONE(td, (char*) &dataPtr->data, entries[i].id.slot);
+				*(char*)slotNo = -1; // Remove TOMBSTONE
+				td->recCnt--;
+				if (page < td->zoneCap)
+					td->zoneLive[page]--;
+				bloomDelete(td, page);
+			}
+
+			addFreePage(td, dataPtr, page);
+			unpinPage(&td->bm, &h);
+		}
+
+		free(entries);
+		return RC_OK;
+	}
+
+	/*
+	 * function getRecords():
+	 *
+	 * Reads the records whose RIDs are specified into records[].
+	 * RIDs are visited in page order so that each page is pinned once
+	 * and pages are requested sequentially.
+	 */
+
+	RC getRecords (RM_TableData *rel, RID *ids, int numIds, Record *records)
+	{
+		RM_MgmtData_Table *td= rel->mgmtData;
+		RM_BatchEntry *entries;
+		RM_ScanTuple *dataPtr;
+		BM_PageHandle h;
+		RM_PageDecoder decoder;
+		Record *record;
+		char *slots;
+		int page, numSlots;
+		int i=0;
+
+		if ((entries= sortBatch(td, ids, numIds)) == NULL)
+			return RC_RM_UPDATE_FAILED;
+		initDecoder(td, &decoder);
+
+		while (i<numIds)
+		{
+			page= entries[i].id.page;
+			pinPage(&td->bm, &h, (PageNumber)page);
+			dataPtr= (RM_ScanTuple*) h.data;
+			slots= pageSlots(td, rel->schema, &decoder, dataPtr, page, &numSlots);
+
+			for (; i<numIds && entries[i].id.page == page; i++)
+			{
+				// Like getRecord, fail past the tuples of a compressed page
+				if (entries[i].id.slot >= numSlots)
+				{
+					unpinPage(&td->bm, &h);
+					free(decoder.buf);
+					free(entries);
+					return RC_RM_UPDATE_FAILED;
+				}
+				record= &records[entries[i].pos];
+				readSlot(td, rel->schema, slots, entries[i].id.slot, record->data);
+				record->id= ids[entries[i].pos];
+			}
+
+			unpinPage(&td->bm, &h);
+		}
+
+		free(decoder.buf);
+		free(entries);
+		return RC_OK;
+	}
+
+
+	//########## SCANS ##########
+
+	/*
+	 * function startScan
+	 */
+	RC startScan (RM_TableData *rel, RM_ScanHandle *scan, Expr *cond)
+	{
+		RM_MgmtData_Scan *sd;
+		sd = (RM_MgmtData_Scan*) malloc(sizeof(RM_MgmtData_Scan));
+		scan->mgmtData = sd;
+		sd->rid.page= -1;
+		sd->rid.slot= -1;
+		sd->cond= cond;
+		sd->prog= NULL;
+		sd->batchRid.page= 1;
+		sd->batchRid.slot= 0;
+		sd->limit= -1;
+		sd->numReturned= 0;
+		sd->viewData= NULL;
+		sd->dataPtr= NULL;
+		sd->stats.pagesPinned= 0;
+		sd->stats.pagesSkipped= 0;
+		sd->stats.bloomSkipped= 0;
+		if (((RM_MgmtData_Table*) rel->mgmtData)->layout == RM_LAYOUT_PAX)
+			sd->viewData= (char*) malloc(rel->schema->recordSize);
+		initDecoder((RM_MgmtData_Table*) rel->mgmtData, &sd->decoder);
+		scan->rel= rel;
+
+		// Compile the condition once; conditions which cannot be compiled are interpreted by evalExpr.
+		if (cond != NULL && compileExpr(cond, rel->schema, &sd->prog) != RC_OK)
+			sd->prog= NULL;
+		return RC_OK;
+	}
+
+	/*
+	 * function setScanLimit():
+	 *
+	 * Pushes a LIMIT down into the scan: once limit matching tuples have
+	 * been returned, next, nextView and nextBatch return RC_RM_NO_MORE_TUPLES
+	 * without pinning further pages. A negative limit scans all tuples.
+	 */
+	RC setScanLimit (RM_ScanHandle *scan, int limit)
+	{
+		RM_MgmtData_Scan *sd= (RM_MgmtData_Scan*) scan->mgmtData;
+
+		sd->limit= limit;
+		return RC_OK;
+	}
+
+	/*
+	 * function next():
+	 */
+	RC next (RM_ScanHandle *scan, Record *record)
+	{
+		LATENCY_START(start);
+		RC rc= scanNext(scan, record, TRUE);
+		LATENCY_END(LAT_SCAN_NEXT, start);
+		return rc;
+	}
+
+	/*
+	 * function nextView():
+	 *
+	 * Like next(), but instead of copying the tuple into record->data it
+	 * points record->data at the tuple inside the page pinned by the scan.
+	 * The view is read only and stays valid until the scan moves on to the
+	 * next page or is closed; materializeRecord copies it for callers that
+	 * keep rows. The record passed must not own its data, as the pointer is
+	 * overwritten. With the PAX layout a tuple is not stored contiguously,
+	 * so the view points to a buffer of the scan refilled by every call.
+	 */
+	RC nextView (RM_ScanHandle *scan, Record *record)
+	{
+		return scanNext(scan, record, FALSE);
+	}
+
+	/*
+	 * function materializeRecord():
+	 *
+	 * Copies a record, typically a view returned by nextView, into the
+	 * data owned by record (see createRecord).
+	 */
+	RC materializeRecord (Record *view, Schema *schema, Record *record)
+	{
+		memcpy(record->data, view->data, schema->recordSize);
+		record->id= view->id;
+		return RC_OK;
+	}
+
+	/*
+	 * function scanNext():
+	 *
+	 * Advances the scan to the next tuple matching its condition and either
+	 * copies it into record->data or points record->data into the page.
+	 */
+	RC scanNext (RM_ScanHandle *scan, Record *record, bool copy)
+	{
+		RM_MgmtData_Scan *sd= (RM_MgmtData_Scan*) scan->mgmtData;
+		RM_MgmtData_Table *td= (RM_MgmtData_Table*) scan->rel->mgmtData;
+
+		Value *result;
+		bool match= TRUE;
+		bool more;
+
+		if (sd->limit >= 0 && sd->numReturned >= sd->limit) // LIMIT reached
+		{
+			if (sd->dataPtr != NULL)
+				unpinPage(&td->bm, &sd->h);
+			sd->dataPtr= NULL;
+			return RC_RM_NO_MORE_TUPLES;
+		}
+
+		do
+		{
+			more= (sd->dataPtr != NULL) || scanToPage(scan, 1); // Start scan
+
+			// Next live slot, moving on to the following pages at the end of a page
+			while (more)
+			{
+				if (++sd->rid.slot == sd->pageSlots)
+				{
+					unpinPage(&td->bm, &sd->h);
+					sd->dataPtr= NULL;
+					more= scanToPage(scan, sd->rid.page+1);
 				}
+				else if (*TOMBSTONE(td, sd->slots, sd->rid.slot) > 0)
+					break;
+			}
+
+			if (!more)
+			{
+				sd->rid.page= -1;
+				sd->rid.slot= -1;
+				return RC_RM_NO_MORE_TUPLES;
 			}
-			slotNo = ((char*) &sd->dataPtr->data) + (sd->rid.slot*(getRecordSize(scan->rel->schema)+1));
 			// Read Record from Slot
-			recordSize= getRecordSize(scan->rel->schema);
-			memcpy(record->data, slotNo+1, recordSize); // +1 for TOMBSTONE
+			if (!copy && td->layout == RM_LAYOUT_ROW)
+				record->data= sd->slots + (sd->rid.slot*td->slotSize) + 1; // +1 for TOMBSTONE
+			else
+			{
+				if (!copy)
+					record->data= sd->viewData;
+				readSlot(td, scan->rel->schema, sd->slots, sd->rid.slot, record->data);
+			}
 
 			record->id.page=sd->rid.page;
 			record->id.slot=sd->rid.slot;
-			sd->recScanCnt++;
 
-			if (sd->cond != NULL)
+			if (sd->prog != NULL)
+				evalProgram(sd->prog, record->data, &match);
+			else if (sd->cond != NULL)
+			{
 				evalExpr(record, (scan->rel)->schema, sd->cond, &result);
+				match= result->v.boolV;
+				freeVal(result);
+			}
 
-		}while (!result->v.boolV && sd->cond != NULL);
+		}while (!match);
 
+		sd->numReturned++;
 		return RC_OK;
 	}
 
@@ -715,9 +1568,14 @@
 		RM_MgmtData_Scan *sd= (RM_MgmtData_Scan*) scan->mgmtData;
 		RM_MgmtData_Table *td= (RM_MgmtData_Table*) scan->rel->mgmtData;
 
-		if (sd->recScanCnt > 0) // Is Scan Pending?
+		if (sd->dataPtr != NULL) // Is Scan Pending?
 			unpinPage(&td->bm, &sd->h); // UnPin Page
 
+		if (sd->prog != NULL)
+			freeProgram(sd->prog);
+		free(sd->viewData);
+		free(sd->decoder.buf);
+
 		// Free mgmtData memory
 		free(scan->mgmtData);
 		scan->mgmtData= NULL;
@@ -726,119 +1584,2151 @@
 	}
 
 
-	//########## DEALING WITH RECORDS AND ATTRIBUTE VALUES ##########
-
 	/*
-	 * function createRecord:
+	 * function getScanStats:
+	 *
+	 * Pages next, nextView and nextBatch read and skipped so far, see pageMayMatch.
 	 */
-	RC createRecord (Record **record, Schema *schema)
+	RC getScanStats (RM_ScanHandle *scan, RM_ScanStats *stats)
 	{
-		*record = (Record*)malloc(sizeof(Record));
-		(*record)->data = (char*)malloc(getRecordSize(schema));
+		*stats= ((RM_MgmtData_Scan*) scan->mgmtData)->stats;
 		return RC_OK;
 	}
 
 	/*
-	 * function freeRecord:
+	 * function scanToPage:
+	 *
+	 * Pins the first page from page on that may hold tuples matching the
+	 * condition of the scan, positioned before its first slot. Returns
+	 * FALSE past the last page.
 	 */
-	RC freeRecord (Record *record)
+	bool scanToPage(RM_ScanHandle *scan, int page)
 	{
-		free(record->data);
-		free(record);
-		return RC_OK;
+		RM_MgmtData_Scan *sd= (RM_MgmtData_Scan*) scan->mgmtData;
+		RM_MgmtData_Table *td= (RM_MgmtData_Table*) scan->rel->mgmtData;
+		BM_MgmtData *bm= td->bm.mgmtData;
+
+		while (page < bm->fHandle.totalNumPages && skipPage(td, scan->rel->schema, sd->cond, page, &sd->stats))
+			page++;
+		if (page >= bm->fHandle.totalNumPages)
+			return FALSE;
+
+		sd->rid.page= page;
+		sd->rid.slot= -1;
+		pinPage(&td->bm, &sd->h, (PageNumber)page);
+		sd->dataPtr= (RM_ScanTuple*) sd->h.data;
+		sd->slots= pageSlots(td, scan->rel->schema, &sd->decoder, sd->dataPtr, page, &sd->pageSlots);
+		refreshBlooms(td, scan->rel->schema, page, sd->slots, sd->pageSlots);
+		sd->stats.pagesPinned++;
+		return TRUE;
 	}
 
+
+	//########## BATCHED SCANS ##########
+
 	/*
-	 * function getAttr:
+	 * function createRecordBatch:
+	 *
+	 * Allocates a batch holding up to capacity tuples of the given Schema.
 	 */
-	RC getAttr (Record *record, Schema *schema, int attrNum, Value **value)
+	RC createRecordBatch (RM_RecordBatch **batch, Schema *schema, int capacity)
 	{
-		void *recOfst = record->data;
-		Value *value1= (Value*) malloc(sizeof(Value));
-		int i=0;
-		int dataType = schema->dataTypes[attrNum];
-
-		while(i<schema->numAttr)
-		{
-			if (i==attrNum)
-			{
-				value1->dt= dataType;
-				switch(dataType)
-				{
-				case DT_STRING:
-					value1->v.stringV= (char*) malloc(schema->typeLength[i]+1);
-					memcpy(value1->v.stringV, recOfst, schema->typeLength[i]);
-					value1->v.stringV[schema->typeLength[i]]='\0';
-					break;
-				case DT_INT:
-				case DT_FLOAT:
-				case DT_BOOL:
-					memcpy(&value1->v, recOfst, schema->typeLength[i]);
-					break;
-				default:
-					assert(!"No such type");
-				}
-				break;
-			}
-			recOfst = recOfst + schema->typeLength[i];
-			i++;
-		}
-		*value = value1;
+		RM_RecordBatch *b;
+
+		b= (RM_RecordBatch*) malloc(sizeof(RM_RecordBatch));
+		b->capacity= capacity;
+		b->numRecords= 0;
+		b->numSelected= 0;
+		b->ids= (RID*) malloc(sizeof(RID)*capacity);
+		b->data= (char*) malloc(getRecordSize(schema)*capacity);
+		b->selection= (uint64_t*) malloc(sizeof(uint64_t)*BITMAP_WORDS(capacity));
+		b->scratch= malloc(EXPR_BATCH_SCRATCH_SIZE(capacity));
+		*batch= b;
 		return RC_OK;
 	}
 
 	/*
-	 * function setAttr:
+	 * function freeRecordBatch:
 	 */
-	RC setAttr (Record *record, Schema *schema, int attrNum, Value *value)
+	RC freeRecordBatch (RM_RecordBatch *batch)
 	{
-		void *recOfst = record->data;
-		int i=0;
-		int dataType = schema->dataTypes[attrNum];
-		while(i<schema->numAttr)
-		{
-			if (i==attrNum)
-			{
-				switch(dataType)
-				{
-				case DT_STRING:
-					memcpy(recOfst, value->v.stringV, schema->typeLength[i]);
-					break;
-				case DT_INT:
-				case DT_BOOL:
-				case DT_FLOAT:
-					memcpy(recOfst, &value->v, schema->typeLength[i]);
-					break;
-				default:
-					assert(!"No such type");
-				}
-			}
-			recOfst = recOfst + schema->typeLength[i];
-			i++;
-		}
+		free(batch->ids);
+		free(batch->data);
+		free(batch->selection);
+		free(batch->scratch);
+		free(batch);
 		return RC_OK;
 	}
 
 	/*
-	 * function findFreeSlot:
+	 * function nextBatch():
 	 *
-	 * Finds an available free slot.
-	 * Returns -1 if no free slot available.
+	 * Copies the next live tuples, up to the capacity of the batch, and sets
+	 * the selection bitmap to the tuples matching the scan condition.
+	 * Each page is pinned once per call and the condition is evaluated for
+	 * the whole batch, using SIMD kernels for simple int/float comparisons.
+	 * Returns RC_RM_NO_MORE_TUPLES once every page has been read.
 	 */
-
-	int findFreeSlot(RM_ScanTuple *dataPtr, Schema *schema)
+	RC nextBatch (RM_ScanHandle *scan, RM_RecordBatch *batch)
 	{
-		int i=0;
-		char *slotNo = ((char*) &dataPtr->data);
-		int recSz= getRecordSize(schema)+1; //Get Record Size
-		int n = REC_SZ/recSz; //Total Number of Slots
+		RM_MgmtData_Scan *sd= (RM_MgmtData_Scan*) scan->mgmtData;
+		RM_MgmtData_Table *td= (RM_MgmtData_Table*) scan->rel->mgmtData;
+		BM_MgmtData *bm= td->bm.mgmtData;
+		RM_ScanTuple *dataPtr;
+		BM_PageHandle h;
+		Record record;
+		Value *result;
+		char *slots, *slotNo;
+		int recordSize= scan->rel->schema->recordSize;
+		int totSlots;
+		int n= 0;
+		int i;
 
-		while(i<n)
+		if (sd->limit >= 0 && sd->numReturned >= sd->limit) // LIMIT reached
 		{
-			if (!(*(char*)slotNo>0)) //Get TOMBSTONE Address
-				return i;
-			slotNo = slotNo + recSz;
+			batch->numRecords= 0;
+			batch->numSelected= 0;
+			return RC_RM_NO_MORE_TUPLES;
+		}
+
+		while (n<batch->capacity && sd->batchRid.page < bm->fHandle.totalNumPages)
+		{
+			// Skip pages whose zone map or bloom filters rule out matching tuples
+			if (sd->batchRid.slot == 0 && skipPage(td, scan->rel->schema, sd->cond, sd->batchRid.page, &sd->stats))
+			{
+				sd->batchRid.page++;
+				continue;
+			}
+			if (sd->batchRid.slot == 0)
+				sd->stats.pagesPinned++;
+			pinPage(&td->bm, &h, (PageNumber)sd->batchRid.page);
+			dataPtr= (RM_ScanTuple*) h.data;
+			slots= pageSlots(td, scan->rel->schema, &sd->decoder, dataPtr, sd->batchRid.page, &totSlots);
+			if (sd->batchRid.slot == 0)
+				refreshBlooms(td, scan->rel->schema, sd->batchRid.page, slots, totSlots);
+			slotNo= TOMBSTONE(td, slots, sd->batchRid.slot);
+
+			// Copy live tuples of this page
+			for (; sd->batchRid.slot<totSlots && n<batch->capacity; sd->batchRid.slot++)
+			{
+				if (*(char*)slotNo > 0)
+				{
+					readSlot(td, scan->rel->schema, slots, sd->batchRid.slot, batch->data + (n*recordSize));
+					batch->ids[n]= sd->batchRid;
+					n++;
+				}
+				slotNo = slotNo + td->tombStride;
+			}
+			unpinPage(&td->bm, &h);
+
+			if (sd->batchRid.slot == totSlots)
+			{
+				sd->batchRid.page++;
+				sd->batchRid.slot= 0;
+			}
+		}
+
+		batch->numRecords= n;
+		if (n == 0)
+		{
+			batch->numSelected= 0;
+			return RC_RM_NO_MORE_TUPLES;
+		}
+
+		// Evaluate the condition for the whole batch
+		if (sd->prog != NULL)
+			evalProgramBatch(sd->prog, batch->data, recordSize, n, batch->selection, batch->scratch);
+		else
+		{
+			memset(batch->selection, 0, sizeof(uint64_t)*BITMAP_WORDS(n));
+			for (i=0; i<n; i++)
+			{
+				bool match= TRUE;
+				if (sd->cond != NULL)
+				{
+					record.id= batch->ids[i];
+					record.data= batch->data + (i*recordSize);
+					evalExpr(&record, scan->rel->schema, sd->cond, &result);
+					match= result->v.boolV;
+					freeVal(result);
+				}
+				if (match)
+					batch->selection[i/64] |= ((uint64_t) 1) << (i%64);
+			}
+		}
+
+		batch->numSelected= 0;
+		for (i=0; i<BITMAP_WORDS(n); i++)
+			batch->numSelected += __builtin_popcountll(batch->selection[i]);
+
+		// Deselect the matching tuples beyond the LIMIT
+		if (sd->limit >= 0 && sd->numReturned + batch->numSelected > sd->limit)
+		{
+			int left= sd->limit - sd->numReturned;
+			for (i=0; i<n; i++)
+				if (BITMAP_TEST(batch->selection, i) && left-- <= 0)
+					batch->selection[i/64] &= ~(((uint64_t) 1) << (i%64));
+			batch->numSelected= sd->limit - sd->numReturned;
+		}
+		sd->numReturned += batch->numSelected;
+
+		return RC_OK;
+	}
+
+
+	//########## PARALLEL SCANS ##########
+
+	/*
+	 * function parallelScan():
+	 *
+	 * Scans the table on numWorkers threads (the calling thread included,
+	 * one per online CPU if numWorkers <= 0) and calls callback for every
+	 * tuple matching cond. The pages are handed out in morsels of
+	 * RM_MORSEL_PAGES: a worker done with its morsel takes the next one, so
+	 * workers slowed down by expensive pages simply take fewer morsels.
+	 * Callbacks run concurrently and in no particular order; worker (0 to
+	 * numWorkers-1) identifies the calling thread for per worker state.
+	 * The table must not be modified during the scan.
+	 * Returns the first result other than RC_OK of a callback, if any.
+	 */
+	RC parallelScan (RM_TableData *rel, Expr *cond, int numWorkers, RM_ScanCallback callback, void *context)
+	{
+		RM_ParallelScan ps;
+
+		ps.rel= rel;
+		ps.cond= cond;
+		ps.callback= callback;
+		ps.columnCallback= NULL;
+		ps.context= context;
+		return runParallelScan(&ps, numWorkers);
+	}
+
+	/*
+	 * function parallelScanColumns():
+	 *
+	 * Like parallelScan, but calls callback once per page with the matching
+	 * tuples of the page as a bitmap and a pointer per attribute to its
+	 * values (RM_ColumnBatch). Callbacks reading only a few attributes of a
+	 * PAX table touch only their minipages.
+	 */
+	RC parallelScanColumns (RM_TableData *rel, Expr *cond, int numWorkers, RM_ColumnCallback callback, void *context)
+	{
+		RM_ParallelScan ps;
+
+		ps.rel= rel;
+		ps.cond= cond;
+		ps.callback= NULL;
+		ps.columnCallback= callback;
+		ps.context= context;
+		return runParallelScan(&ps, numWorkers);
+	}
+
+	/*
+	 * function runParallelScan():
+	 *
+	 * Runs the workers of a parallelScan or parallelScanColumns.
+	 */
+	RC runParallelScan(RM_ParallelScan *ps, int numWorkers)
+	{
+		RM_MgmtData_Table *td= (RM_MgmtData_Table*) ps->rel->mgmtData;
+		BM_MgmtData *bm= td->bm.mgmtData;
+		RM_ScanWorker *workers;
+		int numStarted= 1;
+		int i;
+
+		if (numWorkers <= 0)
+			numWorkers= (int) sysconf(_SC_NPROCESSORS_ONLN);
+		// Every worker keeps one page pinned, leave frames for other callers
+		if (numWorkers > td->bm.numPages/2)
+			numWorkers= td->bm.numPages/2;
+		if (numWorkers < 1)
+			numWorkers= 1;
+
+		ps->numPages= bm->fHandle.totalNumPages;
+		ps->nextPage= 1;
+		ps->stop= 0;
+		ps->rc= RC_OK;
+		pthread_mutex_init(&ps->lock, NULL);
+
+		workers= (RM_ScanWorker*) malloc(sizeof(RM_ScanWorker)*numWorkers);
+		for (i=0; i<numWorkers; i++)
+		{
+			workers[i].ps= ps;
+			workers[i].id= i;
+		}
+		// Worker 0 is the calling thread; if a thread cannot be created the others take its share
+		for (i=1; i<numWorkers; i++)
+		{
+			if (pthread_create(&workers[i].thread, NULL, scanWorker, &workers[i]) != 0)
+				break;
+			numStarted++;
+		}
+		scanWorker(&workers[0]);
+		for (i=1; i<numStarted; i++)
+			pthread_join(workers[i].thread, NULL);
+
+		free(workers);
+		pthread_mutex_destroy(&ps->lock);
+		return ps->rc;
+	}
+
+	/*
+	 * function scanWorker():
+	 *
+	 * Body of a parallelScan worker: takes morsels of pages until none is
+	 * left, evaluating the condition for a whole page at a time in place,
+	 * on the minipages of the attributes it refers to with the PAX layout.
+	 */
+	void *scanWorker(void *arg)
+	{
+		RM_ScanWorker *w= (RM_ScanWorker*) arg;
+		RM_ParallelScan *ps= w->ps;
+		RM_MgmtData_Table *td= (RM_MgmtData_Table*) ps->rel->mgmtData;
+		Schema *schema= ps->rel->schema;
+		int totSlots= td->slotsPerPage;
+		ExprProgram *prog= NULL;
+		RM_PageDecoder decoder;
+		RM_ColumnBatch batch;
+		uint64_t *selection;
+		void *scratch;
+		char *row= NULL;
+		BM_PageHandle h;
+		Record record;
+		Value *result;
+		char *slots;
+		int first, page, i, a;
+		bool match;
+		RC rc= RC_OK;
+
+		// Each worker compiles its own program, as evaluating it updates its statistics
+		if (ps->cond != NULL && compileExpr(ps->cond, schema, &prog) != RC_OK)
+			prog= NULL;
+		selection= (uint64_t*) malloc(sizeof(uint64_t)*BITMAP_WORDS(totSlots));
+		scratch= malloc(EXPR_BATCH_SCRATCH_SIZE(totSlots));
+		batch.selection= selection;
+		batch.columns= (char**) malloc(sizeof(char*)*schema->numAttr);
+		batch.strides= (int*) malloc(sizeof(int)*schema->numAttr);
+		for (a=0; a<schema->numAttr; a++)
+			batch.strides[a]= (td->layout == RM_LAYOUT_ROW) ? td->slotSize : schema->typeLength[a];
+		batch.rowStride= td->slotSize;
+		if (td->layout == RM_LAYOUT_PAX)
+			row= (char*) malloc(schema->recordSize); // tuples gathered from the minipages
+		initDecoder(td, &decoder);
+
+		while (rc == RC_OK && !__atomic_load_n(&ps->stop, __ATOMIC_RELAXED))
+		{
+			first= __atomic_fetch_add(&ps->nextPage, RM_MORSEL_PAGES, __ATOMIC_RELAXED);
+			if (first >= ps->numPages)
+				break;
+
+			for (page= first; rc == RC_OK && page < first+RM_MORSEL_PAGES && page < ps->numPages; page++)
+			{
+				if (skipPage(td, schema, ps->cond, page, NULL))
+					continue;
+				if ((rc= pinPage(&td->bm, &h, (PageNumber)page)) != RC_OK)
+					break;
+				slots= pageSlots(td, schema, &decoder, (RM_ScanTuple*) h.data, page, &totSlots);
+				batch.page= page;
+				batch.numSlots= totSlots;
+				batch.rows= (td->layout == RM_LAYOUT_ROW) ? slots+1 : NULL; // +1 for TOMBSTONE
+				for (a=0; a<schema->numAttr; a++)
+					batch.columns[a]= (td->layout == RM_LAYOUT_ROW) ? slots+1+schema->attrOffsets[a] : slots+td->columnOffsets[a];
+
+				// Evaluate the condition on all slots of the page, free and deleted ones are masked below
+				if (prog != NULL && td->layout == RM_LAYOUT_ROW)
+					evalProgramBatch(prog, slots+1, td->slotSize, totSlots, selection, scratch);
+				else if (prog != NULL)
+					evalProgramColumns(prog, batch.columns, totSlots, selection, scratch);
+				else
+					memset(selection, 0, sizeof(uint64_t)*BITMAP_WORDS(totSlots));
+
+				for (i=0; i<totSlots; i++)
+				{
+					if (prog != NULL)
+						match= BITMAP_TEST(selection, i);
+					else if (ps->cond != NULL && *TOMBSTONE(td, slots, i) > 0)
+					{
+						if (row != NULL)
+							readSlot(td, schema, slots, i, row);
+						record.data= (row != NULL) ? row : slots+(i*td->slotSize)+1;
+						evalExpr(&record, schema, ps->cond, &result);
+						match= result->v.boolV;
+						freeVal(result);
+					}
+					else
+						match= TRUE;
+					if (*TOMBSTONE(td, slots, i) <= 0 || !match)
+						selection[i/64] &= ~(((uint64_t) 1) << (i%64));
+					else
+						selection[i/64] |= ((uint64_t) 1) << (i%64);
+				}
+
+				if (ps->columnCallback != NULL)
+					rc= ps->columnCallback(ps->context, w->id, &batch);
+				for (i=0; ps->callback != NULL && rc == RC_OK && i<totSlots; i++)
+				{
+					if (!BITMAP_TEST(selection, i))
+						continue;
+					record.id.page= page;
+					record.id.slot= i;
+					if (row != NULL)
+					{
+						readSlot(td, schema, slots, i, row);
+						record.data= row;
+					}
+					else
+						record.data= slots+(i*td->slotSize)+1; // +1 for TOMBSTONE
+					rc= ps->callback(ps->context, w->id, &record);
+				}
+				unpinPage(&td->bm, &h);
+			}
+		}
+
+		if (rc != RC_OK)
+		{
+			pthread_mutex_lock(&ps->lock);
+			if (ps->rc == RC_OK)
+				ps->rc= rc;
+			pthread_mutex_unlock(&ps->lock);
+			__atomic_store_n(&ps->stop, 1, __ATOMIC_RELAXED);
+		}
+
+		if (prog != NULL)
+			freeProgram(prog);
+		free(selection);
+		free(scratch);
+		free(batch.columns);
+		free(batch.strides);
+		free(row);
+		free(decoder.buf);
+		return NULL;
+	}
+
+
+	//########## DEALING WITH RECORDS AND ATTRIBUTE VALUES ##########
+
+	/*
+	 * function createRecord:
+	 */
+	RC createRecord (Record **record, Schema *schema)
+	{
+		*record = (Record*)malloc(sizeof(Record));
+		(*record)->data = (char*)malloc(getRecordSize(schema));
+		return RC_OK;
+	}
+
+	/*
+	 * function freeRecord:
+	 */
+	RC freeRecord (Record *record)
+	{
+		free(record->data);
+		free(record);
+		return RC_OK;
+	}
+
+	/*
+	 * function getAttr:
+	 */
+	RC getAttr (Record *record, Schema *schema, int attrNum, Value **value)
+	{
+		void *recOfst = record->data+schema->attrOffsets[attrNum];
+		Value *value1= (Value*) malloc(sizeof(Value));
+		int len = schema->typeLength[attrNum];
+		int dataType = schema->dataTypes[attrNum];
+
+		value1->dt= dataType;
+		switch(dataType)
+		{
+		case DT_STRING:
+			value1->v.stringV= (char*) malloc(len+1);
+			memcpy(value1->v.stringV, recOfst, len);
+			value1->v.stringV[len]='\0';
+			break;
+		case DT_INT:
+		case DT_FLOAT:
+		case DT_BOOL:
+			memcpy(&value1->v, recOfst, len);
+			break;
+		default:
+			assert(!"No such type");
+		}
+		*value = value1;
+		return RC_OK;
+	}
+
+	/*
+	 * function setAttr:
+	 */
+	RC setAttr (Record *record, Schema *schema, int attrNum, Value *value)
+	{
+		void *recOfst = record->data+schema->attrOffsets[attrNum];
+		int len = schema->typeLength[attrNum];
+
+		switch(schema->dataTypes[attrNum])
+		{
+		case DT_STRING:
+			memcpy(recOfst, value->v.stringV, len);
+			break;
+		case DT_INT:
+		case DT_BOOL:
+		case DT_FLOAT:
+			memcpy(recOfst, &value->v, len);
+			break;
+		default:
+			assert(!"No such type");
+		}
+		return RC_OK;
+	}
+
+	/*
+	 * function getIntAttr:
+	 * Reads an int attribute in place, without allocating a Value.
+	 * getFloatAttr, getBoolAttr and getStringAttr work the same way.
+	 */
+	RC getIntAttr (Record *record, Schema *schema, int attrNum, int *value)
+	{
+		if (attrNum<0 || attrNum>=schema->numAttr || schema->dataTypes[attrNum]!=DT_INT)
+			THROW(RC_RM_UNKOWN_DATATYPE, "attribute is not an int");
+		memcpy(value, record->data+schema->attrOffsets[attrNum], sizeof(int));
+		return RC_OK;
+	}
+
+	RC getFloatAttr (Record *record, Schema *schema, int attrNum, float *value)
+	{
+		if (attrNum<0 || attrNum>=schema->numAttr || schema->dataTypes[attrNum]!=DT_FLOAT)
+			THROW(RC_RM_UNKOWN_DATATYPE, "attribute is not a float");
+		memcpy(value, record->data+schema->attrOffsets[attrNum], sizeof(float));
+		return RC_OK;
+	}
+
+	RC getBoolAttr (Record *record, Schema *schema, int attrNum, bool *value)
+	{
+		if (attrNum<0 || attrNum>=schema->numAttr || schema->dataTypes[attrNum]!=DT_BOOL)
+			THROW(RC_RM_UNKOWN_DATATYPE, "attribute is not a bool");
+		memcpy(value, record->data+schema->attrOffsets[attrNum], sizeof(bool));
+		return RC_OK;
+	}
+
+	/*
+	 * function getStringAttr:
+	 * Sets value to a view of the string inside the record data.
+	 * The view is not NUL terminated and is only valid as long as the
+	 * record data (or the page it points into) is.
+	 */
+	RC getStringAttr (Record *record, Schema *schema, int attrNum, RM_StringView *value)
+	{
+		if (attrNum<0 || attrNum>=schema->numAttr || schema->dataTypes[attrNum]!=DT_STRING)
+			THROW(RC_RM_UNKOWN_DATATYPE, "attribute is not a string");
+		value->data= record->data+schema->attrOffsets[attrNum];
+		value->length= strnlen(value->data, schema->typeLength[attrNum]);
+		return RC_OK;
+	}
+
+	/*
+	 * function findFreeSlot:
+	 *
+	 * Finds an available free slot.
+	 * Returns -1 if no free slot available.
+	 */
+
+	int findFreeSlot(RM_ScanTuple *dataPtr, RM_MgmtData_Table *td)
+	{
+		int i=0;
+		char *slotNo = ((char*) &dataPtr->data);
+		int recSz= td->tombStride; //Bytes between TOMBSTONES
+		int n = td->slotsPerPage; //Total Number of Slots
+
+		while(i<n)
+		{
+			if (SLOT_FREE(*(char*)slotNo)) //Get TOMBSTONE Address
+				return i;
+			slotNo = slotNo + recSz;
 			i++;
 		}
 		return -1;
 	}
+
+	/*
+	 * function addFreePage:
+	 *
+	 * Pushes a page onto the head of the Free Page Linked List,
+	 * unless it is already part of the list.
+	 * The caller must mark the page dirty. If the head page cannot be
+	 * pinned, the list is left unchanged and the error returned.
+	 */
+
+	RC addFreePage(RM_MgmtData_Table *td, RM_ScanTuple *dataPtr, int page)
+	{
+		RM_ScanTuple *headPtr;
+		BM_PageHandle h;
+		RC rc;
+
+		// Head of the list, or linked behind another page
+		if (td->initFreePg == page || dataPtr->prev != 0)
+			return RC_OK;
+
+		if (td->initFreePg != 0)
+		{
+			// Read head block and link this page
+			if ((rc= pinPage(&td->bm, &h, (PageNumber)td->initFreePg)) != RC_OK)
+				return rc;
+			headPtr= (RM_ScanTuple*) h.data;
+			markDirty(&td->bm, &h);
+			headPtr->prev= page;
+			unpinPage(&td->bm, &h);
+		}
+
+		dataPtr->next= td->initFreePg;
+		dataPtr->prev= 0;
+		td->initFreePg= page;
+		return RC_OK;
+	}
+
+	/*
+	 * function removeFreePage:
+	 *
+	 * Unlinks a page which has no free slot left from the Free Page Linked List.
+	 * The caller must mark the page dirty. Both neighbours are pinned before
+	 * a link changes, so if one cannot be pinned the list is left unchanged
+	 * and the error returned; insertRecord unlinks a full page it finds later.
+	 */
+
+	RC removeFreePage(RM_MgmtData_Table *td, RM_ScanTuple *dataPtr, int page)
+	{
+		RM_ScanTuple *prevPtr= NULL, *nextPtr= NULL;
+		BM_PageHandle prevH, nextH;
+		RC rc;
+
+		// Not part of the list
+		if (td->initFreePg != page && dataPtr->prev == 0)
+			return RC_OK;
+
+		if (dataPtr->prev != 0)
+		{
+			if ((rc= pinPage(&td->bm, &prevH, (PageNumber)dataPtr->prev)) != RC_OK)
+				return rc;
+			prevPtr= (RM_ScanTuple*) prevH.data;
+		}
+		if (dataPtr->next != 0)
+		{
+			if ((rc= pinPage(&td->bm, &nextH, (PageNumber)dataPtr->next)) != RC_OK)
+			{
+				if (prevPtr != NULL)
+					unpinPage(&td->bm, &prevH);
+				return rc;
+			}
+			nextPtr= (RM_ScanTuple*) nextH.data;
+		}
+
+		if (prevPtr != NULL)
+		{
+			// Previous block skips this page
+			markDirty(&td->bm, &prevH);
+			prevPtr->next= dataPtr->next;
+			unpinPage(&td->bm, &prevH);
+		}
+		else // Remove from head
+			td->initFreePg= dataPtr->next;
+
+		if (nextPtr != NULL)
+		{
+			// Next block skips this page
+			markDirty(&td->bm, &nextH);
+			nextPtr->prev= dataPtr->prev;
+			unpinPage(&td->bm, &nextH);
+		}
+
+		dataPtr->next=dataPtr->prev= 0;
+		return RC_OK;
+	}
+
+	/*
+	 * function initPaxLayout:
+	 *
+	 * Places the minipages of a PAX page for td->slotsPerPage slots: the
+	 * TOMBSTONES, then the values of every attribute, each minipage 8 byte
+	 * aligned. Returns the bytes used.
+	 */
+
+	int initPaxLayout(RM_MgmtData_Table *td, Schema *schema)
+	{
+		int ofst= td->slotsPerPage; // TOMBSTONES
+		int end= ofst;
+		int i;
+
+		for (i=0; i<schema->numAttr; i++)
+		{
+			td->columnOffsets[i]= PAX_ALIGN(end);
+			end= td->columnOffsets[i] + (td->slotsPerPage*schema->typeLength[i]);
+		}
+		return end;
+	}
+
+	/*
+	 * function readSlot:
+	 *
+	 * Copies the tuple of a slot into data; slots points to the slot area
+	 * of the page. With the PAX layout the attributes are gathered from
+	 * their minipages.
+	 */
+
+	void readSlot(RM_MgmtData_Table *td, Schema *schema, char *slots, int slot, char *data)
+	{
+		int i;
+
+		if (td->layout == RM_LAYOUT_ROW)
+		{
+			memcpy(data, slots + (slot*td->slotSize) + 1, schema->recordSize); // +1 for TOMBSTONE
+			return;
+		}
+		for (i=0; i<schema->numAttr; i++)
+			memcpy(data + schema->attrOffsets[i], slots + td->columnOffsets[i] + (slot*schema->typeLength[i]),
+					schema->typeLength[i]);
+	}
+
+	/*
+	 * function writeSlot:
+	 *
+	 * Copies a tuple into a slot, scattering its attributes to their
+	 * minipages with the PAX layout. The TOMBSTONE is left to the caller.
+	 */
+
+	void writeSlot(RM_MgmtData_Table *td, Schema *schema, char *slots, int slot, char *data)
+	{
+		int i;
+
+		if (td->layout == RM_LAYOUT_ROW)
+		{
+			memcpy(slots + (slot*td->slotSize) + 1, data, schema->recordSize); // +1 for TOMBSTONE
+			return;
+		}
+		for (i=0; i<schema->numAttr; i++)
+			memcpy(slots + td->columnOffsets[i] + (slot*schema->typeLength[i]), data + schema->attrOffsets[i],
+					schema->typeLength[i]);
+	}
+
+	/*
+	 * function initSlotLayout:
+	 *
+	 * Derives the slots of the data pages from the schema and the layout.
+	 * Compressed pages are decoded into PAX pages of RM_COMPRESSED_SLOTS slots.
+	 */
+
+	void initSlotLayout(RM_MgmtData_Table *td, Schema *schema)
+	{
+		td->slotSize= schema->recordSize+1; // +1 byte for TOMBSTONE
+		td->slotsPerPage= REC_SZ/td->slotSize;
+		td->tombStride= td->slotSize;
+		td->decodedSize= 0;
+		free(td->columnOffsets);
+		td->columnOffsets= NULL;
+		if (td->compressed)
+		{
+			td->layout= RM_LAYOUT_PAX;
+			td->tombStride= 1;
+			td->slotsPerPage= RM_COMPRESSED_SLOTS;
+			td->columnOffsets= (int*) malloc(sizeof(int)*schema->numAttr);
+			td->decodedSize= initPaxLayout(td, schema);
+		}
+		else if (td->layout == RM_LAYOUT_PAX)
+		{
+			// TOMBSTONES first, then a minipage per attribute; aligning them may cost a few slots
+			td->tombStride= 1;
+			td->columnOffsets= (int*) malloc(sizeof(int)*schema->numAttr);
+			while (initPaxLayout(td, schema) > REC_SZ)
+				td->slotsPerPage--;
+		}
+	}
+
+	/*
+	 * function initDecoder:
+	 */
+
+	void initDecoder(RM_MgmtData_Table *td, RM_PageDecoder *dec)
+	{
+		dec->buf= td->compressed ? (char*) malloc(td->decodedSize) : NULL;
+		dec->page= -1;
+		dec->numSlots= 0;
+	}
+
+	/*
+	 * function pageSlots:
+	 *
+	 * Returns the slot area of a pinned data page and its number of slots.
+	 * Compressed pages are decoded into dec, unless it holds the page already.
+	 */
+
+	char *pageSlots(RM_MgmtData_Table *td, Schema *schema, RM_PageDecoder *dec, RM_ScanTuple *dataPtr, int page, int *numSlots)
+	{
+		if (!td->compressed)
+		{
+			*numSlots= td->slotsPerPage;
+			return (char*) &dataPtr->data;
+		}
+		if (dec->page != page)
+		{
+			dec->numSlots= decodePage(td, schema, (char*) &dataPtr->data, dec->buf);
+			dec->page= page;
+		}
+		*numSlots= dec->numSlots;
+		return dec->buf;
+	}
+
+	// Bits needed for values up to v
+	static int bitWidth(uint32_t v)
+	{
+		return (v == 0) ? 0 : 32-__builtin_clz(v);
+	}
+
+	// Bit-packed values: value i takes bits [i*bits, (i+1)*bits) of the data
+	static void putBits(char *data, long pos, uint32_t v)
+	{
+		uint64_t word;
+
+		memcpy(&word, data + (pos/8), sizeof(uint64_t));
+		word |= ((uint64_t) v) << (pos%8);
+		memcpy(data + (pos/8), &word, sizeof(uint64_t));
+	}
+
+	static uint32_t getBits(char *data, long pos, int bits)
+	{
+		uint64_t word;
+
+		memcpy(&word, data + (pos/8), sizeof(uint64_t));
+		return (uint32_t) ((word >> (pos%8)) & ((((uint64_t) 1) << bits) - 1));
+	}
+
+	/*
+	 * function decodePage:
+	 *
+	 * Decodes the slot area of a compressed page into a PAX page of
+	 * td->slotsPerPage slots, returning the number of tuples.
+	 */
+
+	int decodePage(RM_MgmtData_Table *td, Schema *schema, char *in, char *out)
+	{
+		RM_EncodedColumn *cols= (RM_EncodedColumn*) (in + sizeof(int));
+		int n= *(int*)in;
+		char *col, *data;
+		RM_Run run;
+		int a, i, j, len;
+
+		memset(out, 1, n); // TOMBSTONES
+		memset(out + n, 0, td->slotsPerPage - n);
+		for (a=0; a<schema->numAttr; a++)
+		{
+			col= out + td->columnOffsets[a];
+			data= in + cols[a].offset;
+			len= schema->typeLength[a];
+			switch (cols[a].encoding)
+			{
+				case RM_ENC_FOR:
+				{
+					int *values= (int*) col; // minipages are 8 byte aligned
+					for (i=0; i<n; i++)
+						values[i]= cols[a].base + (int) ((cols[a].bits == 0) ? 0 : getBits(data, (long) i*cols[a].bits, cols[a].bits));
+					break;
+				}
+				case RM_ENC_DICT:
+					for (i=0; i<n; i++)
+						memcpy(col + (i*len), data + (getBits(data + (cols[a].numEntries*len), (long) i*cols[a].bits, cols[a].bits)*len), len);
+					break;
+				case RM_ENC_RLE:
+					for (i=0, j=0; j<cols[a].numEntries; j++)
+					{
+						memcpy(&run, data + (j*sizeof(RM_Run)), sizeof(RM_Run));
+						for (; run.length > 0; run.length--, i++)
+							memcpy(col + (i*len), &run.value, len);
+					}
+					break;
+				default:
+					memcpy(col, data, n*len);
+			}
+		}
+		return n;
+	}
+
+	/*
+	 * function initBuilder:
+	 */
+
+	void initBuilder(RM_PageBuilder *b, RM_MgmtData_Table *td, Schema *schema, SM_FileHandle *fh, RM_CompressionStats *cs)
+	{
+		int a;
+
+		b->td= td;
+		b->schema= schema;
+		b->numTuples= 0;
+		b->tuples= (char*) malloc(RM_COMPRESSED_SLOTS*schema->recordSize);
+		b->stats= (RM_ColumnStats*) calloc(schema->numAttr, sizeof(RM_ColumnStats));
+		b->next= (RM_ColumnStats*) calloc(schema->numAttr, sizeof(RM_ColumnStats));
+		b->dicts= (char**) calloc(schema->numAttr, sizeof(char*));
+		b->buckets= (int**) calloc(schema->numAttr, sizeof(int*));
+		for (a=0; a<schema->numAttr; a++)
+		{
+			if (schema->dataTypes[a] != DT_STRING)
+				continue;
+			b->dicts[a]= (char*) malloc(RM_DICT_MAX*schema->typeLength[a]);
+			b->buckets[a]= (int*) calloc(RM_DICT_BUCKETS, sizeof(int));
+		}
+		b->fh= fh;
+		b->numPages= 0;
+		b->cs= cs;
+	}
+
+	/*
+	 * function freeBuilder:
+	 */
+
+	void freeBuilder(RM_PageBuilder *b)
+	{
+		int a;
+
+		for (a=0; a<b->schema->numAttr; a++)
+		{
+			free(b->dicts[a]);
+			free(b->buckets[a]);
+		}
+		free(b->dicts);
+		free(b->buckets);
+		free(b->stats);
+		free(b->next);
+		free(b->tuples);
+	}
+
+	/*
+	 * function dictFind:
+	 *
+	 * Index of a value in the page dictionary of a string attribute, -1 if
+	 * it is not in there. With insert set a new value is added.
+	 */
+
+	int dictFind(RM_PageBuilder *b, int attr, char *value, bool insert)
+	{
+		int len= b->schema->typeLength[attr];
+		int *buckets= b->buckets[attr];
+		uint32_t hash= 2166136261u;
+		int i;
+
+		for (i=0; i<len; i++)
+			hash= (hash ^ (unsigned char) value[i]) * 16777619u;
+		for (i= hash & (RM_DICT_BUCKETS-1); buckets[i] != 0; i= (i+1) & (RM_DICT_BUCKETS-1))
+			if (memcmp(b->dicts[attr] + ((buckets[i]-1)*len), value, len) == 0)
+				return buckets[i]-1;
+		if (!insert)
+			return -1;
+		memcpy(b->dicts[attr] + (b->stats[attr].numDistinct*len), value, len);
+		buckets[i]= ++b->stats[attr].numDistinct;
+		return buckets[i]-1;
+	}
+
+	/*
+	 * function columnBytes:
+	 *
+	 * Chooses the encoding of an attribute on a page of numTuples tuples with
+	 * the given statistics and returns its size. Bit-packed data is followed
+	 * by 8 bytes of slack so that getBits can read a whole word.
+	 */
+
+	int columnBytes(Schema *schema, int attr, RM_ColumnStats *stats, int numTuples, int *encoding, int *bits)
+	{
+		int len= schema->typeLength[attr];
+		int plain= numTuples*len;
+		int size;
+
+		*encoding= RM_ENC_PLAIN;
+		*bits= 0;
+		switch (schema->dataTypes[attr])
+		{
+			case DT_INT:
+				*bits= bitWidth((uint32_t) stats->max - (uint32_t) stats->min);
+				size= (int) ((((long) numTuples * *bits) + 7) / 8) + 8;
+				if (size < plain)
+				{
+					*encoding= RM_ENC_FOR;
+					return size;
+				}
+				break;
+			case DT_STRING:
+				if (stats->numDistinct > RM_DICT_MAX)
+					break;
+				*bits= bitWidth(stats->numDistinct-1);
+				size= (stats->numDistinct*len) + (int) ((((long) numTuples * *bits) + 7) / 8) + 8;
+				if (size < plain)
+				{
+					*encoding= RM_ENC_DICT;
+					return size;
+				}
+				break;
+			case DT_BOOL:
+				size= stats->numRuns*sizeof(RM_Run);
+				if (size < plain)
+				{
+					*encoding= RM_ENC_RLE;
+					return size;
+				}
+				break;
+			default:
+				break;
+		}
+		*bits= 0;
+		return plain;
+	}
+
+	/*
+	 * function builderSize:
+	 *
+	 * Bytes of the slot area of a page holding numTuples tuples.
+	 */
+
+	int builderSize(RM_PageBuilder *b, RM_ColumnStats *stats, int numTuples)
+	{
+		int size= sizeof(int) + (b->schema->numAttr*sizeof(RM_EncodedColumn));
+		int a, encoding, bits;
+
+		for (a=0; a<b->schema->numAttr; a++)
+			size += columnBytes(b->schema, a, &stats[a], numTuples, &encoding, &bits);
+		return size;
+	}
+
+	/*
+	 * function builderAdd:
+	 *
+	 * Adds a tuple to the page being compressed, writing the page out first
+	 * if the tuple does not fit anymore.
+	 */
+
+	RC builderAdd(RM_PageBuilder *b, char *tuple)
+	{
+		Schema *schema= b->schema;
+		int n= b->numTuples;
+		char *last= b->tuples + (n*schema->recordSize); // just past the last tuple
+		char *value;
+		RM_ColumnStats *tmp;
+		int a, v;
+		RC rc;
+
+		// Statistics of the page with the tuple
+		for (a=0; a<schema->numAttr; a++)
+		{
+			value= tuple + schema->attrOffsets[a];
+			b->next[a]= b->stats[a];
+			switch (schema->dataTypes[a])
+			{
+				case DT_INT:
+					memcpy(&v, value, sizeof(int));
+					if (n == 0 || v < b->next[a].min)
+						b->next[a].min= v;
+					if (n == 0 || v > b->next[a].max)
+						b->next[a].max= v;
+					break;
+				case DT_STRING:
+					if (b->next[a].numDistinct <= RM_DICT_MAX && dictFind(b, a, value, FALSE) < 0)
+						b->next[a].numDistinct++;
+					break;
+				case DT_BOOL:
+					if (n == 0 || memcmp(last - schema->recordSize + schema->attrOffsets[a], value, sizeof(bool)) != 0)
+						b->next[a].numRuns++;
+					break;
+				default:
+					break;
+			}
+		}
+
+		if (n == RM_COMPRESSED_SLOTS || builderSize(b, b->next, n+1) > REC_SZ)
+		{
+			if ((rc= builderFlush(b)) != RC_OK)
+				return rc;
+			return builderAdd(b, tuple);
+		}
+
+		// New values go into the dictionaries until they overflow
+		for (a=0; a<schema->numAttr; a++)
+			if (schema->dataTypes[a] == DT_STRING && b->next[a].numDistinct > b->stats[a].numDistinct
+					&& b->next[a].numDistinct <= RM_DICT_MAX)
+				dictFind(b, a, tuple + schema->attrOffsets[a], TRUE);
+		tmp= b->stats;
+		b->stats= b->next;
+		b->next= tmp;
+		memcpy(last, tuple, schema->recordSize);
+		b->numTuples++;
+		return RC_OK;
+	}
+
+	/*
+	 * function builderFlush:
+	 *
+	 * Encodes the tuples of the page being compressed and appends the page to the file.
+	 */
+
+	RC builderFlush(RM_PageBuilder *b)
+	{
+		Schema *schema= b->schema;
+		char *slots= (char*) &((RM_ScanTuple*) b->page)->data;
+		RM_EncodedColumn *cols= (RM_EncodedColumn*) (slots + sizeof(int));
+		int n= b->numTuples;
+		int ofst= sizeof(int) + (schema->numAttr*sizeof(RM_EncodedColumn));
+		char *data, *value;
+		RM_Run run;
+		int a, i, v, len;
+		RC rc;
+
+		if (n == 0)
+			return RC_OK;
+
+		memset(b->page, 0, PAGE_SIZE); // no free page links, bit-packed data starts out zero
+		*(int*)slots= n;
+		for (a=0; a<schema->numAttr; a++)
+		{
+			len= schema->typeLength[a];
+			cols[a].offset= ofst;
+			cols[a].base= b->stats[a].min;
+			cols[a].numEntries= 0;
+			ofst += columnBytes(schema, a, &b->stats[a], n, &cols[a].encoding, &cols[a].bits);
+			b->cs->numChunks[cols[a].encoding]++;
+			data= slots + cols[a].offset;
+			switch (cols[a].encoding)
+			{
+				case RM_ENC_FOR:
+					for (i=0; cols[a].bits > 0 && i<n; i++)
+					{
+						memcpy(&v, b->tuples + (i*schema->recordSize) + schema->attrOffsets[a], sizeof(int));
+						putBits(data, (long) i*cols[a].bits, (uint32_t) v - (uint32_t) cols[a].base);
+					}
+					break;
+				case RM_ENC_DICT:
+					cols[a].numEntries= b->stats[a].numDistinct;
+					memcpy(data, b->dicts[a], cols[a].numEntries*len);
+					for (i=0; cols[a].bits > 0 && i<n; i++)
+					{
+						value= b->tuples + (i*schema->recordSize) + schema->attrOffsets[a];
+						putBits(data + (cols[a].numEntries*len), (long) i*cols[a].bits,
+								(uint32_t) dictFind(b, a, value, FALSE));
+					}
+					break;
+				case RM_ENC_RLE:
+					for (i=0; i<n; i++)
+					{
+						value= b->tuples + (i*schema->recordSize) + schema->attrOffsets[a];
+						if (i > 0 && memcmp(&run.value, value, sizeof(bool)) == 0)
+						{
+							run.length++;
+							continue;
+						}
+						if (i > 0)
+							memcpy(data + ((cols[a].numEntries++)*sizeof(RM_Run)), &run, sizeof(RM_Run));
+						memset(&run, 0, sizeof(RM_Run));
+						run.length= 1;
+						memcpy(&run.value, value, sizeof(bool));
+					}
+					memcpy(data + ((cols[a].numEntries++)*sizeof(RM_Run)), &run, sizeof(RM_Run));
+					break;
+				default:
+					for (i=0; i<n; i++)
+						memcpy(data + (i*len), b->tuples + (i*schema->recordSize) + schema->attrOffsets[a], len);
+			}
+		}
+
+		if ((rc= writeBlock(++b->numPages, b->fh, b->page)) != RC_OK)
+			return rc;
+
+		// Start an empty page
+		b->numTuples= 0;
+		memset(b->stats, 0, sizeof(RM_ColumnStats)*schema->numAttr);
+		for (a=0; a<schema->numAttr; a++)
+			if (b->buckets[a] != NULL)
+				memset(b->buckets[a], 0, sizeof(int)*RM_DICT_BUCKETS);
+		return RC_OK;
+	}
+
+	/*
+	 * function zoneKey:
+	 *
+	 * Order preserving key of a value: ints and floats with the sign bit
+	 * flipped (all bits of negative floats), strings by their first 8
+	 * characters. Keys of strings only bound the values: equal keys may
+	 * belong to different strings.
+	 */
+
+	uint64_t zoneKey(DataType dt, int len, char *value)
+	{
+		uint64_t key= 0;
+		uint32_t bits;
+		float f;
+		bool b;
+		int i;
+
+		switch (dt)
+		{
+			case DT_INT:
+				memcpy(&bits, value, sizeof(uint32_t));
+				return bits ^ 0x80000000u;
+			case DT_FLOAT:
+				memcpy(&f, value, sizeof(float));
+				if (f == 0)
+					f= 0; // -0 equals 0
+				memcpy(&bits, &f, sizeof(uint32_t));
+				return (bits & 0x80000000u) ? ~bits : bits | 0x80000000u;
+			case DT_BOOL:
+				memcpy(&b, value, sizeof(bool));
+				return b != 0;
+			default:
+				for (i=0; i<8 && i<len && value[i] != '\0'; i++)
+					key |= ((uint64_t) (unsigned char) value[i]) << (56 - (8*i));
+				return key;
+		}
+	}
+
+	// Key of a constant, see zoneKey
+	static uint64_t constKey(Value *v)
+	{
+		if (v->dt == DT_STRING)
+			return zoneKey(DT_STRING, strlen(v->v.stringV), v->v.stringV);
+		return zoneKey(v->dt, sizeof(v->v), (char*) &v->v);
+	}
+
+	/*
+	 * function ensureZones:
+	 *
+	 * Grows the zone map to cover page, new pages start out empty.
+	 */
+
+	void ensureZones(RM_MgmtData_Table *td, int numAttr, int page)
+	{
+		int cap= td->zoneCap;
+		int i;
+
+		if (page < cap)
+			return;
+		while (td->zoneCap <= page)
+			td->zoneCap= (td->zoneCap < 64) ? 64 : td->zoneCap*2;
+		td->zones= (RM_Zone*) realloc(td->zones, sizeof(RM_Zone)*numAttr*td->zoneCap);
+		td->zoneLive= (int*) realloc(td->zoneLive, sizeof(int)*td->zoneCap);
+		for (i=cap*numAttr; i<td->zoneCap*numAttr; i++)
+		{
+			td->zones[i].min= UINT64_MAX;
+			td->zones[i].max= 0;
+		}
+		memset(td->zoneLive + cap, 0, sizeof(int)*(td->zoneCap-cap));
+	}
+
+	/*
+	 * function zoneAdd:
+	 *
+	 * Widens the zones of a page to the values of a tuple written to it.
+	 * Zones never shrink, deleted and overwritten values stay covered.
+	 */
+
+	void zoneAdd(RM_MgmtData_Table *td, Schema *schema, int page, char *data, bool newTuple)
+	{
+		RM_Zone *zone;
+		uint64_t key;
+		int a;
+
+		ensureZones(td, schema->numAttr, page);
+		zone= td->zones + (page*schema->numAttr);
+		for (a=0; a<schema->numAttr; a++)
+		{
+			key= zoneKey(schema->dataTypes[a], schema->typeLength[a], data + schema->attrOffsets[a]);
+			if (key < zone[a].min)
+				zone[a].min= key;
+			if (key > zone[a].max)
+				zone[a].max= key;
+		}
+		if (newTuple)
+			td->zoneLive[page]++;
+	}
+
+	/*
+	 * function skipPage:
+	 *
+	 * Tells whether a scan can skip a page because it holds no live tuple
+	 * or by its zone map or bloom filters, counting skipped pages in stats
+	 * (unless NULL).
+	 */
+
+	bool skipPage(RM_MgmtData_Table *td, Schema *schema, Expr *cond, int page, RM_ScanStats *stats)
+	{
+		if (page < td->zoneCap && td->zoneLive[page] == 0) // Empty page, the zone map counts live tuples
+		{
+			if (stats != NULL)
+				stats->pagesSkipped++;
+			return TRUE;
+		}
+		if (!pageMayMatch(td, schema, cond, page, FALSE))
+		{
+			if (stats != NULL)
+				stats->pagesSkipped++;
+			return TRUE;
+		}
+		if (td->blooms != NULL && !pageMayMatch(td, schema, cond, page, TRUE))
+		{
+			if (stats != NULL)
+			{
+				stats->pagesSkipped++;
+				stats->bloomSkipped++;
+			}
+			return TRUE;
+		}
+		return FALSE;
+	}
+
+	/*
+	 * function pageMayMatch:
+	 *
+	 * Tells from the zone map whether tuples on a page may match cond.
+	 * Comparisons of an attribute with constants, BETWEEN, IN and prefix
+	 * matches are checked against the min and max of the attribute and
+	 * AND and OR combine them; any other condition may match. With useBloom
+	 * equality and IN also probe the bloom filter of the attribute, if any.
+	 */
+
+	bool pageMayMatch(RM_MgmtData_Table *td, Schema *schema, Expr *cond, int page, bool useBloom)
+	{
+		Operator *op;
+		Expr *attr;
+		Value *cons;
+		RM_Zone *zone;
+		RM_BloomFilter *bf= NULL;
+		uint64_t key, upper;
+		OpType type;
+		bool exact;
+		int a, i, len;
+
+		if (cond == NULL || cond->type != EXPR_OP || page >= td->zoneCap)
+			return TRUE;
+		op= cond->expr.op;
+		if (op->type == OP_BOOL_AND)
+			return pageMayMatch(td, schema, op->args[0], page, useBloom) && pageMayMatch(td, schema, op->args[1], page, useBloom);
+		if (op->type == OP_BOOL_OR)
+			return pageMayMatch(td, schema, op->args[0], page, useBloom) || pageMayMatch(td, schema, op->args[1], page, useBloom);
+		if (op->type == OP_BOOL_NOT || op->numArgs < 2)
+			return TRUE;
+
+		// Attribute first, turning constant < attribute into attribute > constant
+		attr= op->args[0];
+		cons= (op->args[1]->type == EXPR_CONST) ? op->args[1]->expr.cons : NULL;
+		type= op->type;
+		if (op->numArgs == 2 && attr->type == EXPR_CONST && op->args[1]->type == EXPR_ATTRREF && type != OP_COMP_PREFIX)
+		{
+			cons= attr->expr.cons;
+			attr= op->args[1];
+			if (type == OP_COMP_SMALLER)
+				type= OP_COMP_GREATER;
+			else if (type == OP_COMP_GREATER)
+				type= OP_COMP_SMALLER;
+			else if (type == OP_COMP_SMALLER_EQUAL)
+				type= OP_COMP_GREATER_EQUAL;
+			else if (type == OP_COMP_GREATER_EQUAL)
+				type= OP_COMP_SMALLER_EQUAL;
+		}
+		if (attr->type != EXPR_ATTRREF || attr->expr.attrRef < 0 || attr->expr.attrRef >= schema->numAttr)
+			return TRUE;
+		a= attr->expr.attrRef;
+		if (cons == NULL || cons->dt != schema->dataTypes[a])
+			return TRUE;
+		for (i=2; i<op->numArgs; i++) // BETWEEN and IN
+			if (op->args[i]->type != EXPR_CONST || op->args[i]->expr.cons->dt != schema->dataTypes[a])
+				return TRUE;
+
+		zone= td->zones + (page*schema->numAttr) + a;
+		if (zone->min > zone->max)
+			return FALSE; // No tuple was ever on the page
+		if (useBloom)
+			for (bf= td->blooms; bf != NULL && bf->attrNum != a; bf= bf->next);
+		exact= schema->dataTypes[a] != DT_STRING;
+		key= constKey(cons);
+		switch (type)
+		{
+			case OP_COMP_EQUAL:
+				return zone->min <= key && key <= zone->max && bloomMayContain(bf, page, constHash(cons, schema->typeLength[a]));
+			case OP_COMP_SMALLER:
+				return exact ? zone->min < key : zone->min <= key;
+			case OP_COMP_SMALLER_EQUAL:
+				return zone->min <= key;
+			case OP_COMP_GREATER:
+				return exact ? zone->max > key : zone->max >= key;
+			case OP_COMP_GREATER_EQUAL:
+				return zone->max >= key;
+			case OP_COMP_NOT_EQUAL:
+				return !exact || zone->min != key || zone->max != key;
+			case OP_COMP_BETWEEN:
+				return zone->max >= key && zone->min <= constKey(op->args[2]->expr.cons);
+			case OP_COMP_IN:
+				for (i=1; i<op->numArgs; i++)
+				{
+					key= constKey(op->args[i]->expr.cons);
+					if (zone->min <= key && key <= zone->max
+							&& bloomMayContain(bf, page, constHash(op->args[i]->expr.cons, schema->typeLength[a])))
+						return TRUE;
+				}
+				return FALSE;
+			case OP_COMP_PREFIX:
+				// Strings starting with the prefix have keys from key to key with the rest of the 8 bytes set
+				len= strlen(cons->v.stringV);
+				upper= (len >= 8) ? key : key | ((((uint64_t) 1) << (64 - (8*len))) - 1);
+				return zone->max >= key && zone->min <= upper;
+			default:
+				return TRUE;
+		}
+	}
+
+	/*
+	 * function rebuildZones:
+	 *
+	 * Computes the zone map from the live tuples of all data pages.
+	 */
+
+	void rebuildZones(RM_MgmtData_Table *td, Schema *schema)
+	{
+		BM_MgmtData *bm= td->bm.mgmtData;
+		BM_PageHandle h;
+		char *tuple= (char*) malloc(schema->recordSize);
+		char *slots;
+		int page, slot, numSlots;
+
+		free(td->zones);
+		free(td->zoneLive);
+		td->zones= NULL;
+		td->zoneLive= NULL;
+		td->zoneCap= 0;
+		ensureZones(td, schema->numAttr, bm->fHandle.totalNumPages);
+		for (page=1; page<bm->fHandle.totalNumPages; page++)
+		{
+			pinPage(&td->bm, &h, (PageNumber)page);
+			slots= pageSlots(td, schema, &td->decoder, (RM_ScanTuple*) h.data, page, &numSlots);
+			for (slot=0; slot<numSlots; slot++)
+			{
+				if (*TOMBSTONE(td, slots, slot) > 0)
+				{
+					readSlot(td, schema, slots, slot, tuple);
+					zoneAdd(td, schema, page, tuple, TRUE);
+				}
+			}
+			unpinPage(&td->bm, &h);
+		}
+		free(tuple);
+	}
+
+	/*
+	 * function sideFile:
+	 *
+	 * Name of a page file kept next to a table: its zone map (.zm) or
+	 * the RIDs of moved tuples (.rid).
+	 */
+
+	char *sideFile(char *name, char *suffix)
+	{
+		char *file= (char*) malloc(strlen(name)+strlen(suffix)+1);
+
+		sprintf(file, "%s%s", name, suffix);
+		return file;
+	}
+
+	/*
+	 * function saveZones:
+	 *
+	 * Writes the zone map to its page file: the number of pages and
+	 * attributes and the tuple count of the table, the live tuples of every
+	 * page and the zones.
+	 */
+
+	RC saveZones(RM_MgmtData_Table *td, RM_TableData *rel)
+	{
+		BM_MgmtData *bm= td->bm.mgmtData;
+		int numPages= bm->fHandle.totalNumPages;
+		int numAttr= rel->schema->numAttr;
+		long size= (3*sizeof(int)) + (numPages*sizeof(int)) + (numPages*numAttr*sizeof(RM_Zone));
+		int numBlocks= (size + PAGE_SIZE - 1) / PAGE_SIZE;
+		char *file= sideFile(rel->name, ".zm");
+		char *buf, *ofst;
+		SM_FileHandle fh;
+		int i;
+		RC rc;
+
+		ensureZones(td, numAttr, numPages);
+		buf= (char*) calloc(numBlocks, PAGE_SIZE);
+		ofst= buf;
+		*(int*)ofst= numPages;
+		ofst = ofst + sizeof(int);
+		*(int*)ofst= numAttr;
+		ofst = ofst + sizeof(int);
+		*(int*)ofst= td->recCnt;
+		ofst = ofst + sizeof(int);
+		memcpy(ofst, td->zoneLive, numPages*sizeof(int));
+		ofst = ofst + (numPages*sizeof(int));
+		memcpy(ofst, td->zones, numPages*numAttr*sizeof(RM_Zone));
+
+		rc= createPageFile(file);
+		if (rc == RC_OK)
+			rc= openPageFile(file, &fh);
+		for (i=0; rc == RC_OK && i<numBlocks; i++)
+			rc= writeBlock(i, &fh, buf + (i*PAGE_SIZE));
+		if (rc == RC_OK)
+			closePageFile(&fh);
+		free(buf);
+		free(file);
+		return rc;
+	}
+
+	/*
+	 * function loadZones:
+	 *
+	 * Reads the zone map written by saveZones, failing if it does not
+	 * match the table.
+	 */
+
+	RC loadZones(RM_MgmtData_Table *td, RM_TableData *rel)
+	{
+		BM_MgmtData *bm= td->bm.mgmtData;
+		int numPages= bm->fHandle.totalNumPages;
+		int numAttr= rel->schema->numAttr;
+		long size= (3*sizeof(int)) + (numPages*sizeof(int)) + (numPages*numAttr*sizeof(RM_Zone));
+		int numBlocks= (size + PAGE_SIZE - 1) / PAGE_SIZE;
+		char *file= sideFile(rel->name, ".zm");
+		char *buf, *ofst;
+		SM_FileHandle fh;
+		int i;
+		RC rc;
+
+		rc= openPageFile(file, &fh);
+		free(file);
+		if (rc != RC_OK)
+			return rc;
+		buf= (char*) malloc(numBlocks*PAGE_SIZE);
+		rc= readBlock(0, &fh, buf);
+		if (rc == RC_OK && (((int*)buf)[0] != numPages || ((int*)buf)[1] != numAttr || ((int*)buf)[2] != td->recCnt
+				|| fh.totalNumPages < numBlocks))
+			rc= RC_READ_NON_EXISTING_PAGE; // Stale
+		for (i=1; rc == RC_OK && i<numBlocks; i++)
+			rc= readBlock(i, &fh, buf + (i*PAGE_SIZE));
+		closePageFile(&fh);
+
+		if (rc == RC_OK)
+		{
+			ensureZones(td, numAttr, numPages);
+			ofst= buf + (3*sizeof(int));
+			memcpy(td->zoneLive, ofst, numPages*sizeof(int));
+			ofst = ofst + (numPages*sizeof(int));
+			memcpy(td->zones, ofst, numPages*numAttr*sizeof(RM_Zone));
+		}
+		free(buf);
+		return rc;
+	}
+
+	//########## BLOOM FILTERS ##########
+
+	/*
+	 * function createBloomFilter:
+	 *
+	 * Adds bloom filters on an attribute, one per data page with
+	 * RM_BLOOM_BITS_PER_KEY bits per slot, built from the pages. They are
+	 * kept in memory until the table is closed.
+	 */
+	RC createBloomFilter (RM_TableData *rel, int attrNum)
+	{
+		RM_MgmtData_Table *td= (RM_MgmtData_Table*) rel->mgmtData;
+		RM_BloomFilter *bf;
+
+		if (attrNum < 0 || attrNum >= rel->schema->numAttr)
+			return RC_RM_UNKOWN_DATATYPE;
+		for (bf= td->blooms; bf != NULL; bf= bf->next)
+			if (bf->attrNum == attrNum)
+				return RC_OK;
+
+		bf= (RM_BloomFilter*) malloc(sizeof(RM_BloomFilter));
+		bf->attrNum= attrNum;
+		bf->words= ((td->slotsPerPage*RM_BLOOM_BITS_PER_KEY) + 63) / 64;
+		bf->cap= 0;
+		bf->bits= NULL;
+		bf->stale= NULL;
+		buildBlooms(td, rel->schema, bf);
+		bf->next= td->blooms;
+		td->blooms= bf;
+		return RC_OK;
+	}
+
+	/*
+	 * function dropBloomFilter:
+	 */
+	RC dropBloomFilter (RM_TableData *rel, int attrNum)
+	{
+		RM_MgmtData_Table *td= (RM_MgmtData_Table*) rel->mgmtData;
+		RM_BloomFilter **link, *bf;
+
+		for (link= &td->blooms; *link != NULL; link= &(*link)->next)
+		{
+			if ((*link)->attrNum == attrNum)
+			{
+				bf= *link;
+				*link= bf->next;
+				free(bf->bits);
+				free(bf->stale);
+				free(bf);
+				return RC_OK;
+			}
+		}
+		return RC_OK;
+	}
+
+	/*
+	 * function bloomHash:
+	 *
+	 * 64 bit FNV-1a hash of a value, strings up to their end within len
+	 * characters and floats with -0 as 0, so equal values hash alike.
+	 */
+
+	uint64_t bloomHash(DataType dt, int len, char *value)
+	{
+		uint64_t hash= 14695981039346656037ull;
+		float f;
+		bool b;
+		int i;
+
+		switch (dt)
+		{
+			case DT_INT:
+				len= sizeof(int);
+				break;
+			case DT_FLOAT:
+				memcpy(&f, value, sizeof(float));
+				if (f == 0)
+					f= 0;
+				value= (char*) &f;
+				len= sizeof(float);
+				break;
+			case DT_BOOL:
+				memcpy(&b, value, sizeof(bool));
+				b= b != 0;
+				value= (char*) &b;
+				len= sizeof(bool);
+				break;
+			default:
+				for (i=0; i<len && value[i] != '\0'; i++);
+				len= i;
+				break;
+		}
+		for (i=0; i<len; i++)
+		{
+			hash ^= (unsigned char) value[i];
+			hash *= 1099511628211ull;
+		}
+		return hash;
+	}
+
+	// Hash of a constant compared with an attribute of length len
+	static uint64_t constHash(Value *v, int len)
+	{
+		if (v->dt == DT_STRING)
+			return bloomHash(DT_STRING, len, v->v.stringV);
+		return bloomHash(v->dt, len, (char*) &v->v);
+	}
+
+	// Sets (probes) the RM_BLOOM_HASHES bits of a hash, derived from its two halves
+	static void bloomSet(RM_BloomFilter *bf, int page, uint64_t hash)
+	{
+		uint64_t *bits= bf->bits + ((long) page*bf->words);
+		uint32_t h1= (uint32_t) hash, h2= (uint32_t) (hash >> 32) | 1;
+		uint32_t bit;
+		int i;
+
+		for (i=0; i<RM_BLOOM_HASHES; i++)
+		{
+			bit= (h1 + (i*h2)) % (bf->words*64);
+			bits[bit/64] |= ((uint64_t) 1) << (bit%64);
+		}
+	}
+
+	static bool bloomMayContain(RM_BloomFilter *bf, int page, uint64_t hash)
+	{
+		uint64_t *bits;
+		uint32_t h1= (uint32_t) hash, h2= (uint32_t) (hash >> 32) | 1;
+		uint32_t bit;
+		int i;
+
+		if (bf == NULL || page >= bf->cap)
+			return TRUE;
+		bits= bf->bits + ((long) page*bf->words);
+		for (i=0; i<RM_BLOOM_HASHES; i++)
+		{
+			bit= (h1 + (i*h2)) % (bf->words*64);
+			if (!(bits[bit/64] & (((uint64_t) 1) << (bit%64))))
+				return FALSE;
+		}
+		return TRUE;
+	}
+
+	// Grows the filters to cover page, new pages start out empty
+	static void bloomEnsure(RM_BloomFilter *bf, int page)
+	{
+		int cap= bf->cap;
+
+		if (page < cap)
+			return;
+		while (bf->cap <= page)
+			bf->cap= (bf->cap < 64) ? 64 : bf->cap*2;
+		bf->bits= (uint64_t*) realloc(bf->bits, sizeof(uint64_t)*bf->words*bf->cap);
+		bf->stale= (int*) realloc(bf->stale, sizeof(int)*bf->cap);
+		memset(bf->bits + ((long) cap*bf->words), 0, sizeof(uint64_t)*bf->words*(bf->cap-cap));
+		memset(bf->stale + cap, 0, sizeof(int)*(bf->cap-cap));
+	}
+
+	/*
+	 * function bloomAdd:
+	 *
+	 * Adds the values of a tuple written to a page to the filters of the
+	 * page. Overwritten values stay in them until the page is rebuilt.
+	 */
+
+	void bloomAdd(RM_MgmtData_Table *td, Schema *schema, int page, char *data, bool newTuple)
+	{
+		RM_BloomFilter *bf;
+		int a;
+
+		for (bf= td->blooms; bf != NULL; bf= bf->next)
+		{
+			a= bf->attrNum;
+			bloomEnsure(bf, page);
+			bloomSet(bf, page, bloomHash(schema->dataTypes[a], schema->typeLength[a], data + schema->attrOffsets[a]));
+			if (!newTuple)
+				bf->stale[page]++;
+		}
+	}
+
+	/*
+	 * function bloomDelete:
+	 *
+	 * Notes a deleted tuple, its value stays in the filters of the page
+	 * until a scan reads the page again and rebuilds them.
+	 */
+
+	void bloomDelete(RM_MgmtData_Table *td, int page)
+	{
+		RM_BloomFilter *bf;
+
+		for (bf= td->blooms; bf != NULL; bf= bf->next)
+			if (page < bf->cap)
+				bf->stale[page]++;
+	}
+
+	/*
+	 * function buildBloomPage:
+	 *
+	 * Builds the filter of a page from the live tuples in its slots.
+	 */
+
+	void buildBloomPage(RM_MgmtData_Table *td, Schema *schema, RM_BloomFilter *bf, int page, char *slots, int numSlots)
+	{
+		int a= bf->attrNum;
+		char *value;
+		int slot;
+
+		bloomEnsure(bf, page);
+		memset(bf->bits + ((long) page*bf->words), 0, sizeof(uint64_t)*bf->words);
+		for (slot=0; slot<numSlots; slot++)
+		{
+			if (*TOMBSTONE(td, slots, slot) > 0)
+			{
+				if (td->layout == RM_LAYOUT_ROW)
+					value= slots + (slot*td->slotSize) + 1 + schema->attrOffsets[a]; // +1 for TOMBSTONE
+				else
+					value= slots + td->columnOffsets[a] + (slot*schema->typeLength[a]);
+				bloomSet(bf, page, bloomHash(schema->dataTypes[a], schema->typeLength[a], value));
+			}
+		}
+		bf->stale[page]= 0;
+	}
+
+	/*
+	 * function refreshBlooms:
+	 *
+	 * Rebuilds the filters of a page a scan has pinned if tuples were
+	 * deleted or overwritten since they were built.
+	 */
+
+	void refreshBlooms(RM_MgmtData_Table *td, Schema *schema, int page, char *slots, int numSlots)
+	{
+		RM_BloomFilter *bf;
+
+		for (bf= td->blooms; bf != NULL; bf= bf->next)
+			if (page < bf->cap && bf->stale[page] > 0)
+				buildBloomPage(td, schema, bf, page, slots, numSlots);
+	}
+
+	/*
+	 * function buildBlooms:
+	 *
+	 * Builds the filters of all data pages.
+	 */
+
+	void buildBlooms(RM_MgmtData_Table *td, Schema *schema, RM_BloomFilter *bf)
+	{
+		BM_MgmtData *bm= td->bm.mgmtData;
+		BM_PageHandle h;
+		char *slots;
+		int page, numSlots;
+
+		bf->words= ((td->slotsPerPage*RM_BLOOM_BITS_PER_KEY) + 63) / 64;
+		free(bf->bits);
+		free(bf->stale);
+		bf->bits= NULL;
+		bf->stale= NULL;
+		bf->cap= 0;
+		bloomEnsure(bf, bm->fHandle.totalNumPages);
+		for (page=1; page<bm->fHandle.totalNumPages; page++)
+		{
+			pinPage(&td->bm, &h, (PageNumber)page);
+			slots= pageSlots(td, schema, &td->decoder, (RM_ScanTuple*) h.data, page, &numSlots);
+			buildBloomPage(td, schema, bf, page, slots, numSlots);
+			unpinPage(&td->bm, &h);
+		}
+	}
+
+
+	//########## COMPACTION ##########
+
+	// Orders RIDs, and RM_RidMaps by their old RID
+	static int cmpRid(const void *a, const void *b)
+	{
+		const RID *l= a;
+		const RID *r= b;
+
+		if (l->page != r->page)
+			return (l->page < r->page) ? -1 : 1;
+		if (l->slot != r->slot)
+			return (l->slot < r->slot) ? -1 : 1;
+		return 0;
+	}
+
+	/*
+	 * function compactTable:
+	 *
+	 * Moves the live tuples of the pages at the end of the table into free
+	 * slots of the pages before them, a page at a time, and truncates the
+	 * emptied pages off the page file. At most maxPages pages are emptied
+	 * per call (all if maxPages <= 0), so a large table can be compacted in
+	 * steps between other operations; no scan may be open during a call.
+	 * The old RIDs of moved tuples stay valid for the record functions
+	 * through a remap table, see resolveRid. If a page cannot be pinned,
+	 * the tuples moved so far stay moved and the error is returned.
+	 * Source and target are marked dirty when unpinned: removeFreePage may
+	 * pin one as the neighbour of the other and write it through meanwhile.
+	 */
+	RC compactTable (RM_TableData *rel, int maxPages, RM_CompactionStats *stats)
+	{
+		RM_MgmtData_Table *td= rel->mgmtData;
+		BM_MgmtData *bm= td->bm.mgmtData;
+		Schema *schema= rel->schema;
+		BM_PageHandle srcH, dstH;
+		RM_ScanTuple *srcPtr, *dstPtr= NULL;
+		RM_BloomFilter *bf;
+		RM_RidMap *moved, *merged, *entry;
+		char *tuple, *tomb;
+		int *reserved; //RM_MOVED slots per page.
+		long freeSlots= 0; //Free slots on the pages dst to src-1.
+		int numPages= bm->fHandle.totalNumPages;
+		int numOld= td->numRemap;
+		int src= numPages-1;
+		int dst= 1;
+		int page, slot, dstSlot, live, i, j, k;
+		RC rc= RC_OK, truncRc;
+
+		memset(stats, 0, sizeof(RM_CompactionStats));
+		stats->pagesBefore= numPages;
+		stats->pagesAfter= numPages;
+		if (td->compressed)
+			return RC_RM_READ_ONLY;
+		if (numPages <= 2)
+			return RC_OK;
+
+		// Free slots per page from the live tuples of the zone map and the reserved slots
+		ensureZones(td, schema->numAttr, numPages);
+		reserved= (int*) calloc(numPages, sizeof(int));
+		for (i=0; i<td->numRemap; i++)
+			if (td->remap[i].from.page < numPages)
+				reserved[td->remap[i].from.page]++;
+		for (page=dst; page<src; page++)
+			freeSlots += td->slotsPerPage - td->zoneLive[page] - reserved[page];
+
+		tuple= (char*) malloc(schema->recordSize);
+		td->remap= (RM_RidMap*) realloc(td->remap, sizeof(RM_RidMap)*(numOld+td->recCnt)); // Every tuple moves at most once
+		while (src > dst && (maxPages <= 0 || stats->pagesMoved < maxPages) && td->zoneLive[src] <= freeSlots)
+		{
+			if ((rc= pinPage(&td->bm, &srcH, (PageNumber)src)) != RC_OK)
+				break;
+			srcPtr= (RM_ScanTuple*) srcH.data;
+			live= td->zoneLive[src];
+			for (slot=0; slot<td->slotsPerPage && live > 0; slot++)
+			{
+				tomb= TOMBSTONE(td, (char*) &srcPtr->data, slot);
+				if (*tomb <= 0)
+					continue;
+
+				// First page before src with a free slot
+				while (dstPtr == NULL || (dstSlot= findFreeSlot(dstPtr, td)) == -1)
+				{
+					if (dstPtr != NULL)
+					{
+						rc= removeFreePage(td, dstPtr, dst);
+						markDirty(&td->bm, &dstH);
+						unpinPage(&td->bm, &dstH);
+						dstPtr= NULL;
+						if (rc != RC_OK)
+							break;
+						dst++;
+					}
+					if ((rc= pinPage(&td->bm, &dstH, (PageNumber)dst)) != RC_OK)
+						break;
+					dstPtr= (RM_ScanTuple*) dstH.data;
+				}
+				if (rc != RC_OK)
+					break;
+
+				readSlot(td, schema, (char*) &srcPtr->data, slot, tuple);
+				writeSlot(td, schema, (char*) &dstPtr->data, dstSlot, tuple);
+				*TOMBSTONE(td, (char*) &dstPtr->data, dstSlot)= 1;
+				zoneAdd(td, schema, dst, tuple, TRUE);
+				bloomAdd(td, schema, dst, tuple, TRUE);
+				*tomb= RM_MOVED; // Reserved if the page is kept after an error
+
+				entry= td->remap + td->numRemap++;
+				entry->from.page= src;
+				entry->from.slot= slot;
+				entry->to.page= dst;
+				entry->to.slot= dstSlot;
+				freeSlots--;
+				live--;
+				stats->tuplesMoved++;
+			}
+
+			// The emptied page leaves the Free Page Linked List
+			if (rc == RC_OK)
+				rc= removeFreePage(td, srcPtr, src);
+			markDirty(&td->bm, &srcH);
+			unpinPage(&td->bm, &srcH);
+			if (rc != RC_OK)
+			{
+				// The page stays, with the tuples not moved yet
+				td->zoneLive[src]= live;
+				break;
+			}
+			td->zoneLive[src]= 0;
+			stats->pagesMoved++;
+			src--;
+			if (src > dst)
+				freeSlots -= td->slotsPerPage - td->zoneLive[src] - reserved[src];
+		}
+		if (dstPtr != NULL)
+		{
+			if (rc == RC_OK && findFreeSlot(dstPtr, td) == -1)
+				rc= removeFreePage(td, dstPtr, dst);
+			markDirty(&td->bm, &dstH);
+			unpinPage(&td->bm, &dstH);
+		}
+		free(tuple);
+		free(reserved);
+
+		// Drop the emptied pages
+		truncRc= truncatePool(&td->bm, src+1);
+		if (truncRc != RC_OK)
+		{
+			if (rc == RC_OK)
+				rc= truncRc;
+		}
+		else
+			stats->pagesAfter= src+1;
+		for (page=src+1; truncRc == RC_OK && page<numPages; page++)
+		{
+			for (i=0; i<schema->numAttr; i++)
+			{
+				td->zones[(page*schema->numAttr)+i].min= UINT64_MAX;
+				td->zones[(page*schema->numAttr)+i].max= 0;
+			}
+			td->zoneLive[page]= 0;
+			for (bf= td->blooms; bf != NULL; bf= bf->next)
+			{
+				if (page < bf->cap)
+				{
+					memset(bf->bits + ((long) page*bf->words), 0, sizeof(uint64_t)*bf->words);
+					bf->stale[page]= 0;
+				}
+			}
+		}
+
+		// Earlier moves of tuples moved again point to their new place
+		moved= td->remap + numOld;
+		qsort(moved, td->numRemap-numOld, sizeof(RM_RidMap), cmpRid);
+		for (i=0; i<numOld; i++)
+		{
+			if (td->remap[i].to.page <= src)
+				continue;
+			entry= (RM_RidMap*) bsearch(&td->remap[i].to, moved, td->numRemap-numOld, sizeof(RM_RidMap), cmpRid);
+			if (entry != NULL)
+				td->remap[i].to= entry->to;
+		}
+
+		// Merge them into the sorted remap table
+		merged= (RM_RidMap*) malloc(sizeof(RM_RidMap)*td->numRemap);
+		for (i=0, j=numOld, k=0; k<td->numRemap; k++)
+		{
+			if (j == td->numRemap || (i < numOld && cmpRid(&td->remap[i], &td->remap[j]) < 0))
+				merged[k]= td->remap[i++];
+			else
+				merged[k]= td->remap[j++];
+		}
+		free(td->remap);
+		td->remap= merged;
+		return rc;
+	}
+
+	/*
+	 * function resolveRid:
+	 *
+	 * Follows a RID to the tuple compactTable moved away from it. Moved
+	 * tuples were on pages truncated off the table, whose slots stay
+	 * reserved if a page with the same number is added later, so no other
+	 * tuple can have the RID of a moved one.
+	 */
+
+	RC resolveRid(RM_MgmtData_Table *td, RID *rid)
+	{
+		BM_MgmtData *bm= td->bm.mgmtData;
+		RM_RidMap *entry;
+
+		if (td->numRemap == 0)
+			return RC_OK;
+		while ((entry= (RM_RidMap*) bsearch(rid, td->remap, td->numRemap, sizeof(RM_RidMap), cmpRid)) != NULL)
+			*rid= entry->to;
+		if (rid->page >= bm->fHandle.totalNumPages)
+			return RC_READ_NON_EXISTING_PAGE;
+		return RC_OK;
+	}
+
+	/*
+	 * function appendPage:
+	 *
+	 * Adds an empty data page to the page file. Slots of tuples moved off
+	 * an earlier page with the same number are reserved (RM_MOVED), so their
+	 * old RIDs still lead to the moved tuples; pages without a free slot
+	 * left are skipped.
+	 */
+
+	RC appendPage(RM_MgmtData_Table *td, int *page)
+	{
+		BM_MgmtData *bm= td->bm.mgmtData;
+		BM_PageHandle h;
+		RM_ScanTuple *dataPtr;
+		bool full;
+		int lo, hi, mid;
+		RC rc;
+
+		do
+		{
+			if (appendEmptyBlock(&bm->fHandle) != RC_OK)
+				return RC_RM_INSERT_FAILED;
+			*page= bm->fHandle.totalNumPages-1;
+
+			// First moved tuple of the page
+			lo= 0;
+			hi= td->numRemap;
+			while (lo < hi)
+			{
+				mid= (lo+hi) / 2;
+				if (td->remap[mid].from.page < *page)
+					lo= mid+1;
+				else
+					hi= mid;
+			}
+			if (lo == td->numRemap || td->remap[lo].from.page != *page)
+				return RC_OK;
+
+			if ((rc= pinPage(&td->bm, &h, (PageNumber)*page)) != RC_OK)
+				return rc;
+			dataPtr= (RM_ScanTuple*) h.data;
+			markDirty(&td->bm, &h);
+			for (; lo < td->numRemap && td->remap[lo].from.page == *page; lo++)
+				*TOMBSTONE(td, (char*) &dataPtr->data, td->remap[lo].from.slot)= RM_MOVED;
+			full= findFreeSlot(dataPtr, td) == -1;
+			unpinPage(&td->bm, &h);
+		} while (full);
+		return RC_OK;
+	}
+
+	/*
+	 * function saveRemap:
+	 *
+	 * Writes the RIDs of moved tuples to their page file: their number,
+	 * then the old and new page and slot of every tuple.
+	 */
+
+	RC saveRemap(RM_MgmtData_Table *td, RM_TableData *rel)
+	{
+		long size= sizeof(int) + (td->numRemap*sizeof(RM_RidMap));
+		int numBlocks= (size + PAGE_SIZE - 1) / PAGE_SIZE;
+		char *file= sideFile(rel->name, ".rid");
+		char *buf;
+		SM_FileHandle fh;
+		int i;
+		RC rc;
+
+		if (td->numRemap == 0)
+		{
+			destroyPageFile(file);
+			free(file);
+			return RC_OK;
+		}
+		buf= (char*) calloc(numBlocks, PAGE_SIZE);
+		*(int*)buf= td->numRemap;
+		memcpy(buf + sizeof(int), td->remap, td->numRemap*sizeof(RM_RidMap));
+
+		rc= createPageFile(file);
+		if (rc == RC_OK)
+			rc= openPageFile(file, &fh);
+		for (i=0; rc == RC_OK && i<numBlocks; i++)
+			rc= writeBlock(i, &fh, buf + (i*PAGE_SIZE));
+		if (rc == RC_OK)
+			closePageFile(&fh);
+		free(buf);
+		free(file);
+		return rc;
+	}
+
+	/*
+	 * function loadRemap:
+	 *
+	 * Reads the RIDs of moved tuples written by saveRemap, if any.
+	 */
+
+	RC loadRemap(RM_MgmtData_Table *td, RM_TableData *rel)
+	{
+		char *file= sideFile(rel->name, ".rid");
+		char *buf;
+		SM_FileHandle fh;
+		long size;
+		int numBlocks, i;
+		RC rc;
+
+		rc= openPageFile(file, &fh);
+		free(file);
+		if (rc != RC_OK)
+			return rc;
+		buf= (char*) malloc(PAGE_SIZE);
+		rc= readBlock(0, &fh, buf);
+		if (rc == RC_OK)
+		{
+			td->numRemap= *(int*)buf;
+			size= sizeof(int) + (td->numRemap*sizeof(RM_RidMap));
+			numBlocks= (size + PAGE_SIZE - 1) / PAGE_SIZE;
+			buf= (char*) realloc(buf, numBlocks*PAGE_SIZE);
+			for (i=1; rc == RC_OK && i<numBlocks; i++)
+				rc= readBlock(i, &fh, buf + (i*PAGE_SIZE));
+			td->remap= (RM_RidMap*) malloc(sizeof(RM_RidMap)*td->numRemap);
+			memcpy(td->remap, buf + sizeof(int), td->numRemap*sizeof(RM_RidMap));
+			if (rc != RC_OK)
+				td->numRemap= 0;
+		}
+		closePageFile(&fh);
+		free(buf);
+		return rc;
+	}
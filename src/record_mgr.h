@@ -1,10 +1,86 @@
 #ifndef RECORD_MGR_H
 #define RECORD_MGR_H
 
+#include "buffer_mgr.h"
 #include "dberror.h"
 #include "expr.h"
 #include "tables.h"
 
+// Configuration passed to initRecordManager, NULL for the defaults: the
+// open tables keep their pages in one buffer pool of poolFrames frames,
+// replaced with strategy across all tables; a table holds at most
+// tableQuota of them unless all its frames are pinned (0 for no limit,
+// see setTableQuota)
+typedef struct RM_Config
+{
+  int poolFrames;
+  ReplacementStrategy strategy;
+  int tableQuota;
+} RM_Config;
+
+#define RM_DEFAULT_POOL_FRAMES 1000
+// Fewest frames of a table's own pool: compactTable holds a source and a target page
+// while unlinking one of them from the free page list pins its two neighbours
+#define RM_MIN_POOL_FRAMES 4
+
+// Buffer pool of a table, see openTableWithOptions
+typedef struct RM_TableOptions
+{
+  int poolFrames; // frames of a pool of the table's own, 0 for the shared pool
+  ReplacementStrategy strategy; // of the table's own pool
+  int readAhead; // pages read together with a page missed by sequential access, 0 for none, at most BM_MAX_READ_AHEAD
+  BM_WritePolicy writePolicy;
+} RM_TableOptions;
+
+// Buffer pool use of all open tables, see getCatalogStats
+typedef struct RM_CatalogStats
+{
+  int numTables; // open tables
+  int poolFrames; // frames of the shared buffer pool
+  long poolBytes; // memory of the pages in the frames
+  long numHits; // pins of pages found in the pool
+  long numReadIO; // pins reading the page from disk
+  long numWriteIO;
+  long numEvictions; // pages of the tables replaced or dropped, see BM_PoolCounters
+  long numDirtyWrites;
+  long numPinWaits;
+} RM_CatalogStats;
+
+// Layout of the tuples within the data pages of a table, see createTableWithLayout
+typedef enum RM_PageLayout
+{
+  RM_LAYOUT_ROW, // slots holding whole tuples
+  RM_LAYOUT_PAX // a minipage per attribute holding its values for all slots
+} RM_PageLayout;
+
+// Encodings of the values of an attribute on a compressed page, see compressTable
+typedef enum RM_Encoding
+{
+  RM_ENC_PLAIN, // values stored as they are
+  RM_ENC_FOR, // int: frame of reference, offsets from the minimum bit-packed
+  RM_ENC_DICT, // string: dictionary of the distinct values, codes bit-packed
+  RM_ENC_RLE // bool: runs of equal values
+} RM_Encoding;
+
+#define RM_NUM_ENCODINGS 4
+
+// Result of compressTable
+typedef struct RM_CompressionStats
+{
+  int pagesBefore; // data pages
+  int pagesAfter;
+  int numChunks[RM_NUM_ENCODINGS]; // values of an attribute on a page, by encoding
+} RM_CompressionStats;
+
+// Result of compactTable
+typedef struct RM_CompactionStats
+{
+  int pagesBefore; // pages of the page file
+  int pagesAfter;
+  int pagesMoved; // pages emptied at the end of the table and truncated
+  int tuplesMoved;
+} RM_CompactionStats;
+
 // Bookkeeping for scans
 typedef struct RM_ScanHandle
 {
@@ -12,14 +88,75 @@ typedef struct RM_ScanHandle
   void *mgmtData;
 } RM_ScanHandle;
 
+// Pages read by a scan and pages it skipped because their zone map (the
+// min and max of every attribute) rules out tuples matching the condition
+typedef struct RM_ScanStats
+{
+  int pagesPinned;
+  int pagesSkipped;
+  int bloomSkipped; // pages skipped by bloom filters, part of pagesSkipped
+} RM_ScanStats;
+
+// Tuples returned by nextBatch, with a bitmap of those matching the scan condition
+typedef struct RM_RecordBatch
+{
+  int capacity; // maximum number of tuples per call
+  int numRecords; // tuples in this batch
+  int numSelected; // tuples matching the condition
+  RID *ids;
+  char *data; // numRecords records of getRecordSize bytes each
+  uint64_t *selection; // bit i is set if tuple i matches, see BITMAP_TEST
+  void *scratch;
+} RM_RecordBatch;
+
+// called by parallelScan on the worker threads for every matching tuple;
+// record is a view into the page pinned by that worker (see nextView),
+// valid until the callback returns. Any result but RC_OK stops the scan.
+typedef RC (*RM_ScanCallback) (void *context, int worker, Record *record);
+
+// the slots of one page passed to parallelScanColumns callbacks: attribute
+// a of slot i is at columns[a] + i * strides[a]. With the row layout the
+// tuples are also whole at rows + i * rowStride, rows is NULL with PAX.
+// Pointers are into the page pinned by the worker, valid during the call.
+typedef struct RM_ColumnBatch
+{
+  int page;
+  int numSlots;
+  uint64_t *selection; // bit i is set if slot i holds a tuple matching the condition
+  char **columns;
+  int *strides;
+  char *rows;
+  int rowStride;
+} RM_ColumnBatch;
+
+typedef RC (*RM_ColumnCallback) (void *context, int worker, RM_ColumnBatch *batch);
+
+// borrowed view of a string attribute: points into the record data (or
+// the pinned page holding it), not NUL terminated, valid while the record is
+typedef struct RM_StringView
+{
+  char *data;
+  int length; // characters up to the first NUL or the type length
+} RM_StringView;
+
 // table and manager
 extern RC initRecordManager (void *mgmtData);
 extern RC shutdownRecordManager ();
 extern RC createTable (char *name, Schema *schema);
+extern RC createTableWithLayout (char *name, Schema *schema, RM_PageLayout layout);
 extern RC openTable (RM_TableData *rel, char *name);
+extern RC openTableWithOptions (RM_TableData *rel, char *name, RM_TableOptions *options);
 extern RC closeTable (RM_TableData *rel);
 extern RC deleteTable (char *name);
 extern int getNumTuples (RM_TableData *rel);
+extern RC compressTable (RM_TableData *rel, RM_CompressionStats *stats);
+extern RC compactTable (RM_TableData *rel, int maxPages, RM_CompactionStats *stats);
+
+// buffer pool shared by the open tables, see RM_Config
+extern RC setTableQuota (RM_TableData *rel, int numFrames);
+extern RC resizeTablePool (RM_TableData *rel, int numFrames);
+extern RC resizeCatalogPool (int numFrames);
+extern RC getCatalogStats (RM_CatalogStats *stats);
 
 // handling records in a table
 extern RC insertRecord (RM_TableData *rel, Record *record);
@@ -27,10 +164,35 @@ extern RC deleteRecord (RM_TableData *rel, RID id);
 extern RC updateRecord (RM_TableData *rel, Record *record);
 extern RC getRecord (RM_TableData *rel, RID id, Record *record);
 
+// handling batches of records, grouped by page
+extern RC insertRecords (RM_TableData *rel, Record *records, int numRecords);
+extern RC deleteRecords (RM_TableData *rel, RID *ids, int numIds);
+extern RC getRecords (RM_TableData *rel, RID *ids, int numIds, Record *records);
+
+// bloom filters on an attribute, one per data page, let scans skip pages
+// without tuples equal to a constant; kept in memory while the table is open
+extern RC createBloomFilter (RM_TableData *rel, int attrNum);
+extern RC dropBloomFilter (RM_TableData *rel, int attrNum);
+
 // scans
 extern RC startScan (RM_TableData *rel, RM_ScanHandle *scan, Expr *cond);
 extern RC next (RM_ScanHandle *scan, Record *record);
 extern RC closeScan (RM_ScanHandle *scan);
+extern RC setScanLimit (RM_ScanHandle *scan, int limit);
+extern RC getScanStats (RM_ScanHandle *scan, RM_ScanStats *stats);
+
+// scans returning views into the pinned page instead of copies
+extern RC nextView (RM_ScanHandle *scan, Record *record);
+extern RC materializeRecord (Record *view, Schema *schema, Record *record);
+
+// batched scans
+extern RC createRecordBatch (RM_RecordBatch **batch, Schema *schema, int capacity);
+extern RC freeRecordBatch (RM_RecordBatch *batch);
+extern RC nextBatch (RM_ScanHandle *scan, RM_RecordBatch *batch);
+
+// scans splitting the pages of a table across worker threads
+extern RC parallelScan (RM_TableData *rel, Expr *cond, int numWorkers, RM_ScanCallback callback, void *context);
+extern RC parallelScanColumns (RM_TableData *rel, Expr *cond, int numWorkers, RM_ColumnCallback callback, void *context);
 
 // dealing with schemas
 extern int getRecordSize (Schema *schema);
@@ -43,4 +205,10 @@ extern RC freeRecord (Record *record);
 extern RC getAttr (Record *record, Schema *schema, int attrNum, Value **value);
 extern RC setAttr (Record *record, Schema *schema, int attrNum, Value *value);
 
+// reading attributes without allocating, using the offsets precomputed in the schema
+extern RC getIntAttr (Record *record, Schema *schema, int attrNum, int *value);
+extern RC getFloatAttr (Record *record, Schema *schema, int attrNum, float *value);
+extern RC getBoolAttr (Record *record, Schema *schema, int attrNum, bool *value);
+extern RC getStringAttr (Record *record, Schema *schema, int attrNum, RM_StringView *value);
+
 #endif // RECORD_MGR_H
@@ -7,8 +7,11 @@
 
 #include <stdio.h>
 #include <string.h>
+#include <unistd.h>
+#include <sys/uio.h>
 #include "storage_mgr.h"
 #include "dberror.h"
+#include "latency.h"
 
 
 /* GLOBAL DECLARATION - METADATA VARIABLES */
@@ -21,7 +24,7 @@ int curPgPos; // Current Page Position
 #define OFFSET_curPgPos SIZE_byte // Offset for storing/retrieving metadata curPgPos is 1 byte (integer size).
 #define OFFSET_pgFile SIZE_FileHeader // Offset for storing/retrieving file records.
 // Offset to seek the START POSITION to read/write/append a page within the file.
-#define OFFSET_page(pageNum) ((PAGE_SIZE * pageNum) + SIZE_FileHeader)
+#define OFFSET_page(pageNum) ((PAGE_SIZE * (pageNum)) + SIZE_FileHeader)
 
 
 /* MANIPULATE PAGE FILES */
@@ -208,6 +211,7 @@ RC readBlock(int pageNum, SM_FileHandle *fHandle, SM_PageHandle memPage)
 		return RC_FILE_NOT_FOUND;
 
 	FILE* file = (FILE*)fHandle->mgmtInfo;
+	LATENCY_START(start);
 	//Seek to beginning of required block
 	if(fseek(file,OFFSET_page(pageNum),SEEK_SET)==0)
 	{
@@ -215,12 +219,55 @@ RC readBlock(int pageNum, SM_FileHandle *fHandle, SM_PageHandle memPage)
 		fread(memPage,sizeof(char),PAGE_SIZE,file);
 		/* Store Page Number to File Handle */
 		fHandle->curPagePos = pageNum;
+		LATENCY_END(LAT_READ_BLOCK, start);
 		return RC_OK;
 	}
 	else
 		return RC_READ_NON_EXISTING_PAGE;
 }
 
+/*
+ * readBlocks() method:
+ *
+ * Read numPages consecutive blocks from pageNum on into the
+ * memory pointed by memPages[0..numPages-1] with a single call
+ * per SM_MAX_READ_BLOCKS pages.
+ */
+
+RC readBlocks(int pageNum, int numPages, SM_FileHandle *fHandle, SM_PageHandle *memPages)
+{
+	struct iovec iov[SM_MAX_READ_BLOCKS];
+	int i, n;
+
+	/* Error Handling */
+	if (fHandle == NULL)
+		return RC_FILE_HANDLE_NOT_INIT;
+	if (pageNum < 0 || numPages < 1 || pageNum + numPages > fHandle->totalNumPages)
+		return RC_READ_NON_EXISTING_PAGE;
+	if (fHandle->mgmtInfo == NULL)
+		return RC_FILE_NOT_FOUND;
+
+	FILE* file = (FILE*)fHandle->mgmtInfo;
+	LATENCY_START(start);
+	/* Pages written through the stream have to reach the file first */
+	fflush(file);
+	/* Up to SM_MAX_READ_BLOCKS pages per call */
+	for (n = 0; n < numPages; n += SM_MAX_READ_BLOCKS)
+	{
+		int count = (numPages - n < SM_MAX_READ_BLOCKS) ? numPages - n : SM_MAX_READ_BLOCKS;
+		for (i = 0; i < count; i++)
+		{
+			iov[i].iov_base = memPages[n + i];
+			iov[i].iov_len = PAGE_SIZE;
+		}
+		if (preadv(fileno(file), iov, count, OFFSET_page(pageNum + n)) != (ssize_t) count * PAGE_SIZE)
+			return RC_READ_NON_EXISTING_PAGE;
+	}
+	fHandle->curPagePos = pageNum + numPages - 1;
+	LATENCY_END(LAT_READ_BLOCKS, start);
+	return RC_OK;
+}
+
 // Get the Current Page Position in file
 int getBlockPos(SM_FileHandle *fHandle)
 {
@@ -306,6 +353,7 @@ RC writeBlock (int pageNum, SM_FileHandle *fHandle, SM_PageHandle memPage)
 			return RC_WRITE_FAILED;
 
 	FILE* file = (FILE*)fHandle->mgmtInfo;
+	LATENCY_START(start);
 
 	/* Seek to available start position to write the requested page */
 	if(fseek(file,OFFSET_page(pageNum),SEEK_SET)==0)
@@ -314,6 +362,7 @@ RC writeBlock (int pageNum, SM_FileHandle *fHandle, SM_PageHandle memPage)
 		fwrite(memPage,sizeof(char),PAGE_SIZE,file);
 		/* Increment Current Page Position by 1 as we have written a new page */
 		fHandle->curPagePos = pageNum + 1;
+		LATENCY_END(LAT_WRITE_BLOCK, start);
 		return RC_OK;
 	}
 	else return RC_WRITE_FAILED;
@@ -398,3 +447,36 @@ RC ensureCapacity (int numberOfPages, SM_FileHandle *fHandle)
 	}
 	return RC_OK;
 }
+
+/*
+ * truncatePageFile() method:
+ *
+ * Shrinks the file to its first 'numberOfPages' pages,
+ * dropping the pages behind them.
+ */
+
+RC truncatePageFile (int numberOfPages, SM_FileHandle *fHandle)
+{
+	//Error Handling: File Not Initialized
+	if (fHandle == NULL)
+		return RC_FILE_HANDLE_NOT_INIT;
+	if (fHandle->mgmtInfo == NULL)
+		return RC_FILE_NOT_FOUND;
+	if (numberOfPages < 1 || numberOfPages > fHandle->totalNumPages)
+		return RC_READ_NON_EXISTING_PAGE;
+
+	FILE *file = (FILE*)fHandle->mgmtInfo;
+
+	/* Cut the file after the last page kept */
+	fflush(file);
+	if (ftruncate(fileno(file), OFFSET_page(numberOfPages)) != 0)
+		return RC_WRITE_FAILED;
+
+	/* Update Page Count in the File Header */
+	fHandle->totalNumPages = numberOfPages;
+	if (fHandle->curPagePos >= numberOfPages)
+		fHandle->curPagePos = numberOfPages-1;
+	fseek(file,OFFSET_totNoPg,SEEK_SET);
+	fwrite(&numberOfPages, sizeof(int), 1, file);
+	return RC_OK;
+}
@@ -15,6 +15,9 @@ typedef struct SM_FileHandle {
 
 typedef char* SM_PageHandle;
 
+// Pages readBlocks reads with one system call, well below IOV_MAX
+#define SM_MAX_READ_BLOCKS 64
+
 /************************************************************
  *                    interface                             *
  ************************************************************/
@@ -27,6 +30,7 @@ extern RC destroyPageFile (char *fileName);
 
 /* reading blocks from disc */
 extern RC readBlock (int pageNum, SM_FileHandle *fHandle, SM_PageHandle memPage);
+extern RC readBlocks (int pageNum, int numPages, SM_FileHandle *fHandle, SM_PageHandle *memPages);
 extern int getBlockPos (SM_FileHandle *fHandle);
 extern RC readFirstBlock (SM_FileHandle *fHandle, SM_PageHandle memPage);
 extern RC readPreviousBlock (SM_FileHandle *fHandle, SM_PageHandle memPage);
@@ -39,5 +43,6 @@ extern RC writeBlock (int pageNum, SM_FileHandle *fHandle, SM_PageHandle memPage
 extern RC writeCurrentBlock (SM_FileHandle *fHandle, SM_PageHandle memPage);
 extern RC appendEmptyBlock (SM_FileHandle *fHandle);
 extern RC ensureCapacity (int numberOfPages, SM_FileHandle *fHandle);
+extern RC truncatePageFile (int numberOfPages, SM_FileHandle *fHandle);
 
 #endif
@@ -41,6 +41,8 @@ typedef struct Schema
   int *typeLength;
   int *keyAttrs;
   int keySize;
+  int *attrOffsets; // byte offset of each attribute within the record data
+  int recordSize; // sum of the type lengths
 } Schema;
 
 // TableData: Management Structure for a Record Manager to handle one relation
@@ -1,7 +1,12 @@
 #include <stdlib.h>
+#include <pthread.h>
+#include <unistd.h>
 #include "dberror.h"
 #include "expr.h"
 #include "record_mgr.h"
+#include "storage_mgr.h"
+#include "buffer_mgr_stat.h"
+#include "latency.h"
 #include "tables.h"
 #include "test_helper.h"
 
@@ -55,6 +60,24 @@ static void testScans (void);
 static void testScansTwo (void);
 static void testInsertManyRecords(void);
 static void testMultipleScans(void);
+static void testBatchRecords(void);
+static void testBatchScans(void);
+static void testAttrViews(void);
+static void testScanViews(void);
+static void testParallelScan(void);
+static void testScanLimit(void);
+static void testPaxTable(void);
+static void testCompressTable(void);
+static void testZoneMaps(void);
+static void testBloomFilters(void);
+static void testCompactTable(void);
+static void testScanDeletes(void);
+static void testSharedPool(void);
+static void testTableOptions(void);
+static void testReadBlocks(void);
+static void testOnlineResize(void);
+static void testPoolStats(void);
+static void testLatencyStats(void);
 
 // struct for test records
 typedef struct TestRecord {
@@ -84,6 +107,24 @@ main (void)
   testScans();
   testScansTwo();
   testMultipleScans();
+  testBatchRecords();
+  testBatchScans();
+  testAttrViews();
+  testScanViews();
+  testParallelScan();
+  testScanLimit();
+  testPaxTable();
+  testCompressTable();
+  testZoneMaps();
+  testBloomFilters();
+  testCompactTable();
+  testScanDeletes();
+  testSharedPool();
+  testTableOptions();
+  testReadBlocks();
+  testOnlineResize();
+  testPoolStats();
+  testLatencyStats();
 
   return 0;
 }
@@ -616,59 +657,1994 @@ void testScansTwo (void)
 }
 
 
-Schema *
-testSchema (void)
+void
+testBatchRecords(void)
 {
-  Schema *result;
-  char *names[] = { "a", "b", "c" };
-  DataType dt[] = { DT_INT, DT_STRING, DT_INT };
-  int sizes[] = { 0, 4, 0 };
-  int keys[] = {0};
-  int i;
-  char **cpNames = (char **) malloc(sizeof(char*) * 3);
-  DataType *cpDt = (DataType *) malloc(sizeof(DataType) * 3);
-  int *cpSizes = (int *) malloc(sizeof(int) * 3);
-  int *cpKeys = (int *) malloc(sizeof(int));
+  RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+  TestRecord inserts[] = { 
+    {1, "aaaa", 3}, 
+    {2, "bbbb", 2},
+    {3, "cccc", 1},
+    {4, "dddd", 3},
+    {5, "eeee", 5},
+    {6, "ffff", 1},
+    {7, "gggg", 3},
+    {8, "hhhh", 3},
+    {9, "iiii", 2},
+    {10, "jjjj", 5},
+  };
+  int numInserts = 2000, numDeletes = 1000, i;
+  Record *batch, *reads, *r;
+  RID *rids, *revRids, *delRids;
+  Schema *schema;
+  testName = "test batched insert, get and delete of records";
+  schema = testSchema();
+  batch = (Record *) malloc(sizeof(Record) * numInserts);
+  reads = (Record *) malloc(sizeof(Record) * numInserts);
+  rids = (RID *) malloc(sizeof(RID) * numInserts);
+  revRids = (RID *) malloc(sizeof(RID) * numInserts);
+  delRids = (RID *) malloc(sizeof(RID) * numDeletes);
 
-  for(i = 0; i < 3; i++)
+  TEST_CHECK(initRecordManager(NULL));
+  TEST_CHECK(createTable("test_table_b",schema));
+  TEST_CHECK(openTable(table, "test_table_b"));
+
+  // insert all rows with one call
+  for(i = 0; i < numInserts; i++)
     {
-      cpNames[i] = (char *) malloc(2);
-      strcpy(cpNames[i], names[i]);
+      TestRecord t = inserts[i%10];
+      t.a = i;
+      r = fromTestRecord(schema, t);
+      batch[i] = *r;
+      free(r);
+      createRecord(&r, schema);
+      reads[i] = *r;
+      free(r);
+    }
+  TEST_CHECK(insertRecords(table, batch, numInserts));
+  ASSERT_EQUALS_INT(numInserts, getNumTuples(table), "all records inserted");
+  for(i = 0; i < numInserts; i++)
+    {
+      rids[i] = batch[i].id;
+      revRids[numInserts - 1 - i] = batch[i].id;
     }
-  memcpy(cpDt, dt, sizeof(DataType) * 3);
-  memcpy(cpSizes, sizes, sizeof(int) * 3);
-  memcpy(cpKeys, keys, sizeof(int));
 
-  result = createSchema(3, cpNames, cpDt, cpSizes, 1, cpKeys);
+  // read back in reverse RID order, results follow the RID array
+  TEST_CHECK(getRecords(table, revRids, numInserts, reads));
+  for(i = 0; i < numInserts; i++)
+    ASSERT_EQUALS_RECORDS(&batch[numInserts - 1 - i], &reads[i], schema, "compare records");
 
-  return result;
+  // delete every other record and refill the freed slots
+  for(i = 0; i < numDeletes; i++)
+    delRids[i] = rids[2 * i];
+  TEST_CHECK(deleteRecords(table, delRids, numDeletes));
+  ASSERT_EQUALS_INT(numInserts - numDeletes, getNumTuples(table), "half of the records deleted");
+
+  // a batch with a deleted or repeated RID fails and deletes nothing
+  delRids[1] = rids[1];
+  ASSERT_ERROR(deleteRecords(table, delRids, 2), "deleted RID in batch");
+  delRids[0] = rids[1];
+  ASSERT_ERROR(deleteRecords(table, delRids, 2), "repeated RID in batch");
+  ASSERT_EQUALS_INT(numInserts - numDeletes, getNumTuples(table), "failed batches delete nothing");
+
+  TEST_CHECK(insertRecords(table, batch, numDeletes));
+  ASSERT_EQUALS_INT(numInserts, getNumTuples(table), "freed slots reused");
+  for(i = 0; i < numDeletes; i++)
+    ASSERT_TRUE(batch[i].id.page <= rids[numInserts - 1].page, "no new page appended");
+
+  TEST_CHECK(getRecords(table, rids, numInserts, reads));
+  for(i = 1; i < numInserts; i += 2)
+    ASSERT_EQUALS_RECORDS(&batch[i], &reads[i], schema, "surviving records unchanged");
+
+  delRids[0].page = -1;
+  ASSERT_ERROR(getRecords(table, delRids, 1, reads), "invalid RID in batch");
+
+  TEST_CHECK(closeTable(table));
+  TEST_CHECK(deleteTable("test_table_b"));
+  TEST_CHECK(shutdownRecordManager());
+
+  for(i = 0; i < numInserts; i++)
+    {
+      free(batch[i].data);
+      free(reads[i].data);
+    }
+  free(batch);
+  free(reads);
+  free(rids);
+  free(revRids);
+  free(delRids);
+  free(table);
+  TEST_DONE();
 }
 
-Record *
-fromTestRecord (Schema *schema, TestRecord in)
+void
+testBatchScans(void)
 {
-  return testRecord(schema, in.a, in.b, in.c);
+  RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+  TestRecord inserts[] = { 
+    {1, "aaaa", 3}, 
+    {2, "bbbb", 2},
+    {3, "cccc", 1},
+    {4, "dddd", 3},
+    {5, "eeee", 5},
+    {6, "ffff", 1},
+    {7, "gggg", 3},
+    {8, "hhhh", 3},
+    {9, "iiii", 2},
+    {10, "jjjj", 5},
+  };
+  bool foundScan[10];
+  int numInserts = 10, numBatches = 0, numRows = 0, i;
+  Record *r;
+  RID *rids;
+  Schema *schema;
+  RM_ScanHandle *sc = (RM_ScanHandle *) malloc(sizeof(RM_ScanHandle));
+  RM_RecordBatch *batch;
+  Expr *sel, *left, *right;
+  int rc;
+
+  testName = "test batched scans with selection bitmaps";
+  schema = testSchema();
+  rids = (RID *) malloc(sizeof(RID) * numInserts);
+  memset(foundScan, 0, sizeof(foundScan));
+
+  TEST_CHECK(initRecordManager(NULL));
+  TEST_CHECK(createTable("test_table_r",schema));
+  TEST_CHECK(openTable(table, "test_table_r"));
+
+  for(i = 0; i < numInserts; i++)
+  {
+      r = fromTestRecord(schema, inserts[i]);
+      TEST_CHECK(insertRecord(table,r)); 
+      rids[i] = r->id;
+  }
+  // deleted tuples are not part of any batch
+  TEST_CHECK(deleteRecord(table, rids[3]));
+
+  // c = 3, batches of 4 tuples
+  MAKE_CONS(left, stringToValue("i3"));
+  MAKE_ATTRREF(right, 2);
+  MAKE_BINOP_EXPR(sel, left, right, OP_COMP_EQUAL);
+  TEST_CHECK(createRecordBatch(&batch, schema, 4));
+  TEST_CHECK(startScan(table, sc, sel));
+  while((rc = nextBatch(sc, batch)) == RC_OK)
+  {
+      numBatches++;
+      numRows += batch->numRecords;
+      for(i = 0; i < batch->numRecords; i++)
+        if (BITMAP_TEST(batch->selection, i))
+          {
+            int a;
+            memcpy(&a, batch->data + (i * getRecordSize(schema)), sizeof(int));
+            foundScan[a - 1] = TRUE;
+          }
+  }
+  ASSERT_EQUALS_INT(RC_RM_NO_MORE_TUPLES, rc, "batched scan completed");
+  TEST_CHECK(closeScan(sc));
+
+  ASSERT_EQUALS_INT(3, numBatches, "9 live tuples in batches of 4");
+  ASSERT_EQUALS_INT(9, numRows, "deleted tuple skipped");
+  for(i = 0; i < numInserts; i++)
+    ASSERT_TRUE(foundScan[i] == (inserts[i].c == 3 && i != 3), "selection bitmap matches c = 3");
+
+  TEST_CHECK(freeRecordBatch(batch));
+  TEST_CHECK(closeTable(table));
+  TEST_CHECK(deleteTable("test_table_r"));
+  TEST_CHECK(shutdownRecordManager());
+
+  freeExpr(sel);
+  free(rids);
+  free(sc);
+  free(table);
+  TEST_DONE();
 }
 
-Record *
-testRecord(Schema *schema, int a, char *b, int c)
+void
+testAttrViews(void)
 {
-  Record *result;
-  Value *value;
+  RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+  char *names[] = { "i", "s", "f", "b" };
+  DataType dt[] = { DT_INT, DT_STRING, DT_FLOAT, DT_BOOL };
+  int sizes[] = { 0, 8, 0, 0 };
+  int keys[] = {0};
+  Schema *schema;
+  Record *r;
+  Value *value, str;
+  RM_StringView view;
+  char buf[9];
+  int i;
+  float f;
+  bool b;
 
-  TEST_CHECK(createRecord(&result, schema));
+  testName = "test reading attributes without allocation";
+  schema = createSchema(4, names, dt, sizes, 1, keys);
+  ASSERT_EQUALS_INT(0, schema->attrOffsets[0], "offset of i");
+  ASSERT_EQUALS_INT(4, schema->attrOffsets[1], "offset of s");
+  ASSERT_EQUALS_INT(12, schema->attrOffsets[2], "offset of f");
+  ASSERT_EQUALS_INT(16, schema->attrOffsets[3], "offset of b");
+  ASSERT_EQUALS_INT(18, getRecordSize(schema), "record size");
 
-  MAKE_VALUE(value, DT_INT, a);
-  TEST_CHECK(setAttr(result, schema, 0, value));
+  TEST_CHECK(createRecord(&r, schema));
+  MAKE_VALUE(value, DT_INT, -42);
+  TEST_CHECK(setAttr(r, schema, 0, value));
   freeVal(value);
-
-  MAKE_STRING_VALUE(value, b);
-  TEST_CHECK(setAttr(result, schema, 1, value));
+  memset(buf, 0, sizeof(buf));
+  strcpy(buf, "abc");
+  str.dt = DT_STRING;
+  str.v.stringV = buf;
+  TEST_CHECK(setAttr(r, schema, 1, &str));
+  MAKE_VALUE(value, DT_FLOAT, 2.5);
+  TEST_CHECK(setAttr(r, schema, 2, value));
   freeVal(value);
-
-  MAKE_VALUE(value, DT_INT, c);
-  TEST_CHECK(setAttr(result, schema, 2, value));
+  MAKE_VALUE(value, DT_BOOL, TRUE);
+  TEST_CHECK(setAttr(r, schema, 3, value));
   freeVal(value);
 
-  return result;
+  TEST_CHECK(getIntAttr(r, schema, 0, &i));
+  ASSERT_EQUALS_INT(-42, i, "int attribute");
+  TEST_CHECK(getStringAttr(r, schema, 1, &view));
+  ASSERT_EQUALS_INT(3, view.length, "string view ends at the first NUL");
+  ASSERT_TRUE(view.data == r->data + 4 && memcmp(view.data, "abc", 3) == 0, "string view points into the record");
+  TEST_CHECK(getFloatAttr(r, schema, 2, &f));
+  ASSERT_TRUE(f == 2.5, "float attribute");
+  TEST_CHECK(getBoolAttr(r, schema, 3, &b));
+  ASSERT_TRUE(b, "bool attribute");
+
+  // strings filling the whole field have the type length
+  memcpy(buf, "abcdefgh", 8);
+  TEST_CHECK(setAttr(r, schema, 1, &str));
+  TEST_CHECK(getStringAttr(r, schema, 1, &view));
+  ASSERT_EQUALS_INT(8, view.length, "string view of a full field");
+
+  ASSERT_ERROR(getIntAttr(r, schema, 1, &i), "string attribute read as int");
+  ASSERT_ERROR(getFloatAttr(r, schema, 4, &f), "attribute outside of the schema");
+  freeRecord(r);
+  freeSchema(schema);
+
+  // offsets of schemas read from a table
+  schema = testSchema();
+  TEST_CHECK(initRecordManager(NULL));
+  TEST_CHECK(createTable("test_table_r",schema));
+  TEST_CHECK(openTable(table, "test_table_r"));
+  r = testRecord(schema, 7, "wxyz", 9);
+  TEST_CHECK(insertRecord(table, r));
+  TEST_CHECK(getRecord(table, r->id, r));
+  TEST_CHECK(getIntAttr(r, table->schema, 2, &i));
+  ASSERT_EQUALS_INT(9, i, "int attribute behind a string");
+  TEST_CHECK(getStringAttr(r, table->schema, 1, &view));
+  ASSERT_TRUE(view.length == 4 && memcmp(view.data, "wxyz", 4) == 0, "string attribute of a stored record");
+  freeRecord(r);
+  TEST_CHECK(closeTable(table));
+  TEST_CHECK(deleteTable("test_table_r"));
+  TEST_CHECK(shutdownRecordManager());
+
+  freeSchema(schema);
+  free(table);
+  TEST_DONE();
+}
+
+void
+testScanViews(void)
+{
+  RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+  TestRecord inserts[] = { 
+    {1, "aaaa", 3}, 
+    {2, "bbbb", 2},
+    {3, "cccc", 1},
+    {4, "dddd", 3},
+    {5, "eeee", 5},
+    {6, "ffff", 1},
+    {7, "gggg", 3},
+    {8, "hhhh", 3},
+    {9, "iiii", 2},
+    {10, "jjjj", 5},
+  };
+  int numInserts = 10, numViews = 0, i;
+  Record *r, *kept[10];
+  Record view;
+  Schema *schema;
+  RM_ScanHandle *sc = (RM_ScanHandle *) malloc(sizeof(RM_ScanHandle));
+  Expr *sel, *left, *right;
+  int rc;
+
+  testName = "test scans returning views into pinned pages";
+  schema = testSchema();
+
+  TEST_CHECK(initRecordManager(NULL));
+  TEST_CHECK(createTable("test_table_r",schema));
+  TEST_CHECK(openTable(table, "test_table_r"));
+
+  for(i = 0; i < numInserts; i++)
+  {
+      r = fromTestRecord(schema, inserts[i]);
+      TEST_CHECK(insertRecord(table,r)); 
+      freeRecord(r);
+  }
+
+  // c = 3, keep a copy of every view
+  MAKE_CONS(left, stringToValue("i3"));
+  MAKE_ATTRREF(right, 2);
+  MAKE_BINOP_EXPR(sel, left, right, OP_COMP_EQUAL);
+  TEST_CHECK(createRecord(&r, schema));
+  TEST_CHECK(startScan(table, sc, sel));
+  while((rc = nextView(sc, &view)) == RC_OK)
+  {
+      TEST_CHECK(getRecord(table, view.id, r));
+      ASSERT_TRUE(memcmp(view.data, r->data, getRecordSize(schema)) == 0, "view equals stored record");
+      TEST_CHECK(createRecord(&kept[numViews], schema));
+      TEST_CHECK(materializeRecord(&view, schema, kept[numViews]));
+      numViews++;
+  }
+  ASSERT_EQUALS_INT(RC_RM_NO_MORE_TUPLES, rc, "view scan completed");
+  TEST_CHECK(closeScan(sc));
+  ASSERT_EQUALS_INT(4, numViews, "4 tuples with c = 3");
+
+  // materialized rows outlive the scan
+  for(i = 0; i < numViews; i++)
+    {
+      int a, c;
+      TEST_CHECK(getIntAttr(kept[i], schema, 0, &a));
+      TEST_CHECK(getIntAttr(kept[i], schema, 2, &c));
+      ASSERT_TRUE(c == 3 && inserts[a - 1].c == 3, "materialized record matches c = 3");
+      ASSERT_TRUE(kept[i]->id.page == 1, "materialized record keeps its RID");
+      freeRecord(kept[i]);
+    }
+
+  TEST_CHECK(closeTable(table));
+  TEST_CHECK(deleteTable("test_table_r"));
+  TEST_CHECK(shutdownRecordManager());
+
+  freeRecord(r);
+  freeExpr(sel);
+  freeSchema(schema);
+  free(sc);
+  free(table);
+  TEST_DONE();
+}
+
+// ************************************************************ 
+void
+testScanLimit(void)
+{
+  RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+  TestRecord inserts[] = { 
+    {1, "aaaa", 3}, 
+    {2, "bbbb", 2},
+    {3, "cccc", 1},
+    {4, "dddd", 3},
+    {5, "eeee", 5},
+    {6, "ffff", 1},
+    {7, "gggg", 3},
+    {8, "hhhh", 3},
+    {9, "iiii", 2},
+    {10, "jjjj", 5},
+  };
+  int numInserts = 10, numFound = 0, i, a;
+  Record *r;
+  Schema *schema;
+  RM_ScanHandle *sc = (RM_ScanHandle *) malloc(sizeof(RM_ScanHandle));
+  RM_RecordBatch *batch;
+  Expr *sel, *left, *right;
+  int rc;
+
+  testName = "test scans with a pushed down LIMIT";
+  schema = testSchema();
+
+  TEST_CHECK(initRecordManager(NULL));
+  TEST_CHECK(createTable("test_table_r",schema));
+  TEST_CHECK(openTable(table, "test_table_r"));
+
+  for(i = 0; i < numInserts; i++)
+  {
+      r = fromTestRecord(schema, inserts[i]);
+      TEST_CHECK(insertRecord(table,r)); 
+      freeRecord(r);
+  }
+
+  // c = 3 LIMIT 2
+  MAKE_CONS(left, stringToValue("i3"));
+  MAKE_ATTRREF(right, 2);
+  MAKE_BINOP_EXPR(sel, left, right, OP_COMP_EQUAL);
+  TEST_CHECK(createRecord(&r, schema));
+  TEST_CHECK(startScan(table, sc, sel));
+  TEST_CHECK(setScanLimit(sc, 2));
+  while((rc = next(sc, r)) == RC_OK)
+  {
+      TEST_CHECK(getIntAttr(r, schema, 0, &a));
+      ASSERT_EQUALS_INT(inserts[numFound == 0 ? 0 : 3].a, a, "first tuples with c = 3");
+      numFound++;
+  }
+  ASSERT_EQUALS_INT(RC_RM_NO_MORE_TUPLES, rc, "scan stopped at the limit");
+  ASSERT_EQUALS_INT(2, numFound, "2 tuples returned");
+  rc = next(sc, r);
+  ASSERT_EQUALS_INT(RC_RM_NO_MORE_TUPLES, rc, "scan stays stopped");
+  TEST_CHECK(closeScan(sc));
+
+  // LIMIT 0 returns nothing
+  TEST_CHECK(startScan(table, sc, NULL));
+  TEST_CHECK(setScanLimit(sc, 0));
+  rc = next(sc, r);
+  ASSERT_EQUALS_INT(RC_RM_NO_MORE_TUPLES, rc, "LIMIT 0");
+  TEST_CHECK(closeScan(sc));
+
+  // batches select the first 3 matching tuples
+  TEST_CHECK(createRecordBatch(&batch, schema, 8));
+  TEST_CHECK(startScan(table, sc, sel));
+  TEST_CHECK(setScanLimit(sc, 3));
+  numFound = 0;
+  while(nextBatch(sc, batch) == RC_OK)
+    for(i = 0; i < batch->numRecords; i++)
+      if (BITMAP_TEST(batch->selection, i))
+	numFound++;
+  ASSERT_EQUALS_INT(3, numFound, "3 tuples selected in batches");
+  TEST_CHECK(closeScan(sc));
+  TEST_CHECK(freeRecordBatch(batch));
+
+  TEST_CHECK(closeTable(table));
+  TEST_CHECK(deleteTable("test_table_r"));
+  TEST_CHECK(shutdownRecordManager());
+
+  freeRecord(r);
+  freeExpr(sel);
+  freeSchema(schema);
+  free(sc);
+  free(table);
+  TEST_DONE();
+}
+
+// per worker results of a parallel scan
+typedef struct ParallelResult {
+  Schema *schema;
+  int count[8];
+  long sum[8];
+  int stopAfter;
+} ParallelResult;
+
+static RC
+collectParallel (void *context, int worker, Record *record)
+{
+  ParallelResult *res = (ParallelResult *) context;
+  int a;
+
+  getIntAttr(record, res->schema, 0, &a);
+  res->count[worker]++;
+  res->sum[worker] += a;
+  if (res->stopAfter > 0 && res->count[worker] == res->stopAfter)
+    return RC_RM_NO_MORE_TUPLES;
+  return RC_OK;
+}
+
+static void
+sumParallel (ParallelResult *res, int *count, long *sum)
+{
+  int i;
+  *count = 0;
+  *sum = 0;
+  for(i = 0; i < 8; i++)
+    {
+      *count += res->count[i];
+      *sum += res->sum[i];
+    }
+}
+
+void
+testParallelScan(void)
+{
+  RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+  int numInserts = 10000, numDeletes = 0, i, count, expCount, rc;
+  long sum, expSum;
+  Record *batch, *r;
+  RID *delRids;
+  Schema *schema;
+  ParallelResult res;
+  Expr *sel, *left, *right;
+
+  testName = "test parallel scans";
+  schema = testSchema();
+  batch = (Record *) malloc(sizeof(Record) * numInserts);
+  delRids = (RID *) malloc(sizeof(RID) * numInserts);
+
+  TEST_CHECK(initRecordManager(NULL));
+  TEST_CHECK(createTable("test_table_p",schema));
+  TEST_CHECK(openTable(table, "test_table_p"));
+
+  // enough records for several morsels, every 10th deleted
+  for(i = 0; i < numInserts; i++)
+    {
+      r = testRecord(schema, i, "abcd", i % 7);
+      batch[i] = *r;
+      free(r);
+    }
+  TEST_CHECK(insertRecords(table, batch, numInserts));
+  for(i = 0; i < numInserts; i += 10)
+    delRids[numDeletes++] = batch[i].id;
+  TEST_CHECK(deleteRecords(table, delRids, numDeletes));
+
+  expCount = 0;
+  expSum = 0;
+  for(i = 0; i < numInserts; i++)
+    if (i % 10 != 0 && i % 7 == 3)
+      {
+	expCount++;
+	expSum += i;
+      }
+
+  // c = 3 on 4 workers
+  MAKE_CONS(left, stringToValue("i3"));
+  MAKE_ATTRREF(right, 2);
+  MAKE_BINOP_EXPR(sel, left, right, OP_COMP_EQUAL);
+  memset(&res, 0, sizeof(ParallelResult));
+  res.schema = schema;
+  TEST_CHECK(parallelScan(table, sel, 4, collectParallel, &res));
+  sumParallel(&res, &count, &sum);
+  ASSERT_EQUALS_INT(expCount, count, "every live tuple with c = 3 returned once");
+  ASSERT_TRUE(expSum == sum, "sum of a over the returned tuples");
+
+  // no condition, deleted tuples skipped
+  memset(&res, 0, sizeof(ParallelResult));
+  res.schema = schema;
+  TEST_CHECK(parallelScan(table, NULL, 3, collectParallel, &res));
+  sumParallel(&res, &count, &sum);
+  ASSERT_EQUALS_INT(numInserts - numDeletes, count, "all live tuples returned");
+
+  // a failing callback stops the scan and its result is returned
+  memset(&res, 0, sizeof(ParallelResult));
+  res.schema = schema;
+  res.stopAfter = 10;
+  rc = parallelScan(table, NULL, 4, collectParallel, &res);
+  ASSERT_EQUALS_INT(RC_RM_NO_MORE_TUPLES, rc, "callback result returned");
+  sumParallel(&res, &count, &sum);
+  ASSERT_TRUE(count < numInserts - numDeletes, "scan stopped early");
+
+  TEST_CHECK(closeTable(table));
+  TEST_CHECK(deleteTable("test_table_p"));
+  TEST_CHECK(shutdownRecordManager());
+
+  for(i = 0; i < numInserts; i++)
+    free(batch[i].data);
+  free(batch);
+  free(delRids);
+  freeExpr(sel);
+  freeSchema(schema);
+  free(table);
+  TEST_DONE();
+}
+
+// tuples and sum of a over the matching tuples of column batches
+static RC
+collectColumns (void *context, int worker, RM_ColumnBatch *batch)
+{
+  ParallelResult *res = (ParallelResult *) context;
+  int i, a;
+
+  for(i = 0; i < batch->numSlots; i++)
+    if (BITMAP_TEST(batch->selection, i))
+      {
+	memcpy(&a, batch->columns[0] + (i * batch->strides[0]), sizeof(int));
+	res->count[worker]++;
+	res->sum[worker] += a;
+      }
+  return RC_OK;
+}
+
+void
+testPaxTable(void)
+{
+  RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+  int numInserts = 3000, numFound, i, a, c, count, expCount, rc;
+  long sum, expSum;
+  Record *batch, *r;
+  Record view;
+  RID *delRids;
+  Schema *schema;
+  RM_ScanHandle *sc = (RM_ScanHandle *) malloc(sizeof(RM_ScanHandle));
+  RM_RecordBatch *scanBatch;
+  RM_StringView b;
+  ParallelResult res;
+  Expr *sel, *left, *right;
+
+  testName = "test tables with the PAX page layout";
+  schema = testSchema();
+  batch = (Record *) malloc(sizeof(Record) * numInserts);
+  delRids = (RID *) malloc(sizeof(RID) * numInserts);
+
+  TEST_CHECK(initRecordManager(NULL));
+  TEST_CHECK(createTableWithLayout("test_table_x", schema, RM_LAYOUT_PAX));
+  TEST_CHECK(openTable(table, "test_table_x"));
+
+  // the first tuples one at a time, the others batched
+  for(i = 0; i < numInserts; i++)
+    {
+      r = testRecord(schema, i, "abcd", i % 7);
+      batch[i] = *r;
+      free(r);
+    }
+  for(i = 0; i < 100; i++)
+    TEST_CHECK(insertRecord(table, &batch[i]));
+  TEST_CHECK(insertRecords(table, batch + 100, numInserts - 100));
+  rc = getNumTuples(table);
+  ASSERT_EQUALS_INT(numInserts, rc, "all tuples inserted");
+
+  // update some tuples, then read them back
+  TEST_CHECK(createRecord(&r, schema));
+  for(i = 0; i < numInserts; i += 100)
+    {
+      TEST_CHECK(setAttr(&batch[i], schema, 2, stringToValue("i10")));
+      TEST_CHECK(updateRecord(table, &batch[i]));
+    }
+  for(i = 0; i < numInserts; i += 37)
+    {
+      TEST_CHECK(getRecord(table, batch[i].id, r));
+      ASSERT_TRUE(memcmp(r->data, batch[i].data, getRecordSize(schema)) == 0, "tuple read back from the minipages");
+    }
+
+  // the layout is stored in the table
+  TEST_CHECK(closeTable(table));
+  TEST_CHECK(openTable(table, "test_table_x"));
+
+  expCount = 0;
+  expSum = 0;
+  for(i = 0; i < numInserts; i++)
+    if (i % 100 != 0 && i % 7 == 3)
+      {
+	expCount++;
+	expSum += i;
+      }
+
+  // c = 3 with copying scans, views and batches
+  MAKE_CONS(left, stringToValue("i3"));
+  MAKE_ATTRREF(right, 2);
+  MAKE_BINOP_EXPR(sel, left, right, OP_COMP_EQUAL);
+  TEST_CHECK(startScan(table, sc, sel));
+  numFound = 0;
+  sum = 0;
+  while(next(sc, r) == RC_OK)
+    {
+      TEST_CHECK(getIntAttr(r, schema, 0, &a));
+      TEST_CHECK(getIntAttr(r, schema, 2, &c));
+      if (c != 3)
+	ASSERT_TRUE(FALSE, "scan returns matching tuples");
+      numFound++;
+      sum += a;
+    }
+  TEST_CHECK(closeScan(sc));
+  ASSERT_EQUALS_INT(expCount, numFound, "tuples with c = 3 scanned");
+  ASSERT_TRUE(expSum == sum, "sum of a over the scanned tuples");
+
+  TEST_CHECK(startScan(table, sc, sel));
+  numFound = 0;
+  while(nextView(sc, &view) == RC_OK)
+    {
+      TEST_CHECK(getStringAttr(&view, schema, 1, &b));
+      if (b.length != 4 || memcmp(b.data, "abcd", 4) != 0)
+	ASSERT_TRUE(FALSE, "view gathered from the minipages");
+      numFound++;
+    }
+  TEST_CHECK(closeScan(sc));
+  ASSERT_EQUALS_INT(expCount, numFound, "tuples with c = 3 viewed");
+
+  TEST_CHECK(createRecordBatch(&scanBatch, schema, 256));
+  TEST_CHECK(startScan(table, sc, sel));
+  numFound = 0;
+  while(nextBatch(sc, scanBatch) == RC_OK)
+    numFound += scanBatch->numSelected;
+  TEST_CHECK(closeScan(sc));
+  TEST_CHECK(freeRecordBatch(scanBatch));
+  ASSERT_EQUALS_INT(expCount, numFound, "tuples with c = 3 selected in batches");
+
+  // parallel scans on the minipages, after deleting every 10th tuple
+  for(i = 0; i < numInserts; i += 10)
+    delRids[i / 10] = batch[i].id;
+  TEST_CHECK(deleteRecords(table, delRids, numInserts / 10));
+  expCount = 0;
+  expSum = 0;
+  for(i = 0; i < numInserts; i++)
+    if (i % 10 != 0 && i % 7 == 3)
+      {
+	expCount++;
+	expSum += i;
+      }
+
+  memset(&res, 0, sizeof(ParallelResult));
+  res.schema = schema;
+  TEST_CHECK(parallelScan(table, sel, 4, collectParallel, &res));
+  sumParallel(&res, &count, &sum);
+  ASSERT_EQUALS_INT(expCount, count, "parallel scan returns live tuples with c = 3");
+  ASSERT_TRUE(expSum == sum, "sum of a over the parallel scan");
+
+  memset(&res, 0, sizeof(ParallelResult));
+  res.schema = schema;
+  TEST_CHECK(parallelScanColumns(table, sel, 3, collectColumns, &res));
+  sumParallel(&res, &count, &sum);
+  ASSERT_EQUALS_INT(expCount, count, "column batches select live tuples with c = 3");
+  ASSERT_TRUE(expSum == sum, "sum of a over the columns");
+
+  TEST_CHECK(closeTable(table));
+  TEST_CHECK(deleteTable("test_table_x"));
+  TEST_CHECK(shutdownRecordManager());
+
+  for(i = 0; i < numInserts; i++)
+    free(batch[i].data);
+  free(batch);
+  free(delRids);
+  freeRecord(r);
+  freeExpr(sel);
+  freeSchema(schema);
+  free(sc);
+  free(table);
+  TEST_DONE();
+}
+
+// schema with an attribute for every encoding of compressed pages
+static Schema *
+compressSchema (void)
+{
+  char *names[] = { "a", "b", "c", "d", "e", "f" };
+  DataType dt[] = { DT_INT, DT_STRING, DT_INT, DT_BOOL, DT_FLOAT, DT_STRING };
+  int sizes[] = { 0, 4, 0, 0, 0, 4 };
+  char **cpNames = (char **) malloc(sizeof(char*) * 6);
+  DataType *cpDt = (DataType *) malloc(sizeof(DataType) * 6);
+  int *cpSizes = (int *) malloc(sizeof(int) * 6);
+  int *cpKeys = (int *) malloc(sizeof(int));
+  int i;
+
+  for(i = 0; i < 6; i++)
+    cpNames[i] = strdup(names[i]);
+  memcpy(cpDt, dt, sizeof(DataType) * 6);
+  memcpy(cpSizes, sizes, sizeof(int) * 6);
+  cpKeys[0] = 0;
+  return createSchema(6, cpNames, cpDt, cpSizes, 1, cpKeys);
+}
+
+// a = i, b one of 3 strings, c = i % 7, d in runs of 100, e = i / 2, f unique
+static void
+setCompressRecord (Schema *schema, Record *r, int i)
+{
+  char *bs[] = { "xxxx", "yyyy", "zzzz" };
+  char f[16];
+  Value *value;
+
+  MAKE_VALUE(value, DT_INT, i);
+  setAttr(r, schema, 0, value);
+  value->v.intV = i % 7;
+  setAttr(r, schema, 2, value);
+  freeVal(value);
+  MAKE_STRING_VALUE(value, bs[i % 3]);
+  setAttr(r, schema, 1, value);
+  freeVal(value);
+  MAKE_VALUE(value, DT_BOOL, (i / 100) % 2 == 1);
+  setAttr(r, schema, 3, value);
+  freeVal(value);
+  MAKE_VALUE(value, DT_FLOAT, i / 2.0f);
+  setAttr(r, schema, 4, value);
+  freeVal(value);
+  sprintf(f, "%04d", i % 10000);
+  MAKE_STRING_VALUE(value, f);
+  setAttr(r, schema, 5, value);
+  freeVal(value);
+}
+
+// lookups of one thread on a compressed table, each decoding its pages
+typedef struct CompressedLookups {
+  RM_TableData *table;
+  Schema *schema;
+  RID *rids; // by a, page -1 for deleted tuples
+  int numRids;
+  int numWrong;
+} CompressedLookups;
+
+static void *
+lookupCompressed(void *arg)
+{
+  CompressedLookups *l = (CompressedLookups *) arg;
+  Record *r, *expected;
+  int round, i;
+
+  createRecord(&r, l->schema);
+  createRecord(&expected, l->schema);
+  for(round = 0; round < 3; round++)
+    for(i = 0; i < l->numRids; i++)
+      {
+	if (l->rids[i].page == -1)
+	  continue;
+	setCompressRecord(l->schema, expected, i);
+	if (getRecord(l->table, l->rids[i], r) != RC_OK
+	    || memcmp(r->data, expected->data, getRecordSize(l->schema)) != 0)
+	  l->numWrong++;
+      }
+  freeRecord(expected);
+  freeRecord(r);
+  return NULL;
+}
+
+void
+testCompressTable(void)
+{
+  RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+  int numInserts = 5000, numDeletes = 0, numFound, i, a, count, rc, e;
+  long sum, expSum;
+  Record *batch, *r, *expected;
+  RID *delRids, rid, past;
+  Schema *schema;
+  RM_ScanHandle *sc = (RM_ScanHandle *) malloc(sizeof(RM_ScanHandle));
+  RM_RecordBatch *scanBatch;
+  RM_CompressionStats stats;
+  ParallelResult res;
+  CompressedLookups lookups[2];
+  pthread_t threads[2];
+  RID *scanRids;
+  Expr *sel, *left, *right;
+
+  testName = "test compressing tables";
+  schema = compressSchema();
+  batch = (Record *) malloc(sizeof(Record) * numInserts);
+  delRids = (RID *) malloc(sizeof(RID) * numInserts);
+  scanRids = (RID *) malloc(sizeof(RID) * numInserts);
+  for(i = 0; i < numInserts; i++)
+    scanRids[i].page = -1;
+
+  TEST_CHECK(initRecordManager(NULL));
+  TEST_CHECK(createTable("test_table_z", schema));
+  TEST_CHECK(openTable(table, "test_table_z"));
+
+  for(i = 0; i < numInserts; i++)
+    {
+      TEST_CHECK(createRecord(&r, schema));
+      setCompressRecord(schema, r, i);
+      batch[i] = *r;
+      free(r);
+    }
+  TEST_CHECK(insertRecords(table, batch, numInserts));
+  for(i = 0; i < numInserts; i += 10)
+    delRids[numDeletes++] = batch[i].id;
+  TEST_CHECK(deleteRecords(table, delRids, numDeletes));
+
+  TEST_CHECK(compressTable(table, &stats));
+  ASSERT_TRUE(stats.pagesAfter * 2 < stats.pagesBefore, "compressed to less than half the pages");
+  ASSERT_TRUE(stats.numChunks[RM_ENC_FOR] > 0, "ints use frame of reference");
+  ASSERT_TRUE(stats.numChunks[RM_ENC_DICT] > 0, "strings with few values use a dictionary");
+  ASSERT_TRUE(stats.numChunks[RM_ENC_RLE] > 0, "bools use runs");
+  ASSERT_TRUE(stats.numChunks[RM_ENC_PLAIN] > 0, "floats and unique strings are plain");
+  rc = getNumTuples(table);
+  ASSERT_EQUALS_INT(numInserts - numDeletes, rc, "live tuples kept");
+
+  // cold tables are read only
+  rc = insertRecord(table, &batch[0]);
+  ASSERT_EQUALS_INT(RC_RM_READ_ONLY, rc, "no inserts into a compressed table");
+  rc = updateRecord(table, &batch[1]);
+  ASSERT_EQUALS_INT(RC_RM_READ_ONLY, rc, "no updates of a compressed table");
+  rc = deleteRecords(table, delRids, 1);
+  ASSERT_EQUALS_INT(RC_RM_READ_ONLY, rc, "no deletes from a compressed table");
+
+  // every attribute decoded, compared to the tuple built for a
+  TEST_CHECK(createRecord(&r, schema));
+  TEST_CHECK(createRecord(&expected, schema));
+  rid.page = -1;
+  for(e = 0; e < 2; e++)
+    {
+      TEST_CHECK(startScan(table, sc, NULL));
+      numFound = 0;
+      sum = 0;
+      while(next(sc, r) == RC_OK)
+	{
+	  TEST_CHECK(getIntAttr(r, schema, 0, &a));
+	  setCompressRecord(schema, expected, a);
+	  if (a % 10 == 0 || memcmp(r->data, expected->data, getRecordSize(schema)) != 0)
+	    ASSERT_TRUE(FALSE, "scan decodes live tuples");
+	  if (a == 1234)
+	    rid = r->id;
+	  scanRids[a] = r->id;
+	  numFound++;
+	  sum += a;
+	}
+      TEST_CHECK(closeScan(sc));
+      ASSERT_EQUALS_INT(numInserts - numDeletes, numFound, "all tuples scanned");
+
+      // the table stays compressed when reopened
+      TEST_CHECK(closeTable(table));
+      TEST_CHECK(openTable(table, "test_table_z"));
+    }
+  expSum = 0;
+  for(i = 0; i < numInserts; i++)
+    if (i % 10 != 0)
+      expSum += i;
+  ASSERT_TRUE(expSum == sum, "sum of a over the scan");
+
+  TEST_CHECK(getRecord(table, rid, r));
+  setCompressRecord(schema, expected, 1234);
+  ASSERT_TRUE(memcmp(r->data, expected->data, getRecordSize(schema)) == 0, "tuple read by RID");
+
+  // a RID past the tuples of its page fails single and batched reads
+  past = rid;
+  for(i = 0; i < numInserts; i++)
+    if (scanRids[i].page == rid.page && scanRids[i].slot >= past.slot)
+      past.slot = scanRids[i].slot + 1;
+  ASSERT_ERROR(getRecord(table, past, r), "slot past the tuples of a page");
+  ASSERT_ERROR(getRecords(table, &past, 1, r), "batch with a slot past the tuples of a page");
+
+  // threads looking up tuples of one compressed table at the same time
+  for(i = 0; i < 2; i++)
+    {
+      lookups[i].table = table;
+      lookups[i].schema = schema;
+      lookups[i].rids = scanRids;
+      lookups[i].numRids = numInserts;
+      lookups[i].numWrong = 0;
+      pthread_create(&threads[i], NULL, lookupCompressed, &lookups[i]);
+    }
+  for(i = 0; i < 2; i++)
+    {
+      pthread_join(threads[i], NULL);
+      ASSERT_EQUALS_INT(0, lookups[i].numWrong, "tuples decoded by concurrent lookups");
+    }
+
+  // c = 3 in batches and on parallel workers
+  expSum = 0;
+  count = 0;
+  for(i = 0; i < numInserts; i++)
+    if (i % 10 != 0 && i % 7 == 3)
+      {
+	count++;
+	expSum += i;
+      }
+  MAKE_CONS(left, stringToValue("i3"));
+  MAKE_ATTRREF(right, 2);
+  MAKE_BINOP_EXPR(sel, left, right, OP_COMP_EQUAL);
+  TEST_CHECK(createRecordBatch(&scanBatch, schema, 300));
+  TEST_CHECK(startScan(table, sc, sel));
+  numFound = 0;
+  while(nextBatch(sc, scanBatch) == RC_OK)
+    numFound += scanBatch->numSelected;
+  TEST_CHECK(closeScan(sc));
+  TEST_CHECK(freeRecordBatch(scanBatch));
+  ASSERT_EQUALS_INT(count, numFound, "tuples with c = 3 selected in batches");
+
+  memset(&res, 0, sizeof(ParallelResult));
+  res.schema = schema;
+  TEST_CHECK(parallelScan(table, sel, 4, collectParallel, &res));
+  sumParallel(&res, &numFound, &sum);
+  ASSERT_EQUALS_INT(count, numFound, "parallel scan returns tuples with c = 3");
+  ASSERT_TRUE(expSum == sum, "sum of a over the parallel scan");
+
+  TEST_CHECK(compressTable(table, &stats));
+  ASSERT_EQUALS_INT(stats.pagesBefore, stats.pagesAfter, "compressing again changes nothing");
+
+  TEST_CHECK(closeTable(table));
+  TEST_CHECK(deleteTable("test_table_z"));
+  TEST_CHECK(shutdownRecordManager());
+
+  for(i = 0; i < numInserts; i++)
+    free(batch[i].data);
+  free(batch);
+  free(delRids);
+  free(scanRids);
+  freeRecord(r);
+  freeRecord(expected);
+  freeExpr(sel);
+  freeSchema(schema);
+  free(sc);
+  free(table);
+  TEST_DONE();
+}
+
+Schema *
+testSchema (void)
+{
+  Schema *result;
+  char *names[] = { "a", "b", "c" };
+  DataType dt[] = { DT_INT, DT_STRING, DT_INT };
+  int sizes[] = { 0, 4, 0 };
+  int keys[] = {0};
+  int i;
+  char **cpNames = (char **) malloc(sizeof(char*) * 3);
+  DataType *cpDt = (DataType *) malloc(sizeof(DataType) * 3);
+  int *cpSizes = (int *) malloc(sizeof(int) * 3);
+  int *cpKeys = (int *) malloc(sizeof(int));
+
+  for(i = 0; i < 3; i++)
+    {
+      cpNames[i] = (char *) malloc(2);
+      strcpy(cpNames[i], names[i]);
+    }
+  memcpy(cpDt, dt, sizeof(DataType) * 3);
+  memcpy(cpSizes, sizes, sizeof(int) * 3);
+  memcpy(cpKeys, keys, sizeof(int));
+
+  result = createSchema(3, cpNames, cpDt, cpSizes, 1, cpKeys);
+
+  return result;
+}
+
+Record *
+fromTestRecord (Schema *schema, TestRecord in)
+{
+  return testRecord(schema, in.a, in.b, in.c);
+}
+
+Record *
+testRecord(Schema *schema, int a, char *b, int c)
+{
+  Record *result;
+  Value *value;
+
+  TEST_CHECK(createRecord(&result, schema));
+
+  MAKE_VALUE(value, DT_INT, a);
+  TEST_CHECK(setAttr(result, schema, 0, value));
+  freeVal(value);
+
+  MAKE_STRING_VALUE(value, b);
+  TEST_CHECK(setAttr(result, schema, 1, value));
+  freeVal(value);
+
+  MAKE_VALUE(value, DT_INT, c);
+  TEST_CHECK(setAttr(result, schema, 2, value));
+  freeVal(value);
+
+  return result;
+}
+
+// count the tuples a scan returns and the pages it skipped
+static int
+countScan (RM_TableData *table, Expr *cond, RM_ScanStats *stats)
+{
+  RM_ScanHandle sc;
+  Record view;
+  int numFound = 0;
+
+  startScan(table, &sc, cond);
+  while(nextView(&sc, &view) == RC_OK)
+    numFound++;
+  getScanStats(&sc, stats);
+  closeScan(&sc);
+  return numFound;
+}
+
+void
+testZoneMaps(void)
+{
+  RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+  int numInserts = 2000, numFound, i;
+  char b[5];
+  Record *r;
+  RID rid;
+  Schema *schema;
+  RM_ScanStats stats;
+  Expr *sel, *left, *right, *lower, *upper;
+
+  testName = "test zone maps skipping pages of scans";
+  schema = testSchema();
+
+  TEST_CHECK(initRecordManager(NULL));
+  TEST_CHECK(createTable("test_table_z",schema));
+  TEST_CHECK(openTable(table, "test_table_z"));
+
+  // a ascending, b the hundreds of a
+  for(i = 0; i < numInserts; i++)
+  {
+      sprintf(b, "k%03d", i / 100);
+      r = testRecord(schema, i, b, i % 7);
+      TEST_CHECK(insertRecord(table,r));
+      if (i == 10)
+	rid = r->id;
+      freeRecord(r);
+  }
+
+  // 1500 <= a < 1600
+  MAKE_ATTRREF(left, 0);
+  MAKE_CONS(right, stringToValue("i1500"));
+  MAKE_BINOP_EXPR(lower, left, right, OP_COMP_GREATER_EQUAL);
+  MAKE_CONS(left, stringToValue("i1600"));
+  MAKE_ATTRREF(right, 0);
+  MAKE_BINOP_EXPR(upper, left, right, OP_COMP_GREATER);
+  MAKE_BINOP_EXPR(sel, lower, upper, OP_BOOL_AND);
+  numFound = countScan(table, sel, &stats);
+  ASSERT_EQUALS_INT(100, numFound, "100 tuples in range");
+  ASSERT_TRUE(stats.pagesSkipped > 0, "pages outside the range skipped");
+  ASSERT_TRUE(stats.pagesPinned < stats.pagesSkipped, "few pages read");
+
+  // moving a tuple of the first page into the range keeps it visible
+  r = testRecord(schema, 1550, "k015", 0);
+  r->id = rid;
+  TEST_CHECK(updateRecord(table, r));
+  freeRecord(r);
+  numFound = countScan(table, sel, &stats);
+  ASSERT_EQUALS_INT(101, numFound, "updated tuple in range");
+
+  // zone maps survive closing the table
+  TEST_CHECK(closeTable(table));
+  TEST_CHECK(openTable(table, "test_table_z"));
+  numFound = countScan(table, sel, &stats);
+  ASSERT_EQUALS_INT(101, numFound, "range after reopening");
+  ASSERT_TRUE(stats.pagesSkipped > 0, "pages skipped after reopening");
+  freeExpr(sel);
+
+  // string prefixes: b = 'k019' and b starting with 'k00'
+  MAKE_ATTRREF(left, 1);
+  MAKE_CONS(right, stringToValue("sk019"));
+  MAKE_BINOP_EXPR(sel, left, right, OP_COMP_EQUAL);
+  numFound = countScan(table, sel, &stats);
+  ASSERT_EQUALS_INT(100, numFound, "string equality");
+  ASSERT_TRUE(stats.pagesSkipped > 0, "pages skipped on strings");
+  freeExpr(sel);
+  MAKE_ATTRREF(left, 1);
+  MAKE_CONS(right, stringToValue("sk00"));
+  MAKE_BINOP_EXPR(sel, left, right, OP_COMP_PREFIX);
+  numFound = countScan(table, sel, &stats);
+  ASSERT_EQUALS_INT(999, numFound, "string prefix without the updated tuple");
+  ASSERT_TRUE(stats.pagesSkipped > 0, "pages skipped on prefixes");
+  freeExpr(sel);
+
+  // skipped pages of a deleted range
+  for(rid.page = 1; rid.page < 3; rid.page++)
+    for(rid.slot = 0; rid.slot < 10; rid.slot++)
+      deleteRecord(table, rid);
+  numFound = countScan(table, NULL, &stats);
+  ASSERT_EQUALS_INT(numInserts - 20, numFound, "full scan after deletes");
+  ASSERT_EQUALS_INT(0, stats.pagesSkipped, "full scan skips nothing");
+
+  // deleting a tuple twice fails and leaves the live counts alone
+  rid.page = 1;
+  for(rid.slot = 0; rid.slot < 10; rid.slot++)
+    ASSERT_ERROR(deleteRecord(table, rid), "tuple already deleted");
+  ASSERT_EQUALS_INT(numInserts - 20, getNumTuples(table), "double deletes not counted");
+  numFound = countScan(table, NULL, &stats);
+  ASSERT_EQUALS_INT(numInserts - 20, numFound, "no live tuple skipped after double deletes");
+
+  TEST_CHECK(closeTable(table));
+  TEST_CHECK(deleteTable("test_table_z"));
+  TEST_CHECK(shutdownRecordManager());
+
+  freeSchema(schema);
+  free(table);
+  TEST_DONE();
+}
+
+void
+testBloomFilters(void)
+{
+  RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+  int numInserts = 2000, numFound, i;
+  char b[5];
+  Record *r;
+  RID rid;
+  Schema *schema;
+  RM_ScanStats stats;
+  Expr *sel, *left, *right;
+
+  testName = "test bloom filters skipping pages of equality scans";
+  schema = testSchema();
+
+  TEST_CHECK(initRecordManager(NULL));
+  TEST_CHECK(createTable("test_table_bf",schema));
+  TEST_CHECK(openTable(table, "test_table_bf"));
+
+  // a and b scattered over all pages, so the zone maps do not help
+  for(i = 0; i < numInserts; i++)
+  {
+      sprintf(b, "%04d", (i * 7919) % numInserts);
+      r = testRecord(schema, (i * 7919) % numInserts, b, i % 7);
+      TEST_CHECK(insertRecord(table,r));
+      if ((i * 7919) % numInserts == 1234)
+	rid = r->id;
+      freeRecord(r);
+  }
+  TEST_CHECK(createBloomFilter(table, 0));
+
+  // a = 1234
+  MAKE_ATTRREF(left, 0);
+  MAKE_CONS(right, stringToValue("i1234"));
+  MAKE_BINOP_EXPR(sel, left, right, OP_COMP_EQUAL);
+  numFound = countScan(table, sel, &stats);
+  ASSERT_EQUALS_INT(1, numFound, "one tuple with a = 1234");
+  ASSERT_TRUE(stats.bloomSkipped > 0, "pages skipped by the bloom filter");
+  ASSERT_TRUE(stats.pagesPinned < stats.bloomSkipped, "few pages read");
+
+  // the filter is rebuilt by the first scan reading the page after the delete
+  TEST_CHECK(deleteRecord(table, rid));
+  numFound = countScan(table, sel, &stats);
+  ASSERT_EQUALS_INT(0, numFound, "deleted tuple not found");
+  ASSERT_TRUE(stats.pagesPinned > 0, "page with deletes read");
+  numFound = countScan(table, sel, &stats);
+  ASSERT_EQUALS_INT(0, stats.pagesPinned, "rebuilt filter skips the page");
+
+  // tuples inserted later are added to the filters
+  r = testRecord(schema, 1234, "xxxx", 0);
+  TEST_CHECK(insertRecord(table, r));
+  freeRecord(r);
+  numFound = countScan(table, sel, &stats);
+  ASSERT_EQUALS_INT(1, numFound, "inserted tuple found");
+  freeExpr(sel);
+
+  // strings, filters built after the inserts
+  TEST_CHECK(createBloomFilter(table, 1));
+  MAKE_ATTRREF(left, 1);
+  MAKE_CONS(right, stringToValue("s0042"));
+  MAKE_BINOP_EXPR(sel, left, right, OP_COMP_EQUAL);
+  numFound = countScan(table, sel, &stats);
+  ASSERT_EQUALS_INT(1, numFound, "one tuple with b = '0042'");
+  ASSERT_TRUE(stats.bloomSkipped > 0, "pages skipped on strings");
+  freeExpr(sel);
+
+  // dropped filters skip nothing
+  TEST_CHECK(dropBloomFilter(table, 0));
+  MAKE_ATTRREF(left, 0);
+  MAKE_CONS(right, stringToValue("i42"));
+  MAKE_BINOP_EXPR(sel, left, right, OP_COMP_EQUAL);
+  numFound = countScan(table, sel, &stats);
+  ASSERT_EQUALS_INT(1, numFound, "one tuple with a = 42");
+  ASSERT_EQUALS_INT(0, stats.bloomSkipped, "no filter on a");
+  freeExpr(sel);
+
+  TEST_CHECK(closeTable(table));
+  TEST_CHECK(deleteTable("test_table_bf"));
+  TEST_CHECK(shutdownRecordManager());
+
+  freeSchema(schema);
+  free(table);
+  TEST_DONE();
+}
+
+// count the live tuples of a table with batched scans
+static int
+countTuples (RM_TableData *table, Schema *schema)
+{
+  RM_ScanHandle sc;
+  RM_RecordBatch *batch;
+  int numFound = 0;
+
+  createRecordBatch(&batch, schema, 64);
+  startScan(table, &sc, NULL);
+  while(nextBatch(&sc, batch) == RC_OK)
+    numFound += batch->numRecords;
+  closeScan(&sc);
+  freeRecordBatch(batch);
+  return numFound;
+}
+
+void
+testCompactTable(void)
+{
+  RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+  int numInserts = 2000, numFound, numWrong, numPages, i, a;
+  RID *rids = (RID *) malloc(sizeof(RID) * numInserts);
+  Record *r;
+  Schema *schema;
+  RM_CompactionStats stats;
+
+  testName = "test compacting a table with moved tuples keeping their RIDs";
+  schema = testSchema();
+
+  TEST_CHECK(initRecordManager(NULL));
+  TEST_CHECK(createTable("test_table_c",schema));
+  TEST_CHECK(openTable(table, "test_table_c"));
+
+  for(i = 0; i < numInserts; i++)
+  {
+      r = testRecord(schema, i, "aaaa", i % 7);
+      TEST_CHECK(insertRecord(table,r));
+      rids[i] = r->id;
+      freeRecord(r);
+  }
+
+  // every other tuple deleted, the pages are half empty
+  for(i = 0; i < numInserts; i += 2)
+    TEST_CHECK(deleteRecord(table, rids[i]));
+
+  // in two steps
+  TEST_CHECK(compactTable(table, 2, &stats));
+  numPages = stats.pagesBefore;
+  ASSERT_EQUALS_INT(2, stats.pagesMoved, "first step empties 2 pages");
+  ASSERT_EQUALS_INT(stats.pagesBefore - 2, stats.pagesAfter, "2 pages truncated");
+  TEST_CHECK(compactTable(table, 0, &stats));
+  ASSERT_TRUE(stats.pagesAfter <= numPages / 2 + 1, "about half of the pages left");
+  ASSERT_TRUE(stats.tuplesMoved > 0, "tuples moved");
+  numFound = countTuples(table, schema);
+  ASSERT_EQUALS_INT(numInserts / 2, numFound, "live tuples after compaction");
+
+  // the old RIDs lead to the moved tuples
+  TEST_CHECK(createRecord(&r, schema));
+  numWrong = 0;
+  for(i = 1; i < numInserts; i += 2)
+  {
+      TEST_CHECK(getRecord(table, rids[i], r));
+      TEST_CHECK(getIntAttr(r, schema, 0, &a));
+      if (a != i || r->id.page != rids[i].page || r->id.slot != rids[i].slot)
+	numWrong++;
+  }
+  ASSERT_EQUALS_INT(0, numWrong, "all tuples found by their old RIDs");
+  freeRecord(r);
+
+  // updates and deletes through old RIDs
+  r = testRecord(schema, -1, "bbbb", 0);
+  r->id = rids[numInserts - 1];
+  TEST_CHECK(updateRecord(table, r));
+  freeRecord(r);
+  TEST_CHECK(deleteRecord(table, rids[numInserts - 3]));
+  numFound = getNumTuples(table);
+  ASSERT_EQUALS_INT(numInserts / 2 - 1, numFound, "deleted through an old RID");
+
+  // old RIDs survive reopening and new pages with the numbers of truncated ones
+  TEST_CHECK(closeTable(table));
+  TEST_CHECK(openTable(table, "test_table_c"));
+  for(i = 0; i < numInserts; i++)
+  {
+      r = testRecord(schema, numInserts + i, "cccc", 0);
+      TEST_CHECK(insertRecord(table,r));
+      freeRecord(r);
+  }
+  TEST_CHECK(createRecord(&r, schema));
+  numWrong = 0;
+  for(i = 1; i < numInserts - 3; i += 2)
+  {
+      TEST_CHECK(getRecord(table, rids[i], r));
+      TEST_CHECK(getIntAttr(r, schema, 0, &a));
+      if (a != i)
+	numWrong++;
+  }
+  ASSERT_EQUALS_INT(0, numWrong, "old RIDs after inserts into new pages");
+  TEST_CHECK(getRecord(table, rids[numInserts - 1], r));
+  TEST_CHECK(getIntAttr(r, schema, 0, &a));
+  ASSERT_EQUALS_INT(-1, a, "updated tuple");
+  freeRecord(r);
+  numFound = countTuples(table, schema);
+  ASSERT_EQUALS_INT(numInserts / 2 - 1 + numInserts, numFound, "live tuples after inserts");
+
+  TEST_CHECK(closeTable(table));
+  TEST_CHECK(deleteTable("test_table_c"));
+  TEST_CHECK(shutdownRecordManager());
+
+  freeSchema(schema);
+  free(rids);
+  free(table);
+  TEST_DONE();
+}
+
+void
+testScanDeletes(void)
+{
+  RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+  int numInserts = 2000, numFound, numWrong, i, a;
+  RID *rids = (RID *) malloc(sizeof(RID) * numInserts);
+  Record *r;
+  Schema *schema;
+  RM_ScanHandle sc;
+  RM_ScanStats stats;
+  RC rc;
+
+  testName = "test scans skipping deleted tuples and empty pages";
+  schema = testSchema();
+
+  TEST_CHECK(initRecordManager(NULL));
+  TEST_CHECK(createTable("test_table_d",schema));
+  TEST_CHECK(openTable(table, "test_table_d"));
+
+  for(i = 0; i < numInserts; i++)
+  {
+      r = testRecord(schema, i, "aaaa", i % 7);
+      TEST_CHECK(insertRecord(table,r));
+      rids[i] = r->id;
+      freeRecord(r);
+  }
+
+  // the first half deleted, emptying the first pages, and every third tuple of the rest
+  for(i = 0; i < numInserts; i++)
+    if (i < numInserts / 2 || i % 3 == 0)
+      TEST_CHECK(deleteRecord(table, rids[i]));
+
+  TEST_CHECK(createRecord(&r, schema));
+  TEST_CHECK(startScan(table, &sc, NULL));
+  numFound = 0;
+  numWrong = 0;
+  while((rc = next(&sc, r)) == RC_OK)
+  {
+      TEST_CHECK(getIntAttr(r, schema, 0, &a));
+      if (a < numInserts / 2 || a % 3 == 0)
+	numWrong++;
+      numFound++;
+  }
+  ASSERT_EQUALS_INT(RC_RM_NO_MORE_TUPLES, rc, "scan ends");
+  getScanStats(&sc, &stats);
+  TEST_CHECK(closeScan(&sc));
+  freeRecord(r);
+  ASSERT_EQUALS_INT(0, numWrong, "no deleted tuple returned");
+  ASSERT_EQUALS_INT(getNumTuples(table), numFound, "all live tuples returned");
+  ASSERT_TRUE(stats.pagesSkipped > 0, "empty pages skipped");
+
+  // a table without live tuples reads no page
+  for(i = numInserts / 2; i < numInserts; i++)
+    if (i % 3 != 0)
+      TEST_CHECK(deleteRecord(table, rids[i]));
+  numFound = countScan(table, NULL, &stats);
+  ASSERT_EQUALS_INT(0, numFound, "no tuples left");
+  ASSERT_EQUALS_INT(0, stats.pagesPinned, "no page read");
+
+  TEST_CHECK(closeTable(table));
+  TEST_CHECK(deleteTable("test_table_d"));
+  TEST_CHECK(shutdownRecordManager());
+
+  freeSchema(schema);
+  free(rids);
+  free(table);
+  TEST_DONE();
+}
+
+void
+testSharedPool(void)
+{
+  RM_TableData *big = (RM_TableData *) malloc(sizeof(RM_TableData));
+  RM_TableData *small = (RM_TableData *) malloc(sizeof(RM_TableData));
+  ReplacementStrategy strategies[3] = { RS_FIFO, RS_LRU, RS_CLOCK };
+  RM_Config config;
+  RM_CatalogStats stats;
+  Record *r;
+  Schema *schema;
+  long numReads;
+  int numFound, i, s;
+  RC rc;
+
+  testName = "test tables sharing one buffer pool with quotas";
+  schema = testSchema();
+
+  for(s = 0; s < 3; s++)
+  {
+      // 16 frames for a table of about 35 pages and one of 2
+      config.poolFrames = 16;
+      config.strategy = strategies[s];
+      config.tableQuota = 0;
+      TEST_CHECK(initRecordManager(&config));
+      TEST_CHECK(createTable("test_table_big",schema));
+      TEST_CHECK(createTable("test_table_small",schema));
+      TEST_CHECK(openTable(big, "test_table_big"));
+      TEST_CHECK(openTable(small, "test_table_small"));
+      for(i = 0; i < 10000; i++)
+      {
+	  r = testRecord(schema, i, "aaaa", i % 7);
+	  TEST_CHECK(insertRecord(i < 100 ? small : big, r));
+	  freeRecord(r);
+      }
+      numFound = countTuples(big, schema);
+      ASSERT_EQUALS_INT(9900, numFound, "big table read through the shared pool");
+      numFound = countTuples(small, schema);
+      ASSERT_EQUALS_INT(100, numFound, "small table read through the shared pool");
+
+      TEST_CHECK(getCatalogStats(&stats));
+      ASSERT_EQUALS_INT(2, stats.numTables, "two open tables");
+      ASSERT_EQUALS_INT(16, stats.poolFrames, "pool frames");
+      ASSERT_TRUE(stats.numHits > 0 && stats.numReadIO > 0, "hits and reads counted");
+      rc = shutdownRecordManager();
+      ASSERT_EQUALS_INT(RC_BM_POOL_IN_USE, rc, "pool in use by open tables");
+
+      // a scan of the big table limited to 4 frames keeps the pages of the small one
+      TEST_CHECK(setTableQuota(big, 4));
+      countTuples(big, schema);
+      TEST_CHECK(getCatalogStats(&stats));
+      numReads = stats.numReadIO;
+      countTuples(small, schema);
+      TEST_CHECK(getCatalogStats(&stats));
+      ASSERT_EQUALS_INT((int) numReads, (int) stats.numReadIO, "small table still buffered");
+
+      // without the quota it replaces them
+      TEST_CHECK(setTableQuota(big, 0));
+      countTuples(big, schema);
+      TEST_CHECK(getCatalogStats(&stats));
+      numReads = stats.numReadIO;
+      countTuples(small, schema);
+      TEST_CHECK(getCatalogStats(&stats));
+      ASSERT_TRUE(stats.numReadIO > numReads, "small table replaced");
+
+      TEST_CHECK(closeTable(big));
+      TEST_CHECK(closeTable(small));
+      TEST_CHECK(getCatalogStats(&stats));
+      ASSERT_EQUALS_INT(0, stats.numTables, "no open tables");
+      TEST_CHECK(deleteTable("test_table_big"));
+      TEST_CHECK(deleteTable("test_table_small"));
+      TEST_CHECK(shutdownRecordManager());
+  }
+
+  freeSchema(schema);
+  free(big);
+  free(small);
+  TEST_DONE();
+}
+
+void
+testTableOptions(void)
+{
+  RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+  ReplacementStrategy strategies[3] = { RS_FIFO, RS_LRU, RS_CLOCK };
+  RM_TableOptions options;
+  RM_CatalogStats stats;
+  RM_CompactionStats cstats;
+  RM_ScanHandle sc, scans[3];
+  Record *r;
+  Schema *schema;
+  RID *rids = (RID *) malloc(sizeof(RID) * 2000);
+  int numFound, numRead, numWrong, i, s, a;
+  RC rc;
+
+  testName = "test table options and resizing an open pool";
+  schema = testSchema();
+
+  for(s = 0; s < 3; s++)
+  {
+      // 8 frames of its own for a table of about 35 pages, written back and read ahead
+      options.poolFrames = 8;
+      options.strategy = strategies[s];
+      options.readAhead = 4;
+      options.writePolicy = BM_WRITE_BACK;
+      TEST_CHECK(initRecordManager(NULL));
+      TEST_CHECK(createTable("test_table_o",schema));
+      TEST_CHECK(openTableWithOptions(table, "test_table_o", &options));
+      for(i = 0; i < 10000; i++)
+      {
+	  r = testRecord(schema, i, "aaaa", i % 7);
+	  TEST_CHECK(insertRecord(table, r));
+	  freeRecord(r);
+      }
+      numFound = countTuples(table, schema);
+      ASSERT_EQUALS_INT(10000, numFound, "tuples read ahead");
+      TEST_CHECK(getCatalogStats(&stats));
+      ASSERT_EQUALS_INT(RM_DEFAULT_POOL_FRAMES * PAGE_SIZE + 8 * PAGE_SIZE, (int) stats.poolBytes, "own frames counted");
+
+      // grown and shrunk while a scan keeps a page pinned
+      TEST_CHECK(createRecord(&r, schema));
+      TEST_CHECK(startScan(table, &sc, NULL));
+      numFound = 0;
+      while(next(&sc, r) == RC_OK)
+      {
+	  if (numFound == 100)
+	    {
+	      TEST_CHECK(resizeTablePool(table, 64));
+	    }
+	  else if (numFound == 5000)
+	    {
+	      TEST_CHECK(resizeTablePool(table, RM_MIN_POOL_FRAMES));
+	    }
+	  numFound++;
+      }
+      TEST_CHECK(closeScan(&sc));
+      freeRecord(r);
+      ASSERT_EQUALS_INT(10000, numFound, "scan across resizes");
+      rc = resizeTablePool(table, 0);
+      ASSERT_EQUALS_INT(RC_RM_POOL_TOO_SMALL, rc, "at least one frame");
+      rc = resizeTablePool(table, RM_MIN_POOL_FRAMES - 1);
+      ASSERT_EQUALS_INT(RC_RM_POOL_TOO_SMALL, rc, "fewer frames than an operation pins");
+
+      // the written back pages reach the file when the table is closed
+      TEST_CHECK(closeTable(table));
+      TEST_CHECK(openTable(table, "test_table_o"));
+      numFound = countTuples(table, schema);
+      ASSERT_EQUALS_INT(10000, numFound, "tuples after closing");
+      rc = resizeTablePool(table, 16);
+      ASSERT_EQUALS_INT(RC_BM_POOL_IN_USE, rc, "shared pool not resized by a table");
+      TEST_CHECK(closeTable(table));
+
+      // reading ahead reads every page once, like reading page by page
+      options.readAhead = 0;
+      TEST_CHECK(openTableWithOptions(table, "test_table_o", &options));
+      countTuples(table, schema);
+      TEST_CHECK(getCatalogStats(&stats));
+      numRead = (int) stats.numReadIO;
+      TEST_CHECK(closeTable(table));
+      options.readAhead = 4;
+      TEST_CHECK(openTableWithOptions(table, "test_table_o", &options));
+      countTuples(table, schema);
+      TEST_CHECK(getCatalogStats(&stats));
+      ASSERT_EQUALS_INT(numRead, (int) stats.numReadIO, "pages read once when reading ahead");
+      TEST_CHECK(closeTable(table));
+
+      // a huge read ahead is cut to BM_MAX_READ_AHEAD pages
+      options.poolFrames = 128;
+      options.readAhead = 1000000;
+      TEST_CHECK(openTableWithOptions(table, "test_table_o", &options));
+      numFound = countTuples(table, schema);
+      ASSERT_EQUALS_INT(10000, numFound, "tuples read with a huge read ahead");
+      TEST_CHECK(closeTable(table));
+      TEST_CHECK(deleteTable("test_table_o"));
+      TEST_CHECK(shutdownRecordManager());
+  }
+
+  // a pool too small or a missing file leaves no table open
+  TEST_CHECK(initRecordManager(NULL));
+  TEST_CHECK(createTable("test_table_o",schema));
+  options.poolFrames = RM_MIN_POOL_FRAMES - 1;
+  options.strategy = RS_LRU;
+  options.readAhead = 0;
+  options.writePolicy = BM_WRITE_THROUGH;
+  rc = openTableWithOptions(table, "test_table_o", &options);
+  ASSERT_EQUALS_INT(RC_RM_POOL_TOO_SMALL, rc, "pool smaller than RM_MIN_POOL_FRAMES");
+  options.poolFrames = RM_MIN_POOL_FRAMES;
+  rc = openTableWithOptions(table, "test_table_missing", &options);
+  ASSERT_EQUALS_INT(RC_FILE_NOT_FOUND, rc, "own pool of a missing table");
+  rc = openTable(table, "test_table_missing");
+  ASSERT_EQUALS_INT(RC_FILE_NOT_FOUND, rc, "shared pool of a missing table");
+  TEST_CHECK(getCatalogStats(&stats));
+  ASSERT_EQUALS_INT(0, stats.numTables, "no table registered");
+
+  // compacting in the smallest pool fails while scans keep 3 other pages pinned
+  TEST_CHECK(openTableWithOptions(table, "test_table_o", &options));
+  for(i = 0; i < 2000; i++)
+  {
+      r = testRecord(schema, i, "aaaa", i % 7);
+      TEST_CHECK(insertRecord(table, r));
+      rids[i] = r->id;
+      freeRecord(r);
+  }
+  for(i = 0; i < 2000; i += 2)
+    TEST_CHECK(deleteRecord(table, rids[i]));
+  TEST_CHECK(createRecord(&r, schema));
+  for(s = 0; s < 3; s++)
+  {
+      TEST_CHECK(startScan(table, &scans[s], NULL));
+      for(i = 0; i <= 300 + 200 * s; i++)
+	TEST_CHECK(next(&scans[s], r));
+  }
+  rc = compactTable(table, 0, &cstats);
+  ASSERT_EQUALS_INT(RC_BM_NO_FREE_FRAME, rc, "no frame left for the target page");
+  for(s = 0; s < 3; s++)
+    TEST_CHECK(closeScan(&scans[s]));
+  numFound = countTuples(table, schema);
+  ASSERT_EQUALS_INT(1000, numFound, "no tuple lost by a failed compaction");
+
+  // and succeeds once they are closed
+  TEST_CHECK(compactTable(table, 0, &cstats));
+  ASSERT_TRUE(cstats.pagesMoved > 0, "pages emptied in the smallest pool");
+  numWrong = 0;
+  for(i = 1; i < 2000; i += 2)
+  {
+      TEST_CHECK(getRecord(table, rids[i], r));
+      TEST_CHECK(getIntAttr(r, schema, 0, &a));
+      if (a != i)
+	numWrong++;
+  }
+  ASSERT_EQUALS_INT(0, numWrong, "moved tuples found by their old RIDs");
+  freeRecord(r);
+  TEST_CHECK(closeTable(table));
+  TEST_CHECK(deleteTable("test_table_o"));
+  TEST_CHECK(shutdownRecordManager());
+
+  freeSchema(schema);
+  free(rids);
+  free(table);
+  TEST_DONE();
+}
+
+void
+testReadBlocks(void)
+{
+  SM_FileHandle fh;
+  SM_PageHandle pages[3 * SM_MAX_READ_BLOCKS];
+  char page[PAGE_SIZE];
+  int numPages = 3 * SM_MAX_READ_BLOCKS, numWrong = 0, i;
+
+  testName = "test reading more pages than one system call takes";
+
+  TEST_CHECK(createPageFile("test_table_b"));
+  TEST_CHECK(openPageFile("test_table_b", &fh));
+  TEST_CHECK(ensureCapacity(numPages + 2, &fh));
+  for(i = 0; i < numPages + 2; i++)
+  {
+      memset(page, i, PAGE_SIZE);
+      TEST_CHECK(writeBlock(i, &fh, page));
+  }
+  for(i = 0; i < numPages; i++)
+    pages[i] = (SM_PageHandle) malloc(PAGE_SIZE);
+
+  TEST_CHECK(readBlocks(1, numPages, &fh, pages));
+  for(i = 0; i < numPages; i++)
+    if (pages[i][0] != (char) (i + 1) || pages[i][PAGE_SIZE - 1] != (char) (i + 1))
+      numWrong++;
+  ASSERT_EQUALS_INT(0, numWrong, "pages read in chunks of SM_MAX_READ_BLOCKS");
+  ASSERT_EQUALS_INT(numPages, getBlockPos(&fh), "position after the last page read");
+
+  for(i = 0; i < numPages; i++)
+    free(pages[i]);
+  TEST_CHECK(closePageFile(&fh));
+  TEST_CHECK(destroyPageFile("test_table_b"));
+  TEST_DONE();
+}
+
+// lookups of one thread while the shared pool is resized
+typedef struct ResizeLookups {
+  RM_TableData *table;
+  Schema *schema;
+  RID *rids;
+  int numRids;
+  int stop; // set with __atomic_store_n by the resizing thread
+  int numLookups; // read after the thread is joined
+  int numWrong;
+} ResizeLookups;
+
+static void *
+lookupWhileResizing(void *arg)
+{
+  ResizeLookups *l = (ResizeLookups *) arg;
+  Record *r;
+  Value *v;
+  int i;
+
+  createRecord(&r, l->schema);
+  for(i = 0; !__atomic_load_n(&l->stop, __ATOMIC_ACQUIRE); i = (i + 7919) % l->numRids)
+  {
+      if (getRecord(l->table, l->rids[i], r) != RC_OK)
+	l->numWrong++;
+      else
+	{
+	  getAttr(r, l->schema, 0, &v);
+	  if (v->v.intV != i)
+	    l->numWrong++;
+	  freeVal(v);
+	}
+      l->numLookups++;
+  }
+  freeRecord(r);
+  return NULL;
+}
+
+void
+testOnlineResize(void)
+{
+  RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+  ReplacementStrategy strategies[3] = { RS_FIFO, RS_LRU, RS_CLOCK };
+  BM_SharedPool sp;
+  BM_BufferPool bm;
+  BM_PageHandle h[10];
+  SM_FileHandle fh;
+  RM_Config config;
+  RM_CatalogStats stats;
+  ResizeLookups lookups[2];
+  pthread_t threads[2];
+  Record *r;
+  Schema *schema;
+  RID *rids;
+  int numFound, i, s;
+
+  testName = "test resizing a shared pool while pages are pinned";
+  schema = testSchema();
+  rids = (RID *) malloc(sizeof(RID) * 5000);
+
+  for(s = 0; s < 3; s++)
+  {
+      TEST_CHECK(createPageFile("test_table_r"));
+      TEST_CHECK(openPageFile("test_table_r", &fh));
+      TEST_CHECK(ensureCapacity(16, &fh));
+      TEST_CHECK(closePageFile(&fh));
+      TEST_CHECK(initSharedPool(&sp, 8, strategies[s]));
+      TEST_CHECK(initBufferPoolShared(&bm, "test_table_r", &sp, 0));
+
+      // shrinking below the pinned pages drops the other frames now and the pinned ones when unpinned
+      for(i = 0; i < 6; i++)
+      {
+	  TEST_CHECK(pinPage(&bm, &h[i], i));
+      }
+      TEST_CHECK(resizeSharedPool(&sp, 2));
+      ASSERT_EQUALS_INT(2, sp.numPages, "new size");
+      getFixCounts(&bm);
+      ASSERT_EQUALS_INT(6, bm.numPages, "pinned frames kept");
+      for(i = 0; i < 4; i++)
+      {
+	  TEST_CHECK(unpinPage(&bm, &h[i]));
+      }
+      getFixCounts(&bm);
+      ASSERT_EQUALS_INT(2, bm.numPages, "frames dropped when unpinned");
+      numFound = getFrameContents(&bm)[0] + getFrameContents(&bm)[1];
+      ASSERT_EQUALS_INT(4 + 5, numFound, "pinned pages stay buffered");
+      for(i = 4; i < 6; i++)
+      {
+	  TEST_CHECK(unpinPage(&bm, &h[i]));
+      }
+
+      // growing makes room for more pinned pages
+      TEST_CHECK(resizeSharedPool(&sp, 10));
+      for(i = 0; i < 10; i++)
+      {
+	  TEST_CHECK(pinPage(&bm, &h[i], i));
+      }
+      getFixCounts(&bm);
+      ASSERT_EQUALS_INT(10, bm.numPages, "grown frames");
+      for(i = 0; i < 10; i++)
+      {
+	  TEST_CHECK(unpinPage(&bm, &h[i]));
+      }
+      ASSERT_TRUE(resizeSharedPool(&sp, 0) != RC_OK, "at least one frame");
+      TEST_CHECK(shutdownBufferPool(&bm));
+      TEST_CHECK(shutdownSharedPool(&sp));
+      TEST_CHECK(destroyPageFile("test_table_r"));
+
+      // two threads keep reading tuples while the pool of all tables is resized
+      config.poolFrames = 32;
+      config.strategy = strategies[s];
+      config.tableQuota = 0;
+      TEST_CHECK(initRecordManager(&config));
+      TEST_CHECK(createTable("test_table_r",schema));
+      TEST_CHECK(openTable(table, "test_table_r"));
+      for(i = 0; i < 5000; i++)
+      {
+	  r = testRecord(schema, i, "aaaa", i % 7);
+	  TEST_CHECK(insertRecord(table, r));
+	  rids[i] = r->id;
+	  freeRecord(r);
+      }
+      for(i = 0; i < 2; i++)
+      {
+	  lookups[i].table = table;
+	  lookups[i].schema = schema;
+	  lookups[i].rids = rids;
+	  lookups[i].numRids = 5000;
+	  lookups[i].stop = 0;
+	  lookups[i].numLookups = 0;
+	  lookups[i].numWrong = 0;
+	  pthread_create(&threads[i], NULL, lookupWhileResizing, &lookups[i]);
+      }
+      for(i = 0; i < 40; i++)
+      {
+	  TEST_CHECK(resizeCatalogPool(i % 2 == 0 ? 4 : 64));
+	  usleep(1000);
+      }
+      for(i = 0; i < 2; i++)
+	__atomic_store_n(&lookups[i].stop, 1, __ATOMIC_RELEASE);
+      for(i = 0; i < 2; i++)
+	pthread_join(threads[i], NULL);
+      for(i = 0; i < 2; i++)
+      {
+	  ASSERT_EQUALS_INT(0, lookups[i].numWrong, "tuples read while resizing");
+	  ASSERT_TRUE(lookups[i].numLookups > 0, "lookups done");
+      }
+      ASSERT_EQUALS_INT(RC_RM_POOL_TOO_SMALL, resizeCatalogPool(RM_MIN_POOL_FRAMES - 1), "fewer frames than an operation pins");
+      TEST_CHECK(getCatalogStats(&stats));
+      ASSERT_EQUALS_INT(64, stats.poolFrames, "pool frames after resizing");
+
+      TEST_CHECK(closeTable(table));
+      TEST_CHECK(deleteTable("test_table_r"));
+      TEST_CHECK(shutdownRecordManager());
+  }
+
+  freeSchema(schema);
+  free(rids);
+  free(table);
+  TEST_DONE();
+}
+
+void
+testPoolStats(void)
+{
+  ReplacementStrategy strategies[3] = { RS_FIFO, RS_LRU, RS_CLOCK };
+  BM_BufferPool bm;
+  BM_PageHandle h;
+  SM_FileHandle fh;
+  BM_PoolCounters counters;
+  BM_PoolSnapshot snap;
+  PageNumber *contents;
+  char *metrics;
+  int pages[6] = { 0, 1, 2, 0, 4, 5 };
+  int i, s, same;
+
+  testName = "test buffer pool counters, snapshots and metrics";
+
+  for(s = 0; s < 3; s++)
+  {
+      TEST_CHECK(createPageFile("test_table_s"));
+      TEST_CHECK(openPageFile("test_table_s", &fh));
+      TEST_CHECK(ensureCapacity(8, &fh));
+      TEST_CHECK(closePageFile(&fh));
+      TEST_CHECK(initBufferPool(&bm, "test_table_s", 3, strategies[s], NULL));
+      TEST_CHECK(setWritePolicy(&bm, BM_WRITE_BACK));
+
+      // 5 misses and a hit; pages 1 and 2 are replaced, page 1 is written back
+      for(i = 0; i < 6; i++)
+      {
+	  TEST_CHECK(pinPage(&bm, &h, pages[i]));
+	  if (pages[i] == 1)
+	    {
+	      TEST_CHECK(markDirty(&bm, &h));
+	    }
+	  TEST_CHECK(unpinPage(&bm, &h));
+      }
+      TEST_CHECK(getPoolCounters(&bm, &counters));
+      ASSERT_EQUALS_INT(1, (int) counters.numHits, "hits");
+      ASSERT_EQUALS_INT(5, (int) counters.numMisses, "misses");
+      ASSERT_EQUALS_INT(5, (int) counters.numReadIO, "pages read");
+      ASSERT_EQUALS_INT(2, (int) counters.numEvictions, "evictions");
+      ASSERT_EQUALS_INT(1, (int) counters.numDirtyWrites, "dirty page written back");
+      ASSERT_EQUALS_INT(1, (int) counters.numWriteIO, "pages written");
+      ASSERT_EQUALS_INT(0, (int) counters.numPinWaits, "no other thread");
+
+      // the snapshot agrees with the arrays of the statistics interface
+      TEST_CHECK(pinPage(&bm, &h, 4));
+      TEST_CHECK(markDirty(&bm, &h));
+      TEST_CHECK(getPoolSnapshot(&bm, &snap));
+      ASSERT_EQUALS_INT(3, snap.numFrames, "frames in the snapshot");
+      ASSERT_EQUALS_INT(3, snap.numBuffered, "buffered pages");
+      ASSERT_EQUALS_INT(1, snap.numPinned, "pinned pages");
+      ASSERT_EQUALS_INT(1, snap.numDirty, "dirty pages");
+      ASSERT_EQUALS_INT(2, (int) snap.counters.numHits, "hits in the snapshot");
+      contents = getFrameContents(&bm);
+      same = 1;
+      for(i = 0; i < 3; i++)
+	if (contents[i] != snap.frameContents[i] || getFixCounts(&bm)[i] != snap.fixCounts[i]
+	    || getDirtyFlags(&bm)[i] != snap.dirtyFlags[i])
+	  same = 0;
+      ASSERT_TRUE(same, "snapshot ordered like getFrameContents");
+      TEST_CHECK(freePoolSnapshot(&snap));
+
+      metrics = sprintPoolMetrics(&bm);
+      ASSERT_TRUE(strstr(metrics, "bm_pins_total{pool=\"test_table_s\",result=\"hit\"} 2\n") != NULL, "hits in the metrics");
+      ASSERT_TRUE(strstr(metrics, "bm_frames{pool=\"test_table_s\",state=\"pinned\"} 1\n") != NULL, "pinned frames in the metrics");
+      free(metrics);
+
+      TEST_CHECK(unpinPage(&bm, &h));
+      TEST_CHECK(shutdownBufferPool(&bm));
+      TEST_CHECK(destroyPageFile("test_table_s"));
+  }
+
+  TEST_DONE();
+}
+
+void
+testLatencyStats(void)
+{
+  RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+  RM_ScanHandle sc;
+  LatencyStats stats;
+  Record *r;
+  Schema *schema;
+  Expr *sel, *left, *right;
+  Value *result;
+  char *dump;
+  int numFound, i;
+
+  testName = "test latency histograms";
+  schema = testSchema();
+  resetLatencyStats();
+
+  TEST_CHECK(initRecordManager(NULL));
+  TEST_CHECK(createTable("test_table_l",schema));
+  TEST_CHECK(openTable(table, "test_table_l"));
+  for(i = 0; i < 100; i++)
+  {
+      r = testRecord(schema, i, "aaaa", i % 7);
+      TEST_CHECK(insertRecord(table, r));
+      freeRecord(r);
+  }
+  TEST_CHECK(createRecord(&r, schema));
+  TEST_CHECK(startScan(table, &sc, NULL));
+  numFound = 0;
+  while(next(&sc, r) == RC_OK)
+    numFound++;
+  TEST_CHECK(closeScan(&sc));
+  MAKE_CONS(left, stringToValue("i3"));
+  MAKE_ATTRREF(right, 2);
+  MAKE_BINOP_EXPR(sel, left, right, OP_COMP_EQUAL);
+  TEST_CHECK(evalExpr(r, schema, sel, &result));
+  freeVal(result);
+  freeExpr(sel);
+  freeRecord(r);
+  TEST_CHECK(closeTable(table));
+  TEST_CHECK(deleteTable("test_table_l"));
+  TEST_CHECK(shutdownRecordManager());
+
+  dump = sprintLatencyStats();
+#ifdef LATENCY_STATS
+  TEST_CHECK(getLatencyStats(LAT_INSERT_RECORD, &stats));
+  ASSERT_EQUALS_INT(100, (int) stats.count, "inserts measured");
+  ASSERT_TRUE(stats.min <= stats.p50 && stats.p50 <= stats.p90 && stats.p90 <= stats.p99
+	      && stats.p99 <= stats.p999 && stats.p999 <= stats.max, "percentiles ordered");
+  TEST_CHECK(getLatencyStats(LAT_SCAN_NEXT, &stats));
+  ASSERT_EQUALS_INT(numFound + 1, (int) stats.count, "calls of next measured");
+  TEST_CHECK(getLatencyStats(LAT_EVAL_EXPR, &stats));
+  ASSERT_EQUALS_INT(1, (int) stats.count, "expression measured once, not per node");
+  TEST_CHECK(getLatencyStats(LAT_PIN_HIT, &stats));
+  ASSERT_TRUE(stats.count > 0, "pins measured");
+  ASSERT_TRUE(strstr(dump, "insertRecord") != NULL, "dump lists the inserts");
+#else
+  TEST_CHECK(getLatencyStats(LAT_INSERT_RECORD, &stats));
+  ASSERT_EQUALS_INT(0, (int) stats.count, "nothing measured without LATENCY_STATS");
+  ASSERT_TRUE(strstr(dump, "not compiled in") != NULL, "dump tells how to compile the histograms in");
+#endif
+  free(dump);
+
+  freeSchema(schema);
+  free(table);
+  TEST_DONE();
 }
@@ -1,3 +1,5 @@
+#include <math.h>
+
 #include "dberror.h"
 #include "expr.h"
 #include "record_mgr.h"
@@ -29,6 +31,17 @@
 static void testValueSerialize (void);
 static void testOperators (void);
 static void testExpressions (void);
+static void testCompiledExpressions (void);
+static void testBatchExpressions (void);
+static void testRangeExpressions (void);
+static void testShortCircuit (void);
+static void testBooleanGroups (void);
+
+// helper methods
+static Schema *testSchema (void);
+static Record *testRecord (Schema *schema, int a, char *b, float c);
+static bool interpret (Record *record, Schema *schema, Expr *expr);
+static bool compiled (Record *record, Schema *schema, Expr *expr);
 
 char *testName;
 
@@ -41,6 +54,11 @@ main (void)
   testValueSerialize();
   testOperators();
   testExpressions();
+  testCompiledExpressions();
+  testBatchExpressions();
+  testRangeExpressions();
+  testShortCircuit();
+  testBooleanGroups();
 
   return 0;
 }
@@ -79,6 +97,25 @@ testOperators (void)
   OP_TRUE(stringToValue("i3"),stringToValue("i10"), valueSmaller, "3 < 10");
   OP_TRUE(stringToValue("f5.0"),stringToValue("f6.5"), valueSmaller, "5.0 < 6.5");
 
+  // greater, smaller equals, greater equals and not equals
+  OP_TRUE(stringToValue("i10"),stringToValue("i3"), valueGreater, "10 > 3");
+  OP_FALSE(stringToValue("i3"),stringToValue("i3"), valueGreater, "3 > 3");
+  OP_TRUE(stringToValue("i3"),stringToValue("i3"), valueSmallerEquals, "3 <= 3");
+  OP_FALSE(stringToValue("sb"),stringToValue("sa"), valueSmallerEquals, "b <= a");
+  OP_TRUE(stringToValue("f6.5"),stringToValue("f6.5"), valueGreaterEquals, "6.5 >= 6.5");
+  OP_TRUE(stringToValue("i9"),stringToValue("i10"), valueNotEquals, "9 <> 10");
+  OP_FALSE(stringToValue("i10"),stringToValue("i10"), valueNotEquals, "10 <> 10");
+
+  // only <> holds for NaN
+  OP_FALSE(stringToValue("fnan"),stringToValue("f1.0"), valueSmallerEquals, "NaN <= 1.0");
+  OP_FALSE(stringToValue("fnan"),stringToValue("f1.0"), valueGreaterEquals, "NaN >= 1.0");
+  OP_FALSE(stringToValue("f1.0"),stringToValue("fnan"), valueGreater, "1.0 > NaN");
+  OP_TRUE(stringToValue("fnan"),stringToValue("f1.0"), valueNotEquals, "NaN <> 1.0");
+
+  // prefix
+  OP_TRUE(stringToValue("sHello World"),stringToValue("sHello"), valuePrefix, "Hello World starts with Hello");
+  OP_FALSE(stringToValue("sHell"),stringToValue("sHello"), valuePrefix, "Hell does not start with Hello");
+
   // boolean
   OP_TRUE(stringToValue("bt"),stringToValue("bt"), boolAnd, "t AND t = t");
   OP_FALSE(stringToValue("bt"),stringToValue("bf"), boolAnd, "t AND f = f");
@@ -123,3 +160,595 @@ testExpressions (void)
 
   TEST_DONE();
 }
+
+// ************************************************************
+void
+testCompiledExpressions (void)
+{
+  Expr *exprs[7], *l, *r, *e1, *e2;
+  Record *records[4];
+  Schema *schema;
+  ExprProgram *prog;
+  int i, j;
+  testName = "test compiled expressions against evalExpr";
+
+  schema = testSchema();
+  records[0] = testRecord(schema, 1, "aaaa", 1.5);
+  records[1] = testRecord(schema, 5, "ab", 0.5);
+  records[2] = testRecord(schema, 9, "abcd", 2.5);
+  records[3] = testRecord(schema, 3, "b", NAN);
+
+  // a = 5
+  MAKE_ATTRREF(l, 0);
+  MAKE_CONS(r, stringToValue("i5"));
+  MAKE_BINOP_EXPR(exprs[0], l, r, OP_COMP_EQUAL);
+
+  // b < 'abc'
+  MAKE_ATTRREF(l, 1);
+  MAKE_CONS(r, stringToValue("sabc"));
+  MAKE_BINOP_EXPR(exprs[1], l, r, OP_COMP_SMALLER);
+
+  // 'ab' = b
+  MAKE_CONS(l, stringToValue("sab"));
+  MAKE_ATTRREF(r, 1);
+  MAKE_BINOP_EXPR(exprs[2], l, r, OP_COMP_EQUAL);
+
+  // NOT (c < 1.0) AND a < 9
+  MAKE_ATTRREF(l, 2);
+  MAKE_CONS(r, stringToValue("f1.0"));
+  MAKE_BINOP_EXPR(e1, l, r, OP_COMP_SMALLER);
+  MAKE_UNOP_EXPR(e2, e1, OP_BOOL_NOT);
+  MAKE_ATTRREF(l, 0);
+  MAKE_CONS(r, stringToValue("i9"));
+  MAKE_BINOP_EXPR(e1, l, r, OP_COMP_SMALLER);
+  MAKE_BINOP_EXPR(exprs[3], e2, e1, OP_BOOL_AND);
+
+  // a = 9 OR b = 'aaaa'
+  MAKE_ATTRREF(l, 0);
+  MAKE_CONS(r, stringToValue("i9"));
+  MAKE_BINOP_EXPR(e1, l, r, OP_COMP_EQUAL);
+  MAKE_ATTRREF(l, 1);
+  MAKE_CONS(r, stringToValue("saaaa"));
+  MAKE_BINOP_EXPR(e2, l, r, OP_COMP_EQUAL);
+  MAKE_BINOP_EXPR(exprs[4], e1, e2, OP_BOOL_OR);
+
+  // true
+  MAKE_CONS(exprs[5], stringToValue("bt"));
+
+  // c = 1.5
+  MAKE_ATTRREF(l, 2);
+  MAKE_CONS(r, stringToValue("f1.5"));
+  MAKE_BINOP_EXPR(exprs[6], l, r, OP_COMP_EQUAL);
+
+  for(i = 0; i < 7; i++)
+    for(j = 0; j < 4; j++)
+      ASSERT_TRUE(interpret(records[j], schema, exprs[i]) == compiled(records[j], schema, exprs[i]),
+		  "compiled result equals interpreted result");
+
+  ASSERT_TRUE(compiled(records[1], schema, exprs[0]), "a = 5");
+  ASSERT_TRUE(compiled(records[2], schema, exprs[4]), "a = 9 OR b = 'aaaa'");
+  ASSERT_TRUE(!compiled(records[1], schema, exprs[3]), "NOT (c < 1.0) AND a < 9");
+  ASSERT_TRUE(compiled(records[0], schema, exprs[6]), "c = 1.5");
+  ASSERT_TRUE(!compiled(records[3], schema, exprs[6]), "NaN = 1.5 is false");
+  ASSERT_TRUE(compiled(records[3], schema, exprs[3]), "NOT (NaN < 1.0) AND a < 9");
+
+  // comparing values of different datatypes cannot be compiled
+  MAKE_ATTRREF(l, 0);
+  MAKE_CONS(r, stringToValue("sabc"));
+  MAKE_BINOP_EXPR(e1, l, r, OP_COMP_EQUAL);
+  ASSERT_ERROR(compileExpr(e1, schema, &prog), "compare int attribute with string");
+
+  for(i = 0; i < 7; i++)
+    freeExpr(exprs[i]);
+  freeExpr(e1);
+  for(j = 0; j < 4; j++)
+    freeRecord(records[j]);
+  freeSchema(schema);
+  TEST_DONE();
+}
+
+// ************************************************************
+void
+testBatchExpressions (void)
+{
+  Expr *exprs[5], *l, *r, *e1, *e2;
+  Schema *schema;
+  ExprProgram *prog;
+  Record *record;
+  char *data;
+  uint64_t selection[BITMAP_WORDS(203)];
+  void *scratch;
+  int numRecords = 203, recordSize, i, j;
+  bool b;
+  testName = "test batch evaluation of compiled expressions";
+
+  schema = testSchema();
+  recordSize = getRecordSize(schema);
+  data = (char *) malloc(recordSize * numRecords);
+  scratch = malloc(EXPR_BATCH_SCRATCH_SIZE(numRecords));
+  for(i = 0; i < numRecords; i++)
+    {
+      char buf[5];
+      sprintf(buf, "%c%c", 'a' + (i % 3), 'a' + (i % 7));
+      record = testRecord(schema, i % 17, buf, (i % 11) * 0.5);
+      memcpy(data + (i * recordSize), record->data, recordSize);
+      freeRecord(record);
+    }
+
+  // a = 5
+  MAKE_ATTRREF(l, 0);
+  MAKE_CONS(r, stringToValue("i5"));
+  MAKE_BINOP_EXPR(exprs[0], l, r, OP_COMP_EQUAL);
+
+  // 10 < a
+  MAKE_CONS(l, stringToValue("i10"));
+  MAKE_ATTRREF(r, 0);
+  MAKE_BINOP_EXPR(exprs[1], l, r, OP_COMP_SMALLER);
+
+  // c < 2.0 OR NOT a < 3
+  MAKE_ATTRREF(l, 2);
+  MAKE_CONS(r, stringToValue("f2.0"));
+  MAKE_BINOP_EXPR(e1, l, r, OP_COMP_SMALLER);
+  MAKE_ATTRREF(l, 0);
+  MAKE_CONS(r, stringToValue("i3"));
+  MAKE_BINOP_EXPR(e2, l, r, OP_COMP_SMALLER);
+  MAKE_UNOP_EXPR(r, e2, OP_BOOL_NOT);
+  MAKE_BINOP_EXPR(exprs[2], e1, r, OP_BOOL_OR);
+
+  // b < 'b' AND c = 1.5
+  MAKE_ATTRREF(l, 1);
+  MAKE_CONS(r, stringToValue("sb"));
+  MAKE_BINOP_EXPR(e1, l, r, OP_COMP_SMALLER);
+  MAKE_ATTRREF(l, 2);
+  MAKE_CONS(r, stringToValue("f1.5"));
+  MAKE_BINOP_EXPR(e2, l, r, OP_COMP_EQUAL);
+  MAKE_BINOP_EXPR(exprs[3], e1, e2, OP_BOOL_AND);
+
+  // false
+  MAKE_CONS(exprs[4], stringToValue("bf"));
+
+  for(i = 0; i < 5; i++)
+    {
+      int numMatches = 0;
+
+      TEST_CHECK(compileExpr(exprs[i], schema, &prog));
+      TEST_CHECK(evalProgramBatch(prog, data, recordSize, numRecords, selection, scratch));
+      for(j = 0; j < numRecords; j++)
+	{
+	  TEST_CHECK(evalProgram(prog, data + (j * recordSize), &b));
+	  if (b != BITMAP_TEST(selection, j))
+	    ASSERT_TRUE(FALSE, "batch result equals per record result");
+	  numMatches += b;
+	}
+      ASSERT_TRUE(numMatches > 0 || i == 4, "condition selects records");
+      ASSERT_TRUE((selection[BITMAP_WORDS(numRecords) - 1] >> (numRecords % 64)) == 0, "no bits past the batch");
+      TEST_CHECK(freeProgram(prog));
+      freeExpr(exprs[i]);
+    }
+
+  free(scratch);
+  free(data);
+  freeSchema(schema);
+  TEST_DONE();
+}
+
+// ************************************************************
+void
+testRangeExpressions (void)
+{
+  Expr *exprs[12], *l, *r, *u, *values[40];
+  Schema *schema;
+  ExprProgram *prog;
+  Record *record;
+  char *data, str[10];
+  uint64_t selection[BITMAP_WORDS(203)];
+  void *scratch;
+  int numRecords = 203, recordSize, i, j;
+  bool b;
+  testName = "test between, in, prefix and negated comparisons";
+
+  schema = testSchema();
+  recordSize = getRecordSize(schema);
+  data = (char *) malloc(recordSize * numRecords);
+  scratch = malloc(EXPR_BATCH_SCRATCH_SIZE(numRecords));
+  for(i = 0; i < numRecords; i++)
+    {
+      char buf[5];
+      sprintf(buf, "%c%c", 'a' + (i % 3), 'a' + (i % 7));
+      record = testRecord(schema, i % 17, buf, (i % 13 == 12) ? NAN : (i % 11) * 0.5);
+      memcpy(data + (i * recordSize), record->data, recordSize);
+      freeRecord(record);
+    }
+
+  // a BETWEEN 3 AND 7
+  MAKE_ATTRREF(l, 0);
+  MAKE_CONS(r, stringToValue("i3"));
+  MAKE_CONS(u, stringToValue("i7"));
+  MAKE_BETWEEN_EXPR(exprs[0], l, r, u);
+
+  // c BETWEEN 1.0 AND 2.5
+  MAKE_ATTRREF(l, 2);
+  MAKE_CONS(r, stringToValue("f1.0"));
+  MAKE_CONS(u, stringToValue("f2.5"));
+  MAKE_BETWEEN_EXPR(exprs[1], l, r, u);
+
+  // b BETWEEN 'ab' AND 'b'
+  MAKE_ATTRREF(l, 1);
+  MAKE_CONS(r, stringToValue("sab"));
+  MAKE_CONS(u, stringToValue("sb"));
+  MAKE_BETWEEN_EXPR(exprs[2], l, r, u);
+
+  // a IN (2, 4, 16)
+  MAKE_CONS(values[0], stringToValue("i2"));
+  MAKE_CONS(values[1], stringToValue("i4"));
+  MAKE_CONS(values[2], stringToValue("i16"));
+  MAKE_ATTRREF(l, 0);
+  MAKE_IN_EXPR(exprs[3], l, values, 3);
+
+  // a IN (0, 3, 6, ..., 117) is hashed
+  for(i = 0; i < 40; i++)
+    {
+      sprintf(str, "i%i", i * 3);
+      MAKE_CONS(values[i], stringToValue(str));
+    }
+  MAKE_ATTRREF(l, 0);
+  MAKE_IN_EXPR(exprs[4], l, values, 40);
+
+  // b IN ('ca', 'ab', 'bb', 'cc', 'aa', 'ba', 'cb', 'ac', 'bc', 'cd')
+  for(i = 0; i < 10; i++)
+    {
+      sprintf(str, "s%c%c", 'a' + ((i * 2) % 3), 'a' + (i % 4));
+      MAKE_CONS(values[i], stringToValue(str));
+    }
+  MAKE_ATTRREF(l, 1);
+  MAKE_IN_EXPR(exprs[5], l, values, 10);
+
+  // b LIKE 'c%'
+  MAKE_ATTRREF(l, 1);
+  MAKE_CONS(r, stringToValue("sc"));
+  MAKE_BINOP_EXPR(exprs[6], l, r, OP_COMP_PREFIX);
+
+  // 2.0 >= c OR a <> 5
+  MAKE_CONS(l, stringToValue("f2.0"));
+  MAKE_ATTRREF(r, 2);
+  MAKE_BINOP_EXPR(u, l, r, OP_COMP_GREATER_EQUAL);
+  MAKE_ATTRREF(l, 0);
+  MAKE_CONS(r, stringToValue("i5"));
+  MAKE_BINOP_EXPR(values[0], l, r, OP_COMP_NOT_EQUAL);
+  MAKE_BINOP_EXPR(exprs[7], u, values[0], OP_BOOL_OR);
+
+  // a > 12 AND a <= 14
+  MAKE_ATTRREF(l, 0);
+  MAKE_CONS(r, stringToValue("i12"));
+  MAKE_BINOP_EXPR(u, l, r, OP_COMP_GREATER);
+  MAKE_ATTRREF(l, 0);
+  MAKE_CONS(r, stringToValue("i14"));
+  MAKE_BINOP_EXPR(values[0], l, r, OP_COMP_SMALLER_EQUAL);
+  MAKE_BINOP_EXPR(exprs[8], u, values[0], OP_BOOL_AND);
+
+  // c <> 1.5
+  MAKE_ATTRREF(l, 2);
+  MAKE_CONS(r, stringToValue("f1.5"));
+  MAKE_BINOP_EXPR(exprs[9], l, r, OP_COMP_NOT_EQUAL);
+
+  // c IN (0.5, 1.5, 2.5)
+  MAKE_CONS(values[0], stringToValue("f0.5"));
+  MAKE_CONS(values[1], stringToValue("f1.5"));
+  MAKE_CONS(values[2], stringToValue("f2.5"));
+  MAKE_ATTRREF(l, 2);
+  MAKE_IN_EXPR(exprs[10], l, values, 3);
+
+  // c <= 2.0
+  MAKE_ATTRREF(l, 2);
+  MAKE_CONS(r, stringToValue("f2.0"));
+  MAKE_BINOP_EXPR(exprs[11], l, r, OP_COMP_SMALLER_EQUAL);
+
+  TEST_CHECK(createRecord(&record, schema));
+  for(i = 0; i < 12; i++)
+    {
+      int numMatches = 0;
+
+      TEST_CHECK(compileExpr(exprs[i], schema, &prog));
+      TEST_CHECK(evalProgramBatch(prog, data, recordSize, numRecords, selection, scratch));
+      for(j = 0; j < numRecords; j++)
+	{
+	  memcpy(record->data, data + (j * recordSize), recordSize);
+	  TEST_CHECK(evalProgram(prog, record->data, &b));
+	  if (b != interpret(record, schema, exprs[i]))
+	    ASSERT_TRUE(FALSE, "compiled result equals interpreted result");
+	  if (b != BITMAP_TEST(selection, j))
+	    ASSERT_TRUE(FALSE, "batch result equals per record result");
+	  numMatches += b;
+	}
+      ASSERT_TRUE(numMatches > 0 && numMatches < numRecords, "condition selects some records");
+      TEST_CHECK(freeProgram(prog));
+    }
+
+  // a IN (0, 3, ..., 117) matches multiples of 3 only
+  memcpy(record->data, data + (12 * recordSize), recordSize);
+  ASSERT_TRUE(compiled(record, schema, exprs[4]), "12 IN (0, 3, ..., 117)");
+  memcpy(record->data, data + (13 * recordSize), recordSize);
+  ASSERT_TRUE(!compiled(record, schema, exprs[4]), "13 NOT IN (0, 3, ..., 117)");
+
+  // record 12 has c = NaN, only <> holds for it
+  memcpy(record->data, data + (12 * recordSize), recordSize);
+  ASSERT_TRUE(!compiled(record, schema, exprs[1]), "NaN NOT BETWEEN 1.0 AND 2.5");
+  ASSERT_TRUE(compiled(record, schema, exprs[9]), "NaN <> 1.5");
+  ASSERT_TRUE(!compiled(record, schema, exprs[10]), "NaN NOT IN (0.5, 1.5, 2.5)");
+  ASSERT_TRUE(!compiled(record, schema, exprs[11]), "NOT NaN <= 2.0");
+
+  // in lists of a different datatype cannot be compiled
+  MAKE_CONS(values[0], stringToValue("sabc"));
+  MAKE_ATTRREF(l, 0);
+  MAKE_IN_EXPR(u, l, values, 1);
+  ASSERT_ERROR(compileExpr(u, schema, &prog), "int attribute in list of strings");
+  freeExpr(u);
+
+  for(i = 0; i < 12; i++)
+    freeExpr(exprs[i]);
+  freeRecord(record);
+  free(scratch);
+  free(data);
+  freeSchema(schema);
+  TEST_DONE();
+}
+
+// ************************************************************
+void
+testShortCircuit (void)
+{
+  Expr *exprs[3], *l, *r, *e1, *e2, *e3;
+  Schema *schema;
+  ExprProgram *prog;
+  Record *record;
+  Value *res;
+  char *data;
+  uint64_t selection[BITMAP_WORDS(203)];
+  void *scratch;
+  int numRecords = 203, recordSize, i, j, round;
+  bool b;
+  testName = "test short circuit evaluation and reordering of terms";
+
+  schema = testSchema();
+  recordSize = getRecordSize(schema);
+  data = (char *) malloc(recordSize * numRecords);
+  scratch = malloc(EXPR_BATCH_SCRATCH_SIZE(numRecords));
+  for(i = 0; i < numRecords; i++)
+    {
+      char buf[5];
+      sprintf(buf, "%c%c", 'a' + (i % 3), 'a' + (i % 7));
+      record = testRecord(schema, i % 17, buf, (i % 11) * 0.5);
+      memcpy(data + (i * recordSize), record->data, recordSize);
+      freeRecord(record);
+    }
+  record = testRecord(schema, 1, "ab", 0.5);
+
+  // the right side of a decided AND/OR is not evaluated
+  MAKE_ATTRREF(l, 0);
+  MAKE_CONS(r, stringToValue("i1"));
+  MAKE_BINOP_EXPR(e1, l, r, OP_COMP_EQUAL);
+  MAKE_ATTRREF(l, 0);
+  MAKE_CONS(r, stringToValue("sabc"));
+  MAKE_BINOP_EXPR(e2, l, r, OP_COMP_EQUAL);
+  MAKE_BINOP_EXPR(e3, e1, e2, OP_BOOL_OR);
+  TEST_CHECK(evalExpr(record, schema, e3, &res));
+  ASSERT_TRUE(res->v.boolV, "a = 1 OR a = 'abc' is decided by a = 1");
+  freeVal(res);
+  freeExpr(e3);
+
+  MAKE_CONS(e1, stringToValue("bf"));
+  MAKE_ATTRREF(l, 0);
+  MAKE_CONS(r, stringToValue("sabc"));
+  MAKE_BINOP_EXPR(e2, l, r, OP_COMP_SMALLER);
+  MAKE_BINOP_EXPR(e3, e1, e2, OP_BOOL_AND);
+  TEST_CHECK(evalExpr(record, schema, e3, &res));
+  ASSERT_TRUE(!res->v.boolV, "false AND a < 'abc' is decided by false");
+  freeVal(res);
+  freeExpr(e3);
+
+  // a < 100 AND b = 'ab': the cheap term never decides the group
+  MAKE_ATTRREF(l, 0);
+  MAKE_CONS(r, stringToValue("i100"));
+  MAKE_BINOP_EXPR(e1, l, r, OP_COMP_SMALLER);
+  MAKE_ATTRREF(l, 1);
+  MAKE_CONS(r, stringToValue("sab"));
+  MAKE_BINOP_EXPR(e2, l, r, OP_COMP_EQUAL);
+  MAKE_BINOP_EXPR(exprs[0], e1, e2, OP_BOOL_AND);
+
+  // (a < 3 OR b = 'ab' OR c = 1.5) AND NOT (c < 1.0 AND a > 10)
+  MAKE_ATTRREF(l, 0);
+  MAKE_CONS(r, stringToValue("i3"));
+  MAKE_BINOP_EXPR(e1, l, r, OP_COMP_SMALLER);
+  MAKE_ATTRREF(l, 1);
+  MAKE_CONS(r, stringToValue("sab"));
+  MAKE_BINOP_EXPR(e2, l, r, OP_COMP_EQUAL);
+  MAKE_BINOP_EXPR(e3, e1, e2, OP_BOOL_OR);
+  MAKE_ATTRREF(l, 2);
+  MAKE_CONS(r, stringToValue("f1.5"));
+  MAKE_BINOP_EXPR(e1, l, r, OP_COMP_EQUAL);
+  MAKE_BINOP_EXPR(exprs[1], e3, e1, OP_BOOL_OR);
+  MAKE_ATTRREF(l, 2);
+  MAKE_CONS(r, stringToValue("f1.0"));
+  MAKE_BINOP_EXPR(e1, l, r, OP_COMP_SMALLER);
+  MAKE_ATTRREF(l, 0);
+  MAKE_CONS(r, stringToValue("i10"));
+  MAKE_BINOP_EXPR(e2, l, r, OP_COMP_GREATER);
+  MAKE_BINOP_EXPR(e3, e1, e2, OP_BOOL_AND);
+  MAKE_UNOP_EXPR(e1, e3, OP_BOOL_NOT);
+  MAKE_BINOP_EXPR(exprs[2], exprs[1], e1, OP_BOOL_AND);
+  exprs[1] = NULL;
+
+  MAKE_ATTRREF(l, 1);
+  MAKE_CONS(r, stringToValue("sb"));
+  MAKE_BINOP_EXPR(e1, l, r, OP_COMP_SMALLER);
+  MAKE_ATTRREF(l, 0);
+  MAKE_CONS(r, stringToValue("i5"));
+  MAKE_BINOP_EXPR(e2, l, r, OP_COMP_NOT_EQUAL);
+  MAKE_BINOP_EXPR(exprs[1], e1, e2, OP_BOOL_OR);
+
+  // results do not change while the terms are reordered
+  for(i = 0; i < 3; i++)
+    {
+      TEST_CHECK(compileExpr(exprs[i], schema, &prog));
+      if (i == 0)
+	ASSERT_TRUE(prog->instr[1].left.dt == DT_INT, "cheap term is evaluated first");
+
+      for(round = 0; round < 3 * EXPR_REORDER_INTERVAL / numRecords; round++)
+	{
+	  TEST_CHECK(evalProgramBatch(prog, data, recordSize, numRecords, selection, scratch));
+	  for(j = 0; j < numRecords; j++)
+	    {
+	      memcpy(record->data, data + (j * recordSize), recordSize);
+	      TEST_CHECK(evalProgram(prog, record->data, &b));
+	      if (b != interpret(record, schema, exprs[i]))
+		ASSERT_TRUE(FALSE, "compiled result equals interpreted result");
+	      if (b != BITMAP_TEST(selection, j))
+		ASSERT_TRUE(FALSE, "batch result equals per record result");
+	    }
+	}
+
+      if (i == 0)
+	ASSERT_TRUE(prog->instr[1].left.dt == DT_STRING, "selective term is evaluated first");
+      TEST_CHECK(freeProgram(prog));
+      freeExpr(exprs[i]);
+    }
+
+  freeRecord(record);
+  free(scratch);
+  free(data);
+  freeSchema(schema);
+  TEST_DONE();
+}
+
+// ************************************************************ 
+void
+testBooleanGroups (void)
+{
+  char *names[] = { "x", "y" };
+  DataType dt[] = { DT_BOOL, DT_BOOL };
+  int sizes[] = { 0, 0 };
+  int keys[] = {0};
+  Expr *exprs[3], *x, *y, *e1, *e2, *e3, *e4;
+  Schema *schema;
+  Record *record;
+  Value *value;
+  int i, j;
+  testName = "test compiled groups of boolean attributes";
+
+  schema = createSchema(2, names, dt, sizes, 1, keys);
+  TEST_CHECK(createRecord(&record, schema));
+
+  // every term of a group adds a short circuit, so these compile to more
+  // instructions than the trees have nodes
+
+  // (x AND y) AND x
+  MAKE_ATTRREF(x, 0);
+  MAKE_ATTRREF(y, 1);
+  MAKE_BINOP_EXPR(e1, x, y, OP_BOOL_AND);
+  MAKE_ATTRREF(x, 0);
+  MAKE_BINOP_EXPR(exprs[0], e1, x, OP_BOOL_AND);
+
+  // x OR NOT y
+  MAKE_ATTRREF(x, 0);
+  MAKE_ATTRREF(y, 1);
+  MAKE_UNOP_EXPR(e1, y, OP_BOOL_NOT);
+  MAKE_BINOP_EXPR(exprs[1], x, e1, OP_BOOL_OR);
+
+  // ((x OR y) AND (NOT x AND y)) AND (y OR NOT x)
+  MAKE_ATTRREF(x, 0);
+  MAKE_ATTRREF(y, 1);
+  MAKE_BINOP_EXPR(e1, x, y, OP_BOOL_OR);
+  MAKE_ATTRREF(x, 0);
+  MAKE_UNOP_EXPR(e2, x, OP_BOOL_NOT);
+  MAKE_ATTRREF(y, 1);
+  MAKE_BINOP_EXPR(e3, e2, y, OP_BOOL_AND);
+  MAKE_BINOP_EXPR(e4, e1, e3, OP_BOOL_AND);
+  MAKE_ATTRREF(x, 0);
+  MAKE_UNOP_EXPR(e2, x, OP_BOOL_NOT);
+  MAKE_ATTRREF(y, 1);
+  MAKE_BINOP_EXPR(e1, y, e2, OP_BOOL_OR);
+  MAKE_BINOP_EXPR(exprs[2], e4, e1, OP_BOOL_AND);
+
+  for(i = 0; i < 3; i++)
+    {
+      for(j = 0; j < 4; j++)
+	{
+	  MAKE_VALUE(value, DT_BOOL, j & 1);
+	  TEST_CHECK(setAttr(record, schema, 0, value));
+	  freeVal(value);
+	  MAKE_VALUE(value, DT_BOOL, (j >> 1) & 1);
+	  TEST_CHECK(setAttr(record, schema, 1, value));
+	  freeVal(value);
+	  if (compiled(record, schema, exprs[i]) != interpret(record, schema, exprs[i]))
+	    ASSERT_TRUE(FALSE, "compiled result equals interpreted result");
+	}
+      freeExpr(exprs[i]);
+    }
+  ASSERT_TRUE(TRUE, "groups of boolean attributes compiled");
+
+  freeRecord(record);
+  freeSchema(schema);
+  TEST_DONE();
+}
+
+Schema *
+testSchema (void)
+{
+  char *names[] = { "a", "b", "c" };
+  DataType dt[] = { DT_INT, DT_STRING, DT_FLOAT };
+  int sizes[] = { 0, 4, 0 };
+  int keys[] = {0};
+
+  return createSchema(3, names, dt, sizes, 1, keys);
+}
+
+Record *
+testRecord (Schema *schema, int a, char *b, float c)
+{
+  Record *result;
+  Value *value, str;
+  char buf[5];
+
+  TEST_CHECK(createRecord(&result, schema));
+
+  MAKE_VALUE(value, DT_INT, a);
+  TEST_CHECK(setAttr(result, schema, 0, value));
+  freeVal(value);
+
+  // zero padded to the type length of b
+  memset(buf, 0, sizeof(buf));
+  strncpy(buf, b, 4);
+  str.dt = DT_STRING;
+  str.v.stringV = buf;
+  TEST_CHECK(setAttr(result, schema, 1, &str));
+
+  MAKE_VALUE(value, DT_FLOAT, c);
+  TEST_CHECK(setAttr(result, schema, 2, value));
+  freeVal(value);
+
+  return result;
+}
+
+bool
+interpret (Record *record, Schema *schema, Expr *expr)
+{
+  Value *res;
+  bool b;
+
+  TEST_CHECK(evalExpr(record, schema, expr, &res));
+  b = res->v.boolV;
+  freeVal(res);
+  return b;
+}
+
+bool
+compiled (Record *record, Schema *schema, Expr *expr)
+{
+  ExprProgram *prog;
+  bool b;
+
+  TEST_CHECK(compileExpr(expr, schema, &prog));
+  TEST_CHECK(evalProgram(prog, record->data, &b));
+  TEST_CHECK(freeProgram(prog));
+  return b;
+}
@@ -0,0 +1,633 @@
+#include <stdlib.h>
+#include <string.h>
+#include "dberror.h"
+#include "expr.h"
+#include "record_mgr.h"
+#include "query.h"
+#include "tables.h"
+#include "test_helper.h"
+
+// test methods
+static void testAggregate (void);
+static void testGroupBy (void);
+static void testJoins (void);
+static void testSort (void);
+static void testTopN (void);
+
+// helper methods
+static Schema *testSchema (void);
+static Record *testRecord (Schema *schema, int a, char *b, float c);
+static void loadTestTable (RM_TableData *table, Schema *schema, int numRecords);
+
+// b of the test records, by a % 3
+static char *names[] = { "xa", "yb", "zc" };
+
+char *testName;
+
+// main method
+int
+main (void)
+{
+  testName = "";
+
+  testAggregate();
+  testGroupBy();
+  testJoins();
+  testSort();
+  testTopN();
+
+  return 0;
+}
+
+// ************************************************************
+void
+testAggregate (void)
+{
+  RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+  AggrSpec aggrs[] = {
+    { AGGR_COUNT, -1 },
+    { AGGR_SUM, 0 },
+    { AGGR_MIN, 0 },
+    { AGGR_MAX, 0 },
+    { AGGR_AVG, 2 },
+    { AGGR_MAX, 2 },
+  };
+  int numRecords = 5000, i, count = 0;
+  int64_t sum = 0;
+  double sumC = 0, diff;
+  AggrResult *res;
+  Schema *schema;
+  Expr *sel, *left, *right;
+  AggrSpec bad = { AGGR_SUM, 1 };
+
+  testName = "test aggregates without grouping";
+  schema = testSchema();
+
+  TEST_CHECK(initRecordManager(NULL));
+  TEST_CHECK(createTable("test_table_q",schema));
+  TEST_CHECK(openTable(table, "test_table_q"));
+  loadTestTable(table, schema, numRecords);
+
+  // a >= 1000
+  MAKE_ATTRREF(left, 0);
+  MAKE_CONS(right, stringToValue("i1000"));
+  MAKE_BINOP_EXPR(sel, left, right, OP_COMP_GREATER_EQUAL);
+  for(i = 1000; i < numRecords; i++)
+    {
+      count++;
+      sum += i;
+      sumC += (i % 5) * 0.5;
+    }
+
+  TEST_CHECK(aggregate(table, sel, 0, NULL, 6, aggrs, 0, 4, &res));
+  ASSERT_EQUALS_INT(1, res->numGroups, "one group without group attributes");
+  ASSERT_EQUALS_INT(DT_INT, res->types[1], "SUM of an int is an int");
+  ASSERT_EQUALS_INT(DT_FLOAT, res->types[4], "AVG is a float");
+  ASSERT_EQUALS_INT(count, (int) AGGR_VALUE(res, 0, 0).intV, "COUNT");
+  ASSERT_TRUE(AGGR_VALUE(res, 0, 1).intV == sum, "SUM(a)");
+  ASSERT_EQUALS_INT(1000, (int) AGGR_VALUE(res, 0, 2).intV, "MIN(a)");
+  ASSERT_EQUALS_INT(numRecords - 1, (int) AGGR_VALUE(res, 0, 3).intV, "MAX(a)");
+  diff = AGGR_VALUE(res, 0, 4).floatV - (sumC / count);
+  ASSERT_TRUE(diff < 1e-6 && diff > -1e-6, "AVG(c)");
+  ASSERT_TRUE(AGGR_VALUE(res, 0, 5).floatV == 2.0, "MAX(c)");
+  TEST_CHECK(freeAggrResult(res));
+
+  // nothing matches: still one group, of zeros
+  freeExpr(sel);
+  MAKE_ATTRREF(left, 0);
+  MAKE_CONS(right, stringToValue("i0"));
+  MAKE_BINOP_EXPR(sel, left, right, OP_COMP_SMALLER);
+  TEST_CHECK(aggregate(table, sel, 0, NULL, 6, aggrs, 0, 2, &res));
+  ASSERT_EQUALS_INT(1, res->numGroups, "one group for no tuples");
+  ASSERT_EQUALS_INT(0, (int) AGGR_VALUE(res, 0, 0).intV, "COUNT of no tuples");
+  ASSERT_EQUALS_INT(0, (int) AGGR_VALUE(res, 0, 2).intV, "MIN of no tuples");
+  TEST_CHECK(freeAggrResult(res));
+
+  ASSERT_ERROR(aggregate(table, NULL, 0, NULL, 1, &bad, 0, 1, &res), "SUM of a string");
+
+  TEST_CHECK(closeTable(table));
+  TEST_CHECK(deleteTable("test_table_q"));
+  TEST_CHECK(shutdownRecordManager());
+
+  freeExpr(sel);
+  freeSchema(schema);
+  free(table);
+  TEST_DONE();
+}
+
+// ************************************************************
+void
+testGroupBy (void)
+{
+  RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+  AggrSpec aggrs[] = {
+    { AGGR_COUNT, -1 },
+    { AGGR_SUM, 0 },
+    { AGGR_MIN, 2 },
+  };
+  int numRecords = 6000, i, g, b;
+  int groupByB[] = { 1 };
+  int groupByBC[] = { 1, 2 };
+  int groupByA[] = { 0 };
+  int64_t sums[3], total;
+  AggrResult *res;
+  Schema *schema;
+  Value *key, *c;
+  Expr *sel, *left, *right;
+
+  testName = "test aggregates grouped by attributes";
+  schema = testSchema();
+
+  TEST_CHECK(initRecordManager(NULL));
+  TEST_CHECK(createTable("test_table_g",schema));
+  TEST_CHECK(openTable(table, "test_table_g"));
+  loadTestTable(table, schema, numRecords);
+
+  memset(sums, 0, sizeof(sums));
+  for(i = 0; i < numRecords; i++)
+    sums[i % 3] += i;
+
+  // GROUP BY b
+  TEST_CHECK(aggregate(table, NULL, 1, groupByB, 3, aggrs, 3, 4, &res));
+  ASSERT_EQUALS_INT(3, res->numGroups, "three values of b");
+  for(g = 0; g < res->numGroups; g++)
+    {
+      TEST_CHECK(getGroupAttr(res, g, 0, &key));
+      ASSERT_EQUALS_INT(DT_STRING, key->dt, "group attribute is a string");
+      for(b = 0; b < 3 && strcmp(names[b], key->v.stringV) != 0; b++)
+	;
+      ASSERT_TRUE(b < 3, "group attribute is a value of b");
+      ASSERT_EQUALS_INT(numRecords / 3, (int) AGGR_VALUE(res, g, 0).intV, "COUNT per b");
+      ASSERT_TRUE(AGGR_VALUE(res, g, 1).intV == sums[b], "SUM(a) per b");
+      freeVal(key);
+    }
+  TEST_CHECK(freeAggrResult(res));
+
+  // GROUP BY b, c: a % 3 and a % 5 give 15 groups
+  TEST_CHECK(aggregate(table, NULL, 2, groupByBC, 3, aggrs, 0, 3, &res));
+  ASSERT_EQUALS_INT(15, res->numGroups, "15 combinations of b and c");
+  for(g = 0; g < res->numGroups; g++)
+    {
+      TEST_CHECK(getGroupAttr(res, g, 1, &c));
+      ASSERT_TRUE(AGGR_VALUE(res, g, 2).floatV == c->v.floatV, "MIN(c) per group is c");
+      ASSERT_EQUALS_INT(numRecords / 15, (int) AGGR_VALUE(res, g, 0).intV, "COUNT per b, c");
+      freeVal(c);
+    }
+  TEST_CHECK(freeAggrResult(res));
+
+  // GROUP BY a: tables growing well past their initial size
+  TEST_CHECK(aggregate(table, NULL, 1, groupByA, 3, aggrs, 0, 4, &res));
+  ASSERT_EQUALS_INT(numRecords, res->numGroups, "one group per a");
+  total = 0;
+  for(g = 0; g < res->numGroups; g++)
+    {
+      TEST_CHECK(getGroupAttr(res, g, 0, &key));
+      if (AGGR_VALUE(res, g, 0).intV != 1 || AGGR_VALUE(res, g, 1).intV != key->v.intV)
+	total = -1;
+      else if (total >= 0)
+	total += key->v.intV;
+      freeVal(key);
+    }
+  ASSERT_TRUE(total == sums[0] + sums[1] + sums[2], "every a in exactly one group");
+  TEST_CHECK(freeAggrResult(res));
+
+  TEST_CHECK(closeTable(table));
+  TEST_CHECK(deleteTable("test_table_g"));
+
+  // GROUP BY b on a PAX table, a < 3000 evaluated on the minipage of a
+  TEST_CHECK(createTableWithLayout("test_table_g", schema, RM_LAYOUT_PAX));
+  TEST_CHECK(openTable(table, "test_table_g"));
+  loadTestTable(table, schema, numRecords);
+  memset(sums, 0, sizeof(sums));
+  for(i = 0; i < numRecords / 2; i++)
+    sums[i % 3] += i;
+  MAKE_ATTRREF(left, 0);
+  MAKE_CONS(right, stringToValue("i3000"));
+  MAKE_BINOP_EXPR(sel, left, right, OP_COMP_SMALLER);
+  TEST_CHECK(aggregate(table, sel, 1, groupByB, 3, aggrs, 3, 4, &res));
+  ASSERT_EQUALS_INT(3, res->numGroups, "three values of b in the PAX table");
+  for(g = 0; g < res->numGroups; g++)
+    {
+      TEST_CHECK(getGroupAttr(res, g, 0, &key));
+      for(b = 0; b < 3 && strcmp(names[b], key->v.stringV) != 0; b++)
+	;
+      ASSERT_TRUE(b < 3, "group attribute gathered from its minipage");
+      ASSERT_EQUALS_INT(numRecords / 6, (int) AGGR_VALUE(res, g, 0).intV, "COUNT per b with PAX");
+      ASSERT_TRUE(AGGR_VALUE(res, g, 1).intV == sums[b], "SUM(a) per b with PAX");
+      freeVal(key);
+    }
+  TEST_CHECK(freeAggrResult(res));
+  TEST_CHECK(closeTable(table));
+  TEST_CHECK(deleteTable("test_table_g"));
+  TEST_CHECK(shutdownRecordManager());
+
+  freeExpr(sel);
+  freeSchema(schema);
+  free(table);
+  TEST_DONE();
+}
+
+// ************************************************************
+// checks the pairs of a join on a and counts them
+typedef struct JoinCheck {
+  Schema *schema;
+  int numPairs;
+  int numWrong;
+  int stopAfter;
+} JoinCheck;
+
+static RC
+checkJoinPair (void *context, Record *left, Record *right)
+{
+  JoinCheck *check = (JoinCheck *) context;
+  int l, r;
+
+  getIntAttr(left, check->schema, 0, &l);
+  getIntAttr(right, check->schema, 0, &r);
+  if (l != r)
+    check->numWrong++;
+  check->numPairs++;
+  if (check->numPairs == check->stopAfter)
+    return RC_RM_NO_MORE_TUPLES;
+  return RC_OK;
+}
+
+void
+testJoins (void)
+{
+  RM_TableData *left = (RM_TableData *) malloc(sizeof(RM_TableData));
+  RM_TableData *right = (RM_TableData *) malloc(sizeof(RM_TableData));
+  int numLeft = 1000, numRight = 2100, i, rc;
+  int onA[] = { 0 };
+  int onAB[] = { 0, 1 };
+  int onB[] = { 1 };
+  Record *records, *r;
+  Schema *schema;
+  JoinCheck check;
+
+  testName = "test hash and sort-merge joins";
+  schema = testSchema();
+
+  TEST_CHECK(initRecordManager(NULL));
+  TEST_CHECK(createTable("test_table_jl",schema));
+  TEST_CHECK(openTable(left, "test_table_jl"));
+  TEST_CHECK(createTable("test_table_jr",schema));
+  TEST_CHECK(openTable(right, "test_table_jr"));
+
+  // left: a = 0..499 twice, right: a = 0..699 three times, b follows a
+  records = (Record *) malloc(sizeof(Record) * numRight);
+  for(i = 0; i < numRight; i++)
+    {
+      int a = (i < numLeft) ? i % 500 : 0;
+      r = testRecord(schema, a, names[a % 3], 0);
+      records[i] = *r;
+      free(r);
+    }
+  TEST_CHECK(insertRecords(left, records, numLeft));
+  for(i = 0; i < numRight; i++)
+    {
+      int a = (numRight - 1 - i) % 700;
+      r = testRecord(schema, a, names[a % 3], 0);
+      free(records[i].data);
+      records[i] = *r;
+      free(r);
+    }
+  TEST_CHECK(insertRecords(right, records, numRight));
+
+  // 500 keys joining 2 x 3 tuples
+  memset(&check, 0, sizeof(JoinCheck));
+  check.schema = schema;
+  TEST_CHECK(hashJoin(left, right, 1, onA, onA, 0, checkJoinPair, &check));
+  ASSERT_EQUALS_INT(3000, check.numPairs, "hash join pairs");
+  ASSERT_EQUALS_INT(0, check.numWrong, "hash join pairs have equal a");
+
+  // a budget far below the left table forces partitioning through temporary files
+  memset(&check, 0, sizeof(JoinCheck));
+  check.schema = schema;
+  TEST_CHECK(hashJoin(left, right, 2, onAB, onAB, 4096, checkJoinPair, &check));
+  ASSERT_EQUALS_INT(3000, check.numPairs, "partitioned hash join pairs");
+  ASSERT_EQUALS_INT(0, check.numWrong, "partitioned hash join pairs have equal a");
+
+  memset(&check, 0, sizeof(JoinCheck));
+  check.schema = schema;
+  TEST_CHECK(sortMergeJoin(left, right, 2, onAB, onAB, checkJoinPair, &check));
+  ASSERT_EQUALS_INT(3000, check.numPairs, "sort-merge join pairs");
+  ASSERT_EQUALS_INT(0, check.numWrong, "sort-merge join pairs have equal a");
+
+  // a failing callback stops the join
+  memset(&check, 0, sizeof(JoinCheck));
+  check.schema = schema;
+  check.stopAfter = 7;
+  rc = hashJoin(left, right, 1, onA, onA, 0, checkJoinPair, &check);
+  ASSERT_EQUALS_INT(RC_RM_NO_MORE_TUPLES, rc, "callback result returned");
+  ASSERT_EQUALS_INT(7, check.numPairs, "join stopped");
+
+  rc = sortMergeJoin(left, right, 1, onA, onB, checkJoinPair, &check);
+  ASSERT_EQUALS_INT(RC_RM_COMPARE_VALUE_OF_DIFFERENT_DATATYPE, rc, "int joined with string");
+
+  TEST_CHECK(closeTable(left));
+  TEST_CHECK(closeTable(right));
+  TEST_CHECK(deleteTable("test_table_jl"));
+  TEST_CHECK(deleteTable("test_table_jr"));
+  TEST_CHECK(shutdownRecordManager());
+
+  for(i = 0; i < numRight; i++)
+    free(records[i].data);
+  free(records);
+  freeSchema(schema);
+  free(left);
+  free(right);
+  TEST_DONE();
+}
+
+// ************************************************************
+// sorts on a and counts the tuples returned out of order
+static int
+sortOnA (RM_TableData *table, Schema *schema, Expr *cond, long memoryBudget,
+	 int *numTuples, RM_SortStats *stats)
+{
+  RM_ScanHandle *sc = (RM_ScanHandle *) malloc(sizeof(RM_ScanHandle));
+  RM_SortHandle sort;
+  int onA[] = { 0 };
+  int a, prev = 0, numWrong = 0;
+  Record *r;
+
+  TEST_CHECK(createRecord(&r, schema));
+  TEST_CHECK(startScan(table, sc, cond));
+  TEST_CHECK(startSort(sc, 1, onA, memoryBudget, &sort));
+  TEST_CHECK(closeScan(sc));
+  for(*numTuples = 0; nextSorted(&sort, r) == RC_OK; (*numTuples)++)
+    {
+      getIntAttr(r, schema, 0, &a);
+      if (*numTuples > 0 && a != prev + 1)
+	numWrong++;
+      prev = a;
+    }
+  TEST_CHECK(getSortStats(&sort, stats));
+  TEST_CHECK(closeSort(&sort));
+  TEST_CHECK(freeRecord(r));
+  free(sc);
+  return numWrong;
+}
+
+void
+testSort (void)
+{
+  RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+  RM_ScanHandle *sc = (RM_ScanHandle *) malloc(sizeof(RM_ScanHandle));
+  RM_SortHandle sort;
+  RM_SortStats stats;
+  int numRecords = 5000, i, rc, numTuples, numWrong, a, prevA = 0;
+  int onBCA[] = { 1, 2, 0 };
+  Record *records, *r;
+  RM_StringView b;
+  char prevB[4];
+  float c, prevC = 0;
+  Schema *schema;
+  Expr *sel, *left, *right;
+
+  testName = "test external merge sort";
+  schema = testSchema();
+
+  TEST_CHECK(initRecordManager(NULL));
+  TEST_CHECK(createTable("test_table_s",schema));
+  TEST_CHECK(openTable(table, "test_table_s"));
+
+  // a is a permutation of -2500..2499, c = -a / 4
+  records = (Record *) malloc(sizeof(Record) * numRecords);
+  for(i = 0; i < numRecords; i++)
+    {
+      a = (i * 7919) % numRecords - numRecords / 2;
+      r = testRecord(schema, a, names[(a + numRecords) % 3], -a * 0.25);
+      records[i] = *r;
+      free(r);
+    }
+  TEST_CHECK(insertRecords(table, records, numRecords));
+
+  numWrong = sortOnA(table, schema, NULL, 0, &numTuples, &stats);
+  ASSERT_EQUALS_INT(numRecords, numTuples, "all tuples sorted in memory");
+  ASSERT_EQUALS_INT(0, numWrong, "in memory sort on negative and positive ints");
+  ASSERT_EQUALS_INT(0, stats.numRuns, "no runs without a budget");
+
+  // about a thousand tuples per run, merged at once
+  numWrong = sortOnA(table, schema, NULL, 64 * 1024, &numTuples, &stats);
+  ASSERT_EQUALS_INT(numRecords, numTuples, "all tuples sorted with spilled runs");
+  ASSERT_EQUALS_INT(0, numWrong, "sort merging runs");
+  ASSERT_TRUE(stats.numRuns > 1, "runs written to disk");
+  ASSERT_EQUALS_INT(1, stats.numMergePasses, "runs merged in one pass");
+  ASSERT_TRUE(stats.bytesWritten >= (long) numRecords * getRecordSize(schema), "spill volume counted");
+
+  // two buffers per merge need several passes
+  numWrong = sortOnA(table, schema, NULL, 3 * PAGE_SIZE + 64, &numTuples, &stats);
+  ASSERT_EQUALS_INT(numRecords, numTuples, "all tuples sorted with the smallest budget");
+  ASSERT_EQUALS_INT(0, numWrong, "sort merging runs in passes");
+  ASSERT_TRUE(stats.numMergePasses > 2, "several merge passes");
+
+  // a < 0
+  MAKE_ATTRREF(left, 0);
+  MAKE_CONS(right, stringToValue("i0"));
+  MAKE_BINOP_EXPR(sel, left, right, OP_COMP_SMALLER);
+  numWrong = sortOnA(table, schema, sel, 16 * 1024, &numTuples, &stats);
+  ASSERT_EQUALS_INT(numRecords / 2, numTuples, "tuples of the scan condition sorted");
+  ASSERT_EQUALS_INT(0, numWrong, "sort of a scan with a condition");
+  freeExpr(sel);
+
+  // string, float and int keys longer than the prefix of the radix sort
+  TEST_CHECK(createRecord(&r, schema));
+  TEST_CHECK(startScan(table, sc, NULL));
+  TEST_CHECK(startSort(sc, 3, onBCA, 32 * 1024, &sort));
+  TEST_CHECK(closeScan(sc));
+  numWrong = 0;
+  for(numTuples = 0; nextSorted(&sort, r) == RC_OK; numTuples++)
+    {
+      getStringAttr(r, schema, 1, &b);
+      getFloatAttr(r, schema, 2, &c);
+      getIntAttr(r, schema, 0, &a);
+      if (numTuples > 0)
+	{
+	  int cmp = strncmp(prevB, b.data, 4);
+	  if (cmp > 0 || (cmp == 0 && (prevC > c || (prevC == c && prevA >= a))))
+	    numWrong++;
+	}
+      memcpy(prevB, b.data, 4);
+      prevC = c;
+      prevA = a;
+    }
+  ASSERT_EQUALS_INT(numRecords, numTuples, "all tuples sorted on b, c, a");
+  ASSERT_EQUALS_INT(0, numWrong, "sort on string, float and int");
+  TEST_CHECK(closeSort(&sort));
+
+  TEST_CHECK(startScan(table, sc, NULL));
+  rc = startSort(sc, 3, onBCA, 1024, &sort);
+  ASSERT_EQUALS_INT(RC_RM_MEMORY_BUDGET, rc, "budget below the buffers of a merge");
+  TEST_CHECK(closeScan(sc));
+
+  TEST_CHECK(freeRecord(r));
+  TEST_CHECK(closeTable(table));
+  TEST_CHECK(deleteTable("test_table_s"));
+  TEST_CHECK(shutdownRecordManager());
+
+  for(i = 0; i < numRecords; i++)
+    free(records[i].data);
+  free(records);
+  freeSchema(schema);
+  free(sc);
+  free(table);
+  TEST_DONE();
+}
+
+// ************************************************************
+void
+testTopN (void)
+{
+  RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+  RM_ScanHandle *sc = (RM_ScanHandle *) malloc(sizeof(RM_ScanHandle));
+  RM_SortHandle sort;
+  int numRecords = 5000, i, a, rc, numTuples, numWrong;
+  int onA[] = { 0 };
+  int onCA[] = { 2, 0 };
+  Record *records, *r;
+  Schema *schema;
+  float c;
+  Expr *sel, *left, *right;
+
+  testName = "test top-N";
+  schema = testSchema();
+
+  TEST_CHECK(initRecordManager(NULL));
+  TEST_CHECK(createTable("test_table_t",schema));
+  TEST_CHECK(openTable(table, "test_table_t"));
+
+  // a is a permutation of -2500..2499, c = -a / 4
+  records = (Record *) malloc(sizeof(Record) * numRecords);
+  for(i = 0; i < numRecords; i++)
+    {
+      a = (i * 7919) % numRecords - numRecords / 2;
+      r = testRecord(schema, a, names[(a + numRecords) % 3], -a * 0.25);
+      records[i] = *r;
+      free(r);
+    }
+  TEST_CHECK(insertRecords(table, records, numRecords));
+  TEST_CHECK(createRecord(&r, schema));
+
+  // ORDER BY a LIMIT 100
+  TEST_CHECK(startScan(table, sc, NULL));
+  TEST_CHECK(startTopN(sc, 1, onA, 100, &sort));
+  TEST_CHECK(closeScan(sc));
+  numWrong = 0;
+  for(numTuples = 0; nextSorted(&sort, r) == RC_OK; numTuples++)
+    {
+      getIntAttr(r, schema, 0, &a);
+      if (a != numTuples - numRecords / 2)
+	numWrong++;
+    }
+  TEST_CHECK(closeSort(&sort));
+  ASSERT_EQUALS_INT(100, numTuples, "100 tuples");
+  ASSERT_EQUALS_INT(0, numWrong, "the 100 smallest a in order");
+
+  // WHERE a >= 0 ORDER BY c, a LIMIT 10: the largest a
+  MAKE_ATTRREF(left, 0);
+  MAKE_CONS(right, stringToValue("i0"));
+  MAKE_BINOP_EXPR(sel, left, right, OP_COMP_GREATER_EQUAL);
+  TEST_CHECK(startScan(table, sc, sel));
+  TEST_CHECK(startTopN(sc, 2, onCA, 10, &sort));
+  TEST_CHECK(closeScan(sc));
+  numWrong = 0;
+  for(numTuples = 0; nextSorted(&sort, r) == RC_OK; numTuples++)
+    {
+      getIntAttr(r, schema, 0, &a);
+      getFloatAttr(r, schema, 2, &c);
+      if (a != numRecords / 2 - 1 - numTuples || c != -a * 0.25f)
+	numWrong++;
+    }
+  TEST_CHECK(closeSort(&sort));
+  ASSERT_EQUALS_INT(10, numTuples, "10 tuples matching the condition");
+  ASSERT_EQUALS_INT(0, numWrong, "smallest negative floats first");
+  freeExpr(sel);
+
+  // a limit beyond the table returns every tuple
+  TEST_CHECK(startScan(table, sc, NULL));
+  TEST_CHECK(startTopN(sc, 1, onA, 2 * numRecords, &sort));
+  TEST_CHECK(closeScan(sc));
+  for(numTuples = 0; nextSorted(&sort, r) == RC_OK; numTuples++)
+    ;
+  TEST_CHECK(closeSort(&sort));
+  ASSERT_EQUALS_INT(numRecords, numTuples, "all tuples below the limit");
+
+  TEST_CHECK(startScan(table, sc, NULL));
+  rc = startTopN(sc, 1, &numRecords, 10, &sort);
+  ASSERT_EQUALS_INT(RC_RM_UNKOWN_DATATYPE, rc, "unknown attribute");
+  TEST_CHECK(closeScan(sc));
+
+  TEST_CHECK(freeRecord(r));
+  TEST_CHECK(closeTable(table));
+  TEST_CHECK(deleteTable("test_table_t"));
+  TEST_CHECK(shutdownRecordManager());
+
+  for(i = 0; i < numRecords; i++)
+    free(records[i].data);
+  free(records);
+  freeSchema(schema);
+  free(sc);
+  free(table);
+  TEST_DONE();
+}
+
+// ************************************************************
+Schema *
+testSchema (void)
+{
+  char *names[] = { "a", "b", "c" };
+  DataType dt[] = { DT_INT, DT_STRING, DT_FLOAT };
+  int sizes[] = { 0, 4, 0 };
+  int keys[] = {0};
+
+  return createSchema(3, names, dt, sizes, 1, keys);
+}
+
+Record *
+testRecord (Schema *schema, int a, char *b, float c)
+{
+  Record *result;
+  Value *value, str;
+  char buf[5];
+
+  TEST_CHECK(createRecord(&result, schema));
+
+  MAKE_VALUE(value, DT_INT, a);
+  TEST_CHECK(setAttr(result, schema, 0, value));
+  freeVal(value);
+
+  // zero padded to the type length of b
+  memset(buf, 0, sizeof(buf));
+  strncpy(buf, b, 4);
+  str.dt = DT_STRING;
+  str.v.stringV = buf;
+  TEST_CHECK(setAttr(result, schema, 1, &str));
+
+  MAKE_VALUE(value, DT_FLOAT, c);
+  TEST_CHECK(setAttr(result, schema, 2, value));
+  freeVal(value);
+
+  return result;
+}
+
+// records a = 0..numRecords-1, b = names[a % 3], c = (a % 5) * 0.5
+void
+loadTestTable (RM_TableData *table, Schema *schema, int numRecords)
+{
+  Record *records = (Record *) malloc(sizeof(Record) * numRecords);
+  Record *r;
+  int i;
+
+  for(i = 0; i < numRecords; i++)
+    {
+      r = testRecord(schema, i, names[i % 3], (i % 5) * 0.5);
+      records[i] = *r;
+      free(r);
+    }
+  TEST_CHECK(insertRecords(table, records, numRecords));
+  for(i = 0; i < numRecords; i++)
+    free(records[i].data);
+  free(records);
+}